@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "trace_tools.h"
+
+//==============================================================================
+// DEFINES
+//==============================================================================
+
+#define DEFAULT_MEAN    1000.0
+#define PARETO_SHAPE    2.5
+#define MAX_TIME        0xFFFFFFFF
+#define MASK_ID         0x00000000FFFFFFFF
+
+#define HEAP_BRANCH     4
+#define HEAP_PARENT(i)  ( ( (i) - 1 ) / HEAP_BRANCH )
+#define HEAP_CHILD(i)   ( (i) * HEAP_BRANCH + 1 )
+
+enum des_distribution
+{
+    DES_EXPONENTIAL,
+    DES_UNIFORM,
+    DES_BIMODAL,
+    DES_TRIANGULAR,
+    DES_PARETO
+};
+
+static const char *distribution_names[] =
+{
+    "exponential",
+    "uniform",
+    "bimodal",
+    "triangular",
+    "pareto",
+    NULL
+};
+
+//==============================================================================
+// STATIC DECLARATIONS
+//==============================================================================
+
+static uint64_t draw_increment( int distribution, double mean );
+static uint64_t schedule( uint64_t now, uint64_t id, int distribution,
+    double mean );
+static void heap_push( uint64_t *heap, uint64_t size, uint64_t key );
+static void heap_replace_top( uint64_t *heap, uint64_t size, uint64_t key );
+
+//==============================================================================
+// MAIN
+//==============================================================================
+
+/**
+ * Writes the trace of a discrete-event simulation run in the classic hold
+ * model.  The event list is filled with size events scheduled from time 0,
+ * and then each of the holds repeatedly takes the earliest event and
+ * schedules a replacement at its time plus a random increment, so the queue
+ * stays at exactly size elements.  Increments are drawn from the named
+ * distribution, scaled so that their mean is the given number of ticks:
+ *
+ *  exponential     -mean ln U
+ *  uniform         on [0, 2 mean]
+ *  bimodal         on [0, mean/5] with probability 0.9, otherwise on
+ *                  [9 mean, 9.2 mean]
+ *  triangular      on [0, 2 mean] with its mode at mean
+ *  pareto          shape 2.5, scale 0.6 mean
+ *
+ * Keys follow the usual layout, with the event time in the high 32 bits and
+ * the event's node ID in the low 32 bits.  A replacement event reuses the
+ * node ID of the event it replaces, so the trace needs only size node IDs.
+ * The generator keeps the event list in a 4-ary heap of keys, so it needs
+ * 8 bytes per event, 800MB for 10^8 events.
+ */
+int main( int argc, char** argv )
+{
+    uint64_t size, holds, seed, key, now, id, i;
+    double mean = DEFAULT_MEAN;
+    int distribution;
+    uint64_t *heap;
+
+    if( argc < 5 )
+    {
+        fprintf( stderr, "Usage: %s trace_file "
+            "<exponential|uniform|bimodal|triangular|pareto> size holds "
+            "[seed [mean]]\n", argv[0] );
+        exit( -1 );
+    }
+
+    for( distribution = 0; distribution_names[distribution] != NULL;
+            distribution++ )
+    {
+        if( strcmp( argv[2], distribution_names[distribution] ) == 0 )
+            break;
+    }
+    if( distribution_names[distribution] == NULL )
+    {
+        fprintf( stderr, "Unknown distribution: %s\n", argv[2] );
+        exit( -1 );
+    }
+
+    size = strtoull( argv[3], NULL, 10 );
+    holds = strtoull( argv[4], NULL, 10 );
+    seed = ( argc > 5 ) ? strtoull( argv[5], NULL, 10 ) : 1;
+    if( argc > 6 )
+        mean = strtod( argv[6], NULL );
+    if( size == 0 || size > MASK_ID || mean <= 0 )
+    {
+        fprintf( stderr, "Bad size or mean.\n" );
+        exit( -1 );
+    }
+    srand48( seed );
+
+    heap = (uint64_t*) malloc( size * sizeof( uint64_t ) );
+    if( heap == NULL )
+    {
+        fprintf( stderr, "Malloc fail.\n" );
+        exit( -1 );
+    }
+
+    int trace_file = open( argv[1], O_RDWR | O_CREAT | O_TRUNC, S_IRWXU );
+    if( trace_file < 0 )
+    {
+        fprintf( stderr, "Could not open file.\n" );
+        exit( -1 );
+    }
+
+    pq_trace_header header;
+    pq_op_create op_create;
+    pq_op_destroy op_destroy;
+    pq_op_insert op_insert;
+    pq_op_delete_min op_delete_min;
+
+    header.op_count = 0;
+    header.pq_ids = 1;
+    header.node_ids = size;
+    header.flags = 0;
+    op_create.code = PQ_OP_CREATE;
+    op_create.pq_id = 0;
+    op_destroy.code = PQ_OP_DESTROY;
+    op_destroy.pq_id = 0;
+    op_insert.code = PQ_OP_INSERT;
+    op_insert.pq_id = 0;
+    op_delete_min.code = PQ_OP_DELETE_MIN;
+    op_delete_min.pq_id = 0;
+
+    pq_trace_write_header( trace_file, header );
+    pq_trace_write_op( trace_file, &op_create );
+    header.op_count++;
+
+    for( i = 0; i < size; i++ )
+    {
+        key = schedule( 0, i, distribution, mean );
+        heap_push( heap, i, key );
+
+        op_insert.node_id = i;
+        op_insert.key = key;
+        op_insert.item = i;
+        pq_trace_write_op( trace_file, &op_insert );
+        header.op_count++;
+    }
+
+    for( i = 0; i < holds; i++ )
+    {
+        now = heap[0] >> 32;
+        id = heap[0] & MASK_ID;
+        pq_trace_write_op( trace_file, &op_delete_min );
+        header.op_count++;
+
+        key = schedule( now, id, distribution, mean );
+        heap_replace_top( heap, size, key );
+
+        op_insert.node_id = id;
+        op_insert.key = key;
+        op_insert.item = id;
+        pq_trace_write_op( trace_file, &op_insert );
+        header.op_count++;
+    }
+
+    pq_trace_write_op( trace_file, &op_destroy );
+    header.op_count++;
+    if( pq_trace_write_header( trace_file, header ) )
+    {
+        fprintf( stderr, "Could not write trace.\n" );
+        exit( -1 );
+    }
+    close( trace_file );
+    free( heap );
+
+    return 0;
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Draws an increment from the given distribution and rounds it to whole
+ * ticks.
+ *
+ * @param distribution  One of the des_distribution values
+ * @param mean          Mean of the distribution in ticks
+ * @return              Increment in ticks
+ */
+static uint64_t draw_increment( int distribution, double mean )
+{
+    double u = drand48();
+    double x;
+
+    switch( distribution )
+    {
+        case DES_EXPONENTIAL:
+            x = -mean * log( 1.0 - u );
+            break;
+        case DES_UNIFORM:
+            x = 2.0 * mean * u;
+            break;
+        case DES_BIMODAL:
+            if( u < 0.9 )
+                x = 0.2 * mean * drand48();
+            else
+                x = mean * ( 9.0 + 0.2 * drand48() );
+            break;
+        case DES_TRIANGULAR:
+            x = mean * ( u + drand48() );
+            break;
+        default:
+            x = mean * ( PARETO_SHAPE - 1.0 ) / PARETO_SHAPE /
+                pow( 1.0 - u, 1.0 / PARETO_SHAPE );
+            break;
+    }
+
+    if( x >= (double) MAX_TIME )
+        return MAX_TIME;
+    return (uint64_t) ( x + 0.5 );
+}
+
+/**
+ * Builds the key of an event scheduled a random increment after now.  Exits
+ * if the event time no longer fits in 32 bits, since the trace would then
+ * fall out of order.
+ *
+ * @param now           Current simulation time
+ * @param id            Node ID of the event
+ * @param distribution  One of the des_distribution values
+ * @param mean          Mean increment in ticks
+ * @return              Key of the new event
+ */
+static uint64_t schedule( uint64_t now, uint64_t id, int distribution,
+    double mean )
+{
+    uint64_t time = now + draw_increment( distribution, mean );
+    if( time > MAX_TIME )
+    {
+        fprintf( stderr, "Simulation time overflow; use a smaller mean.\n" );
+        exit( -1 );
+    }
+
+    return ( time << 32 ) | id;
+}
+
+/**
+ * Adds a key to a heap of the given size and restores heap order.
+ *
+ * @param heap  Heap array with room for the new key
+ * @param size  Number of keys already in the heap
+ * @param key   Key to add
+ */
+static void heap_push( uint64_t *heap, uint64_t size, uint64_t key )
+{
+    uint64_t i = size;
+    while( i > 0 && key < heap[HEAP_PARENT(i)] )
+    {
+        heap[i] = heap[HEAP_PARENT(i)];
+        i = HEAP_PARENT(i);
+    }
+    heap[i] = key;
+}
+
+/**
+ * Replaces the minimum of a heap with a new key and restores heap order.
+ *
+ * @param heap  Heap array
+ * @param size  Number of keys in the heap
+ * @param key   Key to take the minimum's place
+ */
+static void heap_replace_top( uint64_t *heap, uint64_t size, uint64_t key )
+{
+    uint64_t i = 0;
+    uint64_t child, min_child, last;
+
+    while( ( child = HEAP_CHILD(i) ) < size )
+    {
+        min_child = child;
+        last = child + HEAP_BRANCH;
+        if( last > size )
+            last = size;
+        for( child++; child < last; child++ )
+        {
+            if( heap[child] < heap[min_child] )
+                min_child = child;
+        }
+        if( key <= heap[min_child] )
+            break;
+
+        heap[i] = heap[min_child];
+        i = min_child;
+    }
+    heap[i] = key;
+}
@@ -0,0 +1,731 @@
+#include "dimacs_tools.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+//==============================================================================
+// DEFINES, INCLUDES, and STRUCTS
+//==============================================================================
+
+#define MAXLINE         256
+#define DEFAULT_NAME    "unknown"
+//! inputs are not split into chunks smaller than this many bytes
+#define MIN_CHUNK       ( 1 << 20 )
+//! arrays are not split into blocks smaller than this many entries
+#define MIN_BLOCK       ( 1 << 16 )
+//! integers with more digits than this may not be exact as doubles
+#define MAX_EXACT_DIGITS 15
+
+/**
+ * A range of arc lines handled by one thread.  Counts are filled in by the
+ * first pass and positions by the prefix sum that follows it.
+ */
+struct dimacs_chunk
+{
+    pq_dimacs *graph;
+    const char *start;
+    const char *end;
+    //! whether the capacities are real numbers
+    uint32_t real;
+
+    uint64_t first_arc;
+    uint64_t arc_count;
+    uint64_t first_line;
+    uint64_t line_count;
+
+    uint32_t node_min;
+    uint32_t node_max;
+
+    const char *error;
+    uint64_t error_line;
+};
+
+typedef struct dimacs_chunk dimacs_chunk;
+
+/**
+ * A block of an array handled by one thread.
+ */
+struct dimacs_block
+{
+    pq_dimacs *graph;
+    int64_t *values;
+    uint64_t begin;
+    uint64_t end;
+    int64_t offset;
+};
+
+typedef struct dimacs_block dimacs_block;
+
+//==============================================================================
+// STATIC DECLARATIONS
+//==============================================================================
+
+static int read_all( int file, char **buffer, size_t *length );
+static const char* read_header( pq_dimacs *graph, const char *position,
+    const char *end, uint64_t *lines );
+static void run_workers( void* (*work)( void* ), void *workers, size_t size,
+    uint32_t count );
+static void* count_arcs( void *argument );
+static void* parse_arcs( void *argument );
+static void* count_tails( void *argument );
+static void* sum_block( void *argument );
+static void* scan_block( void *argument );
+static uint32_t split_blocks( dimacs_block *blocks, uint64_t count,
+    uint32_t threads );
+static inline const char* line_end( const char *position, const char *end );
+static inline int scan_integer( const char **cursor, int64_t *value );
+static inline int scan_real( const char **cursor, double *value );
+static void report( const char *message, uint64_t line );
+
+//==============================================================================
+// PUBLIC METHODS
+//==============================================================================
+
+uint32_t pq_dimacs_threads()
+{
+    const char *setting = getenv( PQ_DIMACS_THREADS_ENV );
+    long threads = setting != NULL ? atol( setting ) :
+        sysconf( _SC_NPROCESSORS_ONLN );
+
+    return threads < 1 ? 1 : (uint32_t) threads;
+}
+
+int pq_dimacs_read( int file, uint32_t threads, pq_dimacs *graph )
+{
+    char *buffer;
+    size_t length;
+    uint64_t lines = 0;
+    uint64_t arcs = 0;
+    uint32_t i;
+
+    memset( graph, 0, sizeof( pq_dimacs ) );
+    strcpy( graph->name, DEFAULT_NAME );
+
+    if( read_all( file, &buffer, &length ) )
+    {
+        report( "reading error", 0 );
+        return -1;
+    }
+    if( length == 0 )
+    {
+        report( "can't read anything from the input file", 0 );
+        free( buffer );
+        return -1;
+    }
+
+    const char *end = buffer + length;
+    const char *position = read_header( graph, buffer, end, &lines );
+    if( position == NULL )
+    {
+        free( buffer );
+        return -1;
+    }
+
+    graph->tails = malloc( ( graph->declared_arcs + 1 ) * sizeof( uint32_t ) );
+    graph->heads = malloc( ( graph->declared_arcs + 1 ) * sizeof( uint32_t ) );
+    graph->weights = malloc( ( graph->declared_arcs + 1 ) * sizeof( int64_t ) );
+    if( graph->tails == NULL || graph->heads == NULL || graph->weights == NULL )
+    {
+        report( "can't obtain enough memory to solve this problem", lines );
+        pq_dimacs_free( graph );
+        free( buffer );
+        return -1;
+    }
+
+    // one chunk per thread, each starting at the beginning of a line
+    if( threads > ( end - position ) / MIN_CHUNK + 1 )
+        threads = ( end - position ) / MIN_CHUNK + 1;
+    graph->threads = threads;
+
+    dimacs_chunk *chunks = calloc( threads, sizeof( dimacs_chunk ) );
+    for( i = 0; i < threads; i++ )
+    {
+        chunks[i].graph = graph;
+        chunks[i].real = ( strcmp( graph->type, "cut" ) == 0 );
+        chunks[i].start = position;
+        if( i > 0 )
+        {
+            chunks[i].start = line_end( position +
+                ( end - position ) / threads * i - 1, end );
+            if( chunks[i].start < chunks[i-1].start )
+                chunks[i].start = chunks[i-1].start;
+            chunks[i-1].end = chunks[i].start;
+        }
+    }
+    chunks[threads-1].end = end;
+
+    run_workers( count_arcs, chunks, sizeof( dimacs_chunk ), threads );
+
+    for( i = 0; i < threads; i++ )
+    {
+        if( chunks[i].error != NULL )
+        {
+            report( chunks[i].error, lines + chunks[i].error_line );
+            goto fail;
+        }
+        chunks[i].first_arc = arcs;
+        chunks[i].first_line = lines;
+        arcs += chunks[i].arc_count;
+        lines += chunks[i].line_count;
+    }
+    if( arcs > graph->declared_arcs )
+    {
+        report( "too many arcs in the input", lines );
+        goto fail;
+    }
+    if( arcs < graph->declared_arcs )
+    {
+        report( "not enough arcs in the input", lines );
+        goto fail;
+    }
+
+    run_workers( parse_arcs, chunks, sizeof( dimacs_chunk ), threads );
+
+    graph->arc_count = arcs;
+    graph->node_min = UINT32_MAX;
+    graph->node_max = 0;
+    for( i = 0; i < threads; i++ )
+    {
+        if( chunks[i].error != NULL )
+        {
+            report( chunks[i].error, chunks[i].error_line );
+            goto fail;
+        }
+        if( chunks[i].node_min < graph->node_min )
+            graph->node_min = chunks[i].node_min;
+        if( chunks[i].node_max > graph->node_max )
+            graph->node_max = chunks[i].node_max;
+    }
+
+    free( chunks );
+    free( buffer );
+    return 0;
+
+fail:
+    free( chunks );
+    free( buffer );
+    pq_dimacs_free( graph );
+    return -1;
+}
+
+void pq_dimacs_free( pq_dimacs *graph )
+{
+    free( graph->tails );
+    free( graph->heads );
+    free( graph->weights );
+    graph->tails = NULL;
+    graph->heads = NULL;
+    graph->weights = NULL;
+}
+
+void pq_dimacs_count_tails( pq_dimacs *graph, int64_t *counts )
+{
+    dimacs_block blocks[graph->threads];
+    uint32_t i;
+
+    uint32_t count = split_blocks( blocks, graph->arc_count, graph->threads );
+    for( i = 0; i < count; i++ )
+    {
+        blocks[i].graph = graph;
+        blocks[i].values = counts;
+    }
+
+    run_workers( count_tails, blocks, sizeof( dimacs_block ), count );
+}
+
+void pq_dimacs_prefix_sum( int64_t *values, uint64_t count,
+    uint32_t threads )
+{
+    dimacs_block blocks[threads];
+    int64_t offset = 0;
+    int64_t sum;
+    uint32_t i;
+
+    uint32_t block_count = split_blocks( blocks, count, threads );
+    for( i = 0; i < block_count; i++ )
+        blocks[i].values = values;
+
+    // total each block, then scan each block starting from the totals of
+    // all blocks before it
+    run_workers( sum_block, blocks, sizeof( dimacs_block ), block_count );
+    for( i = 0; i < block_count; i++ )
+    {
+        sum = blocks[i].offset;
+        blocks[i].offset = offset;
+        offset += sum;
+    }
+    run_workers( scan_block, blocks, sizeof( dimacs_block ), block_count );
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Reads a file to its end into a NUL-terminated buffer.  Works on pipes as
+ * well as regular files.
+ *
+ * @param file      File to read
+ * @param buffer    Set to the allocated buffer
+ * @param length    Set to the number of bytes read
+ * @return          0 on success, -1 on error
+ */
+static int read_all( int file, char **buffer, size_t *length )
+{
+    struct stat info;
+    size_t capacity = MIN_CHUNK;
+    size_t used = 0;
+    ssize_t bytes;
+    char *data, *grown;
+
+    if( fstat( file, &info ) == 0 && S_ISREG( info.st_mode ) )
+        capacity = info.st_size + 1;
+
+    data = malloc( capacity + 1 );
+    if( data == NULL )
+        return -1;
+
+    while( ( bytes = read( file, data + used, capacity - used ) ) > 0 )
+    {
+        used += bytes;
+        if( used == capacity )
+        {
+            capacity *= 2;
+            grown = realloc( data, capacity + 1 );
+            if( grown == NULL )
+            {
+                free( data );
+                return -1;
+            }
+            data = grown;
+        }
+    }
+    if( bytes < 0 )
+    {
+        free( data );
+        return -1;
+    }
+
+    data[used] = '\0';
+    *buffer = data;
+    *length = used;
+
+    return 0;
+}
+
+/**
+ * Reads the lines before the first arc line.
+ *
+ * @param graph     Problem to fill in
+ * @param position  Start of the input
+ * @param end       End of the input
+ * @param lines     Set to the number of lines read
+ * @return          Start of the first arc line, or NULL on error
+ */
+static const char* read_header( pq_dimacs *graph, const char *position,
+    const char *end, uint64_t *lines )
+{
+    char line[MAXLINE];
+    const char *next;
+    uint32_t problem = 0;
+    size_t length;
+
+    while( position < end && *position != 'a' )
+    {
+        next = line_end( position, end );
+        length = next - position < MAXLINE ? next - position : MAXLINE - 1;
+        memcpy( line, position, length );
+        line[length] = '\0';
+        (*lines)++;
+
+        switch( line[0] )
+        {
+            case 'c':
+            case '\n':
+            case '\r':
+            case '\0':
+                break;
+            case 'p':
+                if( problem )
+                {
+                    report( "more than one problem line", *lines );
+                    return NULL;
+                }
+                problem = 1;
+                if( sscanf( line, "%*c %3s %lu %lu", graph->type,
+                        &graph->declared_nodes, &graph->declared_arcs ) != 3 )
+                {
+                    report( "wrong number of parameters in the problem line",
+                        *lines );
+                    return NULL;
+                }
+                if( graph->declared_nodes == 0 ||
+                        graph->declared_nodes >= UINT32_MAX )
+                {
+                    report( "bad value of a parameter in the problem line",
+                        *lines );
+                    return NULL;
+                }
+                break;
+            case 't':
+                if( sscanf( line, "%*c %30s", graph->name ) != 1 )
+                {
+                    report( "can't read problem name", *lines );
+                    return NULL;
+                }
+                break;
+            case 'n':
+                if( !problem )
+                {
+                    report( "problem description must be before source "
+                        "description", *lines );
+                    return NULL;
+                }
+                if( graph->has_source )
+                {
+                    report( "this parser doesn't support multiple sources",
+                        *lines );
+                    return NULL;
+                }
+                if( sscanf( line, "%*c %lu", &graph->source ) != 1 ||
+                        graph->source > graph->declared_nodes )
+                {
+                    report( "wrong value of parameters in the source line",
+                        *lines );
+                    return NULL;
+                }
+                graph->has_source = 1;
+                break;
+            default:
+                report( "unknown line type before the arcs", *lines );
+                return NULL;
+        }
+
+        position = next;
+    }
+
+    if( !problem )
+    {
+        report( "arc descriptions must follow the problem line", *lines );
+        return NULL;
+    }
+
+    return position;
+}
+
+/**
+ * Runs a function on each of an array of workers, one thread per worker.
+ * The first worker runs on the calling thread.
+ *
+ * @param work      Function to run
+ * @param workers   Array of worker arguments
+ * @param size      Size of each worker argument
+ * @param count     Number of workers
+ */
+static void run_workers( void* (*work)( void* ), void *workers, size_t size,
+    uint32_t count )
+{
+    pthread_t threads[count];
+    uint32_t i;
+
+    for( i = 1; i < count; i++ )
+        pthread_create( &threads[i], NULL, work, (char*) workers + i * size );
+    work( workers );
+    for( i = 1; i < count; i++ )
+        pthread_join( threads[i], NULL );
+}
+
+/**
+ * First pass over a chunk: counts its lines and arc lines, and rejects
+ * lines other than arcs and comments.
+ *
+ * @param argument  Chunk to count
+ * @return          NULL
+ */
+static void* count_arcs( void *argument )
+{
+    dimacs_chunk *chunk = (dimacs_chunk*) argument;
+    const char *position = chunk->start;
+
+    while( position < chunk->end )
+    {
+        chunk->line_count++;
+        switch( *position )
+        {
+            case 'a':
+                chunk->arc_count++;
+                break;
+            case 'c':
+            case '\n':
+            case '\r':
+                break;
+            case 'p':
+            case 't':
+            case 'n':
+                chunk->error = "header lines must precede the arcs";
+                chunk->error_line = chunk->line_count;
+                return NULL;
+            default:
+                chunk->error = "unknown line type in the input";
+                chunk->error_line = chunk->line_count;
+                return NULL;
+        }
+        position = line_end( position, chunk->end );
+    }
+
+    return NULL;
+}
+
+/**
+ * Second pass over a chunk: parses each arc line into its position in
+ * input order.
+ *
+ * @param argument  Chunk to parse
+ * @return          NULL
+ */
+static void* parse_arcs( void *argument )
+{
+    dimacs_chunk *chunk = (dimacs_chunk*) argument;
+    pq_dimacs *graph = chunk->graph;
+    const char *position = chunk->start;
+    const char *cursor;
+    uint64_t arc = chunk->first_arc;
+    uint64_t line = chunk->first_line;
+    int64_t tail, head, weight;
+    double capacity;
+
+    chunk->node_min = UINT32_MAX;
+    chunk->node_max = 0;
+
+    while( position < chunk->end )
+    {
+        line++;
+        if( *position == 'a' )
+        {
+            cursor = position + 1;
+            if( scan_integer( &cursor, &tail ) ||
+                    scan_integer( &cursor, &head ) )
+                goto fields;
+            if( chunk->real )
+            {
+                if( scan_real( &cursor, &capacity ) )
+                    goto fields;
+                if( capacity <= 0 )
+                {
+                    chunk->error = "capacities must be positive";
+                    chunk->error_line = line;
+                    return NULL;
+                }
+                weight = (int64_t) capacity;
+            }
+            else if( scan_integer( &cursor, &weight ) )
+                goto fields;
+
+            if( tail < 0 || tail > graph->declared_nodes ||
+                    head < 0 || head > graph->declared_nodes )
+            {
+                chunk->error = "wrong value of parameters in the arc line";
+                chunk->error_line = line;
+                return NULL;
+            }
+
+            graph->tails[arc] = (uint32_t) tail;
+            graph->heads[arc] = (uint32_t) head;
+            graph->weights[arc] = weight;
+            arc++;
+
+            if( head < chunk->node_min ) chunk->node_min = head;
+            if( tail < chunk->node_min ) chunk->node_min = tail;
+            if( head > chunk->node_max ) chunk->node_max = head;
+            if( tail > chunk->node_max ) chunk->node_max = tail;
+        }
+        position = line_end( position, chunk->end );
+    }
+
+    return NULL;
+
+fields:
+    chunk->error = "wrong number of parameters in the arc line";
+    chunk->error_line = line;
+    return NULL;
+}
+
+/**
+ * Adds the out-degrees of the tails in a block of arcs to the counts.
+ *
+ * @param argument  Block of arcs
+ * @return          NULL
+ */
+static void* count_tails( void *argument )
+{
+    dimacs_block *block = (dimacs_block*) argument;
+    uint32_t *tails = block->graph->tails;
+    uint64_t i;
+
+    for( i = block->begin; i < block->end; i++ )
+        __atomic_fetch_add( &block->values[tails[i] + 1], 1,
+            __ATOMIC_RELAXED );
+
+    return NULL;
+}
+
+/**
+ * Totals a block of values into its offset.
+ *
+ * @param argument  Block to total
+ * @return          NULL
+ */
+static void* sum_block( void *argument )
+{
+    dimacs_block *block = (dimacs_block*) argument;
+    int64_t sum = 0;
+    uint64_t i;
+
+    for( i = block->begin; i < block->end; i++ )
+        sum += block->values[i];
+    block->offset = sum;
+
+    return NULL;
+}
+
+/**
+ * Replaces a block of values with their running sum, starting from the
+ * block's offset.
+ *
+ * @param argument  Block to scan
+ * @return          NULL
+ */
+static void* scan_block( void *argument )
+{
+    dimacs_block *block = (dimacs_block*) argument;
+    int64_t sum = block->offset;
+    uint64_t i;
+
+    for( i = block->begin; i < block->end; i++ )
+    {
+        sum += block->values[i];
+        block->values[i] = sum;
+    }
+
+    return NULL;
+}
+
+/**
+ * Splits a range of indices into at most one block per thread, leaving
+ * small ranges to fewer threads.
+ *
+ * @param blocks    Array of at least threads blocks to fill in
+ * @param count     Number of indices
+ * @param threads   Number of threads available
+ * @return          Number of blocks used
+ */
+static uint32_t split_blocks( dimacs_block *blocks, uint64_t count,
+    uint32_t threads )
+{
+    uint32_t i;
+
+    if( threads > count / MIN_BLOCK + 1 )
+        threads = count / MIN_BLOCK + 1;
+
+    for( i = 0; i < threads; i++ )
+    {
+        blocks[i].begin = count / threads * i;
+        blocks[i].end = i == threads - 1 ? count : count / threads * ( i + 1 );
+    }
+
+    return threads;
+}
+
+/**
+ * Finds the start of the line after the one containing a position.
+ *
+ * @param position  Position within a line
+ * @param end       End of the input
+ * @return          Start of the next line, or end
+ */
+static inline const char* line_end( const char *position, const char *end )
+{
+    const char *newline = memchr( position, '\n', end - position );
+    return newline == NULL ? end : newline + 1;
+}
+
+/**
+ * Reads a decimal integer, skipping leading blanks, and advances the cursor
+ * past it.  Stops at the first character that is not a digit, as scanf does.
+ *
+ * @param cursor    Position to read from, advanced on success
+ * @param value     Set to the integer read
+ * @return          0 on success, -1 if there is no integer
+ */
+static inline int scan_integer( const char **cursor, int64_t *value )
+{
+    const char *position = *cursor;
+    int64_t result = 0;
+    int64_t sign = 1;
+
+    while( *position == ' ' || *position == '\t' )
+        position++;
+    if( *position == '-' || *position == '+' )
+    {
+        sign = *position == '-' ? -1 : 1;
+        position++;
+    }
+    if( *position < '0' || *position > '9' )
+        return -1;
+
+    while( *position >= '0' && *position <= '9' )
+        result = result * 10 + ( *position++ - '0' );
+
+    *value = sign * result;
+    *cursor = position;
+    return 0;
+}
+
+/**
+ * Reads a real number.  Plain integers short enough to be exact as doubles
+ * are read with @ref <scan_integer>; anything else falls back to strtod.
+ * The input buffer is NUL-terminated, so strtod cannot run off its end.
+ *
+ * @param cursor    Position to read from, advanced on success
+ * @param value     Set to the number read
+ * @return          0 on success, -1 if there is no number
+ */
+static inline int scan_real( const char **cursor, double *value )
+{
+    const char *start = *cursor;
+    const char *position;
+    char *stop;
+    int64_t integer;
+
+    while( *start == ' ' || *start == '\t' )
+        start++;
+    position = start;
+    if( scan_integer( &position, &integer ) == 0 &&
+            *position != '.' && *position != 'e' && *position != 'E' &&
+            position - start <= MAX_EXACT_DIGITS )
+    {
+        *value = (double) integer;
+        *cursor = position;
+        return 0;
+    }
+
+    *value = strtod( start, &stop );
+    if( stop == start )
+        return -1;
+    *cursor = stop;
+    return 0;
+}
+
+/**
+ * Reports a parse error on stderr in the style of the DIMACS parsers.
+ *
+ * @param message   Description of the error
+ * @param line      Line of the input the error was found on, 0 if none
+ */
+static void report( const char *message, uint64_t line )
+{
+    if( line > 0 )
+        fprintf( stderr, "\nline %lu of input - %s\n", line, message );
+    else
+        fprintf( stderr, "\n%s\n", message );
+}
@@ -0,0 +1,111 @@
+#ifndef PQ_DIMACS_TOOLS
+#define PQ_DIMACS_TOOLS
+
+//==============================================================================
+// DEFINES, INCLUDES, and STRUCTS
+//==============================================================================
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+//! environment variable overriding the number of parser threads
+#define PQ_DIMACS_THREADS_ENV   "PQ_PARSE_THREADS"
+
+/**
+ * A DIMACS problem with its arcs in input order.  Header lines (problem,
+ * name and source) must all precede the first arc line; comments may appear
+ * anywhere.  Capacities of "cut" problems are read as reals, as parser_ni
+ * does, and must be positive; all other weights are integers.
+ */
+struct pq_dimacs
+{
+    //! problem type from the problem line, e.g. "sp" or "cut"
+    char type[4];
+    //! problem name, or "unknown" if there is no name line
+    char name[32];
+    //! node and arc counts given on the problem line
+    uint64_t declared_nodes;
+    uint64_t declared_arcs;
+    //! source from the node line, if there is one
+    uint32_t has_source;
+    uint64_t source;
+
+    uint64_t arc_count;
+    uint32_t *tails;
+    uint32_t *heads;
+    int64_t *weights;
+    //! lowest and highest node used by an arc
+    uint32_t node_min;
+    uint32_t node_max;
+
+    //! number of threads used to read the graph
+    uint32_t threads;
+};
+
+typedef struct pq_dimacs pq_dimacs;
+
+//==============================================================================
+// PUBLIC DECLARATIONS
+//==============================================================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Picks the number of threads to parse with: the value of
+ * PQ_PARSE_THREADS if set, otherwise the number of online processors.
+ *
+ * @return  Number of threads, at least 1
+ */
+uint32_t pq_dimacs_threads();
+
+/**
+ * Reads a whole DIMACS problem from a file.  The header is read
+ * sequentially, then the arc lines are split into one chunk per thread on
+ * line boundaries.  Each thread counts the arcs in its chunk, and after a
+ * prefix sum over the counts parses them straight into their final
+ * positions, so the arrays are in input order regardless of the number of
+ * threads.  Errors are reported on stderr.
+ *
+ * @param file      File to read, e.g. 0 for stdin
+ * @param threads   Number of threads to use
+ * @param graph     Problem to fill in
+ * @return          0 on success, -1 on error
+ */
+int pq_dimacs_read( int file, uint32_t threads, pq_dimacs *graph );
+
+/**
+ * Releases the arrays of a problem read by @ref <pq_dimacs_read>.
+ *
+ * @param graph Problem to free
+ */
+void pq_dimacs_free( pq_dimacs *graph );
+
+/**
+ * Counts the out-degree of each node in parallel, adding the degree of node
+ * v to counts[v+1] so that a prefix sum turns the counts into arc offsets.
+ *
+ * @param graph     Problem to count
+ * @param counts    Array of at least node_max + 2 counts
+ */
+void pq_dimacs_count_tails( pq_dimacs *graph, int64_t *counts );
+
+/**
+ * Replaces each value with the sum of itself and all values before it,
+ * splitting the array into one block per thread.
+ *
+ * @param values    Values to sum
+ * @param count     Number of values
+ * @param threads   Number of threads to use
+ */
+void pq_dimacs_prefix_sum( int64_t *values, uint64_t count,
+    uint32_t threads );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
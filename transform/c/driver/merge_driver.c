@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef USE_EAGER
+    #include "../memory_management_eager.h"
+#elif USE_LAZY
+    #include "../memory_management_lazy.h"
+#else
+    #include "../memory_management_dumb.h"
+#endif
+
+#include "../trace_tools.h"
+#include "../typedefs.h"
+
+#define PQ_MIN_USEC 2000000
+#define CHUNK_SIZE 1000000
+#define MIN(a,b) ( b < a ? b : a )
+
+// Merges k sorted runs of the insert keys of a trace, by default by keeping
+// the head of every run in a queue and replacing the minimum with the next
+// key of its run.  USE_LOSER_TREE replaces the queue with a tree of losers,
+// the usual baseline for multiway merging.
+#if defined USE_LOSER_TREE
+    #define MAX_KEY 0xFFFFFFFFFFFFFFFF
+    typedef uint8_t pq_node_type;
+
+    /**
+     * The key at the head of a run, and the run it came from.  Each internal
+     * node of the tree holds the loser of the match played there.
+     */
+    struct loser_entry_t
+    {
+        key_type key;
+        uint32_t run;
+    };
+
+    typedef struct loser_entry_t loser_entry;
+#else
+    #ifdef USE_BINOMIAL
+        #include "../queues/binomial_queue.h"
+    #elif defined USE_EXPLICIT_2
+        #include "../queues/explicit_heap.h"
+    #elif defined USE_EXPLICIT_4
+        #include "../queues/explicit_heap.h"
+    #elif defined USE_EXPLICIT_8
+        #include "../queues/explicit_heap.h"
+    #elif defined USE_EXPLICIT_16
+        #include "../queues/explicit_heap.h"
+    #elif defined USE_FIBONACCI
+        #include "../queues/fibonacci_heap.h"
+    #elif defined USE_IMPLICIT_2
+        #include "../queues/implicit_heap.h"
+    #elif defined USE_IMPLICIT_4
+        #include "../queues/implicit_heap.h"
+    #elif defined USE_IMPLICIT_8
+        #include "../queues/implicit_heap.h"
+    #elif defined USE_IMPLICIT_16
+        #include "../queues/implicit_heap.h"
+    #elif defined USE_PAIRING
+        #include "../queues/pairing_heap.h"
+    #elif defined USE_QUAKE
+        #include "../queues/quake_heap.h"
+    #elif defined USE_RANK_PAIRING
+        #include "../queues/rank_pairing_heap.h"
+    #elif defined USE_RANK_RELAXED_WEAK
+        #include "../queues/rank_relaxed_weak_queue.h"
+    #elif defined USE_STRICT_FIBONACCI
+        #include "../queues/strict_fibonacci_heap.h"
+    #elif defined USE_VIOLATION
+        #include "../queues/violation_heap.h"
+    #elif defined USE_BUCKET
+        #include "../queues/bucket_queue.h"
+    #elif defined USE_MULTILEVEL_BUCKET
+        #include "../queues/multilevel_bucket_queue.h"
+    #elif defined USE_CALENDAR
+        #include "../queues/calendar_queue.h"
+    #elif defined USE_LADDER
+        #include "../queues/ladder_queue.h"
+    #elif defined USE_TIMING_WHEEL
+        #include "../queues/timing_wheel.h"
+    #endif
+#endif
+
+#ifdef USE_STRICT_FIBONACCI
+    static uint32_t mem_types = 2;
+    static uint32_t mem_sizes[2] =
+    {
+        sizeof( strict_fibonacci_node ),
+        sizeof( active_record )
+    };
+    static uint32_t mem_capacities[2] =
+    {
+        0,
+        1000
+    };
+#else
+    static uint32_t mem_types = 1;
+    static uint32_t mem_sizes[1] =
+    {
+        sizeof( pq_node_type )
+    };
+    static uint32_t mem_capacities[1] =
+    {
+        0
+    };
+#endif
+
+static int64_t load_keys( char *path, key_type **keys );
+static int compare_keys( const void *a, const void *b );
+static void merge_runs( mem_map *map, key_type *runs, uint64_t *starts,
+    uint64_t *positions, uint32_t k, key_type *merged );
+
+int main( int argc, char** argv )
+{
+    uint64_t i;
+    uint32_t j;
+
+    if( argc < 3 )
+        exit( -1 );
+
+    uint32_t k = (uint32_t) strtoul( argv[2], NULL, 10 );
+    if( k == 0 )
+    {
+        fprintf( stderr, "Need at least one run.\n" );
+        return -1;
+    }
+
+    key_type *keys;
+    int64_t count = load_keys( argv[1], &keys );
+    if( count < 0 )
+    {
+        fprintf( stderr, "Could not read keys.\n" );
+        return -1;
+    }
+    uint64_t n = (uint64_t) count;
+
+    // deal the keys in trace order into k runs of near equal length, and sort
+    // each one up front so that only the merge is timed
+    uint64_t *starts = (uint64_t *)calloc( k + 1, sizeof( uint64_t ) );
+    uint64_t *positions = (uint64_t *)calloc( k, sizeof( uint64_t ) );
+    key_type *merged = (key_type *)calloc( n + 1, sizeof( key_type ) );
+    if( starts == NULL || positions == NULL || merged == NULL )
+    {
+        fprintf( stderr, "Calloc fail.\n" );
+        return -1;
+    }
+    for( j = 0; j <= k; j++ )
+        starts[j] = ( n * j ) / k;
+    for( j = 0; j < k; j++ )
+        qsort( keys + starts[j], starts[j+1] - starts[j], sizeof( key_type ),
+            compare_keys );
+
+    mem_capacities[0] = k;
+
+#ifdef USE_EAGER
+    mem_map *map = mm_create( mem_types, mem_sizes, mem_capacities );
+#else
+    mem_map *map = mm_create( mem_types, mem_sizes );
+#endif
+
+    struct timeval t0, t1;
+    uint32_t iterations = 0;
+    uint64_t total_time = 0;
+
+    while( iterations < 5 || total_time < PQ_MIN_USEC )
+    {
+        mm_clear( map );
+        iterations++;
+
+        gettimeofday(&t0, NULL);
+        merge_runs( map, keys, starts, positions, k, merged );
+        gettimeofday(&t1, NULL);
+        total_time += (t1.tv_sec - t0.tv_sec) * 1000000 +
+            (t1.tv_usec - t0.tv_usec);
+    }
+
+    // a sorted output with the same key sum is almost surely the input merged
+    key_type sum = 0;
+    for( i = 0; i < n; i++ )
+        sum += keys[i] - merged[i];
+    for( i = 1; i < n; i++ )
+    {
+        if( merged[i] < merged[i-1] )
+        {
+            fprintf( stderr, "Output not sorted at %llu.\n",
+                (unsigned long long) i );
+            return -1;
+        }
+    }
+    if( sum != 0 )
+    {
+        fprintf( stderr, "Output keys differ from the input.\n" );
+        return -1;
+    }
+
+    mm_destroy( map );
+    free( keys );
+    free( starts );
+    free( positions );
+    free( merged );
+
+    printf( "%f\n", n == 0 ? 0.0 :
+        ( total_time * 1000.0 ) / ( (double) iterations * n ) );
+
+    return 0;
+}
+
+/**
+ * Collects the keys of every insert in a trace, in trace order.
+ *
+ * @param path  Trace file to read
+ * @param keys  Set to a newly allocated array of keys
+ * @return      Number of keys read, or -1 on error
+ */
+static int64_t load_keys( char *path, key_type **keys )
+{
+    uint64_t i, op_remaining, op_chunk;
+    uint64_t n = 0;
+
+    int trace_file = open( path, O_RDONLY );
+    if( trace_file < 0 )
+        return -1;
+
+    pq_trace_header header;
+    if( pq_trace_read_header( trace_file, &header ) )
+        return -1;
+
+    pq_op_blank *ops = (pq_op_blank *)calloc( MIN( header.op_count,
+        CHUNK_SIZE ), sizeof( pq_op_blank ) );
+    *keys = (key_type *)calloc( header.node_ids + 1, sizeof( key_type ) );
+    if( ops == NULL || *keys == NULL )
+        return -1;
+
+    op_remaining = header.op_count;
+    while( op_remaining > 0 )
+    {
+        op_chunk = MIN( CHUNK_SIZE, op_remaining );
+        op_remaining -= op_chunk;
+        if( pq_trace_read_ops( trace_file, ops, op_chunk ) )
+            return -1;
+
+        for( i = 0; i < op_chunk; i++ )
+        {
+            if( ops[i].code == PQ_OP_INSERT && n <= header.node_ids )
+                (*keys)[n++] = ops[i].key;
+        }
+    }
+
+    close( trace_file );
+    free( ops );
+
+    return (int64_t) n;
+}
+
+/**
+ * Orders keys for qsort.
+ *
+ * @param a Pointer to the first key
+ * @param b Pointer to the second key
+ * @return  Negative, zero, or positive as the first key is smaller, equal, or
+ *          larger
+ */
+static int compare_keys( const void *a, const void *b )
+{
+    key_type x = *(const key_type *) a;
+    key_type y = *(const key_type *) b;
+
+    return ( x > y ) - ( x < y );
+}
+
+#if defined USE_LOSER_TREE
+
+/**
+ * Returns the entry at the head of a run, with the largest possible key once
+ * the run is used up.
+ *
+ * @param runs      Keys of all runs, back to back
+ * @param starts    Index of the first key of each run, and the total count
+ * @param positions Index of the next unmerged key of each run
+ * @param run       Run to query
+ * @return          Entry for the run's next key
+ */
+static loser_entry head_of( key_type *runs, uint64_t *starts,
+    uint64_t *positions, uint32_t run )
+{
+    loser_entry entry;
+    entry.run = run;
+    entry.key = ( positions[run] < starts[run+1] ) ? runs[positions[run]] :
+        MAX_KEY;
+
+    return entry;
+}
+
+/**
+ * Plays out the subtree below an internal node, storing the loser of every
+ * match in the tree.  Nodes 1 to k - 1 are internal, with the children of node
+ * t at 2t and 2t + 1, and run r is the leaf k + r, so any k gives a complete
+ * binary tree.
+ *
+ * @param tree      Loser entries, indexed by internal node
+ * @param runs      Keys of all runs, back to back
+ * @param starts    Index of the first key of each run, and the total count
+ * @param positions Index of the next unmerged key of each run
+ * @param k         Number of runs
+ * @param node      Root of the subtree to play
+ * @return          Winner of the subtree
+ */
+static loser_entry play( loser_entry *tree, key_type *runs, uint64_t *starts,
+    uint64_t *positions, uint32_t k, uint32_t node )
+{
+    loser_entry a, b;
+
+    if( node >= k )
+        return head_of( runs, starts, positions, node - k );
+
+    a = play( tree, runs, starts, positions, k, 2 * node );
+    b = play( tree, runs, starts, positions, k, 2 * node + 1 );
+    if( b.key < a.key )
+    {
+        tree[node] = a;
+        return b;
+    }
+    tree[node] = b;
+    return a;
+}
+
+/**
+ * Merges with a tree of losers.  After the winner is output, its run's next
+ * key replays only the matches on the path from its leaf to the root, one
+ * comparison per level against the stored loser, rather than comparing both
+ * children on the way down as a heap does.
+ */
+static void merge_runs( mem_map *map, key_type *runs, uint64_t *starts,
+    uint64_t *positions, uint32_t k, key_type *merged )
+{
+    loser_entry *tree = (loser_entry *)malloc( k * sizeof( loser_entry ) );
+    loser_entry winner, swap;
+    uint64_t i;
+    uint32_t run, t;
+
+    memcpy( positions, starts, k * sizeof( uint64_t ) );
+    winner = play( tree, runs, starts, positions, k, 1 );
+
+    for( i = 0; i < starts[k]; i++ )
+    {
+        merged[i] = winner.key;
+        run = winner.run;
+        positions[run]++;
+        winner = head_of( runs, starts, positions, run );
+        for( t = ( run + k ) >> 1; t > 0; t >>= 1 )
+        {
+            if( tree[t].key < winner.key )
+            {
+                swap = tree[t];
+                tree[t] = winner;
+                winner = swap;
+            }
+        }
+    }
+
+    free( tree );
+}
+
+#else
+
+#ifndef PQ_HAS_REPLACE_MIN
+static pq_node_type* pq_replace_min( pq_type *queue, item_type item,
+    key_type key )
+{
+    pq_delete_min( queue );
+    return pq_insert( queue, item, key );
+}
+#endif
+
+/**
+ * Merges with a queue holding the head of every non-empty run.  The minimum
+ * is output and replaced by the next key of its run, or deleted once the run
+ * is used up.
+ */
+static void merge_runs( mem_map *map, key_type *runs, uint64_t *starts,
+    uint64_t *positions, uint32_t k, key_type *merged )
+{
+    uint64_t i = 0;
+    uint32_t run;
+    pq_node_type *min;
+    pq_type *q = pq_create( map );
+
+    for( run = 0; run < k; run++ )
+    {
+        positions[run] = starts[run];
+        if( positions[run] < starts[run+1] )
+            pq_insert( q, (item_type) run, runs[positions[run]++] );
+    }
+
+    while( !pq_empty( q ) )
+    {
+        min = pq_find_min( q );
+        run = *pq_get_item( q, min );
+        merged[i++] = pq_get_key( q, min );
+        if( positions[run] < starts[run+1] )
+            pq_replace_min( q, (item_type) run, runs[positions[run]++] );
+        else
+            pq_delete_min( q );
+    }
+
+    pq_destroy( q );
+}
+
+#endif
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef USE_EAGER
+    #include "../memory_management_eager.h"
+#elif USE_LAZY
+    #include "../memory_management_lazy.h"
+#else
+    #include "../memory_management_dumb.h"
+#endif
+
+#include "../trace_tools.h"
+#include "../typedefs.h"
+
+#define PQ_MIN_USEC 2000000
+#define CHUNK_SIZE 1000000
+#define RADIX_BITS 8
+#define RADIX_BUCKETS ( 1 << RADIX_BITS )
+#define MIN(a,b) ( b < a ? b : a )
+
+// Sorts the insert keys of a trace, by default by inserting all of them into a
+// queue and then repeatedly deleting the minimum.  USE_STD_SORT and
+// USE_RADIX_SORT replace the queue with a baseline sorter so every queue can
+// be compared against them on identical keys.
+#if defined USE_STD_SORT
+    #include <algorithm>
+    typedef uint8_t pq_node_type;
+#elif defined USE_RADIX_SORT
+    typedef uint8_t pq_node_type;
+#else
+    #ifdef USE_BINOMIAL
+        #include "../queues/binomial_queue.h"
+    #elif defined USE_EXPLICIT_2
+        #include "../queues/explicit_heap.h"
+    #elif defined USE_EXPLICIT_4
+        #include "../queues/explicit_heap.h"
+    #elif defined USE_EXPLICIT_8
+        #include "../queues/explicit_heap.h"
+    #elif defined USE_EXPLICIT_16
+        #include "../queues/explicit_heap.h"
+    #elif defined USE_FIBONACCI
+        #include "../queues/fibonacci_heap.h"
+    #elif defined USE_IMPLICIT_2
+        #include "../queues/implicit_heap.h"
+    #elif defined USE_IMPLICIT_4
+        #include "../queues/implicit_heap.h"
+    #elif defined USE_IMPLICIT_8
+        #include "../queues/implicit_heap.h"
+    #elif defined USE_IMPLICIT_16
+        #include "../queues/implicit_heap.h"
+    #elif defined USE_PAIRING
+        #include "../queues/pairing_heap.h"
+    #elif defined USE_QUAKE
+        #include "../queues/quake_heap.h"
+    #elif defined USE_RANK_PAIRING
+        #include "../queues/rank_pairing_heap.h"
+    #elif defined USE_RANK_RELAXED_WEAK
+        #include "../queues/rank_relaxed_weak_queue.h"
+    #elif defined USE_STRICT_FIBONACCI
+        #include "../queues/strict_fibonacci_heap.h"
+    #elif defined USE_VIOLATION
+        #include "../queues/violation_heap.h"
+    #elif defined USE_BUCKET
+        #include "../queues/bucket_queue.h"
+    #elif defined USE_MULTILEVEL_BUCKET
+        #include "../queues/multilevel_bucket_queue.h"
+    #elif defined USE_CALENDAR
+        #include "../queues/calendar_queue.h"
+    #elif defined USE_LADDER
+        #include "../queues/ladder_queue.h"
+    #elif defined USE_TIMING_WHEEL
+        #include "../queues/timing_wheel.h"
+    #elif defined USE_KNHEAP
+        #include "../queues/knheap.h"
+    #endif
+#endif
+
+#ifdef USE_STRICT_FIBONACCI
+    static uint32_t mem_types = 2;
+    static uint32_t mem_sizes[2] =
+    {
+        sizeof( strict_fibonacci_node ),
+        sizeof( active_record )
+    };
+    static uint32_t mem_capacities[2] =
+    {
+        0,
+        1000
+    };
+#else
+    static uint32_t mem_types = 1;
+    static uint32_t mem_sizes[1] =
+    {
+        sizeof( pq_node_type )
+    };
+    static uint32_t mem_capacities[1] =
+    {
+        0
+    };
+#endif
+
+static int64_t load_keys( char *path, key_type **keys );
+static void sort_keys( mem_map *map, key_type *keys, key_type *sorted,
+    key_type *scratch, uint64_t n );
+
+int main( int argc, char** argv )
+{
+    uint64_t i;
+
+    if( argc < 2 )
+        exit( -1 );
+
+    key_type *keys;
+    int64_t count = load_keys( argv[1], &keys );
+    if( count < 0 )
+    {
+        fprintf( stderr, "Could not read keys.\n" );
+        return -1;
+    }
+    uint64_t n = (uint64_t) count;
+
+    key_type *sorted = (key_type *)calloc( n + 1, sizeof( key_type ) );
+    key_type *scratch = (key_type *)calloc( n + 1, sizeof( key_type ) );
+    if( sorted == NULL || scratch == NULL )
+    {
+        fprintf( stderr, "Calloc fail.\n" );
+        return -1;
+    }
+
+    mem_capacities[0] = n;
+
+#ifdef USE_EAGER
+    mem_map *map = mm_create( mem_types, mem_sizes, mem_capacities );
+#else
+    mem_map *map = mm_create( mem_types, mem_sizes );
+#endif
+
+    struct timeval t0, t1;
+    uint32_t iterations = 0;
+    uint64_t total_time = 0;
+
+    while( iterations < 5 || total_time < PQ_MIN_USEC )
+    {
+        mm_clear( map );
+        iterations++;
+
+        gettimeofday(&t0, NULL);
+        sort_keys( map, keys, sorted, scratch, n );
+        gettimeofday(&t1, NULL);
+        total_time += (t1.tv_sec - t0.tv_sec) * 1000000 +
+            (t1.tv_usec - t0.tv_usec);
+    }
+
+    for( i = 1; i < n; i++ )
+    {
+        if( sorted[i] < sorted[i-1] )
+        {
+            fprintf( stderr, "Output not sorted at %llu.\n",
+                (unsigned long long) i );
+            return -1;
+        }
+    }
+
+    mm_destroy( map );
+    free( keys );
+    free( sorted );
+    free( scratch );
+
+    printf( "%f\n", n == 0 ? 0.0 :
+        ( total_time * 1000.0 ) / ( (double) iterations * n ) );
+
+    return 0;
+}
+
+/**
+ * Collects the keys of every insert in a trace, in trace order.
+ *
+ * @param path  Trace file to read
+ * @param keys  Set to a newly allocated array of keys
+ * @return      Number of keys read, or -1 on error
+ */
+static int64_t load_keys( char *path, key_type **keys )
+{
+    uint64_t i, op_remaining, op_chunk;
+    uint64_t n = 0;
+
+    int trace_file = open( path, O_RDONLY );
+    if( trace_file < 0 )
+        return -1;
+
+    pq_trace_header header;
+    if( pq_trace_read_header( trace_file, &header ) )
+        return -1;
+
+    pq_op_blank *ops = (pq_op_blank *)calloc( MIN( header.op_count,
+        CHUNK_SIZE ), sizeof( pq_op_blank ) );
+    *keys = (key_type *)calloc( header.node_ids + 1, sizeof( key_type ) );
+    if( ops == NULL || *keys == NULL )
+        return -1;
+
+    op_remaining = header.op_count;
+    while( op_remaining > 0 )
+    {
+        op_chunk = MIN( CHUNK_SIZE, op_remaining );
+        op_remaining -= op_chunk;
+        if( pq_trace_read_ops( trace_file, ops, op_chunk ) )
+            return -1;
+
+        for( i = 0; i < op_chunk; i++ )
+        {
+            if( ops[i].code == PQ_OP_INSERT && n <= header.node_ids )
+                (*keys)[n++] = ops[i].key;
+        }
+    }
+
+    close( trace_file );
+    free( ops );
+
+    return (int64_t) n;
+}
+
+#if defined USE_STD_SORT
+
+static void sort_keys( mem_map *map, key_type *keys, key_type *sorted,
+    key_type *scratch, uint64_t n )
+{
+    memcpy( sorted, keys, n * sizeof( key_type ) );
+    std::sort( sorted, sorted + n );
+}
+
+#elif defined USE_RADIX_SORT
+
+/**
+ * Least-significant-digit radix sort on the full 64-bit key, one byte per
+ * pass.  Passes whose digit is the same for every key are skipped, which for
+ * the usual (priority << 32 | name) keys drops the unused high bytes.
+ */
+static void sort_keys( mem_map *map, key_type *keys, key_type *sorted,
+    key_type *scratch, uint64_t n )
+{
+    uint64_t counts[sizeof( key_type )][RADIX_BUCKETS];
+    uint64_t i, sum, next;
+    uint32_t pass, b;
+    key_type *src, *dst, *tmp;
+
+    memset( counts, 0, sizeof( counts ) );
+    for( i = 0; i < n; i++ )
+    {
+        for( pass = 0; pass < sizeof( key_type ); pass++ )
+            counts[pass][( keys[i] >> ( pass * RADIX_BITS ) ) &
+                ( RADIX_BUCKETS - 1 )]++;
+    }
+
+    memcpy( sorted, keys, n * sizeof( key_type ) );
+    src = sorted;
+    dst = scratch;
+    for( pass = 0; pass < sizeof( key_type ); pass++ )
+    {
+        if( n == 0 || counts[pass][( src[0] >> ( pass * RADIX_BITS ) ) &
+                ( RADIX_BUCKETS - 1 )] == n )
+            continue;
+
+        sum = 0;
+        for( b = 0; b < RADIX_BUCKETS; b++ )
+        {
+            next = sum + counts[pass][b];
+            counts[pass][b] = sum;
+            sum = next;
+        }
+
+        for( i = 0; i < n; i++ )
+            dst[counts[pass][( src[i] >> ( pass * RADIX_BITS ) ) &
+                ( RADIX_BUCKETS - 1 )]++] = src[i];
+
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if( src != sorted )
+        memcpy( sorted, src, n * sizeof( key_type ) );
+}
+
+#else
+
+static void sort_keys( mem_map *map, key_type *keys, key_type *sorted,
+    key_type *scratch, uint64_t n )
+{
+    uint64_t i;
+    pq_type *q = pq_create( map );
+
+    for( i = 0; i < n; i++ )
+        pq_insert( q, (item_type) i, keys[i] );
+    for( i = 0; i < n; i++ )
+        sorted[i] = pq_delete_min( q );
+
+    pq_destroy( q );
+}
+
+#endif
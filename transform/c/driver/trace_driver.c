@@ -1,9 +1,13 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <stdint.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
 
 #ifdef USE_EAGER
     #include "../memory_management_eager.h"
@@ -18,7 +22,61 @@
 
 #define PQ_MIN_USEC 2000000
 #define CHUNK_SIZE 1000000
+#define PQ_SCRUB_BYTES 0x4000000
 #define MIN(a,b) ( b < a ? b : a )
+#define MAX(a,b) ( b > a ? b : a )
+
+/**
+ * Double-buffered trace reader.  A background thread fills one chunk buffer
+ * while the queue replays the other, so the timed loop never waits on a
+ * synchronous read unless the reader falls behind.  In synchronous mode the
+ * chunks are read in the caller's thread instead, as the driver always used to.
+ */
+typedef struct trace_reader_t
+{
+    int file;
+    //! operations not yet handed to the reader thread
+    uint64_t remaining;
+    //! read in a background thread rather than on demand
+    uint32_t threaded;
+    //! CPUs the reader thread may run on, or NULL to share the caller's
+    cpu_set_t *cpus;
+    //! set if a read failed
+    int status;
+
+    pq_op_blank *buffers[2];
+    uint64_t counts[2];
+    uint32_t filled[2];
+    //! buffer the consumer will take next
+    uint32_t current;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} trace_reader;
+
+static void reader_start( trace_reader *reader, int file, uint64_t op_count );
+static pq_op_blank* reader_acquire( trace_reader *reader, uint64_t *count );
+static void reader_release( trace_reader *reader );
+static void reader_finish( trace_reader *reader );
+static void* reader_main( void *arg );
+static void evict_caches( void );
+static mem_map* create_map( void );
+static void collect_stats( mem_map *map, mm_stats *stats );
+static void report_stats( mm_stats *stats, uint64_t max_elements );
+#ifdef USE_EAGER
+static int profile_trace( const char *trace_path, pq_trace_header *header,
+    pq_op_blank *buffer, pq_trace_profile *profile );
+#endif
+
+static uint8_t *scrub_buffer;
+static uint64_t scrub_bytes = PQ_SCRUB_BYTES;
+static volatile uint64_t scrub_sink;
+static uint32_t zero_nodes = 0;
+static uint32_t ordered_slots = 0;
+static uint32_t prefault_slabs = 0;
+static uint32_t placement = MM_PLACE_DEFAULT;
+static uint32_t placement_node = 0;
 
 #ifdef DUMMY
     // This measures the overhead of processing the input files, which should be
@@ -73,26 +131,32 @@
         #include "../queues/strict_fibonacci_heap.h"
     #elif defined USE_VIOLATION
         #include "../queues/violation_heap.h"
+    #elif defined USE_BUCKET
+        #include "../queues/bucket_queue.h"
+    #elif defined USE_MULTILEVEL_BUCKET
+        #include "../queues/multilevel_bucket_queue.h"
+    #elif defined USE_CALENDAR
+        #include "../queues/calendar_queue.h"
+    #elif defined USE_LADDER
+        #include "../queues/ladder_queue.h"
+    #elif defined USE_TIMING_WHEEL
+        #include "../queues/timing_wheel.h"
     #elif defined USE_KNHEAP
         #include "../queues/knheap.h"
     #endif
 #endif
 
 #ifdef USE_STRICT_FIBONACCI
-    static uint32_t mem_types = 4;
-    static uint32_t mem_sizes[4] =
+    static uint32_t mem_types = 2;
+    static uint32_t mem_sizes[2] =
     {
         sizeof( strict_fibonacci_node ),
-        sizeof( fix_node ),
-        sizeof( active_record ),
-        sizeof( rank_record )
+        sizeof( active_record )
     };
-    static uint32_t mem_capacities[4] =
+    static uint32_t mem_capacities[2] =
     {
         0,
-        100000,
-        1000,
-        1000
+        0
     };
 #else
     static uint32_t mem_types = 1;
@@ -106,6 +170,23 @@
     };
 #endif
 
+#ifdef PQ_HAS_COMPACT
+/**
+ * Old and new addresses of the nodes moved by one round of compaction, in an
+ * open-addressed table keyed by the old address.
+ */
+typedef struct relocation_table_t
+{
+    void **from;
+    void **to;
+    uint64_t mask;
+} relocation_table;
+
+static void relocate_node( void *context, void *from, void *to );
+static void compact_queues( pq_type **pq_index, uint64_t pq_ids,
+    pq_node_type **node_index, uint64_t node_ids );
+#endif
+
 int main( int argc, char** argv )
 {
     uint64_t i;
@@ -129,10 +210,107 @@ int main( int argc, char** argv )
     pq_type *q;//, *r;
     pq_node_type *n;
 
-    if( argc < 2 )
+    // -s reads chunks synchronously
+    // -f evicts caches before each timed chunk
+    // -n N evicts caches every N operations, outside the timed region
+    // -e B sets the size in bytes of the buffer walked to evict caches
+    // -c recreates the memory map on every pass instead of reusing its slabs
+    // -m reports memory usage after the timing
+    // -z zeroes every node on allocation, even for queues that skip it
+    // -a hands out free node slots lowest address first (eager maps only)
+    // -k N compacts every queue every N operations, inside the timed region
+    // -p CPU pins the replaying thread to a CPU; the reader gets the others
+    // -b NODE binds node memory to a NUMA node
+    // -i interleaves node memory across NUMA nodes
+    // -t faults in node slabs up front, keeping page faults out of the timing
+    //    (eager maps only)
+    int opt;
+    uint32_t synchronous = 0;
+    uint32_t flush = 0;
+#ifndef CACHEGRIND
+    uint32_t cold_map = 0;
+#endif
+    uint32_t report_memory = 0;
+    uint64_t evict_interval = 0;
+    uint64_t compact_interval = 0;
+    int32_t pin_cpu = -1;
+    cpu_set_t replay_cpus, reader_cpus;
+    while( ( opt = getopt( argc, argv, "sfn:e:cmzak:p:b:it" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 's':
+                synchronous = 1;
+                break;
+            case 'f':
+                flush = 1;
+                break;
+            case 'n':
+                evict_interval = strtoull( optarg, NULL, 10 );
+                break;
+            case 'e':
+                scrub_bytes = strtoull( optarg, NULL, 10 );
+                break;
+            case 'c':
+#ifdef CACHEGRIND
+                fprintf( stderr, "A single pass has no map to recreate.\n" );
+                exit( -1 );
+#else
+                cold_map = 1;
+#endif
+                break;
+            case 'm':
+                report_memory = 1;
+                break;
+            case 'z':
+                zero_nodes = 1;
+                break;
+            case 'a':
+#ifndef USE_EAGER
+                fprintf( stderr, "Ordered free slots need the eager map.\n" );
+                exit( -1 );
+#endif
+                ordered_slots = 1;
+                break;
+            case 'k':
+#ifndef PQ_HAS_COMPACT
+                fprintf( stderr, "Queue cannot compact its nodes.\n" );
+                exit( -1 );
+#endif
+                compact_interval = strtoull( optarg, NULL, 10 );
+                break;
+            case 'p':
+                pin_cpu = atoi( optarg );
+                break;
+            case 'b':
+                placement = MM_PLACE_BIND;
+                placement_node = atoi( optarg );
+                break;
+            case 'i':
+                placement = MM_PLACE_INTERLEAVE;
+                break;
+            case 't':
+#ifndef USE_EAGER
+                fprintf( stderr, "Prefaulting needs the eager map.\n" );
+                exit( -1 );
+#endif
+                prefault_slabs = 1;
+                break;
+            default:
+                exit( -1 );
+        }
+    }
+    if( evict_interval > 0 )
+        flush = 1;
+
+    if( optind >= argc )
         exit( -1 );
+    char *trace_path = argv[optind];
+#ifdef CACHEGRIND
+    uint32_t print_keys = ( optind + 1 < argc );
+#endif
 
-    int trace_file = open( argv[1], O_RDONLY );
+    int trace_file = open( trace_path, O_RDONLY );
     if( trace_file < 0 )
     {
         fprintf( stderr, "Could not open file.\n" );
@@ -140,37 +318,122 @@ int main( int argc, char** argv )
     }
 
     pq_trace_header header;
-    pq_trace_read_header( trace_file, &header );
+    if( pq_trace_read_header( trace_file, &header ) != 0 )
+    {
+        fprintf( stderr, "Not a trace of the current format.\n" );
+        return -1;
+    }
     close( trace_file );
 
+    // the queue's ordering is fixed at compile time, so a trace written for
+    // the other ordering would replay a different delete-min sequence
+#ifdef USE_MAX_ORDER
+    if( !( header.flags & PQ_TRACE_MAX_ORDER ) )
+#else
+    if( header.flags & PQ_TRACE_MAX_ORDER )
+#endif
+    {
+        fprintf( stderr, "Trace ordering does not match the queue.\n" );
+        return -1;
+    }
+
     //printf("Header: (%llu,%lu,%lu)\n",header.op_count,header.pq_ids,
     //    header.node_ids);
 
-    pq_op_blank *ops = (pq_op_blank *)calloc( MIN( header.op_count, CHUNK_SIZE ),
-        sizeof( pq_op_blank ) );
+    trace_reader reader;
+    reader.threaded = !synchronous;
+    reader.cpus = NULL;
+
+    // pin before the map is created, so that its slabs are first touched
+    // from the chosen CPU
+    if( pin_cpu >= 0 )
+    {
+        sched_getaffinity( 0, sizeof( cpu_set_t ), &reader_cpus );
+        CPU_ZERO( &replay_cpus );
+        CPU_SET( pin_cpu, &replay_cpus );
+        if( pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ),
+                &replay_cpus ) != 0 )
+        {
+            fprintf( stderr, "Could not pin to CPU.\n" );
+            return -1;
+        }
+        CPU_CLR( pin_cpu, &reader_cpus );
+        if( CPU_COUNT( &reader_cpus ) > 0 )
+            reader.cpus = &reader_cpus;
+    }
+    reader.buffers[0] = (pq_op_blank *)calloc( MIN( header.op_count,
+        CHUNK_SIZE ), sizeof( pq_op_blank ) );
+    reader.buffers[1] = (pq_op_blank *)calloc( MIN( header.op_count,
+        CHUNK_SIZE ), sizeof( pq_op_blank ) );
+    if( flush )
+    {
+        scrub_buffer = (uint8_t *)malloc( scrub_bytes + 1 );
+        // untouched pages all map to the shared zero page and evict nothing,
+        // so give every page of the buffer a frame of its own
+        if( scrub_buffer != NULL )
+            memset( scrub_buffer, 1, scrub_bytes + 1 );
+    }
+    pthread_mutex_init( &reader.lock, NULL );
+    pthread_cond_init( &reader.cond, NULL );
+
+    pq_op_blank *ops;
     pq_type **pq_index = (pq_type **)calloc( header.pq_ids, sizeof( pq_type* ) );
     pq_node_type **node_index = (pq_node_type **)calloc( header.node_ids,
         sizeof( pq_node_type* ) );
-    if( ops == NULL || pq_index == NULL || node_index == NULL )
+    if( reader.buffers[0] == NULL || reader.buffers[1] == NULL ||
+        ( flush && scrub_buffer == NULL ) || pq_index == NULL ||
+        node_index == NULL )
     {
         fprintf( stderr, "Calloc fail.\n" );
         return -1;
     }
 
-#ifdef USE_QUAKE
-    mem_capacities[0] = header.node_ids << 2;
-#else
-    mem_capacities[0] = header.node_ids;
+    // size the eager pools for the most elements live in a queue at once, if
+    // trace_stats -p has profiled the trace, rather than for every element
+    // ever inserted
+    pq_trace_profile profile;
+    uint32_t pool_elements = header.node_ids;
+    uint32_t profiled =
+        ( pq_trace_read_profile( trace_path, &header, &profile ) == 0 );
+#ifdef USE_EAGER
+    // every queue's arena gets a full pool, so one per element of the trace
+    // would reserve far more than it ever holds once there are many queues;
+    // profile the trace here instead, outside the timed region
+    if( !profiled && header.pq_ids > 1 )
+    {
+        if( profile_trace( trace_path, &header, reader.buffers[0],
+                &profile ) != 0 )
+        {
+            fprintf( stderr, "Could not profile trace.\n" );
+            return -1;
+        }
+        profiled = 1;
+    }
 #endif
+    if( profiled )
+        pool_elements = profile.peak_queue;
 
-#ifdef USE_EAGER
-    mem_map *map = mm_create( mem_types, mem_sizes, mem_capacities );
-#else
-    mem_map *map = mm_create( mem_types, mem_sizes );
+    mem_capacities[0] = pool_elements;
+#ifdef USE_STRICT_FIBONACCI
+    // every active record in use is held by a node, and one more may be made
+    // before an old one is released
+    mem_capacities[1] = pool_elements + 1;
 #endif
 
-    uint64_t op_remaining, op_chunk;
-    int status;
+    mem_map *map = create_map();
+    mm_stats stats[2];
+    memset( stats, 0, sizeof( stats ) );
+    // -m profiles the first pass itself if trace_stats -p has not
+    uint32_t *pq_sizes = NULL;
+    uint32_t live_total = 0;
+    if( report_memory && !profiled )
+    {
+        memset( &profile, 0, sizeof( pq_trace_profile ) );
+        pq_sizes = calloc( header.pq_ids, sizeof( uint32_t ) );
+    }
+
+    uint64_t op_remaining, op_chunk, op_segment;
+    uint64_t since_compact = 0;
     struct timeval t0, t1;
     uint32_t iterations = 0;
     uint32_t total_time = 0;
@@ -180,149 +443,196 @@ int main( int argc, char** argv )
 #ifndef CACHEGRIND
     while( iterations < 5 || total_time < PQ_MIN_USEC )
     {
-        mm_clear( map );
+        // queues the last pass left behind hold arenas of the map
+        for( i = 0; i < header.pq_ids; i++ )
+        {
+            if( pq_index[i] != NULL )
+                pq_destroy( pq_index[i] );
+            pq_index[i] = NULL;
+        }
+
+        if( cold_map )
+        {
+            collect_stats( map, stats );
+            mm_destroy( map );
+            map = create_map();
+        }
+        else
+            mm_clear( map );
         iterations++;
 #endif
 
-        trace_file = open( argv[1], O_RDONLY );
+        trace_file = open( trace_path, O_RDONLY );
         if( trace_file < 0 )
         {
             fprintf( stderr, "Could not open file.\n" );
             return -1;
         }
-        pq_trace_read_header( trace_file, &header );
+        if( pq_trace_read_header( trace_file, &header ) != 0 )
+        {
+            fprintf( stderr, "Not a trace of the current format.\n" );
+            return -1;
+        }
         op_remaining = header.op_count;
+        since_compact = 0;
+        reader_start( &reader, trace_file, op_remaining );
 
         while( op_remaining > 0 )
         {
-            op_chunk = MIN( CHUNK_SIZE, op_remaining );
+            ops = reader_acquire( &reader, &op_chunk );
+            if( ops == NULL )
+            {
+                fprintf( stderr, "Invalid operation!" );
+                return -1;
+            }
             op_remaining -= op_chunk;
 
-            for( i = 0; i < op_chunk; i++ )
+            // count live elements outside the timed region
+            if( pq_sizes != NULL && iterations <= 1 )
+                pq_trace_profile_ops( &profile, pq_sizes, &live_total, ops,
+                    op_chunk );
+
+            // with -n the chunk is split into segments, each timed separately
+            // after a cache eviction; otherwise the segment is the whole chunk.
+            // With -k segments also end where the queues are due a compaction.
+            for( i = 0; i < op_chunk; )
             {
-                status = pq_trace_read_op( trace_file, ops + i );
-                if( status == -1 )
-                {
-                    fprintf( stderr, "Invalid operation!" );
-                    return -1;
-                }
-            }
+                op_segment = evict_interval > 0 ?
+                    MIN( op_chunk, i + evict_interval ) : op_chunk;
+                if( compact_interval > 0 )
+                    op_segment = MIN( op_segment,
+                        i + compact_interval - since_compact );
+                since_compact += op_segment - i;
+                if( flush )
+                    evict_caches();
 
 #ifndef CACHEGRIND
-            gettimeofday(&t0, NULL);
+                gettimeofday(&t0, NULL);
 #endif
 
-            for( i = 0; i < op_chunk; i++ )
-            {
-                switch( ops[i].code )
+                for( ; i < op_segment; i++ )
                 {
-                    case PQ_OP_CREATE:
-                        op_create = (pq_op_create*) ( ops + i );
-                        //printf("pq_create(%d)\n", op_create->pq_id);
-                        pq_index[op_create->pq_id] = pq_create( map );
-                        break;
-                    case PQ_OP_DESTROY:
-                        op_destroy = (pq_op_destroy*) ( ops + i );
-                        //printf("pq_destroy(%d)\n", op_destroy->pq_id);
-                        q = pq_index[op_destroy->pq_id];
-                        pq_destroy( q );
-                        pq_index[op_destroy->pq_id] = NULL;
-                        break;
-                    case PQ_OP_CLEAR:
-                        op_clear = (pq_op_clear*) ( ops + i );
-                        //printf("pq_clear(%d)\n", op_clear->pq_id );
-                        q = pq_index[op_clear->pq_id];
-                        pq_clear( q );
-                        break;
-                    case PQ_OP_GET_KEY:
-                        op_get_key = (pq_op_get_key*) ( ops + i );
-                        //printf("pq_get_key(%d,%d)\n", op_get_key->pq_id,
-                        //    op_get_key->node_id );
-                        q = pq_index[op_get_key->pq_id];
-                        n = node_index[op_get_key->node_id];
-                        pq_get_key( q, n );
-                        break;
-                    case PQ_OP_GET_ITEM:
-                        op_get_item = (pq_op_get_item*) ( ops + i );
-                        //printf("pq_get_item(%d,%d)\n", op_get_item->pq_id,
-                        //    op_get_item->node_id);
-                        q = pq_index[op_get_item->pq_id];
-                        n = node_index[op_get_item->node_id];
-                        pq_get_item( q, n );
-                        break;
-                    case PQ_OP_GET_SIZE:
-                        op_get_size = (pq_op_get_size*) ( ops + i );
-                        //printf("pq_get_size(%d)\n", op_get_size->pq_id);
-                        q = pq_index[op_get_size->pq_id];
-                        pq_get_size( q );
-                        break;
-                    case PQ_OP_INSERT:
-                        op_insert = (pq_op_insert*) ( ops + i );
-                        //printf("pq_insert(%d,%d,%llu,%d)\n", op_insert->pq_id,
-                        //    op_insert->node_id, op_insert->key, op_insert->item );
-                        q = pq_index[op_insert->pq_id];
-                        node_index[op_insert->node_id] = pq_insert( q,
-                            op_insert->item, op_insert->key );
-                        break;
-                    case PQ_OP_FIND_MIN:
-                        op_find_min = (pq_op_find_min*) ( ops + i );
-                        //printf("pq_find_min(%d)\n", op_find_min->pq_id );
-                        q = pq_index[op_find_min->pq_id];
-                        pq_find_min( q );
-                        break;
-                    case PQ_OP_DELETE:
-                        op_delete = (pq_op_delete*) ( ops + i );
-                        //printf("pq_delete(%d,%d)\n", op_delete->pq_id,
-                        //    op_delete->node_id );
-                        q = pq_index[op_delete->pq_id];
-                        n = node_index[op_delete->node_id];
-                        pq_delete( q, n );
-                        break;
-                    case PQ_OP_DELETE_MIN:
-                        op_delete_min = (pq_op_delete_min*) ( ops + i );
-                        //printf("pq_delete_min(%d)\n", op_delete_min->pq_id);
-                        q = pq_index[op_delete_min->pq_id];
-                        //min = pq_find_min( q );
-                        k = pq_delete_min( q );
+                    switch( ops[i].code )
+                    {
+                        case PQ_OP_CREATE:
+                            op_create = (pq_op_create*) ( ops + i );
+                            //printf("pq_create(%d)\n", op_create->pq_id);
+                            pq_index[op_create->pq_id] = pq_create( map );
+                            break;
+                        case PQ_OP_DESTROY:
+                            op_destroy = (pq_op_destroy*) ( ops + i );
+                            //printf("pq_destroy(%d)\n", op_destroy->pq_id);
+                            q = pq_index[op_destroy->pq_id];
+                            pq_destroy( q );
+                            pq_index[op_destroy->pq_id] = NULL;
+                            break;
+                        case PQ_OP_CLEAR:
+                            op_clear = (pq_op_clear*) ( ops + i );
+                            //printf("pq_clear(%d)\n", op_clear->pq_id );
+                            q = pq_index[op_clear->pq_id];
+                            pq_clear( q );
+                            break;
+                        case PQ_OP_GET_KEY:
+                            op_get_key = (pq_op_get_key*) ( ops + i );
+                            //printf("pq_get_key(%d,%d)\n", op_get_key->pq_id,
+                            //    op_get_key->node_id );
+                            q = pq_index[op_get_key->pq_id];
+                            n = node_index[op_get_key->node_id];
+                            pq_get_key( q, n );
+                            break;
+                        case PQ_OP_GET_ITEM:
+                            op_get_item = (pq_op_get_item*) ( ops + i );
+                            //printf("pq_get_item(%d,%d)\n", op_get_item->pq_id,
+                            //    op_get_item->node_id);
+                            q = pq_index[op_get_item->pq_id];
+                            n = node_index[op_get_item->node_id];
+                            pq_get_item( q, n );
+                            break;
+                        case PQ_OP_GET_SIZE:
+                            op_get_size = (pq_op_get_size*) ( ops + i );
+                            //printf("pq_get_size(%d)\n", op_get_size->pq_id);
+                            q = pq_index[op_get_size->pq_id];
+                            pq_get_size( q );
+                            break;
+                        case PQ_OP_INSERT:
+                            op_insert = (pq_op_insert*) ( ops + i );
+                            //printf("pq_insert(%d,%d,%llu,%d)\n", op_insert->pq_id,
+                            //    op_insert->node_id, op_insert->key, op_insert->item );
+                            q = pq_index[op_insert->pq_id];
+                            node_index[op_insert->node_id] = pq_insert( q,
+                                op_insert->item, op_insert->key );
+                            break;
+                        case PQ_OP_FIND_MIN:
+                            op_find_min = (pq_op_find_min*) ( ops + i );
+                            //printf("pq_find_min(%d)\n", op_find_min->pq_id );
+                            q = pq_index[op_find_min->pq_id];
+                            pq_find_min( q );
+                            break;
+                        case PQ_OP_DELETE:
+                            op_delete = (pq_op_delete*) ( ops + i );
+                            //printf("pq_delete(%d,%d)\n", op_delete->pq_id,
+                            //    op_delete->node_id );
+                            q = pq_index[op_delete->pq_id];
+                            n = node_index[op_delete->node_id];
+                            pq_delete( q, n );
+                            break;
+                        case PQ_OP_DELETE_MIN:
+                            op_delete_min = (pq_op_delete_min*) ( ops + i );
+                            //printf("pq_delete_min(%d)\n", op_delete_min->pq_id);
+                            q = pq_index[op_delete_min->pq_id];
+                            //min = pq_find_min( q );
+                            k = pq_delete_min( q );
 #ifdef CACHEGRIND
-                        if( argc > 2 )
-                            printf("%llu\n",k);
+                            if( print_keys )
+                                printf("%llu\n",k);
 #endif
-                        break;
-                    case PQ_OP_DECREASE_KEY:
-                        op_decrease_key = (pq_op_decrease_key*) ( ops + i );
-                        //printf("pq_decrease_key(%d,%d,%llu)\n", op_decrease_key->pq_id,
-                        //    op_decrease_key->node_id, op_decrease_key->key);
-                        q = pq_index[op_decrease_key->pq_id];
-                        n = node_index[op_decrease_key->node_id];
-                        pq_decrease_key( q, n, op_decrease_key->key );
-                        break;
-                    /*case PQ_OP_MELD:
-                        printf("Meld.\n");
-                        op_meld = (pq_op_meld*) ( ops + i );
-                        q = pq_index[op_meld->pq_src1_id];
-                        r = pq_index[op_meld->pq_src2_id];
-                        pq_index[op_meld->pq_dst_id] = pq_meld( q, r );
-                        break;*/
-                    case PQ_OP_EMPTY:
-                        op_empty = (pq_op_empty*) ( ops + i );
-                        //printf("pq_empty(%d)\n", op_empty->pq_id);
-                        q = pq_index[op_empty->pq_id];
-                        pq_empty( q );
-                        break;
-                    default:
-                        break;
+                            break;
+                        case PQ_OP_DECREASE_KEY:
+                            op_decrease_key = (pq_op_decrease_key*) ( ops + i );
+                            //printf("pq_decrease_key(%d,%d,%llu)\n", op_decrease_key->pq_id,
+                            //    op_decrease_key->node_id, op_decrease_key->key);
+                            q = pq_index[op_decrease_key->pq_id];
+                            n = node_index[op_decrease_key->node_id];
+                            pq_decrease_key( q, n, op_decrease_key->key );
+                            break;
+                        /*case PQ_OP_MELD:
+                            printf("Meld.\n");
+                            op_meld = (pq_op_meld*) ( ops + i );
+                            q = pq_index[op_meld->pq_src1_id];
+                            r = pq_index[op_meld->pq_src2_id];
+                            pq_index[op_meld->pq_dst_id] = pq_meld( q, r );
+                            break;*/
+                        case PQ_OP_EMPTY:
+                            op_empty = (pq_op_empty*) ( ops + i );
+                            //printf("pq_empty(%d)\n", op_empty->pq_id);
+                            q = pq_index[op_empty->pq_id];
+                            pq_empty( q );
+                            break;
+                        default:
+                            break;
+                    }
+                    //verify_queue( pq_index[0], header.node_ids );
                 }
-                //verify_queue( pq_index[0], header.node_ids );
-            }
+
+#ifdef PQ_HAS_COMPACT
+                if( since_compact == compact_interval && compact_interval > 0 )
+                {
+                    compact_queues( pq_index, header.pq_ids, node_index,
+                        header.node_ids );
+                    since_compact = 0;
+                }
+#endif
 
 #ifndef CACHEGRIND
-            gettimeofday(&t1, NULL);
-            total_time += (t1.tv_sec - t0.tv_sec) * 1000000 +
-                (t1.tv_usec - t0.tv_usec);
+                gettimeofday(&t1, NULL);
+                total_time += (t1.tv_sec - t0.tv_sec) * 1000000 +
+                    (t1.tv_usec - t0.tv_usec);
 #endif
+            }
+            reader_release( &reader );
         }
 
+        reader_finish( &reader );
         close( trace_file );
 #ifndef CACHEGRIND
     }
@@ -334,14 +644,403 @@ int main( int argc, char** argv )
             pq_destroy( pq_index[i] );
     }
 
+    collect_stats( map, stats );
     mm_destroy( map );
     free( pq_index );
     free( node_index );
-    free( ops );
+    free( pq_sizes );
+    free( reader.buffers[0] );
+    free( reader.buffers[1] );
+    free( scrub_buffer );
+    pthread_mutex_destroy( &reader.lock );
+    pthread_cond_destroy( &reader.cond );
 
 #ifndef CACHEGRIND
     printf( "%d\n", total_time / iterations );
 #endif
+    if( report_memory )
+        report_stats( stats, profile.peak_total );
 
     return 0;
 }
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Prepares the reader for a pass over the trace and, in threaded mode, starts
+ * the background thread.  The file must already be positioned past the header.
+ *
+ * @param reader    Reader to start
+ * @param file      Trace file to read from
+ * @param op_count  Number of operations to read
+ */
+static void reader_start( trace_reader *reader, int file, uint64_t op_count )
+{
+    pthread_attr_t attributes;
+
+    reader->file = file;
+    reader->remaining = op_count;
+    reader->status = 0;
+    reader->current = 0;
+    reader->filled[0] = 0;
+    reader->filled[1] = 0;
+
+    if( reader->threaded )
+    {
+        pthread_attr_init( &attributes );
+        if( reader->cpus != NULL )
+            pthread_attr_setaffinity_np( &attributes, sizeof( cpu_set_t ),
+                reader->cpus );
+        pthread_create( &reader->thread, &attributes, reader_main, reader );
+        pthread_attr_destroy( &attributes );
+    }
+}
+
+/**
+ * Hands the next filled chunk to the consumer, blocking until the reader
+ * thread has finished it.  The chunk remains valid until the matching
+ * @ref <reader_release>.
+ *
+ * @param reader    Reader to take the chunk from
+ * @param count     Set to the number of operations in the chunk
+ * @return          Chunk of operations, or NULL if the read failed
+ */
+static pq_op_blank* reader_acquire( trace_reader *reader, uint64_t *count )
+{
+    uint32_t b = reader->current;
+
+    if( !reader->threaded )
+    {
+        *count = MIN( CHUNK_SIZE, reader->remaining );
+        reader->remaining -= *count;
+        if( pq_trace_read_ops( reader->file, reader->buffers[b], *count ) )
+            return NULL;
+        return reader->buffers[b];
+    }
+
+    pthread_mutex_lock( &reader->lock );
+    while( !reader->filled[b] && reader->status == 0 )
+        pthread_cond_wait( &reader->cond, &reader->lock );
+    pthread_mutex_unlock( &reader->lock );
+
+    if( !reader->filled[b] )
+        return NULL;
+
+    *count = reader->counts[b];
+    return reader->buffers[b];
+}
+
+/**
+ * Returns the current chunk to the reader so it can be refilled.
+ *
+ * @param reader    Reader to return the chunk to
+ */
+static void reader_release( trace_reader *reader )
+{
+    uint32_t b = reader->current;
+    reader->current = b ^ 1;
+
+    if( !reader->threaded )
+        return;
+
+    pthread_mutex_lock( &reader->lock );
+    reader->filled[b] = 0;
+    pthread_cond_signal( &reader->cond );
+    pthread_mutex_unlock( &reader->lock );
+}
+
+/**
+ * Waits for the reader thread to exit at the end of a pass.
+ *
+ * @param reader    Reader to finish
+ */
+static void reader_finish( trace_reader *reader )
+{
+    if( reader->threaded )
+        pthread_join( reader->thread, NULL );
+}
+
+/**
+ * Reader thread body.  Alternates between the two buffers, waiting for the
+ * consumer to release each one before refilling it.
+ *
+ * @param arg   Reader to fill
+ * @return      Always NULL
+ */
+static void* reader_main( void *arg )
+{
+    trace_reader *reader = (trace_reader *) arg;
+    uint32_t b = 0;
+    uint64_t count;
+    int status;
+
+    while( reader->remaining > 0 )
+    {
+        pthread_mutex_lock( &reader->lock );
+        while( reader->filled[b] )
+            pthread_cond_wait( &reader->cond, &reader->lock );
+        pthread_mutex_unlock( &reader->lock );
+
+        count = MIN( CHUNK_SIZE, reader->remaining );
+        reader->remaining -= count;
+        status = pq_trace_read_ops( reader->file, reader->buffers[b], count );
+
+        pthread_mutex_lock( &reader->lock );
+        if( status == -1 )
+        {
+            reader->status = -1;
+            pthread_cond_signal( &reader->cond );
+            pthread_mutex_unlock( &reader->lock );
+            break;
+        }
+        reader->counts[b] = count;
+        reader->filled[b] = 1;
+        pthread_cond_signal( &reader->cond );
+        pthread_mutex_unlock( &reader->lock );
+
+        b ^= 1;
+    }
+
+    return NULL;
+}
+
+/**
+ * Walks a buffer larger than the last-level cache so that neither the reader's
+ * leftovers nor earlier queue state are resident when timing starts.  The
+ * buffer size defaults to 64MB and can be set with -e.
+ */
+static void evict_caches( void )
+{
+    uint64_t i;
+    uint64_t sum = 0;
+
+    // reads only, so the timed region does not pay for writing back dirty
+    // scrub lines; the buffer was written once when allocated, so its pages
+    // are real frames rather than the shared zero page
+    for( i = 0; i < scrub_bytes; i += 64 )
+        sum += scrub_buffer[i];
+    scrub_sink = sum;
+}
+
+/**
+ * Creates a memory map sized for the current trace.  Called once up front,
+ * and again on every pass when the map is recreated to start from cold slabs.
+ *
+ * @return  New memory map
+ */
+static mem_map* create_map( void )
+{
+#ifdef USE_EAGER
+    mem_map *map = mm_create( mem_types, mem_sizes, mem_capacities );
+#else
+    mem_map *map = mm_create( mem_types, mem_sizes );
+#endif
+    map->zero_all = zero_nodes;
+#ifdef USE_EAGER
+    if( ordered_slots )
+        mm_order_free_slots( map );
+#endif
+    if( placement != MM_PLACE_DEFAULT &&
+            mm_set_placement( map, placement, placement_node ) != 0 )
+    {
+        fprintf( stderr, "Could not place node memory.\n" );
+        exit( -1 );
+    }
+#ifdef USE_EAGER
+    if( prefault_slabs )
+        mm_prefault( map );
+#endif
+
+    return map;
+}
+
+/**
+ * Folds the map's per-type usage into the running maxima kept across passes.
+ *
+ * @param map   Map to query
+ * @param stats Per-type maxima to update
+ */
+static void collect_stats( mem_map *map, mm_stats *stats )
+{
+    uint32_t t;
+    mm_stats current;
+
+    for( t = 0; t < mem_types; t++ )
+    {
+        mm_get_stats( map, t, &current );
+        stats[t].live_bytes = current.live_bytes;
+        stats[t].peak_bytes = MAX( stats[t].peak_bytes, current.peak_bytes );
+        stats[t].reserved_bytes = MAX( stats[t].reserved_bytes,
+            current.reserved_bytes );
+        stats[t].slabs = MAX( stats[t].slabs, current.slabs );
+    }
+}
+
+/**
+ * Prints memory usage in the same "name: value" form as trace_stats, one line
+ * per node type followed by the totals.  Fragmentation is the share of
+ * reserved node storage that was never in use at the peak.
+ *
+ * @param stats         Per-type maxima
+ * @param max_elements  Most elements held by all queues at once
+ */
+static void report_stats( mm_stats *stats, uint64_t max_elements )
+{
+    uint32_t t;
+    uint64_t peak = 0;
+    uint64_t reserved = 0;
+    uint64_t slabs = 0;
+    uint64_t nodes = 0;
+    struct rusage usage;
+
+    for( t = 0; t < mem_types; t++ )
+    {
+        printf( "mem_type_%u: size=%u peak=%llu reserved=%llu slabs=%u "
+            "fragmentation=%f\n", t, mem_sizes[t],
+            (unsigned long long) stats[t].peak_bytes,
+            (unsigned long long) stats[t].reserved_bytes, stats[t].slabs,
+            stats[t].reserved_bytes == 0 ? 0.0 :
+            1.0 - ( (double) stats[t].peak_bytes ) / stats[t].reserved_bytes );
+        peak += stats[t].peak_bytes;
+        nodes += stats[t].peak_bytes / mem_sizes[t];
+        reserved += stats[t].reserved_bytes;
+        slabs += stats[t].slabs;
+    }
+
+    getrusage( RUSAGE_SELF, &usage );
+    printf( "peak_rss_kb: %ld\n", usage.ru_maxrss );
+    printf( "peak_bytes: %llu\n", (unsigned long long) peak );
+    printf( "reserved_bytes: %llu\n", (unsigned long long) reserved );
+    printf( "slabs: %llu\n", (unsigned long long) slabs );
+    printf( "fragmentation: %f\n", reserved == 0 ? 0.0 :
+        1.0 - ( (double) peak ) / reserved );
+    printf( "max_elements: %llu\n", (unsigned long long) max_elements );
+    printf( "bytes_per_element: %f\n", max_elements == 0 ? 0.0 :
+        ( (double) peak ) / max_elements );
+    printf( "nodes_per_element: %f\n", max_elements == 0 ? 0.0 :
+        ( (double) nodes ) / max_elements );
+}
+
+#ifdef USE_EAGER
+/**
+ * Profiles a trace in a pass of its own, as trace_stats -p would, for when
+ * there is no side-car profile to size the pools from.
+ *
+ * @param trace_path    Path of the trace
+ * @param header        Header read from the trace
+ * @param buffer        Room for a chunk of operations
+ * @param profile       Address of struct to write the profile to
+ * @return              0 on success, -1 on error
+ */
+static int profile_trace( const char *trace_path, pq_trace_header *header,
+    pq_op_blank *buffer, pq_trace_profile *profile )
+{
+    uint64_t op_remaining = header->op_count;
+    uint64_t op_chunk;
+    uint32_t live_total = 0;
+    pq_trace_header file_header;
+    int status = 0;
+
+    uint32_t *pq_sizes = calloc( header->pq_ids, sizeof( uint32_t ) );
+    int trace_file = open( trace_path, O_RDONLY );
+    if( pq_sizes == NULL || trace_file < 0 ||
+            pq_trace_read_header( trace_file, &file_header ) != 0 )
+        status = -1;
+
+    memset( profile, 0, sizeof( pq_trace_profile ) );
+    profile->op_count = header->op_count;
+    profile->node_ids = header->node_ids;
+
+    while( status == 0 && op_remaining > 0 )
+    {
+        op_chunk = MIN( CHUNK_SIZE, op_remaining );
+        op_remaining -= op_chunk;
+        status = pq_trace_read_ops( trace_file, buffer, op_chunk );
+        if( status == 0 )
+            pq_trace_profile_ops( profile, pq_sizes, &live_total, buffer,
+                op_chunk );
+    }
+
+    if( trace_file >= 0 )
+        close( trace_file );
+    free( pq_sizes );
+
+    return status;
+}
+#endif
+
+#ifdef PQ_HAS_COMPACT
+/**
+ * Records a node moved by compaction.  The table has room to spare, so there
+ * is always an empty slot.
+ *
+ * @param context   Relocation table
+ * @param from      Old address of the node
+ * @param to        New address of the node
+ */
+static void relocate_node( void *context, void *from, void *to )
+{
+    relocation_table *table = (relocation_table*) context;
+    uint64_t slot = ( (uintptr_t) from >> 3 ) & table->mask;
+
+    while( table->from[slot] != NULL )
+        slot = ( slot + 1 ) & table->mask;
+    table->from[slot] = from;
+    table->to[slot] = to;
+}
+
+/**
+ * Compacts every live queue, then points the node handles at the moved nodes.
+ * The trace refers to nodes by id, not by item, so the handles are fixed up
+ * in a pass over the whole index.  Handles of deleted nodes may be moved
+ * along with a live node that took over their slot; they are never used
+ * before being set again.
+ *
+ * @param pq_index      Queues by id
+ * @param pq_ids        Number of queue ids
+ * @param node_index    Node handles by id
+ * @param node_ids      Number of node ids
+ */
+static void compact_queues( pq_type **pq_index, uint64_t pq_ids,
+    pq_node_type **node_index, uint64_t node_ids )
+{
+    uint64_t i, slot;
+    uint64_t nodes = 0;
+    relocation_table table;
+
+    for( i = 0; i < pq_ids; i++ )
+    {
+        if( pq_index[i] != NULL )
+            nodes += pq_get_size( pq_index[i] );
+    }
+    if( nodes == 0 )
+        return;
+
+    for( table.mask = 1; table.mask < 2 * nodes; table.mask <<= 1 );
+    table.from = calloc( table.mask, sizeof( void* ) );
+    table.to = malloc( table.mask * sizeof( void* ) );
+    table.mask--;
+
+    for( i = 0; i < pq_ids; i++ )
+    {
+        if( pq_index[i] != NULL )
+            pq_compact( pq_index[i], relocate_node, &table );
+    }
+
+    for( i = 0; i < node_ids; i++ )
+    {
+        if( node_index[i] == NULL )
+            continue;
+        slot = ( (uintptr_t) node_index[i] >> 3 ) & table.mask;
+        while( table.from[slot] != NULL && table.from[slot] != node_index[i] )
+            slot = ( slot + 1 ) & table.mask;
+        if( table.from[slot] != NULL )
+            node_index[i] = table.to[slot];
+    }
+
+    free( table.from );
+    free( table.to );
+}
+#endif
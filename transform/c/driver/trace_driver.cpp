@@ -77,19 +77,15 @@
 #endif
 
 #ifdef USE_STRICT_FIBONACCI
-    static uint32_t mem_types = 4;
-    static uint32_t mem_sizes[4] =
+    static uint32_t mem_types = 2;
+    static uint32_t mem_sizes[2] =
     {
         sizeof( strict_fibonacci_node ),
-        sizeof( fix_node ),
-        sizeof( active_record ),
-        sizeof( rank_record )
+        sizeof( active_record )
     };
-    static uint32_t mem_capacities[4] =
+    static uint32_t mem_capacities[2] =
     {
         0,
-        100000,
-        1000,
         1000
     };
 #else
@@ -138,9 +134,19 @@ int main( int argc, char** argv )
     }
 
     pq_trace_header header;
-    pq_trace_read_header( trace_file, &header );
+    if( pq_trace_read_header( trace_file, &header ) != 0 )
+    {
+        fprintf( stderr, "Not a trace of the current format.\n" );
+        return -1;
+    }
     close( trace_file );
 
+    if( header.flags & PQ_TRACE_MAX_ORDER )
+    {
+        fprintf( stderr, "Trace ordering does not match the queue.\n" );
+        return -1;
+    }
+
     //printf("Header: (%llu,%lu,%lu)\n",header.op_count,header.pq_ids,
     //    header.node_ids);
 
@@ -155,11 +161,7 @@ int main( int argc, char** argv )
         return -1;
     }
 
-#ifdef USE_QUAKE
-    mem_capacities[0] = header.node_ids << 2;
-#else
     mem_capacities[0] = header.node_ids;
-#endif
 
 #ifdef USE_EAGER
     mem_map *map = mm_create( mem_types, mem_sizes, mem_capacities );
@@ -188,7 +190,11 @@ int main( int argc, char** argv )
             fprintf( stderr, "Could not open file.\n" );
             return -1;
         }
-        pq_trace_read_header( trace_file, &header );
+        if( pq_trace_read_header( trace_file, &header ) != 0 )
+        {
+            fprintf( stderr, "Not a trace of the current format.\n" );
+            return -1;
+        }
         op_remaining = header.op_count;
 
         while( op_remaining > 0 )
@@ -76,19 +76,15 @@
 #endif
 
 #ifdef USE_STRICT_FIBONACCI
-    static uint32_t mem_types = 4;
-    static uint32_t mem_sizes[4] =
+    static uint32_t mem_types = 2;
+    static uint32_t mem_sizes[2] =
     {
         sizeof( strict_fibonacci_node ),
-        sizeof( fix_node ),
-        sizeof( active_record ),
-        sizeof( rank_record )
+        sizeof( active_record )
     };
-    static uint32_t mem_capacities[4] =
+    static uint32_t mem_capacities[2] =
     {
         0,
-        1000,
-        1000,
         1000
     };
 #else
@@ -121,10 +117,26 @@ int main( int argc, char** argv )
     uint64_t count_decrease_key = 0;
     uint64_t count_empty = 0;
 
-    if( argc < 2 )
+    // -p also writes the trace's profile, which the drivers size pools from
+    int opt;
+    uint32_t write_profile = 0;
+    while( ( opt = getopt( argc, argv, "p" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'p':
+                write_profile = 1;
+                break;
+            default:
+                exit( -1 );
+        }
+    }
+
+    if( optind >= argc )
         exit( -1 );
+    char *trace_path = argv[optind];
 
-    int trace_file = open( argv[1], O_RDONLY );
+    int trace_file = open( trace_path, O_RDONLY );
     if( trace_file < 0 )
     {
         fprintf( stderr, "Could not open file.\n" );
@@ -132,7 +144,11 @@ int main( int argc, char** argv )
     }
 
     pq_trace_header header;
-    pq_trace_read_header( trace_file, &header );
+    if( pq_trace_read_header( trace_file, &header ) != 0 )
+    {
+        fprintf( stderr, "Not a trace of the current format.\n" );
+        return -1;
+    }
 
     //printf("Header: (%llu,%lu,%lu)\n",header.op_count,header.pq_ids,
     //    header.node_ids);
@@ -141,17 +157,15 @@ int main( int argc, char** argv )
     pq_type **pq_index = calloc( header.pq_ids, sizeof( pq_type* ) );
     pq_node_type **node_index = calloc( header.node_ids,
         sizeof( pq_node_type* ) );
-    if( ops == NULL || pq_index == NULL || node_index == NULL )
+    uint32_t *pq_sizes = calloc( header.pq_ids, sizeof( uint32_t ) );
+    if( ops == NULL || pq_index == NULL || node_index == NULL ||
+        pq_sizes == NULL )
     {
         fprintf( stderr, "Calloc fail.\n" );
         return -1;
     }
 
-#ifdef USE_QUAKE
-    mem_capacities[0] = header.node_ids << 2;
-#else
     mem_capacities[0] = header.node_ids;
-#endif
 #ifdef USE_EAGER
     mem_map *map = mm_create( mem_types, mem_sizes, mem_capacities );
 #else
@@ -164,6 +178,12 @@ int main( int argc, char** argv )
     uint32_t queue_size = 0;
     uint64_t sum_size = 0;
     uint32_t max_size = 0;
+    // unlike queue_size, these follow clears and destroys
+    uint32_t live_total = 0;
+    pq_trace_profile profile;
+    memset( &profile, 0, sizeof( pq_trace_profile ) );
+    profile.op_count = header.op_count;
+    profile.node_ids = header.node_ids;
 
     mm_clear( map );
 
@@ -240,6 +260,7 @@ int main( int argc, char** argv )
             }
         }
 
+        pq_trace_profile_ops( &profile, pq_sizes, &live_total, ops, op_chunk );
     }
 
     close( trace_file );
@@ -253,8 +274,15 @@ int main( int argc, char** argv )
     mm_destroy( map );
     free( pq_index );
     free( node_index );
+    free( pq_sizes );
     free( ops );
 
+    if( write_profile && pq_trace_write_profile( trace_path, &profile ) != 0 )
+    {
+        fprintf( stderr, "Could not write profile.\n" );
+        return -1;
+    }
+
     printf("create: %llu\n",count_create);
     printf("destroy: %llu\n",count_destroy);
     printf("clear: %llu\n",count_clear);
@@ -269,6 +297,8 @@ int main( int argc, char** argv )
     printf("empty: %llu\n",count_empty);
     printf("max_size: %lu\n",max_size);
     printf("avg_size: %f\n",((double)sum_size)/((double)header.op_count));
+    printf("peak_queue: %u\n",profile.peak_queue);
+    printf("peak_total: %u\n",profile.peak_total);
 
     return 0;
 }
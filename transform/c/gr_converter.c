@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "graph_tools.h"
+
+//==============================================================================
+// DEFINES
+//==============================================================================
+
+#define MAXLINE 256
+#define DEFAULT_NAME "unknown"
+
+//==============================================================================
+// STATIC DECLARATIONS
+//==============================================================================
+
+static void order_splib( uint64_t m, uint32_t declared, uint32_t node_min,
+    uint32_t node_max, uint32_t *tails, uint32_t *heads, uint64_t *weights,
+    uint64_t *offsets );
+static void order_stable( uint64_t m, uint32_t n, uint32_t node_min,
+    uint32_t *tails, uint32_t *heads, uint64_t *weights, uint64_t *offsets,
+    uint32_t *ids );
+
+//==============================================================================
+// MAIN
+//==============================================================================
+
+/**
+ * Converts a DIMACS shortest path (p sp) or mincut (p cut) problem read from
+ * stdin into the binary graph format of graph_tools.h, written to the file
+ * named by the first argument.
+ *
+ * Shortest path arcs are stored in the order SPLIB's parse() leaves them in,
+ * and mincut arcs keep their input positions, so programs loading the binary
+ * file build exactly the structures they would have built from the text and
+ * produce identical traces.
+ */
+int main( int argc, char** argv )
+{
+    char line[MAXLINE];
+    char type[4];
+    char *cursor;
+    uint64_t declared_n = 0;
+    uint64_t m = 0;
+    uint64_t count = 0;
+    uint64_t source = 0;
+    uint64_t max_weight = 0;
+    uint64_t tail, head, weight, i;
+    uint32_t node_min = UINT32_MAX;
+    uint32_t node_max = 0;
+    uint32_t cut = 0;
+    uint32_t *tails = NULL;
+    uint32_t *heads = NULL;
+    uint64_t *weights = NULL;
+    pq_graph graph;
+
+    if( argc < 2 )
+    {
+        fprintf( stderr, "Usage: %s out_file < graph.gr\n", argv[0] );
+        exit( -1 );
+    }
+
+    memset( &graph, 0, sizeof( pq_graph ) );
+    strcpy( graph.header.name, DEFAULT_NAME );
+
+    while( fgets( line, MAXLINE, stdin ) != NULL )
+    {
+        switch( line[0] )
+        {
+            case 'c':
+            case '\n':
+            case '\0':
+                break;
+            case 't':
+                sscanf( line, "%*c %30s", graph.header.name );
+                break;
+            case 'p':
+                if( sscanf( line, "%*c %3s %lu %lu", type, &declared_n, &m )
+                        != 3 || declared_n >= UINT32_MAX )
+                {
+                    fprintf( stderr, "Bad problem line.\n" );
+                    return -1;
+                }
+                cut = ( strcmp( type, "cut" ) == 0 );
+                tails = (uint32_t*) malloc( m * sizeof( uint32_t ) );
+                heads = (uint32_t*) malloc( m * sizeof( uint32_t ) );
+                weights = (uint64_t*) malloc( m * sizeof( uint64_t ) );
+                if( tails == NULL || heads == NULL || weights == NULL )
+                {
+                    fprintf( stderr, "Malloc fail.\n" );
+                    return -1;
+                }
+                break;
+            case 'n':
+                source = strtoull( line + 1, NULL, 10 );
+                break;
+            case 'a':
+                if( count >= m )
+                {
+                    fprintf( stderr, "Too many arcs.\n" );
+                    return -1;
+                }
+                tail = strtoull( line + 1, &cursor, 10 );
+                head = strtoull( cursor, &cursor, 10 );
+                // mincut capacities are read as doubles, as parser_ni does
+                weight = cut ? (uint64_t) strtod( cursor, NULL ) :
+                    strtoull( cursor, NULL, 10 );
+                if( tail > declared_n || head > declared_n )
+                {
+                    fprintf( stderr, "Bad arc line.\n" );
+                    return -1;
+                }
+
+                tails[count] = (uint32_t) tail;
+                heads[count] = (uint32_t) head;
+                weights[count] = weight;
+                count++;
+
+                if( head < node_min ) node_min = head;
+                if( tail < node_min ) node_min = tail;
+                if( head > node_max ) node_max = head;
+                if( tail > node_max ) node_max = tail;
+                if( weight > max_weight ) max_weight = weight;
+                break;
+            default:
+                fprintf( stderr, "Unknown line type.\n" );
+                return -1;
+        }
+    }
+
+    if( count == 0 || count != m )
+    {
+        fprintf( stderr, "Not enough arcs.\n" );
+        return -1;
+    }
+    if( !cut && ( source < node_min || source > node_max ) )
+    {
+        fprintf( stderr, "Bad source.\n" );
+        return -1;
+    }
+
+    graph.header.node_count = node_max - node_min + 1;
+    graph.header.arc_count = m;
+    graph.header.node_min = node_min;
+    graph.header.source = cut ? 0 : (uint32_t) ( source - node_min );
+    graph.header.declared_nodes = (uint32_t) declared_n;
+    if( cut )
+        graph.header.flags |= PQ_GRAPH_CUT | PQ_GRAPH_ARC_IDS;
+    if( m > UINT32_MAX )
+        graph.header.flags |= PQ_GRAPH_WIDE_OFFSETS;
+    if( max_weight > UINT32_MAX )
+        graph.header.flags |= PQ_GRAPH_WIDE_WEIGHTS;
+
+    uint64_t *offsets = (uint64_t*) calloc( graph.header.node_count + 1,
+        sizeof( uint64_t ) );
+    uint32_t *ids = cut ? (uint32_t*) malloc( m * sizeof( uint32_t ) ) : NULL;
+    if( offsets == NULL || ( cut && ids == NULL ) )
+    {
+        fprintf( stderr, "Malloc fail.\n" );
+        return -1;
+    }
+
+    if( cut )
+        order_stable( m, graph.header.node_count, node_min, tails, heads,
+            weights, offsets, ids );
+    else
+        order_splib( m, (uint32_t) declared_n, node_min, node_max, tails,
+            heads, weights, offsets );
+
+    // narrow the arrays in place where the header says 32 bits suffice
+    if( !( graph.header.flags & PQ_GRAPH_WIDE_OFFSETS ) )
+    {
+        for( i = 0; i <= graph.header.node_count; i++ )
+            ( (uint32_t*) offsets )[i] = (uint32_t) offsets[i];
+    }
+    if( !( graph.header.flags & PQ_GRAPH_WIDE_WEIGHTS ) )
+    {
+        for( i = 0; i < m; i++ )
+            ( (uint32_t*) weights )[i] = (uint32_t) weights[i];
+    }
+
+    graph.offsets = offsets;
+    graph.heads = heads;
+    graph.weights = weights;
+    graph.ids = ids;
+
+    int out_file = open( argv[1], O_WRONLY | O_CREAT | O_TRUNC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH );
+    if( out_file < 0 || pq_graph_write( out_file, &graph ) )
+    {
+        fprintf( stderr, "Could not write graph.\n" );
+        return -1;
+    }
+    close( out_file );
+
+    free( tails );
+    free( heads );
+    free( weights );
+    free( offsets );
+    free( ids );
+
+    return 0;
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Groups arcs by tail exactly as SPLIB's parse() does, with a prefix sum over
+ * out-degrees followed by in-place cycle-leader swaps.  The swaps do not keep
+ * input order within a node, so a stable sort would hand Dijkstra its arcs in
+ * a different order than the text parser.  Heads are renumbered from
+ * node_min.
+ *
+ * @param m         Number of arcs
+ * @param declared  Node count from the problem line
+ * @param node_min  Lowest node used by an arc
+ * @param node_max  Highest node used by an arc
+ * @param tails     Arc tails in input order, scrambled on return
+ * @param heads     Arc heads, reordered in place
+ * @param weights   Arc weights, reordered in place
+ * @param offsets   Filled with node_max - node_min + 2 arc offsets
+ */
+static void order_splib( uint64_t m, uint32_t declared, uint32_t node_min,
+    uint32_t node_max, uint32_t *tails, uint32_t *heads, uint64_t *weights,
+    uint64_t *offsets )
+{
+    uint64_t arc_num, arc_new_num, last, swap, i;
+    uint32_t tail, node_swap;
+
+    uint64_t *arc_first = (uint64_t*) calloc( (uint64_t) declared + 2,
+        sizeof( uint64_t ) );
+    for( i = 0; i < m; i++ )
+        arc_first[tails[i] + 1]++;
+
+    offsets[0] = 0;
+    for( i = node_min + 1; i <= node_max + 1; i++ )
+    {
+        arc_first[i] += arc_first[i-1];
+        offsets[i - node_min] = arc_first[i];
+    }
+
+    for( i = node_min; i < node_max; i++ )
+    {
+        last = offsets[i + 1 - node_min];
+        for( arc_num = arc_first[i]; arc_num < last; arc_num++ )
+        {
+            tail = tails[arc_num];
+            while( tail != i )
+            {
+                arc_new_num = arc_first[tail];
+
+                node_swap = heads[arc_new_num];
+                heads[arc_new_num] = heads[arc_num];
+                heads[arc_num] = node_swap;
+
+                swap = weights[arc_new_num];
+                weights[arc_new_num] = weights[arc_num];
+                weights[arc_num] = swap;
+
+                tails[arc_num] = tails[arc_new_num];
+                tails[arc_new_num] = tail;
+                arc_first[tail]++;
+
+                tail = tails[arc_num];
+            }
+        }
+    }
+
+    for( i = 0; i < m; i++ )
+        heads[i] -= node_min;
+
+    free( arc_first );
+}
+
+/**
+ * Groups arcs by tail with a stable counting sort, recording where each arc
+ * appeared in the input.  Heads are renumbered from node_min.
+ *
+ * @param m         Number of arcs
+ * @param n         Number of nodes from node_min up
+ * @param node_min  Lowest node used by an arc
+ * @param tails     Arc tails in input order
+ * @param heads     Arc heads, reordered in place
+ * @param weights   Arc weights, reordered in place
+ * @param offsets   Filled with n + 1 arc offsets
+ * @param ids       Filled with the input position of each arc
+ */
+static void order_stable( uint64_t m, uint32_t n, uint32_t node_min,
+    uint32_t *tails, uint32_t *heads, uint64_t *weights, uint64_t *offsets,
+    uint32_t *ids )
+{
+    uint64_t i, position;
+
+    uint64_t *next = (uint64_t*) calloc( (uint64_t) n + 1,
+        sizeof( uint64_t ) );
+    uint32_t *sorted_heads = (uint32_t*) malloc( m * sizeof( uint32_t ) );
+    uint64_t *sorted_weights = (uint64_t*) malloc( m * sizeof( uint64_t ) );
+
+    for( i = 0; i < m; i++ )
+        offsets[tails[i] - node_min + 1]++;
+    for( i = 1; i <= n; i++ )
+        offsets[i] += offsets[i-1];
+    memcpy( next, offsets, n * sizeof( uint64_t ) );
+
+    for( i = 0; i < m; i++ )
+    {
+        position = next[tails[i] - node_min]++;
+        sorted_heads[position] = heads[i] - node_min;
+        sorted_weights[position] = weights[i];
+        ids[position] = (uint32_t) i;
+    }
+
+    memcpy( heads, sorted_heads, m * sizeof( uint32_t ) );
+    memcpy( weights, sorted_weights, m * sizeof( uint64_t ) );
+
+    free( next );
+    free( sorted_heads );
+    free( sorted_weights );
+}
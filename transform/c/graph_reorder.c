@@ -0,0 +1,500 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dimacs_tools.h"
+
+//==============================================================================
+// DEFINES
+//==============================================================================
+
+#define MAXLINE 256
+//! coordinates are scaled to a grid of this many bits per axis
+#define HILBERT_BITS 16
+#define UNVISITED UINT32_MAX
+//! George-Liu iterations when looking for a pseudo-peripheral node
+#define PERIPHERAL_ROUNDS 2
+
+/**
+ * Both directions of every arc, grouped by node, so orderings can follow
+ * the graph's connectivity regardless of arc direction.
+ */
+struct neighborhood
+{
+    uint32_t n;
+    uint64_t *offsets;
+    uint32_t *neighbors;
+};
+
+typedef struct neighborhood neighborhood;
+
+//==============================================================================
+// STATIC DECLARATIONS
+//==============================================================================
+
+static void build_neighborhood( pq_dimacs *graph, uint32_t first,
+    neighborhood *hood );
+static uint32_t bfs( neighborhood *hood, uint32_t start, uint32_t *queue,
+    uint32_t *marks, uint32_t stamp, uint32_t sorted, uint32_t *last_level );
+static void order_bfs( neighborhood *hood, uint32_t source,
+    uint32_t *order );
+static void order_rcm( neighborhood *hood, uint32_t *order );
+static int order_hilbert( const char *path, uint32_t first, uint32_t n,
+    uint32_t *order );
+static uint64_t hilbert_index( uint32_t x, uint32_t y );
+static int compare_degree( const void *a, const void *b );
+static int compare_index( const void *a, const void *b );
+
+//! degrees and curve positions consulted by the qsort comparators
+static uint64_t *sort_offsets;
+static uint64_t *sort_indices;
+
+//==============================================================================
+// MAIN
+//==============================================================================
+
+/**
+ * Renumbers the nodes of a DIMACS shortest path problem read from stdin and
+ * writes the renumbered problem to the file named by the second argument.
+ * The first argument picks the ordering:
+ *
+ *  bfs     - breadth-first discovery order from the source
+ *  rcm     - reverse Cuthill-McKee, which keeps neighbors close together
+ *  hilbert - position along a Hilbert curve through the node coordinates,
+ *            read from the DIMACS .co file named by the third argument
+ *
+ * Nodes not reached from the starting point follow in further searches.
+ * Arcs are written grouped by their new tail, in input order within each
+ * node.
+ */
+int main( int argc, char** argv )
+{
+    pq_dimacs graph;
+    neighborhood hood;
+    uint64_t i, position;
+    uint32_t first, n, v;
+
+    if( argc < 3 || ( strcmp( argv[1], "hilbert" ) == 0 && argc < 4 ) )
+    {
+        fprintf( stderr, "Usage: %s <bfs|rcm|hilbert> out.gr [coords.co] "
+            "< graph.gr\n", argv[0] );
+        exit( -1 );
+    }
+
+    if( pq_dimacs_read( 0, pq_dimacs_threads(), &graph ) )
+        return -1;
+    if( strcmp( graph.type, "sp" ) || !graph.has_source )
+    {
+        fprintf( stderr, "Not a shortest path problem.\n" );
+        return -1;
+    }
+
+    // DIMACS nodes are numbered from 1, but the parsers accept 0
+    first = graph.node_min < 1 ? 0 : 1;
+    n = graph.declared_nodes - first + 1;
+
+    uint32_t *order = malloc( n * sizeof( uint32_t ) );
+    uint32_t *rename = malloc( n * sizeof( uint32_t ) );
+    if( order == NULL || rename == NULL )
+    {
+        fprintf( stderr, "Malloc fail.\n" );
+        return -1;
+    }
+
+    if( strcmp( argv[1], "hilbert" ) == 0 )
+    {
+        if( order_hilbert( argv[3], first, n, order ) )
+            return -1;
+    }
+    else
+    {
+        build_neighborhood( &graph, first, &hood );
+        if( strcmp( argv[1], "bfs" ) == 0 )
+            order_bfs( &hood, graph.source - first, order );
+        else if( strcmp( argv[1], "rcm" ) == 0 )
+            order_rcm( &hood, order );
+        else
+        {
+            fprintf( stderr, "Unknown ordering %s.\n", argv[1] );
+            return -1;
+        }
+        free( hood.offsets );
+        free( hood.neighbors );
+    }
+
+    for( i = 0; i < n; i++ )
+        rename[order[i]] = i;
+
+    // group the arcs by new tail, keeping input order within each node
+    uint64_t *offsets = calloc( (uint64_t) n + 1, sizeof( uint64_t ) );
+    uint64_t *sorted = malloc( ( graph.arc_count + 1 ) * sizeof( uint64_t ) );
+    if( offsets == NULL || sorted == NULL )
+    {
+        fprintf( stderr, "Malloc fail.\n" );
+        return -1;
+    }
+    for( i = 0; i < graph.arc_count; i++ )
+        offsets[rename[graph.tails[i] - first] + 1]++;
+    for( i = 1; i <= n; i++ )
+        offsets[i] += offsets[i-1];
+    for( i = 0; i < graph.arc_count; i++ )
+    {
+        position = offsets[rename[graph.tails[i] - first]]++;
+        sorted[position] = i;
+    }
+
+    FILE *out = fopen( argv[2], "w" );
+    if( out == NULL )
+    {
+        fprintf( stderr, "Could not open %s.\n", argv[2] );
+        return -1;
+    }
+    setvbuf( out, NULL, _IOFBF, 1 << 20 );
+
+    fprintf( out, "c %s reordered by %s\n", graph.name, argv[1] );
+    if( strcmp( graph.name, "unknown" ) )
+        fprintf( out, "t %s\n", graph.name );
+    fprintf( out, "p sp %lu %lu\n", graph.declared_nodes, graph.arc_count );
+    fprintf( out, "n %u\n", rename[graph.source - first] + first );
+    for( i = 0; i < graph.arc_count; i++ )
+    {
+        v = sorted[i];
+        fprintf( out, "a %u %u %ld\n", rename[graph.tails[v] - first] + first,
+            rename[graph.heads[v] - first] + first, graph.weights[v] );
+    }
+    fclose( out );
+
+    free( order );
+    free( rename );
+    free( offsets );
+    free( sorted );
+    pq_dimacs_free( &graph );
+
+    return 0;
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Builds the undirected adjacency of a problem, with nodes renumbered to
+ * start from 0.
+ *
+ * @param graph Problem to build from
+ * @param first DIMACS number of node 0
+ * @param hood  Adjacency to fill in
+ */
+static void build_neighborhood( pq_dimacs *graph, uint32_t first,
+    neighborhood *hood )
+{
+    uint64_t i;
+    uint32_t tail, head;
+
+    hood->n = graph->declared_nodes - first + 1;
+    hood->offsets = calloc( (uint64_t) hood->n + 1, sizeof( uint64_t ) );
+    hood->neighbors = malloc( ( 2 * graph->arc_count + 1 ) *
+        sizeof( uint32_t ) );
+    uint64_t *next = malloc( ( (uint64_t) hood->n + 1 ) * sizeof( uint64_t ) );
+    if( hood->offsets == NULL || hood->neighbors == NULL || next == NULL )
+    {
+        fprintf( stderr, "Malloc fail.\n" );
+        exit( -1 );
+    }
+
+    for( i = 0; i < graph->arc_count; i++ )
+    {
+        hood->offsets[graph->tails[i] - first + 1]++;
+        hood->offsets[graph->heads[i] - first + 1]++;
+    }
+    for( i = 1; i <= hood->n; i++ )
+        hood->offsets[i] += hood->offsets[i-1];
+    memcpy( next, hood->offsets, ( (uint64_t) hood->n + 1 ) *
+        sizeof( uint64_t ) );
+
+    for( i = 0; i < graph->arc_count; i++ )
+    {
+        tail = graph->tails[i] - first;
+        head = graph->heads[i] - first;
+        hood->neighbors[next[tail]++] = head;
+        hood->neighbors[next[head]++] = tail;
+    }
+
+    free( next );
+}
+
+/**
+ * Breadth-first search that appends each node reached to a queue and marks
+ * it with a stamp.  Nodes already carrying the stamp are not revisited, so
+ * the same marks can serve several searches.
+ *
+ * @param hood      Adjacency to search
+ * @param start     Node to start from
+ * @param queue     Array to append nodes to, in discovery order
+ * @param marks     Per-node stamps
+ * @param stamp     Stamp for this search
+ * @param sorted    Whether to visit neighbors in increasing degree order
+ * @param last_level    If not NULL, set to the queue position of the first
+ *                      node at the greatest depth
+ * @return          Number of nodes appended
+ */
+static uint32_t bfs( neighborhood *hood, uint32_t start, uint32_t *queue,
+    uint32_t *marks, uint32_t stamp, uint32_t sorted, uint32_t *last_level )
+{
+    uint64_t a;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    uint32_t level_begin = 0;
+    uint32_t level_end = 1;
+    uint32_t v, w, level_start;
+
+    marks[start] = stamp;
+    queue[tail++] = start;
+
+    while( head < tail )
+    {
+        // the queue holds nodes in order of depth
+        if( head == level_end )
+        {
+            level_begin = head;
+            level_end = tail;
+        }
+        v = queue[head++];
+        level_start = tail;
+        for( a = hood->offsets[v]; a < hood->offsets[v+1]; a++ )
+        {
+            w = hood->neighbors[a];
+            if( marks[w] == stamp )
+                continue;
+            marks[w] = stamp;
+            queue[tail++] = w;
+        }
+        if( sorted && tail - level_start > 1 )
+            qsort( queue + level_start, tail - level_start,
+                sizeof( uint32_t ), compare_degree );
+    }
+
+    if( last_level != NULL )
+        *last_level = level_begin;
+    return tail;
+}
+
+/**
+ * Orders nodes by breadth-first discovery from the source, then from each
+ * node not yet reached in increasing order.
+ *
+ * @param hood      Adjacency to order
+ * @param source    Node to start from
+ * @param order     Filled with the nodes in their new order
+ */
+static void order_bfs( neighborhood *hood, uint32_t source,
+    uint32_t *order )
+{
+    uint32_t *marks = malloc( hood->n * sizeof( uint32_t ) );
+    uint32_t count, v;
+
+    memset( marks, 0xFF, hood->n * sizeof( uint32_t ) );
+    count = bfs( hood, source, order, marks, 0, 0, NULL );
+    for( v = 0; v < hood->n; v++ )
+    {
+        if( marks[v] == UNVISITED )
+            count += bfs( hood, v, order + count, marks, 0, 0, NULL );
+    }
+
+    free( marks );
+}
+
+/**
+ * Orders nodes by reverse Cuthill-McKee.  Each component is searched from a
+ * pseudo-peripheral node found with the George-Liu heuristic, visiting
+ * neighbors in increasing degree order, and the whole order is reversed at
+ * the end.
+ *
+ * @param hood      Adjacency to order
+ * @param order     Filled with the nodes in their new order
+ */
+static void order_rcm( neighborhood *hood, uint32_t *order )
+{
+    uint32_t *marks = malloc( hood->n * sizeof( uint32_t ) );
+    uint32_t *probe = malloc( hood->n * sizeof( uint32_t ) );
+    uint32_t *probe_marks = malloc( hood->n * sizeof( uint32_t ) );
+    uint32_t count = 0;
+    uint32_t stamp = 0;
+    uint32_t size, begin, start, v, i, round, last;
+
+    memset( marks, 0xFF, hood->n * sizeof( uint32_t ) );
+    memset( probe_marks, 0xFF, hood->n * sizeof( uint32_t ) );
+    sort_offsets = hood->offsets;
+
+    for( v = 0; v < hood->n; v++ )
+    {
+        if( marks[v] != UNVISITED )
+            continue;
+
+        // move to a minimum degree node of the farthest level, twice
+        start = v;
+        for( round = 0; round < PERIPHERAL_ROUNDS; round++ )
+        {
+            size = bfs( hood, start, probe, probe_marks, stamp++, 1, &begin );
+            last = probe[begin];
+            for( i = begin + 1; i < size; i++ )
+            {
+                if( hood->offsets[probe[i]+1] - hood->offsets[probe[i]] <
+                        hood->offsets[last+1] - hood->offsets[last] )
+                    last = probe[i];
+            }
+            start = last;
+        }
+
+        count += bfs( hood, start, order + count, marks, 0, 1, NULL );
+    }
+
+    for( i = 0; i < count / 2; i++ )
+    {
+        v = order[i];
+        order[i] = order[count-1-i];
+        order[count-1-i] = v;
+    }
+
+    free( marks );
+    free( probe );
+    free( probe_marks );
+}
+
+/**
+ * Orders nodes along a Hilbert curve through their coordinates, read from a
+ * DIMACS coordinate file with lines of the form "v id x y".  Nodes without
+ * coordinates go last.
+ *
+ * @param path      Coordinate file
+ * @param first     DIMACS number of node 0
+ * @param n         Number of nodes
+ * @param order     Filled with the nodes in their new order
+ * @return          0 on success, -1 on error
+ */
+static int order_hilbert( const char *path, uint32_t first, uint32_t n,
+    uint32_t *order )
+{
+    char line[MAXLINE];
+    long id, x, y;
+    long x_min = 0, x_max = 0, y_min = 0, y_max = 0;
+    uint32_t i, found = 0;
+    double scale_x, scale_y;
+
+    FILE *coords = fopen( path, "r" );
+    int64_t *xs = malloc( n * sizeof( int64_t ) );
+    int64_t *ys = malloc( n * sizeof( int64_t ) );
+    uint8_t *known = calloc( n, sizeof( uint8_t ) );
+    sort_indices = malloc( n * sizeof( uint64_t ) );
+    if( coords == NULL || xs == NULL || ys == NULL || known == NULL ||
+            sort_indices == NULL )
+    {
+        fprintf( stderr, "Could not read %s.\n", path );
+        return -1;
+    }
+
+    while( fgets( line, MAXLINE, coords ) != NULL )
+    {
+        if( line[0] != 'v' || sscanf( line, "%*c %ld %ld %ld", &id, &x, &y )
+                != 3 || id < first || id - first >= n )
+            continue;
+        xs[id - first] = x;
+        ys[id - first] = y;
+        known[id - first] = 1;
+        if( found == 0 || x < x_min ) x_min = x;
+        if( found == 0 || x > x_max ) x_max = x;
+        if( found == 0 || y < y_min ) y_min = y;
+        if( found == 0 || y > y_max ) y_max = y;
+        found++;
+    }
+    fclose( coords );
+
+    scale_x = x_max > x_min ?
+        ( (1 << HILBERT_BITS) - 1 ) / (double) ( x_max - x_min ) : 0;
+    scale_y = y_max > y_min ?
+        ( (1 << HILBERT_BITS) - 1 ) / (double) ( y_max - y_min ) : 0;
+
+    for( i = 0; i < n; i++ )
+    {
+        order[i] = i;
+        sort_indices[i] = !known[i] ? UINT64_MAX : hilbert_index(
+            ( xs[i] - x_min ) * scale_x, ( ys[i] - y_min ) * scale_y );
+    }
+    qsort( order, n, sizeof( uint32_t ), compare_index );
+
+    free( xs );
+    free( ys );
+    free( known );
+    free( sort_indices );
+
+    return 0;
+}
+
+/**
+ * Computes the distance along a Hilbert curve filling a square grid of
+ * HILBERT_BITS bits per axis.
+ *
+ * @param x Horizontal grid position
+ * @param y Vertical grid position
+ * @return  Position along the curve
+ */
+static uint64_t hilbert_index( uint32_t x, uint32_t y )
+{
+    uint64_t d = 0;
+    uint32_t s, rx, ry, t;
+
+    for( s = 1 << ( HILBERT_BITS - 1 ); s > 0; s >>= 1 )
+    {
+        rx = ( x & s ) > 0;
+        ry = ( y & s ) > 0;
+        d += (uint64_t) s * s * ( ( 3 * rx ) ^ ry );
+
+        // rotate the quadrant so the curve stays continuous
+        if( ry == 0 )
+        {
+            if( rx == 1 )
+            {
+                x = s - 1 - ( x & ( s - 1 ) );
+                y = s - 1 - ( y & ( s - 1 ) );
+            }
+            t = x;
+            x = y;
+            y = t;
+        }
+        x &= s - 1;
+        y &= s - 1;
+    }
+
+    return d;
+}
+
+/**
+ * Orders nodes by increasing degree, then number.
+ */
+static int compare_degree( const void *a, const void *b )
+{
+    uint32_t v = *(const uint32_t*) a;
+    uint32_t w = *(const uint32_t*) b;
+    uint64_t dv = sort_offsets[v+1] - sort_offsets[v];
+    uint64_t dw = sort_offsets[w+1] - sort_offsets[w];
+
+    if( dv != dw )
+        return dv < dw ? -1 : 1;
+    return v < w ? -1 : ( v > w );
+}
+
+/**
+ * Orders nodes by increasing curve position, then number.
+ */
+static int compare_index( const void *a, const void *b )
+{
+    uint32_t v = *(const uint32_t*) a;
+    uint32_t w = *(const uint32_t*) b;
+
+    if( sort_indices[v] != sort_indices[w] )
+        return sort_indices[v] < sort_indices[w] ? -1 : 1;
+    return v < w ? -1 : ( v > w );
+}
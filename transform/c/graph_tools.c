@@ -0,0 +1,165 @@
+#include "graph_tools.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//==============================================================================
+// DEFINES
+//==============================================================================
+
+#define PQ_GRAPH_ALIGN(a) ( ( (a) + 7 ) & ~( (size_t) 7 ) )
+
+//==============================================================================
+// STATIC DECLARATIONS
+//==============================================================================
+
+static void array_sizes( pq_graph_header *header, size_t *sizes );
+static int write_fully( int file, const void *data, size_t length );
+
+//==============================================================================
+// PUBLIC METHODS
+//==============================================================================
+
+int pq_graph_write( int file, pq_graph *graph )
+{
+    static const uint8_t padding[8] = { 0 };
+    size_t sizes[4];
+    void *arrays[4];
+    uint32_t i;
+
+    graph->header.magic = PQ_GRAPH_MAGIC;
+    graph->header.version = PQ_GRAPH_VERSION;
+    if( write_fully( file, &graph->header, sizeof( pq_graph_header ) ) )
+        return -1;
+
+    array_sizes( &graph->header, sizes );
+    arrays[0] = graph->offsets;
+    arrays[1] = graph->heads;
+    arrays[2] = graph->weights;
+    arrays[3] = graph->ids;
+
+    for( i = 0; i < 4; i++ )
+    {
+        if( sizes[i] == 0 )
+            continue;
+        if( write_fully( file, arrays[i], sizes[i] ) )
+            return -1;
+        if( write_fully( file, padding, PQ_GRAPH_ALIGN( sizes[i] ) -
+                sizes[i] ) )
+            return -1;
+    }
+
+    return 0;
+}
+
+int pq_graph_map( const char *path, pq_graph *graph )
+{
+    struct stat info;
+    size_t sizes[4];
+    size_t position;
+    uint8_t *base;
+    void **arrays[4];
+    uint32_t i;
+
+    int file = open( path, O_RDONLY );
+    if( file < 0 )
+        return -1;
+    if( fstat( file, &info ) || info.st_size < sizeof( pq_graph_header ) )
+    {
+        close( file );
+        return -1;
+    }
+
+    base = mmap( NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+    close( file );
+    if( base == MAP_FAILED )
+        return -1;
+
+    memcpy( &graph->header, base, sizeof( pq_graph_header ) );
+    graph->base = base;
+    graph->length = info.st_size;
+    if( graph->header.magic != PQ_GRAPH_MAGIC ||
+            graph->header.version != PQ_GRAPH_VERSION )
+    {
+        pq_graph_unmap( graph );
+        return -1;
+    }
+
+    array_sizes( &graph->header, sizes );
+    arrays[0] = &graph->offsets;
+    arrays[1] = (void**) &graph->heads;
+    arrays[2] = &graph->weights;
+    arrays[3] = (void**) &graph->ids;
+
+    position = sizeof( pq_graph_header );
+    for( i = 0; i < 4; i++ )
+    {
+        *arrays[i] = sizes[i] == 0 ? NULL : base + position;
+        position += PQ_GRAPH_ALIGN( sizes[i] );
+    }
+    if( position > graph->length )
+    {
+        pq_graph_unmap( graph );
+        return -1;
+    }
+
+    // the arrays are read front to back by every loader
+    madvise( base, graph->length, MADV_SEQUENTIAL );
+
+    return 0;
+}
+
+void pq_graph_unmap( pq_graph *graph )
+{
+    if( graph->base != NULL )
+        munmap( graph->base, graph->length );
+    graph->base = NULL;
+    graph->length = 0;
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Computes the unpadded size in bytes of each array described by a header:
+ * offsets, heads, weights and ids, in file order.
+ *
+ * @param header    Header describing the graph
+ * @param sizes     Array of four sizes to fill in
+ */
+static void array_sizes( pq_graph_header *header, size_t *sizes )
+{
+    uint64_t m = header->arc_count;
+
+    sizes[0] = ( (size_t) header->node_count + 1 ) *
+        ( header->flags & PQ_GRAPH_WIDE_OFFSETS ? 8 : 4 );
+    sizes[1] = m * sizeof( uint32_t );
+    sizes[2] = m * ( header->flags & PQ_GRAPH_WIDE_WEIGHTS ? 8 : 4 );
+    sizes[3] = header->flags & PQ_GRAPH_ARC_IDS ? m * sizeof( uint32_t ) : 0;
+}
+
+/**
+ * Writes a buffer in full, retrying after short writes.
+ *
+ * @param file      File to write to
+ * @param data      Data to write
+ * @param length    Number of bytes to write
+ * @return          0 on success, -1 on error
+ */
+static int write_fully( int file, const void *data, size_t length )
+{
+    const uint8_t *position = (const uint8_t*) data;
+    ssize_t bytes;
+
+    while( length > 0 )
+    {
+        bytes = write( file, position, length );
+        if( bytes <= 0 )
+            return -1;
+        position += bytes;
+        length -= bytes;
+    }
+
+    return 0;
+}
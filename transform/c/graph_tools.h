@@ -0,0 +1,145 @@
+#ifndef PQ_GRAPH_TOOLS
+#define PQ_GRAPH_TOOLS
+
+//==============================================================================
+// DEFINES, INCLUDES, and STRUCTS
+//==============================================================================
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PQ_GRAPH_MAGIC      0x52475150
+#define PQ_GRAPH_VERSION    1
+
+// header flags
+//! offsets are 64-bit rather than 32-bit
+#define PQ_GRAPH_WIDE_OFFSETS   0x1
+//! weights are 64-bit rather than 32-bit
+#define PQ_GRAPH_WIDE_WEIGHTS   0x2
+//! an array of input arc positions follows the weights
+#define PQ_GRAPH_ARC_IDS        0x4
+//! the graph is a mincut problem rather than a shortest path problem
+#define PQ_GRAPH_CUT            0x8
+
+/**
+ * Describes a binary graph file.  The header is followed by the arrays of a
+ * compressed sparse row graph, each starting on an 8-byte boundary: node_count
+ * + 1 offsets, arc_count heads, arc_count weights and, if PQ_GRAPH_ARC_IDS is
+ * set, arc_count input positions.  Nodes are numbered from 0 in the file and
+ * correspond to DIMACS nodes node_min and up; heads use the same numbering.
+ * Arcs of node i occupy positions offsets[i] to offsets[i+1]-1.
+ */
+struct pq_graph_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    //! number of nodes from the lowest to the highest one used by an arc
+    uint32_t node_count;
+    uint64_t arc_count;
+    //! DIMACS number of node 0
+    uint32_t node_min;
+    //! source node for shortest path problems, numbered from 0
+    uint32_t source;
+    //! node count given on the DIMACS problem line
+    uint32_t declared_nodes;
+    uint32_t reserved;
+    //! problem name, NUL-terminated
+    char name[32];
+} __attribute__ ((packed, aligned(8)));
+
+typedef struct pq_graph_header pq_graph_header;
+
+/**
+ * A graph in memory, either mapped from a file by @ref <pq_graph_map> or
+ * assembled by a writer.  The array pointers have the widths given by the
+ * header flags.
+ */
+struct pq_graph
+{
+    pq_graph_header header;
+    void *offsets;
+    uint32_t *heads;
+    void *weights;
+    //! input position of each arc, or NULL
+    uint32_t *ids;
+
+    //! start and length of the mapping, if mapped
+    void *base;
+    size_t length;
+};
+
+typedef struct pq_graph pq_graph;
+
+//==============================================================================
+// PUBLIC DECLARATIONS
+//==============================================================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Writes a graph to the current position in the file: the header followed by
+ * each array, padded to 8-byte boundaries.
+ *
+ * @param file  File to write to
+ * @param graph Graph to write
+ * @return      0 on success, -1 on error
+ */
+int pq_graph_write( int file, pq_graph *graph );
+
+/**
+ * Maps a binary graph file read-only and points the graph's arrays into the
+ * mapping, so no parsing or copying takes place.  Checks the magic number,
+ * version and that the file is long enough for the arrays it declares.
+ *
+ * @param path  Path of the file to map
+ * @param graph Graph to fill in
+ * @return      0 on success, -1 on error
+ */
+int pq_graph_map( const char *path, pq_graph *graph );
+
+/**
+ * Releases the mapping made by @ref <pq_graph_map>.
+ *
+ * @param graph Graph to unmap
+ */
+void pq_graph_unmap( pq_graph *graph );
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * Returns the position of the first arc of a node.  Passing node_count gives
+ * the total number of arcs.
+ *
+ * @param graph Graph to query
+ * @param node  Node, numbered from 0
+ * @return      Position of the node's first arc
+ */
+static inline uint64_t pq_graph_offset( pq_graph *graph, uint32_t node )
+{
+    if( graph->header.flags & PQ_GRAPH_WIDE_OFFSETS )
+        return ( (uint64_t*) graph->offsets )[node];
+    return ( (uint32_t*) graph->offsets )[node];
+}
+
+/**
+ * Returns the weight, i.e. length or capacity, of an arc.
+ *
+ * @param graph Graph to query
+ * @param arc   Arc position
+ * @return      Weight of the arc
+ */
+static inline uint64_t pq_graph_weight( pq_graph *graph, uint64_t arc )
+{
+    if( graph->header.flags & PQ_GRAPH_WIDE_WEIGHTS )
+        return ( (uint64_t*) graph->weights )[arc];
+    return ( (uint32_t*) graph->weights )[arc];
+}
+
+#endif
@@ -7,32 +7,116 @@
 
 mem_map* mm_create( uint32_t types, uint32_t *sizes )
 {
-    mem_map *map = malloc( sizeof( mem_map ) );
+    mem_map *map = calloc( 1, sizeof( mem_map ) );
     map->types = types;
     map->sizes = malloc( types * sizeof( uint32_t ) );
+    memcpy( map->sizes, sizes, types * sizeof( uint32_t ) );
+    map->live = calloc( types, sizeof( uint32_t ) );
+    map->peak = calloc( types, sizeof( uint32_t ) );
+    map->held = calloc( types, sizeof( uint32_t ) );
+
+    return map;
+}
+
+mem_map* mm_create_arena( mem_map *parent )
+{
+    mem_map *map = calloc( 1, sizeof( mem_map ) );
+    map->types = parent->types;
+    map->sizes = parent->sizes;
+    map->live = parent->live;
+    map->peak = parent->peak;
+    map->parent = parent;
+    map->zero_all = parent->zero_all;
+    map->held = calloc( map->types, sizeof( uint32_t ) );
 
     return map;
 }
 
 void mm_destroy( mem_map *map )
 {
-    free( map->sizes );
+    if( map->parent != NULL )
+        mm_clear( map );
+    else
+    {
+        free( map->sizes );
+        free( map->live );
+        free( map->peak );
+    }
+    free( map->held );
     free( map );
 }
 
 void mm_clear( mem_map *map )
 {
-    return;
+    uint32_t i;
+
+    // nodes are not tracked individually, so they cannot be released here;
+    // just restart the count
+    if( map->parent != NULL )
+    {
+        for( i = 0; i < map->types; i++ )
+            map->live[i] -= map->held[i];
+    }
+    else
+        memset( map->live, 0, map->types * sizeof( uint32_t ) );
+    memset( map->held, 0, map->types * sizeof( uint32_t ) );
+}
+
+void mm_meld( mem_map *dst, mem_map *src )
+{
+    uint32_t i;
+
+    if( dst == src )
+        return;
+
+    for( i = 0; i < src->types; i++ )
+    {
+        dst->held[i] += src->held[i];
+        src->held[i] = 0;
+    }
+}
+
+int mm_set_placement( mem_map *map, uint32_t placement, uint32_t node )
+{
+    return ( placement == MM_PLACE_DEFAULT ) ? 0 : -1;
 }
 
 void* pq_alloc_node( mem_map *map, uint32_t type )
 {
     void *node = calloc( 1, map->sizes[type] );
 
+    map->held[type]++;
+    if( ++(map->live[type]) > map->peak[type] )
+        map->peak[type] = map->live[type];
+
+    return node;
+}
+
+void* pq_alloc_node_uninit( mem_map *map, uint32_t type )
+{
+    void *node = map->zero_all ? calloc( 1, map->sizes[type] ) :
+        malloc( map->sizes[type] );
+
+    map->held[type]++;
+    if( ++(map->live[type]) > map->peak[type] )
+        map->peak[type] = map->live[type];
+
     return node;
 }
 
 void pq_free_node( mem_map *map, uint32_t type, void *node )
 {
+    map->held[type]--;
+    map->live[type]--;
     free( node );
 }
+
+void mm_get_stats( mem_map *map, uint32_t type, mm_stats *stats )
+{
+    // every node is its own allocation, so the most ever reserved is the peak;
+    // allocator headers are not visible from here
+    stats->live_bytes = (uint64_t) map->live[type] * map->sizes[type];
+    stats->peak_bytes = (uint64_t) map->peak[type] * map->sizes[type];
+    stats->reserved_bytes = stats->peak_bytes;
+    stats->slabs = map->peak[type];
+}
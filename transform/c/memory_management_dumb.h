@@ -11,9 +11,17 @@
 
 #define PQ_MEM_WIDTH 32
 
+/**
+ * Placements of node slabs among NUMA nodes, as set by @ref <mm_set_placement>.
+ */
+#define MM_PLACE_DEFAULT    0
+#define MM_PLACE_BIND       1
+#define MM_PLACE_INTERLEAVE 2
+
 /**
  * Dummy API for node allocation.  Just makes simple calls to associated system
- * functions.
+ * functions.  Arenas only keep count of their nodes, which share the live and
+ * peak counts of the top-level map.
  */
 
 typedef struct mem_map_t
@@ -22,12 +30,46 @@ typedef struct mem_map_t
     uint32_t types;
     //! sizes of single nodes
     uint32_t *sizes;
+
+    //! nodes of each type currently allocated
+    uint32_t *live;
+    //! most nodes of each type allocated at once
+    uint32_t *peak;
+
+    //! zero nodes allocated by @ref <pq_alloc_node_uninit> too, to measure
+    //! what skipping it saves; arenas take the flag from their parent
+    uint32_t zero_all;
+
+    //! map this arena was created from, or NULL for a top-level map
+    struct mem_map_t *parent;
+    //! nodes of each type allocated through this map and not freed
+    uint32_t *held;
 } mem_map;
 
+/**
+ * Footprint of a single node type, as reported by @ref <mm_get_stats>.  Byte
+ * counts cover node storage only, not the map's own bookkeeping.
+ */
+typedef struct mm_stats_t
+{
+    //! bytes held by nodes currently allocated
+    uint64_t live_bytes;
+    //! high-water mark of live_bytes since the map was created
+    uint64_t peak_bytes;
+    //! bytes of node storage obtained from the system
+    uint64_t reserved_bytes;
+    //! number of separate allocations backing the node storage
+    uint32_t slabs;
+} mm_stats;
+
 //==============================================================================
 // PUBLIC DECLARATIONS
 //==============================================================================
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * Creates a new memory map for the specified node sizes
  *
@@ -38,6 +80,18 @@ typedef struct mem_map_t
  */
 mem_map* mm_create( uint32_t types, uint32_t *sizes );
 
+/**
+ * Creates an arena for the nodes of a single queue, carved from a parent map.
+ * The parent may itself be an arena.  Every arena must be destroyed before
+ * its parent, and once a map has arenas it should not be cleared while they
+ * hold nodes.  As with @ref <mm_clear>, destroying an arena cannot release
+ * nodes it has not freed.
+ *
+ * @param parent    Map whose counts to share
+ * @return          Pointer to the new arena
+ */
+mem_map* mm_create_arena( mem_map *parent );
+
 /**
  * Releases all allocated memory associated with the map.
  *
@@ -52,6 +106,26 @@ void mm_destroy( mem_map *map );
  */
 void mm_clear( mem_map *map );
 
+/**
+ * Hands all the nodes of one map to another.  Nodes are separate allocations,
+ * so only their count moves.
+ *
+ * @param dst   Map to take over the nodes
+ * @param src   Map to give them up
+ */
+void mm_meld( mem_map *dst, mem_map *src );
+
+/**
+ * Would place the map's node slabs on NUMA nodes, but nodes come from malloc
+ * one at a time, with no slab to place.
+ *
+ * @param map       Map to place
+ * @param placement One of the MM_PLACE_ values
+ * @param node      Node to bind to, for MM_PLACE_BIND
+ * @return          0 for MM_PLACE_DEFAULT, -1 otherwise
+ */
+int mm_set_placement( mem_map *map, uint32_t placement, uint32_t node );
+
 /**
  * Allocates a single node from the memory pool.  First attempts to recycle old
  * data from the free list.  If there is nothing to recycle, then it takes a new
@@ -63,6 +137,17 @@ void mm_clear( mem_map *map );
  */
 void* pq_alloc_node( mem_map *map, uint32_t type );
 
+/**
+ * Allocates a single node as @ref <pq_alloc_node> does, but leaves its memory
+ * as the last user left it.  The caller must set every field it will read.
+ * Nodes are still zeroed if the map's zero_all flag is set.
+ *
+ * @param map   Map from which to allocate
+ * @param type  Type of node to allocate
+ * @return      Pointer to allocated node
+ */
+void* pq_alloc_node_uninit( mem_map *map, uint32_t type );
+
 /**
  * Takes a previously allocated node and adds it to the free list to be
  * recycled with further allocation requests.
@@ -73,4 +158,18 @@ void* pq_alloc_node( mem_map *map, uint32_t type );
  */
 void pq_free_node( mem_map *map, uint32_t type, void *node );
 
+/**
+ * Reports current and peak usage of one node type.  Peak usage survives
+ * @ref <mm_clear>, so it covers every pass made over the map.
+ *
+ * @param map   Map to query
+ * @param type  Type of node to report on
+ * @param stats Struct to fill in
+ */
+void mm_get_stats( mem_map *map, uint32_t type, mm_stats *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -1,5 +1,31 @@
 #include "memory_management_eager.h"
 #include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <linux/mempolicy.h>
+
+//==============================================================================
+// STATIC DECLARATIONS
+//==============================================================================
+
+#define MM_MAX(a,b) ( (a) > (b) ? (a) : (b) )
+
+static inline void* mm_next_node( mem_map *map, uint32_t type );
+static inline void* mm_next_ordered( mem_map *map, uint32_t type );
+static void mm_clear_bits( mem_map *map, uint32_t type );
+static uint8_t* mm_alloc_slab( mem_map *map, uint64_t bytes );
+static int mm_place( mem_map *map, void *slab, uint64_t bytes );
+static void mm_populate( uint8_t *slab, uint64_t bytes );
+static mem_map* mm_alloc_map( uint32_t types );
+static uint8_t* mm_take_data( mem_map *map, uint32_t type );
+static uint8_t* mm_take_free( mem_map *map, uint32_t type );
+static void mm_give( uint8_t **pool, uint8_t *slab );
+static uint8_t* mm_pop( uint8_t **pool );
+static void mm_create_spares( mem_map *map );
+static void mm_adopt( mem_map *map, mm_slab slab );
+static void mm_release_adopted( mem_map *map );
+static uint32_t mm_held( mem_map *map, uint32_t type );
 
 //==============================================================================
 // PUBLIC METHODS
@@ -9,44 +35,135 @@ mem_map* mm_create( uint32_t types, uint32_t *sizes, uint32_t *capacities )
 {
     int i;
 
-    mem_map *map = malloc( sizeof( mem_map ) );
-    map->types = types;
+    mem_map *map = mm_alloc_map( types );
     map->sizes = malloc( types * sizeof( uint32_t ) );
     map->capacities = malloc( types * sizeof( uint32_t ) );
-    map->data = malloc( types * sizeof( uint8_t* ) );
-    map->free = malloc( types * sizeof( uint8_t** ) );
-    map->index_data = calloc( types, sizeof( uint32_t ) );
-    map->index_free = calloc( types, sizeof( uint32_t ) );
-
+    map->live = calloc( types, sizeof( uint32_t ) );
+    map->peak = calloc( types, sizeof( uint32_t ) );
+    map->arena_bytes = calloc( types, sizeof( uint64_t ) );
+    map->arena_slabs = calloc( types, sizeof( uint32_t ) );
 
     for( i = 0; i < types; i++ )
     {
         map->sizes[i] = sizes[i];
         map->capacities[i] = capacities[i];
 
-        map->data[i] = calloc( PQ_MEM_WIDTH, sizeof( uint8_t* ) );
-        map->free[i] = calloc( PQ_MEM_WIDTH, sizeof( uint8_t** ) );
-
-        map->data[i] = malloc( map->sizes[i] * map->capacities[i] );
+        map->data[i] = mm_alloc_slab( map,
+            (uint64_t) map->sizes[i] * map->capacities[i] );
         map->free[i] = malloc( sizeof( uint8_t* ) * map->capacities[i] );
     }
 
     return map;
 }
 
+mem_map* mm_create_arena( mem_map *parent )
+{
+    int i;
+
+    mem_map *map = mm_alloc_map( parent->types );
+    map->parent = parent;
+    map->zero_all = parent->zero_all;
+    map->placement = parent->placement;
+    map->placement_node = parent->placement_node;
+    map->prefault = parent->prefault;
+    map->sizes = parent->sizes;
+    map->capacities = parent->capacities;
+    map->live = parent->live;
+    map->peak = parent->peak;
+
+    if( parent->spare_data == NULL )
+        mm_create_spares( parent );
+
+    for( i = 0; i < map->types; i++ )
+    {
+        map->data[i] = mm_take_data( map, i );
+        map->free[i] = (uint8_t**) mm_take_free( map, i );
+    }
+
+    if( parent->free_bits != NULL )
+        mm_order_free_slots( map );
+
+    return map;
+}
+
 void mm_destroy( mem_map *map )
 {
     int i;
+    uint8_t *slab;
+    mem_map *parent = map->parent;
+
+    if( parent != NULL )
+        mm_clear( map );
+
+    for( i = 0; i < map->types; i++ )
+    {
+        // spares of the map's own arenas, less its own slabs lent to them,
+        // pass up to its parent or back to the system
+        while( map->spare_data != NULL &&
+                ( slab = mm_pop( &map->spare_data[i] ) ) != NULL )
+        {
+            if( slab == map->data[i] )
+                continue;
+            if( parent != NULL )
+                mm_give( &parent->spare_data[i], slab );
+            else
+                free( slab );
+        }
+        while( map->spare_free != NULL &&
+                ( slab = mm_pop( &map->spare_free[i] ) ) != NULL )
+        {
+            if( slab == (uint8_t*) map->free[i] )
+                continue;
+            if( parent != NULL )
+                mm_give( &parent->spare_free[i], slab );
+            else
+                free( slab );
+        }
+
+        if( parent != NULL )
+        {
+            mm_give( &parent->spare_data[i], map->data[i] );
+            mm_give( &parent->spare_free[i], (uint8_t*) map->free[i] );
+        }
+        else
+        {
+            free( map->data[i] );
+            free( map->free[i] );
+        }
+
+        if( map->free_bits != NULL )
+            free( map->free_bits[i] );
+    }
+
+    for( i = 0; i < map->adopted_count; i++ )
+        free( map->adopted[i].data );
     for( i = 0; i < map->types; i++ )
+        free( map->adopted_free[i] );
+
+    if( parent == NULL )
     {
-        free( map->data[i] );
-        free( map->free[i] );
+        free( map->capacities );
+        free( map->sizes );
+        free( map->live );
+        free( map->peak );
+        free( map->arena_bytes );
+        free( map->arena_slabs );
     }
 
     free( map->data );
     free( map->free );
-    free( map->capacities );
-    free( map->sizes );
+    free( map->spare_data );
+    free( map->spare_free );
+    free( map->adopted );
+    free( map->melded );
+    free( map->adopted_free );
+    free( map->index_adopted );
+    free( map->adopted_slots );
+    free( map->index_data );
+    free( map->index_free );
+    free( map->free_bits );
+    free( map->free_low );
+    free( map->index_bits );
 
     free( map );
 }
@@ -56,26 +173,505 @@ void mm_clear( mem_map *map )
     int i;
     for( i = 0; i < map->types; i++ )
     {
+        // an arena's nodes are only its share of the common count
+        if( map->parent != NULL )
+            map->live[i] -= mm_held( map, i );
+        else
+            map->live[i] = 0;
+
+        mm_clear_bits( map, i );
         map->index_data[i] = 0;
         map->index_free[i] = 0;
+        map->melded[i] = 0;
+    }
+
+    mm_release_adopted( map );
+}
+
+void mm_meld( mem_map *dst, mem_map *src )
+{
+    int i;
+    mm_slab slab;
+
+    if( dst == src )
+        return;
+
+    for( i = 0; i < src->types; i++ )
+    {
+        dst->melded[i] += mm_held( src, i );
+
+        slab.data = src->data[i];
+        slab.type = i;
+        slab.chunk = 0;
+        mm_adopt( dst, slab );
+
+        // the slots listed are now the destination's, which cannot reach them
+        mm_clear_bits( src, i );
+        src->index_data[i] = 0;
+        src->index_free[i] = 0;
+        src->index_adopted[i] = 0;
+        src->adopted_slots[i] = 0;
+        src->melded[i] = 0;
+        src->data[i] = ( src->parent != NULL ) ? mm_take_data( src, i ) :
+            mm_alloc_slab( src, (uint64_t) src->sizes[i] * src->capacities[i] );
+    }
+
+    for( i = 0; i < src->adopted_count; i++ )
+        mm_adopt( dst, src->adopted[i] );
+    src->adopted_count = 0;
+}
+
+void mm_order_free_slots( mem_map *map )
+{
+    int i;
+
+    map->free_bits = malloc( map->types * sizeof( uint64_t* ) );
+    map->free_low = calloc( map->types, sizeof( uint32_t ) );
+    map->index_bits = calloc( map->types, sizeof( uint32_t ) );
+    for( i = 0; i < map->types; i++ )
+        map->free_bits[i] = calloc( map->capacities[i] / 64 + 1,
+            sizeof( uint64_t ) );
+}
+
+int mm_set_placement( mem_map *map, uint32_t placement, uint32_t node )
+{
+    int i;
+
+    map->placement = placement;
+    map->placement_node = node;
+    for( i = 0; i < map->types; i++ )
+    {
+        if( mm_place( map, map->data[i],
+                (uint64_t) map->sizes[i] * map->capacities[i] ) != 0 )
+            return -1;
+    }
+
+    return 0;
+}
+
+void mm_prefault( mem_map *map )
+{
+    int i;
+
+    map->prefault = 1;
+    for( i = 0; i < map->types; i++ )
+    {
+        mm_populate( map->data[i],
+            (uint64_t) map->sizes[i] * map->capacities[i] );
+        mm_populate( (uint8_t*) map->free[i],
+            sizeof( uint8_t* ) * map->capacities[i] );
     }
 }
 
 void* pq_alloc_node( mem_map *map, uint32_t type )
+{
+    void *node = mm_next_node( map, type );
+    memset( node, 0, map->sizes[type] );
+
+    return node;
+}
+
+void* pq_alloc_node_uninit( mem_map *map, uint32_t type )
+{
+    void *node = mm_next_node( map, type );
+    if( map->zero_all )
+        memset( node, 0, map->sizes[type] );
+
+    return node;
+}
+
+void pq_free_node( mem_map *map, uint32_t type, void *node )
+{
+    uintptr_t offset = (uintptr_t) node - (uintptr_t) map->data[type];
+    uint32_t slot;
+
+    map->live[type]--;
+    // the map's own stack and bitmap have room for its own slab alone
+    if( map->adopted_count != 0 &&
+            offset >= (uintptr_t) map->sizes[type] * map->capacities[type] )
+        map->adopted_free[type][(map->index_adopted[type])++] = node;
+    else if( map->free_bits != NULL )
+    {
+        slot = offset / map->sizes[type];
+        map->free_bits[type][slot / 64] |= ( (uint64_t) 1 ) << ( slot % 64 );
+        if( slot / 64 < map->free_low[type] )
+            map->free_low[type] = slot / 64;
+        map->index_bits[type]++;
+    }
+    else
+        map->free[type][(map->index_free[type])++] = node;
+}
+
+void mm_get_stats( mem_map *map, uint32_t type, mm_stats *stats )
+{
+    stats->live_bytes = (uint64_t) map->live[type] * map->sizes[type];
+    stats->peak_bytes = (uint64_t) map->peak[type] * map->sizes[type];
+    stats->reserved_bytes = (uint64_t) map->capacities[type] *
+        map->sizes[type];
+    stats->slabs = 1;
+    if( map->arena_bytes != NULL )
+    {
+        stats->reserved_bytes += map->arena_bytes[type];
+        stats->slabs += map->arena_slabs[type];
+    }
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Takes the next node slot, recycling from the free list first, and counts
+ * it as live.  Leaves its memory untouched.
+ *
+ * @param map   Map from which to allocate
+ * @param type  Type of node to allocate
+ * @return      Pointer to the node
+ */
+static inline void* mm_next_node( mem_map *map, uint32_t type )
 {
     void *node;
-    if ( map->index_free[type] == 0 )
+    if( map->index_bits != NULL && map->index_bits[type] != 0 )
+        node = mm_next_ordered( map, type );
+    else if ( map->index_free[type] != 0 )
+        node = map->free[type][--(map->index_free[type])];
+    else if ( map->index_adopted[type] != 0 )
+        node = map->adopted_free[type][--(map->index_adopted[type])];
+    else
         node = ( map->data[type] + ( map->sizes[type] *
             (map->index_data[type])++ ) );
-    else
-        node = map->free[type][--(map->index_free[type])];
 
-    memset( node, 0, map->sizes[type] );
+    if( ++(map->live[type]) > map->peak[type] )
+        map->peak[type] = map->live[type];
 
     return node;
 }
 
-void pq_free_node( mem_map *map, uint32_t type, void *node )
+/**
+ * Takes the free slot of the map's own slab with the lowest address.  There
+ * must be one.
+ *
+ * @param map   Map from which to allocate
+ * @param type  Type of node to allocate
+ * @return      Pointer to the node
+ */
+static inline void* mm_next_ordered( mem_map *map, uint32_t type )
+{
+    uint64_t *bits = map->free_bits[type];
+    uint32_t word = map->free_low[type];
+    uint32_t slot;
+
+    while( bits[word] == 0 )
+        word++;
+    map->free_low[type] = word;
+
+    slot = word * 64 + (uint32_t) __builtin_ctzll( bits[word] );
+    bits[word] &= bits[word] - 1;
+    map->index_bits[type]--;
+
+    return map->data[type] + ( map->sizes[type] * slot );
+}
+
+/**
+ * Forgets the free slots of one type marked in a map's bitmap, if it has one.
+ * Only the words covering slots handed out so far can have bits set.
+ *
+ * @param map   Map to reset
+ * @param type  Type of node to reset
+ */
+static void mm_clear_bits( mem_map *map, uint32_t type )
+{
+    if( map->free_bits == NULL )
+        return;
+
+    memset( map->free_bits[type], 0,
+        ( map->index_data[type] / 64 + 1 ) * sizeof( uint64_t ) );
+    map->free_low[type] = 0;
+    map->index_bits[type] = 0;
+}
+
+/**
+ * Allocates a slab of node storage from the system, placed as the map's
+ * slabs are.  A slab that cannot be placed is used where it is.
+ *
+ * @param map   Map that needs the slab
+ * @param bytes Size of the slab
+ * @return      The slab
+ */
+static uint8_t* mm_alloc_slab( mem_map *map, uint64_t bytes )
+{
+    uint8_t *slab = malloc( bytes );
+    if( map->placement != MM_PLACE_DEFAULT )
+        mm_place( map, slab, bytes );
+    if( map->prefault )
+        mm_populate( slab, bytes );
+
+    return slab;
+}
+
+/**
+ * Applies the map's placement to a slab.  The policy applies to whole pages,
+ * so the first and last page of the slab may be shared with whatever malloc
+ * put next to it, and pages already touched are moved.
+ *
+ * @param map   Map whose placement to apply
+ * @param slab  Start of the slab
+ * @param bytes Size of the slab
+ * @return      0 on success, -1 on failure
+ */
+static int mm_place( mem_map *map, void *slab, uint64_t bytes )
+{
+    uintptr_t page = (uintptr_t) sysconf( _SC_PAGESIZE );
+    uintptr_t start = (uintptr_t) slab & ~( page - 1 );
+    uintptr_t end = ( (uintptr_t) slab + bytes + page - 1 ) & ~( page - 1 );
+    unsigned long nodes = 0;
+    unsigned long max_node = 8 * sizeof( nodes ) + 1;
+    int mode = MPOL_DEFAULT;
+
+    if( bytes == 0 )
+        return 0;
+
+    if( map->placement == MM_PLACE_BIND )
+    {
+        if( map->placement_node >= 8 * sizeof( nodes ) )
+            return -1;
+        mode = MPOL_BIND;
+        nodes = 1UL << map->placement_node;
+    }
+    else if( map->placement == MM_PLACE_INTERLEAVE )
+    {
+        // every node the process may use
+        if( syscall( SYS_get_mempolicy, NULL, &nodes, max_node, NULL,
+                MPOL_F_MEMS_ALLOWED ) != 0 )
+            return -1;
+        mode = MPOL_INTERLEAVE;
+    }
+
+    return (int) syscall( SYS_mbind, start, end - start, mode,
+        ( mode == MPOL_DEFAULT ) ? NULL : &nodes,
+        ( mode == MPOL_DEFAULT ) ? 0 : max_node, MPOL_MF_MOVE );
+}
+
+/**
+ * Faults in every page of a slab, keeping its contents.
+ *
+ * @param slab  Start of the slab
+ * @param bytes Size of the slab
+ */
+static void mm_populate( uint8_t *slab, uint64_t bytes )
+{
+    uintptr_t page = (uintptr_t) sysconf( _SC_PAGESIZE );
+    volatile uint8_t *touch = slab;
+    uint64_t i;
+
+    if( bytes == 0 )
+        return;
+
+#ifdef MADV_POPULATE_WRITE
+    uintptr_t start = (uintptr_t) slab & ~( page - 1 );
+    uintptr_t end = ( (uintptr_t) slab + bytes + page - 1 ) & ~( page - 1 );
+    if( madvise( (void*) start, end - start, MADV_POPULATE_WRITE ) == 0 )
+        return;
+#endif
+
+    for( i = 0; i < bytes; i += page )
+        touch[i] = touch[i];
+    touch[bytes - 1] = touch[bytes - 1];
+}
+
+/**
+ * Allocates a map's own bookkeeping, without any slabs.
+ *
+ * @param types The number of different types of nodes to manage
+ * @return      Pointer to the new map
+ */
+static mem_map* mm_alloc_map( uint32_t types )
+{
+    mem_map *map = calloc( 1, sizeof( mem_map ) );
+    map->types = types;
+    map->data = malloc( types * sizeof( uint8_t* ) );
+    map->free = malloc( types * sizeof( uint8_t** ) );
+    map->index_data = calloc( types, sizeof( uint32_t ) );
+    map->index_free = calloc( types, sizeof( uint32_t ) );
+    map->melded = calloc( types, sizeof( uint32_t ) );
+    map->adopted_free = calloc( types, sizeof( uint8_t** ) );
+    map->index_adopted = calloc( types, sizeof( uint32_t ) );
+    map->adopted_slots = calloc( types, sizeof( uint32_t ) );
+
+    return map;
+}
+
+/**
+ * Takes a node slab for an arena, the nearest spare along its chain of
+ * parents, falling back to the system.
+ *
+ * @param map   Arena that needs the slab
+ * @param type  Type of node the slab holds
+ * @return      The slab
+ */
+static uint8_t* mm_take_data( mem_map *map, uint32_t type )
 {
-    map->free[type][(map->index_free[type])++] = node;
+    uint8_t *slab;
+    mem_map *owner;
+
+    for( owner = map->parent; owner != NULL; owner = owner->parent )
+    {
+        if( owner->spare_data != NULL &&
+                ( slab = mm_pop( &owner->spare_data[type] ) ) != NULL )
+            return slab;
+    }
+
+    for( owner = map; owner->parent != NULL; owner = owner->parent );
+    owner->arena_bytes[type] += (uint64_t) map->sizes[type] *
+        map->capacities[type];
+    owner->arena_slabs[type]++;
+
+    // a slab must hold the link to the next spare even at zero capacity
+    return mm_alloc_slab( map, MM_MAX( (uint64_t) map->sizes[type] *
+        map->capacities[type], sizeof( uint8_t* ) ) );
+}
+
+/**
+ * Takes a free list slab for an arena, from the same places as
+ * @ref <mm_take_data>.
+ *
+ * @param map   Arena that needs the slab
+ * @param type  Type of node whose free list the slab holds
+ * @return      The slab
+ */
+static uint8_t* mm_take_free( mem_map *map, uint32_t type )
+{
+    uint8_t *slab;
+    mem_map *owner;
+
+    for( owner = map->parent; owner != NULL; owner = owner->parent )
+    {
+        if( owner->spare_free != NULL &&
+                ( slab = mm_pop( &owner->spare_free[type] ) ) != NULL )
+            return slab;
+    }
+
+    slab = malloc( sizeof( uint8_t* ) * MM_MAX( map->capacities[type], 1 ) );
+    if( map->prefault )
+        mm_populate( slab, sizeof( uint8_t* ) * map->capacities[type] );
+
+    return slab;
+}
+
+/**
+ * Pushes a slab onto a list of spares.  Every slab holds at least a pointer.
+ *
+ * @param pool  Head of the list
+ * @param slab  Slab to push
+ */
+static void mm_give( uint8_t **pool, uint8_t *slab )
+{
+    *(uint8_t**) slab = *pool;
+    *pool = slab;
+}
+
+/**
+ * Pops a slab off a list of spares.
+ *
+ * @param pool  Head of the list
+ * @return      The slab, or NULL if the list is empty
+ */
+static uint8_t* mm_pop( uint8_t **pool )
+{
+    uint8_t *slab = *pool;
+    if( slab != NULL )
+        *pool = *(uint8_t**) slab;
+
+    return slab;
+}
+
+/**
+ * Sets up the lists of spare slabs a map needs to be a parent.  Unless the
+ * map has already allocated nodes of a type, its own slabs of that type are
+ * lent out as the first spares, so that a single queue uses the storage
+ * sized for it up front.
+ *
+ * @param map   Map to set up
+ */
+static void mm_create_spares( mem_map *map )
+{
+    int i;
+
+    map->spare_data = calloc( map->types, sizeof( uint8_t* ) );
+    map->spare_free = calloc( map->types, sizeof( uint8_t* ) );
+    for( i = 0; i < map->types; i++ )
+    {
+        if( map->index_data[i] != 0 || map->capacities[i] == 0 )
+            continue;
+        mm_give( &map->spare_data[i], map->data[i] );
+        mm_give( &map->spare_free[i], (uint8_t*) map->free[i] );
+    }
+}
+
+/**
+ * Records a slab a map has taken over from another, and makes room on the
+ * map's stack of adopted free slots for every slot of the slab.
+ *
+ * @param map   Map taking the slab
+ * @param slab  Slab to take
+ */
+static void mm_adopt( mem_map *map, mm_slab slab )
+{
+    if( map->adopted_count == map->adopted_capacity )
+    {
+        map->adopted_capacity = ( map->adopted_capacity == 0 ) ? 8 :
+            map->adopted_capacity * 2;
+        map->adopted = realloc( map->adopted, map->adopted_capacity *
+            sizeof( mm_slab ) );
+    }
+    map->adopted[map->adopted_count++] = slab;
+
+    map->adopted_slots[slab.type] += map->capacities[slab.type];
+    map->adopted_free[slab.type] = realloc( map->adopted_free[slab.type],
+        sizeof( uint8_t* ) * map->adopted_slots[slab.type] );
+}
+
+/**
+ * Hands the slabs adopted from melded maps, which hold no live nodes once the
+ * map is cleared, to the parent's spares, or a top-level map's own.
+ *
+ * @param map   Map to strip of adopted slabs
+ */
+static void mm_release_adopted( mem_map *map )
+{
+    int i;
+    mem_map *owner = ( map->parent != NULL ) ? map->parent : map;
+
+    if( map->adopted_count == 0 )
+        return;
+    for( i = 0; i < map->types; i++ )
+    {
+        map->index_adopted[i] = 0;
+        map->adopted_slots[i] = 0;
+    }
+    if( owner->spare_data == NULL )
+        mm_create_spares( owner );
+
+    for( i = 0; i < map->adopted_count; i++ )
+        mm_give( &owner->spare_data[map->adopted[i].type],
+            map->adopted[i].data );
+    map->adopted_count = 0;
+}
+
+/**
+ * Counts the nodes of a type a map has handed out and not taken back,
+ * including those live in melded maps at the time.
+ *
+ * @param map   Map to query
+ * @param type  Type of node to count
+ * @return      Number of live nodes
+ */
+static uint32_t mm_held( mem_map *map, uint32_t type )
+{
+    uint32_t held = map->index_data[type] - map->index_free[type] -
+        map->index_adopted[type] + map->melded[type];
+    if( map->index_bits != NULL )
+        held -= map->index_bits[type];
+
+    return held;
 }
@@ -11,12 +11,39 @@
 
 #define PQ_MEM_WIDTH 32
 
+/**
+ * Placements of node slabs among NUMA nodes, as set by @ref <mm_set_placement>.
+ */
+#define MM_PLACE_DEFAULT    0
+#define MM_PLACE_BIND       1
+#define MM_PLACE_INTERLEAVE 2
+
+/**
+ * A slab of node storage taken over by one map from another when they are
+ * melded.
+ */
+typedef struct mm_slab_t
+{
+    uint8_t *data;
+    uint32_t type;
+    //! unused; slabs of a type all have the same capacity
+    uint32_t chunk;
+} mm_slab;
+
 /**
  * Basic memory pool to use for node allocation.  Memory maps can be shared
  * between multiple queues for the purpose of melding.  The size of the pool is
  * doubled when the current capacity is exceeded.
+ *
+ * A map can also be an arena carved from a parent map, as each queue makes
+ * for itself.  An arena has its parent's capacities, and takes its slabs from
+ * those the parent's other arenas have given back, the first arena getting
+ * the parent's own, before asking the system.  It gives them all back when
+ * destroyed, so queues come and go without returning memory to the system.
+ * Clearing or destroying an arena affects no other map.  All maps in a
+ * hierarchy share their live and peak counts, which therefore cover every
+ * queue.
  */
-
 typedef struct mem_map_t
 {
     //! number of different node types
@@ -31,12 +58,80 @@ typedef struct mem_map_t
 
     uint32_t *index_data;
     uint32_t *index_free;
+
+    //! nodes of each type currently allocated
+    uint32_t *live;
+    //! most nodes of each type allocated at once
+    uint32_t *peak;
+
+    //! free slots of each type in the map's own slab, one bit per slot, when
+    //! handed out in address order; NULL unless @ref <mm_order_free_slots>
+    uint64_t **free_bits;
+    //! lowest word of each bitmap that may have a bit set
+    uint32_t *free_low;
+    //! slots of each type marked free in the bitmaps
+    uint32_t *index_bits;
+
+    //! zero nodes allocated by @ref <pq_alloc_node_uninit> too, to measure
+    //! what skipping it saves; arenas take the flag from their parent
+    uint32_t zero_all;
+
+    //! NUMA placement of node slabs and the node they are bound to; arenas
+    //! take both from their parent
+    uint32_t placement;
+    uint32_t placement_node;
+
+    //! fault in the pages of every slab obtained from the system, see
+    //! @ref <mm_prefault>; arenas take the flag from their parent
+    uint32_t prefault;
+
+    //! map this arena draws its slabs from, or NULL for a top-level map
+    struct mem_map_t *parent;
+    //! slabs given back by arenas, per type, each linked to the next through
+    //! its first word; NULL until the map has had an arena
+    uint8_t **spare_data;
+    uint8_t **spare_free;
+    //! slabs taken over from melded maps
+    mm_slab *adopted;
+    uint32_t adopted_count;
+    uint32_t adopted_capacity;
+    //! nodes of each type that were live in melded maps when they were melded
+    uint32_t *melded;
+    //! free slots of each type in adopted slabs, which the map's own stacks
+    //! are too short to take, with room for every slot of those slabs
+    uint8_t ***adopted_free;
+    uint32_t *index_adopted;
+    uint32_t *adopted_slots;
+    //! node storage obtained from the system for arenas, kept by the top-level
+    //! map only
+    uint64_t *arena_bytes;
+    uint32_t *arena_slabs;
 } mem_map;
 
+/**
+ * Footprint of a single node type, as reported by @ref <mm_get_stats>.  Byte
+ * counts cover node storage only, not the map's own bookkeeping.
+ */
+typedef struct mm_stats_t
+{
+    //! bytes held by nodes currently allocated
+    uint64_t live_bytes;
+    //! high-water mark of live_bytes since the map was created
+    uint64_t peak_bytes;
+    //! bytes of node storage obtained from the system
+    uint64_t reserved_bytes;
+    //! number of separate allocations backing the node storage
+    uint32_t slabs;
+} mm_stats;
+
 //==============================================================================
 // PUBLIC DECLARATIONS
 //==============================================================================
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * Creates a new memory map for the specified node sizes
  *
@@ -48,19 +143,85 @@ typedef struct mem_map_t
 mem_map* mm_create( uint32_t types, uint32_t *sizes, uint32_t *capacities );
 
 /**
- * Releases all allocated memory associated with the map.
+ * Creates an arena for the nodes of a single queue, carved from a parent map.
+ * The parent may itself be an arena, and the arena has the same capacities.
+ * Every arena must be destroyed before its parent, and once a map has arenas
+ * it should neither be cleared while they hold nodes nor allocate nodes
+ * itself, since its own slabs may be lent to them.
+ *
+ * @param parent    Map from which to take slabs
+ * @return          Pointer to the new arena
+ */
+mem_map* mm_create_arena( mem_map *parent );
+
+/**
+ * Releases all allocated memory associated with the map.  An arena gives its
+ * slabs back to its parent instead, in time independent of how many nodes it
+ * held.
  *
  * @param map   Map to deallocate
  */
 void mm_destroy( mem_map *map );
 
 /**
- * Resets map to initial state.  Does not deallocate memory.
+ * Resets map to initial state.  Does not deallocate memory.  Slabs adopted
+ * through @ref <mm_meld> are handed to the parent's spare slabs.
  *
  * @param map   Map to reset
  */
 void mm_clear( mem_map *map );
 
+/**
+ * Hands all the node storage of one map to another, so that nodes allocated
+ * from the source stay valid for as long as the destination holds them.
+ * Source nodes freed afterwards go to a free stack the destination keeps for
+ * adopted slabs, grown by a slab's worth of slots with each; the source's
+ * own free list is dropped, and its slots stay unused until the destination
+ * is cleared.  The source is left empty but usable.  Both maps
+ * must share a top-level map.
+ *
+ * @param dst   Map to take over the storage
+ * @param src   Map to give it up
+ */
+void mm_meld( mem_map *dst, mem_map *src );
+
+/**
+ * Makes the map hand out free slots of its own slabs lowest address first,
+ * tracking them in a bitmap rather than a stack, so that the nodes a queue
+ * holds after many deletions stay packed towards the start of its slab.
+ * Slots of slabs adopted through @ref <mm_meld> are still recycled last in,
+ * first out.  Must be called before the map allocates; arenas carved from it
+ * afterwards follow the same policy.
+ *
+ * @param map   Map to set up
+ */
+void mm_order_free_slots( mem_map *map );
+
+/**
+ * Places the map's node slabs on NUMA nodes, binding them to a single node or
+ * interleaving them page by page across all nodes.  Slabs already allocated
+ * are moved, and slabs the map or its arenas obtain later follow the same
+ * placement.  Uses the mbind system call directly, so needs no libnuma.
+ *
+ * @param map       Top-level map to place, before it has arenas
+ * @param placement One of the MM_PLACE_ values
+ * @param node      Node to bind to, for MM_PLACE_BIND
+ * @return          0 on success, -1 if the kernel refused the placement
+ */
+int mm_set_placement( mem_map *map, uint32_t placement, uint32_t node );
+
+/**
+ * Faults in every page of the map's slabs now, and of the slabs it or its
+ * arenas obtain from the system later as they are obtained, so that first
+ * touches of node storage do not land in timed code.  Pages are faulted in
+ * with MADV_POPULATE_WRITE where the kernel has it, and by writing each page
+ * otherwise.  Should follow @ref <mm_set_placement>, so that the pages are
+ * faulted in where they are placed.
+ *
+ * @param map   Top-level map to prefault, before it has arenas
+ */
+void mm_prefault( mem_map *map );
+
 /**
  * Allocates a single node from the memory pool.  First attempts to recycle old
  * data from the free list.  If there is nothing to recycle, then it takes a new
@@ -72,6 +233,17 @@ void mm_clear( mem_map *map );
  */
 void* pq_alloc_node( mem_map *map, uint32_t type );
 
+/**
+ * Allocates a single node as @ref <pq_alloc_node> does, but leaves its memory
+ * as the last user left it.  The caller must set every field it will read.
+ * Nodes are still zeroed if the map's zero_all flag is set.
+ *
+ * @param map   Map from which to allocate
+ * @param type  Type of node to allocate
+ * @return      Pointer to allocated node
+ */
+void* pq_alloc_node_uninit( mem_map *map, uint32_t type );
+
 /**
  * Takes a previously allocated node and adds it to the free list to be
  * recycled with further allocation requests.
@@ -82,4 +254,18 @@ void* pq_alloc_node( mem_map *map, uint32_t type );
  */
 void pq_free_node( mem_map *map, uint32_t type, void *node );
 
+/**
+ * Reports current and peak usage of one node type.  Peak usage survives
+ * @ref <mm_clear>, so it covers every pass made over the map.
+ *
+ * @param map   Map to query
+ * @param type  Type of node to report on
+ * @param stats Struct to fill in
+ */
+void mm_get_stats( mem_map *map, uint32_t type, mm_stats *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -1,5 +1,8 @@
 #include "memory_management_lazy.h"
 #include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 
 //==============================================================================
 // STATIC DECLARATIONS
@@ -17,8 +20,20 @@ static const uint32_t mm_sizes[PQ_MEM_WIDTH] =
     0x10000000, 0x20000000, 0x40000000, 0x80000000
 };
 
+static inline void* mm_next_node( mem_map *map, uint32_t type );
+static mem_map* mm_alloc_map( uint32_t types );
 static void mm_grow_data( mem_map *map, uint32_t type );
 static void mm_grow_free( mem_map *map, uint32_t type );
+static uint8_t* mm_take_data( mem_map *map, uint32_t type, uint32_t chunk );
+static uint8_t* mm_take_free( mem_map *map, uint32_t type, uint32_t chunk );
+static void mm_give( uint8_t **pool, uint8_t *slab );
+static uint8_t* mm_pop( uint8_t **pool );
+static void mm_create_spares( mem_map *map );
+static void mm_adopt( mem_map *map, mm_slab slab );
+static void mm_release_adopted( mem_map *map );
+static uint32_t mm_held( mem_map *map, uint32_t type );
+static uint8_t* mm_alloc_slab( mem_map *map, uint64_t bytes );
+static int mm_place( mem_map *map, void *slab, uint64_t bytes );
 
 //==============================================================================
 // PUBLIC METHODS
@@ -28,51 +43,121 @@ mem_map* mm_create( uint32_t types, uint32_t *sizes )
 {
     int i;
 
-    mem_map *map = malloc( sizeof( mem_map ) );
-    map->types = types;
+    mem_map *map = mm_alloc_map( types );
     map->sizes = malloc( types * sizeof( uint32_t ) );
-    map->data = malloc( types * sizeof( uint8_t* ) );
-    map->free = malloc( types * sizeof( uint8_t** ) );
-    map->chunk_data = calloc( types, sizeof( uint32_t ) );
-    map->chunk_free = calloc( types, sizeof( uint32_t ) );
-    map->index_data = calloc( types, sizeof( uint32_t ) );
-    map->index_free = calloc( types, sizeof( uint32_t ) );
-
+    map->live = calloc( types, sizeof( uint32_t ) );
+    map->peak = calloc( types, sizeof( uint32_t ) );
+    map->arena_bytes = calloc( types, sizeof( uint64_t ) );
+    map->arena_slabs = calloc( types, sizeof( uint32_t ) );
 
     for( i = 0; i < types; i++ )
     {
         map->sizes[i] = sizes[i];
 
-        map->data[i] = calloc( PQ_MEM_WIDTH, sizeof( uint8_t* ) );
-        map->free[i] = calloc( PQ_MEM_WIDTH, sizeof( uint8_t** ) );
-
-        map->data[i][0] = malloc( map->sizes[i] );
+        map->data[i][0] = mm_alloc_slab( map, map->sizes[i] );
         map->free[i][0] = malloc( sizeof( uint8_t* ) );
     }
 
     return map;
 }
 
+mem_map* mm_create_arena( mem_map *parent )
+{
+    int i;
+
+    mem_map *map = mm_alloc_map( parent->types );
+    map->parent = parent;
+    map->zero_all = parent->zero_all;
+    map->placement = parent->placement;
+    map->placement_node = parent->placement_node;
+    map->sizes = parent->sizes;
+    map->live = parent->live;
+    map->peak = parent->peak;
+
+    if( parent->spare_data == NULL )
+        mm_create_spares( parent );
+
+    for( i = 0; i < map->types; i++ )
+    {
+        map->data[i][0] = mm_take_data( map, i, 0 );
+        map->free[i][0] = (uint8_t**) mm_take_free( map, i, 0 );
+    }
+
+    return map;
+}
+
 void mm_destroy( mem_map *map )
 {
     int i, j;
+    mem_map *parent = map->parent;
+
+    if( parent != NULL )
+        mm_clear( map );
+
     for( i = 0; i < map->types; i++ )
     {
         for( j = 0; j < PQ_MEM_WIDTH; j++ )
         {
+            if( parent != NULL )
+            {
+                if( map->data[i][j] != NULL )
+                    mm_give( &parent->spare_data[i][j], map->data[i][j] );
+                if( map->free[i][j] != NULL )
+                    mm_give( &parent->spare_free[i][j],
+                        (uint8_t*) map->free[i][j] );
+                // spares of an arena's own arenas pass up to its parent
+                if( map->spare_data != NULL )
+                {
+                    while( map->spare_data[i][j] != NULL )
+                        mm_give( &parent->spare_data[i][j],
+                            mm_pop( &map->spare_data[i][j] ) );
+                    while( map->spare_free[i][j] != NULL )
+                        mm_give( &parent->spare_free[i][j],
+                            mm_pop( &map->spare_free[i][j] ) );
+                }
+                continue;
+            }
+
             if( map->data[i][j] != NULL )
                 free( map->data[i][j] );
             if( map->free[i][j] != NULL )
                 free( map->free[i][j] );
+            if( map->spare_data != NULL )
+            {
+                while( map->spare_data[i][j] != NULL )
+                    free( mm_pop( &map->spare_data[i][j] ) );
+                while( map->spare_free[i][j] != NULL )
+                    free( mm_pop( &map->spare_free[i][j] ) );
+            }
         }
 
         free( map->data[i] );
         free( map->free[i] );
+        if( map->spare_data != NULL )
+        {
+            free( map->spare_data[i] );
+            free( map->spare_free[i] );
+        }
+    }
+
+    for( i = 0; i < map->adopted_count; i++ )
+        free( map->adopted[i].data );
+
+    if( parent == NULL )
+    {
+        free( map->sizes );
+        free( map->live );
+        free( map->peak );
+        free( map->arena_bytes );
+        free( map->arena_slabs );
     }
 
     free( map->data );
     free( map->free );
-    free( map->sizes );
+    free( map->spare_data );
+    free( map->spare_free );
+    free( map->adopted );
+    free( map->melded );
     free( map->chunk_data );
     free( map->chunk_free );
     free( map->index_data );
@@ -86,14 +171,142 @@ void mm_clear( mem_map *map )
     int i;
     for( i = 0; i < map->types; i++ )
     {
+        // an arena's nodes are only its share of the common count
+        if( map->parent != NULL )
+            map->live[i] -= mm_held( map, i );
+        else
+            map->live[i] = 0;
+
         map->chunk_data[i] = 0;
         map->chunk_free[i] = 0;
         map->index_data[i] = 0;
         map->index_free[i] = 0;
+        map->melded[i] = 0;
     }
+
+    mm_release_adopted( map );
+}
+
+void mm_meld( mem_map *dst, mem_map *src )
+{
+    int i, j;
+    mm_slab slab;
+
+    if( dst == src )
+        return;
+
+    for( i = 0; i < src->types; i++ )
+    {
+        dst->melded[i] += mm_held( src, i );
+
+        for( j = 0; j < PQ_MEM_WIDTH; j++ )
+        {
+            if( src->data[i][j] == NULL )
+                continue;
+
+            slab.data = src->data[i][j];
+            slab.type = i;
+            slab.chunk = j;
+            mm_adopt( dst, slab );
+            src->data[i][j] = NULL;
+        }
+
+        // the slots listed are now the destination's, which cannot reach them
+        src->chunk_data[i] = 0;
+        src->chunk_free[i] = 0;
+        src->index_data[i] = 0;
+        src->index_free[i] = 0;
+        src->melded[i] = 0;
+        src->data[i][0] = ( src->parent != NULL ) ? mm_take_data( src, i, 0 ) :
+            mm_alloc_slab( src, src->sizes[i] );
+    }
+
+    for( i = 0; i < src->adopted_count; i++ )
+        mm_adopt( dst, src->adopted[i] );
+    src->adopted_count = 0;
+}
+
+int mm_set_placement( mem_map *map, uint32_t placement, uint32_t node )
+{
+    int i, j;
+
+    map->placement = placement;
+    map->placement_node = node;
+    for( i = 0; i < map->types; i++ )
+    {
+        for( j = 0; j < PQ_MEM_WIDTH; j++ )
+        {
+            if( map->data[i][j] != NULL && mm_place( map, map->data[i][j],
+                    (uint64_t) map->sizes[i] * mm_sizes[j] ) != 0 )
+                return -1;
+        }
+    }
+
+    return 0;
 }
 
 void* pq_alloc_node( mem_map *map, uint32_t type )
+{
+    void *node = mm_next_node( map, type );
+    memset( node, 0, map->sizes[type] );
+
+    return node;
+}
+
+void* pq_alloc_node_uninit( mem_map *map, uint32_t type )
+{
+    void *node = mm_next_node( map, type );
+    if( map->zero_all )
+        memset( node, 0, map->sizes[type] );
+
+    return node;
+}
+
+void pq_free_node( mem_map *map, uint32_t type, void *node )
+{
+    map->live[type]--;
+
+    if( map->index_free[type] == mm_sizes[map->chunk_free[type]] )
+        mm_grow_free( map, type );
+
+    map->free[type][map->chunk_free[type]][(map->index_free[type])++] = node;
+}
+
+void mm_get_stats( mem_map *map, uint32_t type, mm_stats *stats )
+{
+    int j;
+
+    stats->live_bytes = (uint64_t) map->live[type] * map->sizes[type];
+    stats->peak_bytes = (uint64_t) map->peak[type] * map->sizes[type];
+    stats->reserved_bytes = 0;
+    stats->slabs = 0;
+    for( j = 0; j < PQ_MEM_WIDTH; j++ )
+    {
+        if( map->data[type][j] == NULL )
+            continue;
+        stats->reserved_bytes += (uint64_t) map->sizes[type] * mm_sizes[j];
+        stats->slabs++;
+    }
+    if( map->arena_bytes != NULL )
+    {
+        stats->reserved_bytes += map->arena_bytes[type];
+        stats->slabs += map->arena_slabs[type];
+    }
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Takes the next node slot, recycling from the free list first, and counts
+ * it as live.  Leaves its memory untouched.
+ *
+ * @param map   Map from which to allocate
+ * @param type  Type of node to allocate
+ * @return      Pointer to the node
+ */
+static inline void* mm_next_node( mem_map *map, uint32_t type )
 {
     void *node;
     if ( map->chunk_free[type] == 0 && map->index_free[type] == 0 )
@@ -113,30 +326,53 @@ void* pq_alloc_node( mem_map *map, uint32_t type )
             map->free[type][map->chunk_free[type]][--(map->index_free[type])];
     }
 
-    memset( node, 0, map->sizes[type] );
+    if( ++(map->live[type]) > map->peak[type] )
+        map->peak[type] = map->live[type];
 
     return node;
 }
 
-void pq_free_node( mem_map *map, uint32_t type, void *node )
+/**
+ * Allocates a map's own bookkeeping, with empty slab tables.
+ *
+ * @param types The number of different types of nodes to manage
+ * @return      Pointer to the new map
+ */
+static mem_map* mm_alloc_map( uint32_t types )
 {
-    if( map->index_free[type] == mm_sizes[map->chunk_free[type]] )
-        mm_grow_free( map, type );
+    int i;
 
-    map->free[type][map->chunk_free[type]][(map->index_free[type])++] = node;
-}
+    mem_map *map = calloc( 1, sizeof( mem_map ) );
+    map->types = types;
+    map->data = malloc( types * sizeof( uint8_t* ) );
+    map->free = malloc( types * sizeof( uint8_t** ) );
+    map->chunk_data = calloc( types, sizeof( uint32_t ) );
+    map->chunk_free = calloc( types, sizeof( uint32_t ) );
+    map->index_data = calloc( types, sizeof( uint32_t ) );
+    map->index_free = calloc( types, sizeof( uint32_t ) );
+    map->melded = calloc( types, sizeof( uint32_t ) );
 
-//==============================================================================
-// STATIC METHODS
-//==============================================================================
+    for( i = 0; i < types; i++ )
+    {
+        map->data[i] = calloc( PQ_MEM_WIDTH, sizeof( uint8_t* ) );
+        map->free[i] = calloc( PQ_MEM_WIDTH, sizeof( uint8_t** ) );
+    }
+
+    return map;
+}
 
 static void mm_grow_data( mem_map *map, uint32_t type )
 {
     uint32_t chunk = ++(map->chunk_data[type]);
     map->index_data[type] = 0;
 
-    if( map->data[type][chunk] == NULL )
-        map->data[type][chunk] = malloc( map->sizes[type] * mm_sizes[chunk] );
+    if( map->data[type][chunk] != NULL )
+        return;
+    if( map->parent != NULL )
+        map->data[type][chunk] = mm_take_data( map, type, chunk );
+    else
+        map->data[type][chunk] = mm_alloc_slab( map,
+            (uint64_t) map->sizes[type] * mm_sizes[chunk] );
 }
 
 static void mm_grow_free( mem_map *map, uint32_t type )
@@ -144,7 +380,228 @@ static void mm_grow_free( mem_map *map, uint32_t type )
     uint32_t chunk = ++(map->chunk_free[type]);
     map->index_free[type] = 0;
 
-    if( map->free[type][chunk] == NULL )
-        map->free[type][chunk] = malloc( map->sizes[type] * mm_sizes[chunk] );
+    if( map->free[type][chunk] != NULL )
+        return;
+    if( map->parent != NULL )
+        map->free[type][chunk] = (uint8_t**) mm_take_free( map, type, chunk );
+    else
+        map->free[type][chunk] = malloc( sizeof( uint8_t* ) * mm_sizes[chunk] );
+}
+
+/**
+ * Takes a node slab of the given chunk size for a map.  A top-level map takes
+ * one from its own spares, and an arena the nearest spare along its chain of
+ * parents, falling back to the system.
+ *
+ * @param map   Map that needs the slab
+ * @param type  Type of node the slab holds
+ * @param chunk Index of the slab's size
+ * @return      The slab
+ */
+static uint8_t* mm_take_data( mem_map *map, uint32_t type, uint32_t chunk )
+{
+    uint8_t *slab;
+    mem_map *owner = ( map->parent != NULL ) ? map->parent : map;
+
+    for( ; owner != NULL; owner = owner->parent )
+    {
+        if( owner->spare_data != NULL &&
+                ( slab = mm_pop( &owner->spare_data[type][chunk] ) ) != NULL )
+            return slab;
+    }
+
+    for( owner = map; owner->parent != NULL; owner = owner->parent );
+    owner->arena_bytes[type] += (uint64_t) map->sizes[type] * mm_sizes[chunk];
+    owner->arena_slabs[type]++;
+
+    return mm_alloc_slab( map, (uint64_t) map->sizes[type] * mm_sizes[chunk] );
 }
 
+/**
+ * Takes a free list slab of the given chunk size for a map, from the same
+ * places as @ref <mm_take_data>.
+ *
+ * @param map   Map that needs the slab
+ * @param type  Type of node whose free list the slab extends
+ * @param chunk Index of the slab's size
+ * @return      The slab
+ */
+static uint8_t* mm_take_free( mem_map *map, uint32_t type, uint32_t chunk )
+{
+    uint8_t *slab;
+    mem_map *owner = ( map->parent != NULL ) ? map->parent : map;
+
+    for( ; owner != NULL; owner = owner->parent )
+    {
+        if( owner->spare_free != NULL &&
+                ( slab = mm_pop( &owner->spare_free[type][chunk] ) ) != NULL )
+            return slab;
+    }
+
+    return malloc( sizeof( uint8_t* ) * mm_sizes[chunk] );
+}
+
+/**
+ * Pushes a slab onto a list of spares.  Every slab holds at least a pointer.
+ *
+ * @param pool  Head of the list
+ * @param slab  Slab to push
+ */
+static void mm_give( uint8_t **pool, uint8_t *slab )
+{
+    *(uint8_t**) slab = *pool;
+    *pool = slab;
+}
+
+/**
+ * Pops a slab off a list of spares.
+ *
+ * @param pool  Head of the list
+ * @return      The slab, or NULL if the list is empty
+ */
+static uint8_t* mm_pop( uint8_t **pool )
+{
+    uint8_t *slab = *pool;
+    if( slab != NULL )
+        *pool = *(uint8_t**) slab;
+
+    return slab;
+}
+
+/**
+ * Sets up the empty lists of spare slabs a map needs to be a parent.
+ *
+ * @param map   Map to set up
+ */
+static void mm_create_spares( mem_map *map )
+{
+    int i;
+
+    map->spare_data = malloc( map->types * sizeof( uint8_t** ) );
+    map->spare_free = malloc( map->types * sizeof( uint8_t** ) );
+    for( i = 0; i < map->types; i++ )
+    {
+        map->spare_data[i] = calloc( PQ_MEM_WIDTH, sizeof( uint8_t* ) );
+        map->spare_free[i] = calloc( PQ_MEM_WIDTH, sizeof( uint8_t* ) );
+    }
+}
+
+/**
+ * Records a slab a map has taken over from another.
+ *
+ * @param map   Map taking the slab
+ * @param slab  Slab to take
+ */
+static void mm_adopt( mem_map *map, mm_slab slab )
+{
+    if( map->adopted_count == map->adopted_capacity )
+    {
+        map->adopted_capacity = ( map->adopted_capacity == 0 ) ? 8 :
+            map->adopted_capacity * 2;
+        map->adopted = realloc( map->adopted, map->adopted_capacity *
+            sizeof( mm_slab ) );
+    }
+    map->adopted[map->adopted_count++] = slab;
+}
+
+/**
+ * Hands the slabs adopted from melded maps, which hold no live nodes once the
+ * map is cleared, to the parent's spares, or a top-level map's own.
+ *
+ * @param map   Map to strip of adopted slabs
+ */
+static void mm_release_adopted( mem_map *map )
+{
+    int i;
+    mem_map *owner = ( map->parent != NULL ) ? map->parent : map;
+
+    if( map->adopted_count == 0 )
+        return;
+    if( owner->spare_data == NULL )
+        mm_create_spares( owner );
+
+    for( i = 0; i < map->adopted_count; i++ )
+        mm_give( &owner->spare_data[map->adopted[i].type]
+            [map->adopted[i].chunk], map->adopted[i].data );
+    map->adopted_count = 0;
+}
+
+/**
+ * Counts the nodes of a type a map has handed out and not taken back,
+ * including those live in melded maps at the time.  Every chunk below the
+ * current one is full, and chunk sizes double from one, so a position in the
+ * slabs converts directly to a count.
+ *
+ * @param map   Map to query
+ * @param type  Type of node to count
+ * @return      Number of live nodes
+ */
+static uint32_t mm_held( mem_map *map, uint32_t type )
+{
+    uint32_t handed = mm_sizes[map->chunk_data[type]] - 1 +
+        map->index_data[type];
+    uint32_t freed = mm_sizes[map->chunk_free[type]] - 1 +
+        map->index_free[type];
+
+    return handed - freed + map->melded[type];
+}
+
+/**
+ * Allocates a slab of node storage from the system, placed as the map's
+ * slabs are.  A slab that cannot be placed is used where it is.
+ *
+ * @param map   Map that needs the slab
+ * @param bytes Size of the slab
+ * @return      The slab
+ */
+static uint8_t* mm_alloc_slab( mem_map *map, uint64_t bytes )
+{
+    uint8_t *slab = malloc( bytes );
+    if( map->placement != MM_PLACE_DEFAULT )
+        mm_place( map, slab, bytes );
+
+    return slab;
+}
+
+/**
+ * Applies the map's placement to a slab.  The policy applies to whole pages,
+ * so the first and last page of the slab may be shared with whatever malloc
+ * put next to it, and pages already touched are moved.
+ *
+ * @param map   Map whose placement to apply
+ * @param slab  Start of the slab
+ * @param bytes Size of the slab
+ * @return      0 on success, -1 on failure
+ */
+static int mm_place( mem_map *map, void *slab, uint64_t bytes )
+{
+    uintptr_t page = (uintptr_t) sysconf( _SC_PAGESIZE );
+    uintptr_t start = (uintptr_t) slab & ~( page - 1 );
+    uintptr_t end = ( (uintptr_t) slab + bytes + page - 1 ) & ~( page - 1 );
+    unsigned long nodes = 0;
+    unsigned long max_node = 8 * sizeof( nodes ) + 1;
+    int mode = MPOL_DEFAULT;
+
+    if( bytes == 0 )
+        return 0;
+
+    if( map->placement == MM_PLACE_BIND )
+    {
+        if( map->placement_node >= 8 * sizeof( nodes ) )
+            return -1;
+        mode = MPOL_BIND;
+        nodes = 1UL << map->placement_node;
+    }
+    else if( map->placement == MM_PLACE_INTERLEAVE )
+    {
+        // every node the process may use
+        if( syscall( SYS_get_mempolicy, NULL, &nodes, max_node, NULL,
+                MPOL_F_MEMS_ALLOWED ) != 0 )
+            return -1;
+        mode = MPOL_INTERLEAVE;
+    }
+
+    return (int) syscall( SYS_mbind, start, end - start, mode,
+        ( mode == MPOL_DEFAULT ) ? NULL : &nodes,
+        ( mode == MPOL_DEFAULT ) ? 0 : max_node, MPOL_MF_MOVE );
+}
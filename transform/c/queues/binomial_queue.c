@@ -21,7 +21,7 @@ static void swap_with_parent( binomial_queue *queue, binomial_node *node,
 binomial_queue* pq_create( mem_map *map )
 {
     binomial_queue *queue = calloc( 1, sizeof( binomial_queue ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
 
     return queue;
 }
@@ -29,6 +29,7 @@ binomial_queue* pq_create( mem_map *map )
 void pq_destroy( binomial_queue *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -99,7 +100,7 @@ key_type pq_delete( binomial_queue *queue, binomial_node *node )
 {
     key_type key = node->key;
 
-    pq_decrease_key( queue, node, 0 );
+    pq_decrease_key( queue, node, PQ_KEY_FRONT );
     pq_delete_min( queue );
 
     return key;
@@ -120,13 +121,13 @@ void pq_decrease_key( binomial_queue *queue, binomial_node *node,
             parent = current->parent;
         }
 
-        if( node->key < parent->key )
+        if( PQ_KEY_BEFORE( node->key, parent->key ) )
             swap_with_parent( queue, node, parent );
         else
             break;
     }
 
-    if( new_key < queue->minimum->key )
+    if( PQ_KEY_BEFORE( new_key, queue->minimum->key ) )
         queue->minimum = node;
 }
 
@@ -150,7 +151,8 @@ static void make_root( binomial_queue *queue, binomial_node *node )
     node->parent = NULL;
     node->right = NULL;
 
-    if( queue->minimum == NULL || node->key < queue->minimum->key )
+    if( queue->minimum == NULL ||
+            PQ_KEY_BEFORE( node->key, queue->minimum->key ) )
         queue->minimum = node;
 
     binomial_node *result = node;
@@ -177,7 +179,7 @@ static void cherry_pick_min( binomial_queue *queue )
     {
         rank = REGISTRY_LEADER( registry );
         REGISTRY_UNSET( registry, rank );
-        if( queue->roots[rank]->key < queue->roots[min]->key )
+        if( PQ_KEY_BEFORE( queue->roots[rank]->key, queue->roots[min]->key ) )
             min = rank;
     }
 
@@ -196,7 +198,7 @@ static binomial_node* join( binomial_queue *queue, binomial_node *a,
     binomial_node *b )
 {
     binomial_node *parent, *child;
-    if( b->key < a->key)
+    if( PQ_KEY_BEFORE( b->key, a->key ))
     {
         parent = b;
         child = a;
@@ -0,0 +1,607 @@
+#include "bucket_queue.h"
+
+//==============================================================================
+// DEFINES AND STATIC DECLARATIONS
+//==============================================================================
+
+#define PRIORITY(a) ( (a) >> BUCKET_KEY_SHIFT )
+// highest bit at which two distinct priorities differ
+#define LEVEL(a,b)  ( (uint32_t) ( 63 - __builtin_clzll( (a) ^ (b) ) ) )
+
+static bucket_node** locate( bucket_queue *queue, bucket_node *node );
+static void place( bucket_queue *queue, bucket_node *node );
+static void remove_from( bucket_queue *queue, bucket_node **list,
+    bucket_node *node );
+static void lower_window( bucket_queue *queue, uint64_t priority );
+static void refill( bucket_queue *queue );
+static uint32_t place_all( bucket_queue *queue, bucket_node *list );
+static uint32_t next_occupied( bucket_queue *queue, uint32_t start );
+static void list_link( bucket_node **list, bucket_node *node );
+static void list_unlink( bucket_node **list, bucket_node *node );
+static uint32_t list_splice( bucket_node **dst, bucket_node *src );
+static void list_insert_sorted( bucket_node **list, bucket_node *node );
+static void list_sort( bucket_node **list );
+
+//==============================================================================
+// PUBLIC METHODS
+//==============================================================================
+
+bucket_queue* pq_create( mem_map *map )
+{
+    bucket_queue *queue = calloc( 1, sizeof( bucket_queue ) );
+    queue->map = mm_create_arena( map );
+
+    return queue;
+}
+
+void pq_destroy( bucket_queue *queue )
+{
+    pq_clear( queue );
+    mm_destroy( queue->map );
+    free( queue );
+}
+
+void pq_clear( bucket_queue *queue )
+{
+    mm_clear( queue->map );
+    queue->size = 0;
+    queue->overflow_size = 0;
+    queue->base = 0;
+    queue->cursor = 0;
+    queue->minimum = NULL;
+    queue->sorted = NULL;
+    queue->overflow_levels = 0;
+    memset( queue->overflow, 0, BUCKET_LEVELS * sizeof( bucket_node* ) );
+    memset( queue->occupied, 0, BUCKET_WORDS * sizeof( uint64_t ) );
+    memset( queue->buckets, 0, BUCKET_COUNT * sizeof( bucket_node* ) );
+}
+
+key_type pq_get_key( bucket_queue *queue, bucket_node *node )
+{
+    return PQ_KEY_ORDER( node->key );
+}
+
+item_type* pq_get_item( bucket_queue *queue, bucket_node *node )
+{
+    return (item_type*) &(node->item);
+}
+
+uint32_t pq_get_size( bucket_queue *queue )
+{
+    return queue->size;
+}
+
+bucket_node* pq_insert( bucket_queue *queue, item_type item, key_type key )
+{
+    // keys are stored so that the front of the queue is the smallest
+    key = PQ_KEY_ORDER( key );
+    uint64_t priority = PRIORITY( key );
+    bucket_node *wrapper = pq_alloc_node( queue->map, 0 );
+    ITEM_ASSIGN( wrapper->item, item );
+    wrapper->key = key;
+
+    // an empty queue can start its window wherever the new key lies
+    if ( queue->size == 0 )
+    {
+        queue->base = priority;
+        queue->cursor = priority;
+    }
+    else if ( priority < queue->base )
+        lower_window( queue, priority );
+
+    queue->size++;
+    place( queue, wrapper );
+
+    if ( queue->size == 1 ||
+            ( queue->minimum != NULL && key < queue->minimum->key ) )
+        queue->minimum = wrapper;
+
+    return wrapper;
+}
+
+bucket_node* pq_find_min( bucket_queue *queue )
+{
+    uint32_t slot;
+
+    if ( pq_empty( queue ) )
+        return NULL;
+    if ( queue->minimum != NULL )
+        return queue->minimum;
+
+    if ( queue->size == queue->overflow_size )
+        refill( queue );
+
+    slot = next_occupied( queue, (uint32_t) ( queue->cursor & BUCKET_MASK ) );
+    queue->cursor += ( slot - queue->cursor ) & BUCKET_MASK;
+
+    // every node in the bucket shares a priority, so only the low bits differ
+    if ( queue->sorted != &queue->buckets[slot] )
+    {
+        list_sort( &queue->buckets[slot] );
+        queue->sorted = &queue->buckets[slot];
+    }
+    queue->minimum = queue->buckets[slot];
+
+    return queue->minimum;
+}
+
+key_type pq_delete_min( bucket_queue *queue )
+{
+    return pq_delete( queue, pq_find_min( queue ) );
+}
+
+key_type pq_delete( bucket_queue *queue, bucket_node *node )
+{
+    key_type key = node->key;
+
+    if ( node == queue->minimum )
+        queue->minimum = NULL;
+
+    remove_from( queue, locate( queue, node ), node );
+    pq_free_node( queue->map, 0, node );
+    queue->size--;
+
+    return PQ_KEY_ORDER( key );
+}
+
+void pq_decrease_key( bucket_queue *queue, bucket_node *node, key_type new_key )
+{
+    new_key = PQ_KEY_ORDER( new_key );
+    uint64_t priority = PRIORITY( new_key );
+    bucket_node **list = locate( queue, node );
+
+    if ( priority < queue->base )
+    {
+        remove_from( queue, list, node );
+        node->key = new_key;
+        lower_window( queue, priority );
+        place( queue, node );
+    }
+    else
+    {
+        node->key = new_key;
+        if ( locate( queue, node ) != list || list == queue->sorted )
+        {
+            // relink from the old location, which the new key may no longer map to
+            remove_from( queue, list, node );
+            place( queue, node );
+        }
+    }
+
+    if ( queue->minimum != NULL && new_key < queue->minimum->key )
+        queue->minimum = node;
+}
+
+bool pq_empty( bucket_queue *queue )
+{
+    return ( queue->size == 0 );
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Finds the list in which a node currently resides.  Relies on the invariant
+ * that every priority in the queue is at least the window base, and that
+ * everything in the overflow levels lies above the window, in the level of
+ * its highest bit differing from the base.
+ *
+ * @param queue Queue in which the node resides
+ * @param node  Node to locate
+ * @return      Address of the head pointer of the node's list
+ */
+static bucket_node** locate( bucket_queue *queue, bucket_node *node )
+{
+    uint64_t priority = PRIORITY( node->key );
+
+    if ( priority - queue->base >= BUCKET_COUNT )
+        return &queue->overflow[LEVEL( priority, queue->base )];
+
+    return &queue->buckets[priority & BUCKET_MASK];
+}
+
+/**
+ * Links a node into the bucket for its priority, or into its overflow level
+ * if it lies above the window.  Assumes the priority is at least the base.
+ *
+ * @param queue Queue in which to operate
+ * @param node  Node to place
+ */
+static void place( bucket_queue *queue, bucket_node *node )
+{
+    uint64_t priority = PRIORITY( node->key );
+    uint32_t slot, level;
+
+    if ( priority - queue->base >= BUCKET_COUNT )
+    {
+        level = LEVEL( priority, queue->base );
+        if ( queue->overflow[level] == NULL )
+            REGISTRY_SET( queue->overflow_levels, level );
+        list_link( &queue->overflow[level], node );
+        queue->overflow_size++;
+        return;
+    }
+
+    slot = (uint32_t) ( priority & BUCKET_MASK );
+    if ( queue->buckets[slot] == NULL )
+        REGISTRY_SET( queue->occupied[slot >> 6], ( slot & 63 ) );
+    if ( &queue->buckets[slot] == queue->sorted )
+        list_insert_sorted( &queue->buckets[slot], node );
+    else
+        list_link( &queue->buckets[slot], node );
+
+    if ( priority < queue->cursor )
+        queue->cursor = priority;
+}
+
+/**
+ * Unlinks a node from the given list, keeping the occupancy bitmaps and
+ * overflow count up to date.
+ *
+ * @param queue Queue in which to operate
+ * @param list  Head pointer of the list holding the node
+ * @param node  Node to remove
+ */
+static void remove_from( bucket_queue *queue, bucket_node **list,
+    bucket_node *node )
+{
+    uint32_t slot, level;
+
+    list_unlink( list, node );
+    if ( list >= queue->overflow && list < queue->overflow + BUCKET_LEVELS )
+    {
+        queue->overflow_size--;
+        level = (uint32_t) ( list - queue->overflow );
+        if ( *list == NULL )
+            REGISTRY_UNSET( queue->overflow_levels, level );
+    }
+    else if ( *list == NULL )
+    {
+        if ( list == queue->sorted )
+            queue->sorted = NULL;
+        slot = (uint32_t) ( list - queue->buckets );
+        REGISTRY_UNSET( queue->occupied[slot >> 6], ( slot & 63 ) );
+    }
+}
+
+/**
+ * Moves the window down so that it starts at the given priority.  Only the
+ * bitmap words covering the priorities that fall off the top of the window
+ * are visited, and their buckets are gathered whole.  So are the overflow
+ * levels up to the highest bit at which the old and new bases differ, since
+ * their nodes no longer differ from the base at the bit of their level; the
+ * levels above it still match.  Everything gathered is then placed anew.
+ *
+ * @param queue     Queue in which to operate
+ * @param priority  New base priority, below the current one
+ */
+static void lower_window( bucket_queue *queue, uint64_t priority )
+{
+    uint64_t drop = queue->base - priority;
+    uint64_t stale = ( (uint64_t) 2 << LEVEL( priority, queue->base ) ) - 1;
+    bucket_node *moved = NULL;
+    uint64_t bits;
+    uint32_t first, count, span, slot, level;
+
+    // the dropped priorities start at priority + BUCKET_COUNT, whose slot is
+    // that of priority itself
+    count = ( drop < BUCKET_COUNT ) ? (uint32_t) drop : BUCKET_COUNT;
+    first = (uint32_t) ( priority & BUCKET_MASK );
+    if ( queue->size == queue->overflow_size )
+        count = 0;
+    while ( count > 0 )
+    {
+        span = 64 - ( first & 63 );
+        if ( span > count )
+            span = count;
+        bits = queue->occupied[first >> 6] >> ( first & 63 );
+        if ( span < 64 )
+            bits &= ( (uint64_t) 1 << span ) - 1;
+
+        while ( bits )
+        {
+            slot = first + REGISTRY_LEADER( bits );
+            REGISTRY_UNSET( bits, ( slot - first ) );
+
+            if ( &queue->buckets[slot] == queue->sorted )
+                queue->sorted = NULL;
+            list_splice( &moved, queue->buckets[slot] );
+            queue->buckets[slot] = NULL;
+            REGISTRY_UNSET( queue->occupied[slot >> 6], ( slot & 63 ) );
+        }
+
+        first = ( first + span ) & BUCKET_MASK;
+        count -= span;
+    }
+
+    while ( queue->overflow_levels & stale )
+    {
+        level = REGISTRY_LEADER( queue->overflow_levels );
+        REGISTRY_UNSET( queue->overflow_levels, level );
+        queue->overflow_size -= list_splice( &moved, queue->overflow[level] );
+        queue->overflow[level] = NULL;
+    }
+
+    queue->base = priority;
+    queue->cursor = priority;
+    place_all( queue, moved );
+}
+
+/**
+ * Restarts an empty window at the smallest priority in the overflow levels,
+ * which lies in the lowest non-empty level, and places the nodes of that
+ * level anew, each falling into the window or into a lower level.  The
+ * nodes of the levels above still differ from the new base at the bit of
+ * their level, but the lowest of those levels may now reach into the window,
+ * so each level whose smallest possible priority does is placed anew too.
+ *
+ * @param queue Queue in which to operate
+ */
+static void refill( bucket_queue *queue )
+{
+    uint32_t level = REGISTRY_LEADER( queue->overflow_levels );
+    bucket_node *list = queue->overflow[level];
+    bucket_node *current = list;
+    uint64_t priority = PRIORITY( list->key );
+    uint64_t bits;
+
+    do
+    {
+        if ( PRIORITY( current->key ) < priority )
+            priority = PRIORITY( current->key );
+        current = current->next;
+    } while ( current != list );
+
+    queue->base = priority;
+    queue->cursor = priority;
+
+    // the lowest level is placed regardless; placing only ever moves nodes to
+    // lower levels, so the levels above are visited from a snapshot
+    bits = queue->overflow_levels;
+    while ( bits )
+    {
+        level = REGISTRY_LEADER( bits );
+        REGISTRY_UNSET( bits, level );
+        if ( list == NULL && ( ( ( priority >> level ) | 1 ) << level ) -
+                priority >= BUCKET_COUNT )
+            break;
+
+        list = queue->overflow[level];
+        queue->overflow[level] = NULL;
+        REGISTRY_UNSET( queue->overflow_levels, level );
+        queue->overflow_size -= place_all( queue, list );
+        list = NULL;
+    }
+}
+
+/**
+ * Places every node of a detached circular list under the current base.
+ *
+ * @param queue Queue in which to operate
+ * @param list  Head of the list, or NULL
+ * @return      Number of nodes placed
+ */
+static uint32_t place_all( bucket_queue *queue, bucket_node *list )
+{
+    bucket_node *current = list;
+    bucket_node *next;
+    uint32_t count = 0;
+
+    if ( list == NULL )
+        return 0;
+
+    // each node's successor is read before placing relinks it
+    do
+    {
+        next = current->next;
+        place( queue, current );
+        count++;
+        current = next;
+    } while ( current != list );
+
+    return count;
+}
+
+/**
+ * Finds the first occupied bucket at or cyclically after the given slot.
+ * Assumes the window holds at least one node.
+ *
+ * @param queue Queue to search
+ * @param start Slot at which to begin
+ * @return      Index of the first occupied bucket
+ */
+static uint32_t next_occupied( bucket_queue *queue, uint32_t start )
+{
+    uint32_t i;
+    uint32_t word = start >> 6;
+    uint64_t bits = queue->occupied[word] & ( ~( (uint64_t) 0 ) <<
+        ( start & 63 ) );
+
+    // the extra iteration picks up the bits of the first word below start
+    for ( i = 0; i <= BUCKET_WORDS; i++ )
+    {
+        if ( bits )
+            return ( word << 6 ) + REGISTRY_LEADER( bits );
+        word = ( word + 1 ) & ( BUCKET_WORDS - 1 );
+        bits = queue->occupied[word];
+    }
+
+    return 0;
+}
+
+/**
+ * Appends a node to the end of a circular list.
+ *
+ * @param list  Head pointer of the list
+ * @param node  Node to append
+ */
+static void list_link( bucket_node **list, bucket_node *node )
+{
+    bucket_node *head = *list;
+
+    if ( head == NULL )
+    {
+        node->next = node;
+        node->prev = node;
+        *list = node;
+        return;
+    }
+
+    node->next = head;
+    node->prev = head->prev;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+/**
+ * Removes a node from a circular list, advancing the head if necessary.
+ *
+ * @param list  Head pointer of the list
+ * @param node  Node to remove
+ */
+static void list_unlink( bucket_node **list, bucket_node *node )
+{
+    if ( node->next == node )
+    {
+        *list = NULL;
+        return;
+    }
+
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    if ( *list == node )
+        *list = node->next;
+}
+
+/**
+ * Appends an entire circular list to the end of another.
+ *
+ * @param dst   Head pointer of the list to extend
+ * @param src   Head of the list to append
+ * @return      Number of nodes appended
+ */
+static uint32_t list_splice( bucket_node **dst, bucket_node *src )
+{
+    bucket_node *current, *dst_tail, *src_tail;
+    uint32_t count = 0;
+
+    if ( src == NULL )
+        return 0;
+
+    current = src;
+    do
+    {
+        count++;
+        current = current->next;
+    } while ( current != src );
+
+    if ( *dst == NULL )
+    {
+        *dst = src;
+        return count;
+    }
+
+    dst_tail = (*dst)->prev;
+    src_tail = src->prev;
+    dst_tail->next = src;
+    src->prev = dst_tail;
+    src_tail->next = *dst;
+    (*dst)->prev = src_tail;
+
+    return count;
+}
+
+/**
+ * Inserts a node into a circular list kept sorted by key.  Searches from the
+ * tail, since new nodes usually carry the largest tie-breaking bits.
+ *
+ * @param list  Head pointer of the sorted list
+ * @param node  Node to insert
+ */
+static void list_insert_sorted( bucket_node **list, bucket_node *node )
+{
+    bucket_node *current;
+
+    if ( *list == NULL || node->key < (*list)->key )
+    {
+        list_link( list, node );
+        *list = node;
+        return;
+    }
+
+    current = (*list)->prev;
+    while ( node->key < current->key )
+        current = current->prev;
+
+    node->next = current->next;
+    node->prev = current;
+    current->next->prev = node;
+    current->next = node;
+}
+
+/**
+ * Sorts a circular list by key with a bottom-up merge sort.
+ *
+ * @param list  Head pointer of the list to sort
+ */
+static void list_sort( bucket_node **list )
+{
+    bucket_node *head = *list;
+    bucket_node *tail, *p, *q, *next;
+    uint32_t width, merges, p_size, q_size;
+
+    if ( head == NULL || head->next == head )
+        return;
+
+    head->prev->next = NULL;
+    for ( width = 1; ; width <<= 1 )
+    {
+        p = head;
+        head = NULL;
+        tail = NULL;
+        merges = 0;
+
+        while ( p != NULL )
+        {
+            merges++;
+            q = p;
+            for ( p_size = 0; p_size < width && q != NULL; p_size++ )
+                q = q->next;
+            q_size = width;
+
+            while ( p_size > 0 || ( q_size > 0 && q != NULL ) )
+            {
+                if ( p_size == 0 || ( q_size > 0 && q != NULL &&
+                        q->key < p->key ) )
+                {
+                    next = q;
+                    q = q->next;
+                    q_size--;
+                }
+                else
+                {
+                    next = p;
+                    p = p->next;
+                    p_size--;
+                }
+
+                if ( tail == NULL )
+                    head = next;
+                else
+                    tail->next = next;
+                next->prev = tail;
+                tail = next;
+            }
+            p = q;
+        }
+        tail->next = NULL;
+
+        if ( merges <= 1 )
+            break;
+    }
+
+    head->prev = tail;
+    tail->next = head;
+    *list = head;
+}
@@ -0,0 +1,215 @@
+#ifndef BUCKET_QUEUE
+#define BUCKET_QUEUE
+
+//==============================================================================
+// DEFINES, INCLUDES, and STRUCTS
+//==============================================================================
+
+#include "queue_common.h"
+
+// keys are bucketed by their high bits; the low bits only break ties
+#ifndef BUCKET_KEY_SHIFT
+    #define BUCKET_KEY_SHIFT    32
+#endif
+// log2 of the number of buckets, i.e. of the width of the priority window
+#ifndef BUCKET_BITS
+    #define BUCKET_BITS         14
+#endif
+#define BUCKET_COUNT            ( 1 << BUCKET_BITS )
+#define BUCKET_MASK             ( BUCKET_COUNT - 1 )
+#define BUCKET_WORDS            ( BUCKET_COUNT >> 6 )
+// one overflow level per bit of priority
+#define BUCKET_LEVELS           64
+
+/**
+ * Holds an inserted element, as well as pointers to maintain its place in a
+ * bucket.  Acts as a handle to clients for the purpose of mutability.  Each
+ * bucket is a circular doubly linked list, so the prev pointer of the first
+ * node in a bucket points to the last.
+ */
+struct bucket_node_t
+{
+    //! Next node in this node's bucket
+    struct bucket_node_t *next;
+    //! Previous node in this node's bucket
+    struct bucket_node_t *prev;
+
+    //! Pointer to a piece of client data
+    item_type item;
+    //! Key for the item
+    key_type key;
+} __attribute__ ((aligned(4)));
+
+typedef struct bucket_node_t bucket_node;
+typedef bucket_node pq_node_type;
+
+/**
+ * A mutable Dial-style bucket queue for keys whose priorities, the key bits
+ * above BUCKET_KEY_SHIFT, fall in a bounded range.  Keeps a window of
+ * BUCKET_COUNT consecutive priorities starting at base, one bucket per
+ * priority, indexed cyclically by the low priority bits.  A bitmap of
+ * occupied buckets lets the scan for the minimum skip empty buckets a word at
+ * a time.  Ties on priority are broken by sorting the minimum bucket by full
+ * key when it is first reached and keeping it sorted while it remains the
+ * minimum, so keys come out in exact order.
+ *
+ * Elements beyond the window wait in overflow levels, as in a radix heap:
+ * level i holds the priorities whose highest bit differing from the base is
+ * bit i, so every priority in a level is below every priority in the levels
+ * above it.  Once the window runs dry it restarts at the smallest priority
+ * of the lowest non-empty level, and that level alone is redistributed, its
+ * nodes falling into the window or into strictly lower levels.  A node thus
+ * moves at most once per priority bit while it waits, which keeps priorities
+ * spread far wider than the window at O(log C) amortized per operation.
+ *
+ * The queue is meant for monotone use, where no priority below the last
+ * minimum is inserted, as in Dijkstra's algorithm or event simulation.
+ * Inserting a priority below the window is supported but not cheap: the
+ * window must be moved down, its top end spilled into the overflow levels,
+ * and the levels up to the highest bit at which the old and new bases
+ * differ redistributed.
+ */
+struct bucket_queue_t
+{
+    //! Memory map to use for node allocation
+    mem_map *map;
+    //! The number of items held in the queue
+    uint32_t size;
+    //! The number of items held in the overflow levels
+    uint32_t overflow_size;
+    //! Lowest priority covered by the window
+    uint64_t base;
+    //! Priority at or below which the window holds nothing
+    uint64_t cursor;
+    //! Cached minimum node, or NULL if it must be recomputed
+    bucket_node *minimum;
+    //! Head pointer of the bucket kept sorted by key, or NULL if none is
+    bucket_node **sorted;
+    //! One bit per overflow level, set if the level is non-empty
+    uint64_t overflow_levels;
+    //! Elements too large for the window, by highest bit differing from base
+    bucket_node *overflow[BUCKET_LEVELS];
+    //! One bit per bucket, set if the bucket is non-empty
+    uint64_t occupied[BUCKET_WORDS];
+    //! Heads of the bucket lists
+    bucket_node *buckets[BUCKET_COUNT];
+} __attribute__ ((aligned(4)));
+
+typedef struct bucket_queue_t bucket_queue;
+typedef bucket_queue pq_type;
+
+//==============================================================================
+// PUBLIC DECLARATIONS
+//==============================================================================
+
+/**
+ * Creates a new, empty queue, with its own arena carved from the given map.
+ *
+ * @param map   Memory map from which to carve the arena for its nodes
+ * @return      Pointer to the new queue
+ */
+bucket_queue* pq_create( mem_map *map );
+
+/**
+ * Frees all the memory used by the queue.
+ *
+ * @param queue Queue to destroy
+ */
+void pq_destroy( bucket_queue *queue );
+
+/**
+ * Deletes all nodes, leaving the queue empty.
+ *
+ * @param queue Queue to clear
+ */
+void pq_clear( bucket_queue *queue );
+
+/**
+ * Returns the key associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's key
+ */
+key_type pq_get_key( bucket_queue *queue, bucket_node *node );
+
+/**
+ * Returns the item associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's item
+ */
+item_type* pq_get_item( bucket_queue *queue, bucket_node *node );
+
+/**
+ * Returns the current size of the queue.
+ *
+ * @param queue Queue to query
+ * @return      Size of queue
+ */
+uint32_t pq_get_size( bucket_queue *queue );
+
+/**
+ * Takes an item-key pair to insert it into the queue and creates a new
+ * corresponding node.  Links the node into the bucket for its priority, or
+ * into its overflow level if the priority lies above the window.
+ *
+ * @param queue Queue to insert into
+ * @param item  Item to insert
+ * @param key   Key to use for node priority
+ * @return      Pointer to corresponding node
+ */
+bucket_node* pq_insert( bucket_queue *queue, item_type item, key_type key );
+
+/**
+ * Returns the minimum item from the queue.  Scans forward from the cursor
+ * for the first occupied bucket, refilling the window from the lowest
+ * overflow level if necessary, and caches the result.
+ *
+ * @param queue Queue to query
+ * @return      Node with minimum key
+ */
+bucket_node* pq_find_min( bucket_queue *queue );
+
+/**
+ * Deletes the minimum item from the queue and returns it.  Relies on
+ * @ref <pq_find_min> to locate it and @ref <pq_delete> to unlink it.
+ *
+ * @param queue Queue to query
+ * @return      Minimum key, corresponding to item deleted
+ */
+key_type pq_delete_min( bucket_queue *queue );
+
+/**
+ * Deletes an arbitrary item from the queue.  Requires that the location of
+ * the item's corresponding node is known.  Unlinks the node from its bucket.
+ *
+ * @param queue Queue in which the node resides
+ * @param node  Pointer to node corresponding to the item to delete
+ * @return      Key of item deleted
+ */
+key_type pq_delete( bucket_queue *queue, bucket_node *node );
+
+/**
+ * If the item in the queue is modified in such a way to decrease the
+ * key, then this function will update the queue to preserve queue
+ * properties given a pointer to the corresponding node.  Moves the node to
+ * the bucket for its new priority.
+ *
+ * @param queue     Queue in which the node resides
+ * @param node      Node to change
+ * @param new_key   New key to use for the given node
+ */
+void pq_decrease_key( bucket_queue *queue, bucket_node *node,
+    key_type new_key );
+
+/**
+ * Determines whether the queue is empty, or if it holds some items.
+ *
+ * @param queue Queue to query
+ * @return      True if queue holds nothing, false otherwise
+ */
+bool pq_empty( bucket_queue *queue );
+
+#endif
@@ -0,0 +1,497 @@
+#include "calendar_queue.h"
+
+//==============================================================================
+// DEFINES AND STATIC DECLARATIONS
+//==============================================================================
+
+#define DAY(queue,a)    ( (a) >> (queue)->shift )
+#define SLOT(queue,a)   ( DAY( queue, a ) & ( (queue)->bucket_count - 1 ) )
+
+static void place( calendar_queue *queue, calendar_node *node );
+static void resize( calendar_queue *queue, uint32_t bucket_count );
+static uint32_t estimate_shift( calendar_queue *queue );
+static void list_link( calendar_node **list, calendar_node *node );
+static void list_unlink( calendar_node **list, calendar_node *node );
+static void list_insert_sorted( calendar_node **list, calendar_node *node );
+static void list_sort( calendar_node **list );
+
+//==============================================================================
+// PUBLIC METHODS
+//==============================================================================
+
+calendar_queue* pq_create( mem_map *map )
+{
+    calendar_queue *queue = calloc( 1, sizeof( calendar_queue ) );
+    queue->map = mm_create_arena( map );
+    queue->bucket_count = CALENDAR_MIN_BUCKETS;
+    queue->shift = CALENDAR_KEY_SHIFT;
+    queue->buckets = calloc( CALENDAR_MIN_BUCKETS, sizeof( calendar_node* ) );
+
+    return queue;
+}
+
+void pq_destroy( calendar_queue *queue )
+{
+    pq_clear( queue );
+    mm_destroy( queue->map );
+    free( queue->buckets );
+    free( queue );
+}
+
+void pq_clear( calendar_queue *queue )
+{
+    mm_clear( queue->map );
+    queue->size = 0;
+    queue->day = 0;
+    queue->minimum = NULL;
+    queue->sorted = NULL;
+    queue->shift = CALENDAR_KEY_SHIFT;
+
+    if ( queue->bucket_count != CALENDAR_MIN_BUCKETS )
+    {
+        free( queue->buckets );
+        queue->bucket_count = CALENDAR_MIN_BUCKETS;
+        queue->buckets = calloc( CALENDAR_MIN_BUCKETS,
+            sizeof( calendar_node* ) );
+    }
+    else
+        memset( queue->buckets, 0, CALENDAR_MIN_BUCKETS *
+            sizeof( calendar_node* ) );
+}
+
+key_type pq_get_key( calendar_queue *queue, calendar_node *node )
+{
+    return PQ_KEY_ORDER( node->key );
+}
+
+item_type* pq_get_item( calendar_queue *queue, calendar_node *node )
+{
+    return (item_type*) &(node->item);
+}
+
+uint32_t pq_get_size( calendar_queue *queue )
+{
+    return queue->size;
+}
+
+calendar_node* pq_insert( calendar_queue *queue, item_type item, key_type key )
+{
+    // keys are stored so that the front of the queue is the smallest
+    key = PQ_KEY_ORDER( key );
+    calendar_node *wrapper = pq_alloc_node( queue->map, 0 );
+    ITEM_ASSIGN( wrapper->item, item );
+    wrapper->key = key;
+
+    if ( queue->size == 0 || DAY( queue, key ) < queue->day )
+        queue->day = DAY( queue, key );
+
+    place( queue, wrapper );
+    queue->size++;
+
+    if ( queue->size == 1 ||
+            ( queue->minimum != NULL && key < queue->minimum->key ) )
+        queue->minimum = wrapper;
+
+    if ( queue->size > ( queue->bucket_count << 1 ) &&
+            queue->bucket_count < ( (uint32_t) 1 << 31 ) )
+        resize( queue, queue->bucket_count << 1 );
+
+    return wrapper;
+}
+
+calendar_node* pq_find_min( calendar_queue *queue )
+{
+    calendar_node *head, *current;
+    calendar_node *best = NULL;
+    uint32_t mask = queue->bucket_count - 1;
+    uint32_t slot, i;
+
+    if ( pq_empty( queue ) )
+        return NULL;
+    if ( queue->minimum != NULL )
+        return queue->minimum;
+
+    slot = (uint32_t) ( queue->day & mask );
+    for ( i = 0; i < queue->bucket_count; i++ )
+    {
+        if ( queue->buckets[slot] != NULL )
+        {
+            if ( queue->sorted != &queue->buckets[slot] )
+            {
+                list_sort( &queue->buckets[slot] );
+                queue->sorted = &queue->buckets[slot];
+            }
+            head = queue->buckets[slot];
+            if ( DAY( queue, head->key ) == queue->day )
+            {
+                queue->minimum = head;
+                return head;
+            }
+        }
+        queue->day++;
+        slot = ( slot + 1 ) & mask;
+    }
+
+    // a year without an event on its day, so jump straight to the minimum
+    for ( i = 0; i < queue->bucket_count; i++ )
+    {
+        head = queue->buckets[i];
+        if ( head == NULL )
+            continue;
+        current = head;
+        do
+        {
+            if ( best == NULL || current->key < best->key )
+                best = current;
+            current = current->next;
+        } while ( current != head );
+    }
+    queue->day = DAY( queue, best->key );
+    queue->minimum = best;
+
+    return best;
+}
+
+key_type pq_delete_min( calendar_queue *queue )
+{
+    return pq_delete( queue, pq_find_min( queue ) );
+}
+
+key_type pq_delete( calendar_queue *queue, calendar_node *node )
+{
+    key_type key = node->key;
+    calendar_node **list = &queue->buckets[SLOT( queue, key )];
+
+    if ( node == queue->minimum )
+        queue->minimum = NULL;
+
+    list_unlink( list, node );
+    if ( *list == NULL && list == queue->sorted )
+        queue->sorted = NULL;
+    pq_free_node( queue->map, 0, node );
+    queue->size--;
+
+    if ( queue->size < ( queue->bucket_count >> 1 ) &&
+            queue->bucket_count > CALENDAR_MIN_BUCKETS )
+        resize( queue, queue->bucket_count >> 1 );
+
+    return PQ_KEY_ORDER( key );
+}
+
+void pq_decrease_key( calendar_queue *queue, calendar_node *node,
+    key_type new_key )
+{
+    new_key = PQ_KEY_ORDER( new_key );
+
+    list_unlink( &queue->buckets[SLOT( queue, node->key )], node );
+    node->key = new_key;
+    if ( DAY( queue, new_key ) < queue->day )
+        queue->day = DAY( queue, new_key );
+    place( queue, node );
+
+    if ( queue->minimum != NULL && new_key < queue->minimum->key )
+        queue->minimum = node;
+}
+
+bool pq_empty( calendar_queue *queue )
+{
+    return ( queue->size == 0 );
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Links a node into the bucket for its key's day, in key order if that is
+ * the bucket currently kept sorted.
+ *
+ * @param queue Queue in which to operate
+ * @param node  Node to place
+ */
+static void place( calendar_queue *queue, calendar_node *node )
+{
+    calendar_node **list = &queue->buckets[SLOT( queue, node->key )];
+
+    if ( list == queue->sorted )
+        list_insert_sorted( list, node );
+    else
+        list_link( list, node );
+}
+
+/**
+ * Rebuilds the calendar with the given number of buckets and a freshly
+ * estimated bucket width.  Every node is unhooked into a single chain and
+ * then placed into its new bucket, so a resize costs O(n).
+ *
+ * @param queue         Queue to resize
+ * @param bucket_count  New number of buckets, a power of two
+ */
+static void resize( calendar_queue *queue, uint32_t bucket_count )
+{
+    calendar_node *chain = NULL;
+    calendar_node *head, *next;
+    key_type min_key = MAX_KEY;
+    uint32_t i;
+
+    uint32_t shift = estimate_shift( queue );
+
+    for ( i = 0; i < queue->bucket_count; i++ )
+    {
+        head = queue->buckets[i];
+        if ( head == NULL )
+            continue;
+        head->prev->next = chain;
+        chain = head;
+    }
+
+    free( queue->buckets );
+    queue->buckets = calloc( bucket_count, sizeof( calendar_node* ) );
+    queue->bucket_count = bucket_count;
+    queue->shift = shift;
+    queue->sorted = NULL;
+
+    while ( chain != NULL )
+    {
+        next = chain->next;
+        if ( chain->key < min_key )
+            min_key = chain->key;
+        place( queue, chain );
+        chain = next;
+    }
+    queue->day = DAY( queue, min_key );
+}
+
+/**
+ * Estimates a bucket width from the keys at the front of the queue, as three
+ * times their average separation once separations of more than twice the
+ * first average are discarded.  The keys are gathered by walking at most one
+ * year forward from the current day, taking those on the day being visited
+ * from each bucket and sorting them once gathered; if that finds fewer than
+ * two, the width is too small to say anything, and the average separation
+ * over the whole queue is used instead.
+ *
+ * @param queue Queue to sample
+ * @return      log2 of the estimated width, rounded up, and at least
+ *              CALENDAR_KEY_SHIFT
+ */
+static uint32_t estimate_shift( calendar_queue *queue )
+{
+    key_type keys[CALENDAR_SAMPLE];
+    key_type min_key = MAX_KEY;
+    key_type max_key = 0;
+    key_type key;
+    calendar_node *head, *current;
+    uint64_t day = queue->day;
+    uint64_t average, gap, total, width;
+    uint32_t mask = queue->bucket_count - 1;
+    uint32_t slot = (uint32_t) ( day & mask );
+    uint32_t count = 0;
+    uint32_t gaps = 0;
+    uint32_t i, j, shift;
+
+    for ( i = 0; i < queue->bucket_count && count < CALENDAR_SAMPLE; i++ )
+    {
+        head = queue->buckets[slot];
+        current = head;
+        while ( current != NULL && count < CALENDAR_SAMPLE )
+        {
+            if ( DAY( queue, current->key ) == day )
+                keys[count++] = current->key;
+            current = current->next;
+            if ( current == head )
+                break;
+        }
+        day++;
+        slot = ( slot + 1 ) & mask;
+    }
+
+    if ( count >= 2 )
+    {
+        for ( i = 1; i < count; i++ )
+        {
+            key = keys[i];
+            for ( j = i; j > 0 && keys[j - 1] > key; j-- )
+                keys[j] = keys[j - 1];
+            keys[j] = key;
+        }
+
+        average = ( keys[count - 1] - keys[0] ) / ( count - 1 );
+        total = 0;
+        for ( i = 1; i < count; i++ )
+        {
+            gap = keys[i] - keys[i - 1];
+            if ( gap <= average << 1 )
+            {
+                total += gap;
+                gaps++;
+            }
+        }
+        average = total / gaps;
+    }
+    else
+    {
+        for ( i = 0; i < queue->bucket_count; i++ )
+        {
+            head = queue->buckets[i];
+            if ( head == NULL )
+                continue;
+            current = head;
+            do
+            {
+                if ( current->key < min_key )
+                    min_key = current->key;
+                if ( current->key > max_key )
+                    max_key = current->key;
+                current = current->next;
+            } while ( current != head );
+        }
+        if ( queue->size < 2 || max_key <= min_key )
+            return queue->shift;
+        average = ( max_key - min_key ) / ( queue->size - 1 );
+    }
+
+    width = ( average > MAX_KEY / 3 ) ? MAX_KEY : average * 3;
+    for ( shift = CALENDAR_KEY_SHIFT; shift < 63 &&
+        ( (uint64_t) 1 << shift ) < width; shift++ );
+
+    return shift;
+}
+
+/**
+ * Appends a node to the end of a circular list.
+ *
+ * @param list  Head pointer of the list
+ * @param node  Node to append
+ */
+static void list_link( calendar_node **list, calendar_node *node )
+{
+    calendar_node *head = *list;
+
+    if ( head == NULL )
+    {
+        node->next = node;
+        node->prev = node;
+        *list = node;
+        return;
+    }
+
+    node->next = head;
+    node->prev = head->prev;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+/**
+ * Removes a node from a circular list, advancing the head if necessary.
+ *
+ * @param list  Head pointer of the list
+ * @param node  Node to remove
+ */
+static void list_unlink( calendar_node **list, calendar_node *node )
+{
+    if ( node->next == node )
+    {
+        *list = NULL;
+        return;
+    }
+
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    if ( *list == node )
+        *list = node->next;
+}
+
+/**
+ * Inserts a node into a circular list kept sorted by key.  Searches from the
+ * tail, since events are usually scheduled after those already in a bucket.
+ *
+ * @param list  Head pointer of the sorted list
+ * @param node  Node to insert
+ */
+static void list_insert_sorted( calendar_node **list, calendar_node *node )
+{
+    calendar_node *current;
+
+    if ( *list == NULL || node->key < (*list)->key )
+    {
+        list_link( list, node );
+        *list = node;
+        return;
+    }
+
+    current = (*list)->prev;
+    while ( node->key < current->key )
+        current = current->prev;
+
+    node->next = current->next;
+    node->prev = current;
+    current->next->prev = node;
+    current->next = node;
+}
+
+/**
+ * Sorts a circular list by key with a bottom-up merge sort.
+ *
+ * @param list  Head pointer of the list to sort
+ */
+static void list_sort( calendar_node **list )
+{
+    calendar_node *head = *list;
+    calendar_node *tail, *p, *q, *next;
+    uint32_t width, merges, p_size, q_size;
+
+    if ( head == NULL || head->next == head )
+        return;
+
+    head->prev->next = NULL;
+    for ( width = 1; ; width <<= 1 )
+    {
+        p = head;
+        head = NULL;
+        tail = NULL;
+        merges = 0;
+
+        while ( p != NULL )
+        {
+            merges++;
+            q = p;
+            for ( p_size = 0; p_size < width && q != NULL; p_size++ )
+                q = q->next;
+            q_size = width;
+
+            while ( p_size > 0 || ( q_size > 0 && q != NULL ) )
+            {
+                if ( p_size == 0 || ( q_size > 0 && q != NULL &&
+                        q->key < p->key ) )
+                {
+                    next = q;
+                    q = q->next;
+                    q_size--;
+                }
+                else
+                {
+                    next = p;
+                    p = p->next;
+                    p_size--;
+                }
+
+                if ( tail == NULL )
+                    head = next;
+                else
+                    tail->next = next;
+                next->prev = tail;
+                tail = next;
+            }
+            p = q;
+        }
+        tail->next = NULL;
+
+        if ( merges <= 1 )
+            break;
+    }
+
+    head->prev = tail;
+    tail->next = head;
+    *list = head;
+}
@@ -0,0 +1,201 @@
+#ifndef CALENDAR_QUEUE
+#define CALENDAR_QUEUE
+
+//==============================================================================
+// DEFINES, INCLUDES, and STRUCTS
+//==============================================================================
+
+#include "queue_common.h"
+
+// log2 of the narrowest bucket width, also used until the first resize; trace
+// keys carry their priority above bit 32, and the bits below only break ties
+#ifndef CALENDAR_KEY_SHIFT
+    #define CALENDAR_KEY_SHIFT  32
+#endif
+// the bucket count never drops below this
+#define CALENDAR_MIN_BUCKETS    16
+// number of leading keys sampled to estimate the bucket width on a resize
+#define CALENDAR_SAMPLE         25
+
+/**
+ * Holds an inserted element, as well as pointers to maintain its place in a
+ * bucket.  Acts as a handle to clients for the purpose of mutability.  Each
+ * bucket is a circular doubly linked list, so the prev pointer of the first
+ * node in a bucket points to the last.
+ */
+struct calendar_node_t
+{
+    //! Next node in this node's bucket
+    struct calendar_node_t *next;
+    //! Previous node in this node's bucket
+    struct calendar_node_t *prev;
+
+    //! Pointer to a piece of client data
+    item_type item;
+    //! Key for the item
+    key_type key;
+} __attribute__ ((aligned(4)));
+
+typedef struct calendar_node_t calendar_node;
+typedef calendar_node pq_node_type;
+
+/**
+ * A mutable calendar queue, after Brown.  Time is divided into days of
+ * 2^shift keys, and day d is kept in bucket d mod bucket_count, so one pass
+ * over the buckets covers a year.  The minimum is found by walking the days
+ * forward from the current one until a bucket's first node falls on the day
+ * being visited; if a whole year passes without one, the minimum is found by
+ * a direct search of all the nodes.  Rather than keeping every bucket sorted,
+ * which costs a scan per insert when many keys share a day, a bucket is
+ * sorted when the walk reaches it and kept sorted while it is the one being
+ * visited, as in bucket_queue.
+ *
+ * The bucket count doubles when the size exceeds twice the count and halves
+ * when it drops below half of it.  On each resize the width is re-estimated
+ * from the gaps between the first CALENDAR_SAMPLE keys, ignoring gaps over
+ * twice the average, and rounded up to a power of two so that days are
+ * computed with shifts.  Days are never shorter than one priority, since
+ * tie-breaking bits say nothing about how events are spread out.  With a
+ * steady key distribution this keeps a few nodes per bucket and makes every
+ * operation O(1) amortized.
+ */
+struct calendar_queue_t
+{
+    //! Memory map to use for node allocation
+    mem_map *map;
+    //! The number of items held in the queue
+    uint32_t size;
+    //! Number of buckets, a power of two
+    uint32_t bucket_count;
+    //! log2 of the bucket width
+    uint32_t shift;
+    //! Day currently being visited; no key lies on an earlier day
+    uint64_t day;
+    //! Cached minimum node, or NULL if it must be recomputed
+    calendar_node *minimum;
+    //! Head pointer of the bucket kept sorted by key, or NULL if none is
+    calendar_node **sorted;
+    //! Heads of the bucket lists
+    calendar_node **buckets;
+} __attribute__ ((aligned(4)));
+
+typedef struct calendar_queue_t calendar_queue;
+typedef calendar_queue pq_type;
+
+//==============================================================================
+// PUBLIC DECLARATIONS
+//==============================================================================
+
+/**
+ * Creates a new, empty queue, with its own arena carved from the given map.
+ *
+ * @param map   Memory map from which to carve the arena for its nodes
+ * @return      Pointer to the new queue
+ */
+calendar_queue* pq_create( mem_map *map );
+
+/**
+ * Frees all the memory used by the queue.
+ *
+ * @param queue Queue to destroy
+ */
+void pq_destroy( calendar_queue *queue );
+
+/**
+ * Deletes all nodes, leaving the queue empty.
+ *
+ * @param queue Queue to clear
+ */
+void pq_clear( calendar_queue *queue );
+
+/**
+ * Returns the key associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's key
+ */
+key_type pq_get_key( calendar_queue *queue, calendar_node *node );
+
+/**
+ * Returns the item associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's item
+ */
+item_type* pq_get_item( calendar_queue *queue, calendar_node *node );
+
+/**
+ * Returns the current size of the queue.
+ *
+ * @param queue Queue to query
+ * @return      Size of queue
+ */
+uint32_t pq_get_size( calendar_queue *queue );
+
+/**
+ * Takes an item-key pair to insert it into the queue and creates a new
+ * corresponding node.  Links the node into its bucket, moving the current
+ * day back if the key falls before it, and doubles the bucket count if the
+ * queue has outgrown it.
+ *
+ * @param queue Queue to insert into
+ * @param item  Item to insert
+ * @param key   Key to use for node priority
+ * @return      Pointer to corresponding node
+ */
+calendar_node* pq_insert( calendar_queue *queue, item_type item, key_type key );
+
+/**
+ * Returns the minimum item from the queue.  Walks the days forward from the
+ * current one, falling back to a direct search after a fruitless year, and
+ * caches the result.
+ *
+ * @param queue Queue to query
+ * @return      Node with minimum key
+ */
+calendar_node* pq_find_min( calendar_queue *queue );
+
+/**
+ * Deletes the minimum item from the queue and returns it.  Relies on
+ * @ref <pq_find_min> to locate it and @ref <pq_delete> to unlink it.
+ *
+ * @param queue Queue to query
+ * @return      Minimum key, corresponding to item deleted
+ */
+key_type pq_delete_min( calendar_queue *queue );
+
+/**
+ * Deletes an arbitrary item from the queue.  Requires that the location of
+ * the item's corresponding node is known.  Unlinks the node from its bucket
+ * and halves the bucket count if the queue has shrunk well below it.
+ *
+ * @param queue Queue in which the node resides
+ * @param node  Pointer to node corresponding to the item to delete
+ * @return      Key of item deleted
+ */
+key_type pq_delete( calendar_queue *queue, calendar_node *node );
+
+/**
+ * If the item in the queue is modified in such a way to decrease the
+ * key, then this function will update the queue to preserve queue
+ * properties given a pointer to the corresponding node.  Unlinks the node
+ * and links it back in under its new key.
+ *
+ * @param queue     Queue in which the node resides
+ * @param node      Node to change
+ * @param new_key   New key to use for the given node
+ */
+void pq_decrease_key( calendar_queue *queue, calendar_node *node,
+    key_type new_key );
+
+/**
+ * Determines whether the queue is empty, or if it holds some items.
+ *
+ * @param queue Queue to query
+ * @return      True if queue holds nothing, false otherwise
+ */
+bool pq_empty( calendar_queue *queue );
+
+#endif
@@ -18,6 +18,8 @@ static explicit_node* find_insertion_point( explicit_heap *queue );
 static explicit_node* find_node( explicit_heap *queue, uint32_t n );
 static uint32_t int_log2( uint32_t n );
 static bool is_leaf( explicit_heap *queue, explicit_node* node );
+static explicit_node* copy_node( explicit_heap *queue, explicit_node *node,
+    pq_relocate_fn relocate, void *context );
 
 //==============================================================================
 // PUBLIC METHODS
@@ -26,7 +28,10 @@ static bool is_leaf( explicit_heap *queue, explicit_node* node );
 explicit_heap* pq_create( mem_map *map )
 {
     explicit_heap *queue = (explicit_heap*) calloc( 1, sizeof( explicit_heap ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
+#ifdef USE_COMPACT_REFS
+    queue->base = (explicit_node*) queue->map->data[0];
+#endif
 
     return queue;
 }
@@ -34,6 +39,7 @@ explicit_heap* pq_create( mem_map *map )
 void pq_destroy( explicit_heap *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -63,9 +69,12 @@ explicit_node* pq_insert( explicit_heap *queue, item_type item, key_type key )
 {
     int i;
     explicit_node* parent;
-    explicit_node* node = pq_alloc_node( queue->map, 0 );
+    explicit_node* node = pq_alloc_node_uninit( queue->map, 0 );
     ITEM_ASSIGN( node->item, item );
     node->key = key;
+    node->parent = PQ_NULL_LINK;
+    for( i = 0; i < BRANCHING_FACTOR; i++ )
+        node->children[i] = PQ_NULL_LINK;
 
     if ( queue->root == NULL )
         queue->root = node;
@@ -75,14 +84,14 @@ explicit_node* pq_insert( explicit_heap *queue, item_type item, key_type key )
 
         for( i = 0; i < BRANCHING_FACTOR; i++ )
         {
-            if ( parent->children[i] == NULL )
+            if ( parent->children[i] == PQ_NULL_LINK )
             {
-                parent->children[i] = node;
+                parent->children[i] = PQ_REF( queue, node );
                 break;
             }
         }
 
-        node->parent = parent;
+        node->parent = PQ_REF( queue, parent );
     }
 
     queue->size++;
@@ -103,20 +112,33 @@ key_type pq_delete_min( explicit_heap *queue )
     return pq_delete( queue, queue->root );
 }
 
+explicit_node* pq_replace_min( explicit_heap *queue, item_type item,
+    key_type key )
+{
+    explicit_node *node = queue->root;
+    ITEM_ASSIGN( node->item, item );
+    node->key = key;
+    heapify_down( queue, node );
+
+    return node;
+}
+
 key_type pq_delete( explicit_heap *queue, explicit_node* node )
 {
     int i;
     key_type key = node->key;
+    explicit_node *parent;
     explicit_node *last_node = find_last_node( queue );
     swap( queue, node, last_node);
 
     // figure out which child this node is and clear reference from parent
-    if ( node->parent != NULL )
+    parent = PQ_NODE( queue, node->parent );
+    if ( parent != NULL )
     {
         for( i = 0; i < BRANCHING_FACTOR; i++ )
         {
-            if ( node->parent->children[i] == node )
-                node->parent->children[i] = NULL;
+            if ( parent->children[i] == PQ_REF( queue, node ) )
+                parent->children[i] = PQ_NULL_LINK;
         }
     }
 
@@ -125,8 +147,14 @@ key_type pq_delete( explicit_heap *queue, explicit_node* node )
 
     if ( pq_empty( queue ) )
         queue->root = NULL;
-    else if ( node != last_node)
-        heapify_down( queue, last_node );
+    else if ( node != last_node )
+    {
+        // the last node may belong above the vacated position as well as below
+        if ( PQ_KEY_BEFORE( last_node->key, key ) )
+            heapify_up( queue, last_node );
+        else
+            heapify_down( queue, last_node );
+    }
 
     return key;
 }
@@ -138,6 +166,53 @@ void pq_decrease_key( explicit_heap *queue, explicit_node *node,
     heapify_up( queue, node );
 }
 
+void pq_compact( explicit_heap *queue, pq_relocate_fn relocate,
+    void *context )
+{
+    int i;
+    // the old links still resolve against the old slab
+    explicit_heap old = *queue;
+    explicit_node **pending;
+    explicit_node *from, *to, *child, *copy;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    queue->map = mm_create_arena( old.map->parent );
+#ifdef USE_COMPACT_REFS
+    queue->base = (explicit_node*) queue->map->data[0];
+#endif
+
+    if ( old.root != NULL )
+    {
+        // pairs of old and new nodes whose children are yet to be copied
+        pending = malloc( 2 * old.size * sizeof( explicit_node* ) );
+        queue->root = copy_node( queue, old.root, relocate, context );
+        pending[tail++] = old.root;
+        pending[tail++] = queue->root;
+
+        while ( head < tail )
+        {
+            from = pending[head++];
+            to = pending[head++];
+            // children keep their slots, which locate the last node
+            for( i = 0; i < BRANCHING_FACTOR; i++ )
+            {
+                child = PQ_NODE( &old, from->children[i] );
+                if ( child == NULL )
+                    continue;
+                copy = copy_node( queue, child, relocate, context );
+                copy->parent = PQ_REF( queue, to );
+                to->children[i] = PQ_REF( queue, copy );
+                pending[tail++] = child;
+                pending[tail++] = copy;
+            }
+        }
+        free( pending );
+    }
+
+    mm_destroy( old.map );
+}
+
 bool pq_empty( explicit_heap *queue )
 {
     return ( queue->size == 0 );
@@ -161,9 +236,9 @@ static void swap( explicit_heap *queue, explicit_node *a, explicit_node *b )
     if ( ( a == NULL ) || ( b == NULL ) || ( a == b ) )
         return;
 
-    if ( a->parent == b )
+    if ( a->parent == PQ_REF( queue, b ) )
         swap_connected( queue, b, a );
-    else if ( b->parent == a )
+    else if ( b->parent == PQ_REF( queue, a ) )
         swap_connected( queue, a, b );
     else
         swap_disconnected( queue, a, b );
@@ -185,18 +260,18 @@ static void swap( explicit_heap *queue, explicit_node *a, explicit_node *b )
 static void swap_connected( explicit_heap *queue, explicit_node *parent,
     explicit_node *child )
 {
-    explicit_node *temp;
+    PQ_LINK( explicit_node ) temp;
 
     child->parent = parent->parent;
-    parent->parent = child;
+    parent->parent = PQ_REF( queue, child );
 
     int i;
     for( i = 0; i < BRANCHING_FACTOR; i++ )
     {
-        if( parent->children[i] == child )
+        if( parent->children[i] == PQ_REF( queue, child ) )
         {
             parent->children[i] = child->children[i];
-            child->children[i] = parent;
+            child->children[i] = PQ_REF( queue, parent );
         }
         else
         {
@@ -220,16 +295,15 @@ static void swap_connected( explicit_heap *queue, explicit_node *parent,
 static void swap_disconnected( explicit_heap *queue, explicit_node *a,
     explicit_node *b )
 {
-    explicit_node *temp[BRANCHING_FACTOR];
+    PQ_LINK( explicit_node ) temp[BRANCHING_FACTOR];
 
     temp[0] = a->parent;
     a->parent = b->parent;
     b->parent = temp[0];
 
-    memcpy( temp, a->children, BRANCHING_FACTOR * sizeof( explicit_node* ) );
-    memcpy( a->children, b->children, BRANCHING_FACTOR *
-        sizeof( explicit_node* ) );
-    memcpy( b->children, temp, BRANCHING_FACTOR * sizeof( explicit_node* ) );
+    memcpy( temp, a->children, sizeof( temp ) );
+    memcpy( a->children, b->children, sizeof( temp ) );
+    memcpy( b->children, temp, sizeof( temp ) );
 
     fill_back_pointers( queue, a, b );
 }
@@ -246,26 +320,43 @@ static void fill_back_pointers( explicit_heap *queue, explicit_node *a,
     explicit_node *b )
 {
     int i;
+    explicit_node *a_parent = PQ_NODE( queue, a->parent );
+    explicit_node *b_parent = PQ_NODE( queue, b->parent );
+    PQ_LINK( explicit_node ) a_ref = PQ_REF( queue, a );
+    PQ_LINK( explicit_node ) b_ref = PQ_REF( queue, b );
 
-    if ( a->parent != NULL )
+    // siblings just trade slots, which the searches below would confuse
+    if ( a_parent != NULL && a_parent == b_parent )
+    {
+        for( i = 0; i < BRANCHING_FACTOR; i++ )
+        {
+            if( a_parent->children[i] == a_ref )
+                a_parent->children[i] = b_ref;
+            else if( a_parent->children[i] == b_ref )
+                a_parent->children[i] = a_ref;
+        }
+    }
+    else if ( a_parent != NULL )
     {
         for( i = 0; i < BRANCHING_FACTOR; i++ )
         {
-            if( a->parent->children[i] == a || a->parent->children[i] == b )
+            if( a_parent->children[i] == a_ref ||
+                    a_parent->children[i] == b_ref )
             {
-                a->parent->children[i] = a;
+                a_parent->children[i] = a_ref;
                 break;
             }
         }
     }
 
-    if ( b->parent != NULL )
+    if ( b_parent != NULL && b_parent != a_parent )
     {
         for( i = 0; i < BRANCHING_FACTOR; i++ )
         {
-            if( b->parent->children[i] == a || b->parent->children[i] == b )
+            if( b_parent->children[i] == a_ref ||
+                    b_parent->children[i] == b_ref )
             {
-                b->parent->children[i] = b;
+                b_parent->children[i] = b_ref;
                 break;
             }
         }
@@ -273,10 +364,10 @@ static void fill_back_pointers( explicit_heap *queue, explicit_node *a,
 
     for( i = 0; i < BRANCHING_FACTOR; i++ )
     {
-        if( a->children[i] != NULL )
-            a->children[i]->parent = a;
-        if( b->children[i] != NULL )
-            b->children[i]->parent = b;
+        if( a->children[i] != PQ_NULL_LINK )
+            PQ_NODE( queue, a->children[i] )->parent = a_ref;
+        if( b->children[i] != PQ_NULL_LINK )
+            PQ_NODE( queue, b->children[i] )->parent = b_ref;
     }
 }
 
@@ -293,21 +384,21 @@ static void heapify_down( explicit_heap *queue, explicit_node *node )
         return;
 
     // repeatedly swap with smallest child if node violates queue order
-    explicit_node* smallest_child;
-    int k, min_k;
+    explicit_node *smallest_child, *child;
+    int k;
     while ( !is_leaf( queue, node ) )
     {
-        min_k = 0;
+        smallest_child = PQ_NODE( queue, node->children[0] );
         for( k = 1; k < BRANCHING_FACTOR; k++ )
         {
-            if( node->children[k] == NULL )
+            child = PQ_NODE( queue, node->children[k] );
+            if( child == NULL )
                 break;
-            if( node->children[k]->key < node->children[min_k]->key )
-                min_k = k;
+            if( PQ_KEY_BEFORE( child->key, smallest_child->key ) )
+                smallest_child = child;
         }
-        smallest_child = node->children[min_k];
 
-        if ( smallest_child->key < node->key )
+        if ( PQ_KEY_BEFORE( smallest_child->key, node->key ) )
             swap( queue, smallest_child, node );
         else
             break;
@@ -323,13 +414,15 @@ static void heapify_down( explicit_heap *queue, explicit_node *node )
  */
 static void heapify_up( explicit_heap *queue, explicit_node *node )
 {
+    explicit_node *parent;
+
     if ( node == NULL )
         return;
 
-    while ( node->parent != NULL )
+    while ( ( parent = PQ_NODE( queue, node->parent ) ) != NULL )
     {
-        if ( node->key < node->parent->key )
-            swap( queue, node, node->parent );
+        if ( PQ_KEY_BEFORE( node->key, parent->key ) )
+            swap( queue, node, parent );
         else
             break;
     }
@@ -386,7 +479,7 @@ static explicit_node* find_node( explicit_heap *queue, uint32_t n )
     {
         path = ( ( location & ( mask << ( ( i * BRANCHING_POWER ) ) ) ) >>
             ( ( i * BRANCHING_POWER ) ) );
-        next = current->children[path];
+        next = PQ_NODE( queue, current->children[path] );
 
         if ( next == NULL )
             break;
@@ -421,5 +514,30 @@ static uint32_t int_log2( uint32_t n )
  */
 static bool is_leaf( explicit_heap *queue, explicit_node* node )
 {
-    return ( node->children[0] == NULL );
+    return ( node->children[0] == PQ_NULL_LINK );
+}
+
+/**
+ * Copies a node's item and key into a new node of the queue's arena, with no
+ * links yet, and reports the move.
+ *
+ * @param queue     Queue to allocate from
+ * @param node      Node to copy
+ * @param relocate  Called with the old and new node
+ * @param context   Passed through to relocate
+ * @return          The new node
+ */
+static explicit_node* copy_node( explicit_heap *queue, explicit_node *node,
+    pq_relocate_fn relocate, void *context )
+{
+    int i;
+    explicit_node *copy = pq_alloc_node_uninit( queue->map, 0 );
+    ITEM_ASSIGN( copy->item, node->item );
+    copy->key = node->key;
+    copy->parent = PQ_NULL_LINK;
+    for( i = 0; i < BRANCHING_FACTOR; i++ )
+        copy->children[i] = PQ_NULL_LINK;
+    relocate( context, node, copy );
+
+    return copy;
 }
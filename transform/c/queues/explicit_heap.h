@@ -21,6 +21,10 @@
 
 #include "queue_common.h"
 
+#define PQ_HAS_REPLACE_MIN
+#define PQ_HAS_COMPACT_REFS
+#define PQ_HAS_COMPACT
+
 /**
  * Holds an inserted element, as well as pointers to maintain tree
  * structure.  Acts as a handle to clients for the purpose of
@@ -30,9 +34,9 @@
 struct explicit_node_t
 {
     //! Pointer to parent node
-    struct explicit_node_t *parent;
+    PQ_LINK( struct explicit_node_t ) parent;
     //! Pointers to children
-    struct explicit_node_t *children[BRANCHING_FACTOR];
+    PQ_LINK( struct explicit_node_t ) children[BRANCHING_FACTOR];
 
     //! Pointer to a piece of client data
     item_type item;
@@ -55,6 +59,10 @@ struct explicit_heap_t
     explicit_node *root;
     //! The number of items held in the queue
     uint32_t size;
+#ifdef USE_COMPACT_REFS
+    //! Start of the arena's node slab, against which links are resolved
+    explicit_node *base;
+#endif
 } __attribute__ ((aligned(4)));
 
 typedef struct explicit_heap_t explicit_heap;
@@ -65,9 +73,10 @@ typedef explicit_heap pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty priority queue.
+ * Creates a new, empty priority queue, with its own arena carved from the
+ * given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 explicit_heap* pq_create( mem_map *map );
@@ -142,6 +151,22 @@ explicit_node* pq_find_min( explicit_heap *queue );
  */
 key_type pq_delete_min( explicit_heap *queue ) ;
 
+/**
+ * Replaces the minimum item of the queue with a new item-key pair.  Has the
+ * same effect as @ref <pq_delete_min> followed by @ref <pq_insert>, but writes
+ * the new pair into the root and sifts it down once instead of swapping in the
+ * last node, sifting it down, and sifting the new node up from the bottom.  The
+ * minimum's node is reused for the new item, so clients must read the old
+ * minimum before the call.
+ *
+ * @param queue Queue to modify, which must not be empty
+ * @param item  Item to insert
+ * @param key   Key to use for node priority
+ * @return      Pointer to the node now holding the new item
+ */
+explicit_node* pq_replace_min( explicit_heap *queue, item_type item,
+    key_type key );
+
 /**
  * Removes an arbitrary item from the queue.  Requires that the location
  * of the item's corresponding node is known.  First swaps target node
@@ -167,6 +192,21 @@ key_type pq_delete( explicit_heap *queue, explicit_node* node );
 void pq_decrease_key( explicit_heap *queue, explicit_node *node,
     key_type new_key );
 
+/**
+ * Moves every node of the queue into a fresh arena carved from the same
+ * parent map, laid out level by level as in an array-based heap, so that
+ * sifting touches nodes close to one another.  Gives the old arena back.
+ * Handles to the queue's nodes are invalidated; relocate is called once for
+ * each node with its old and new address, so that the client can update its
+ * own.  Briefly needs room for two copies of the nodes.
+ *
+ * @param queue     Queue to compact
+ * @param relocate  Called for each node moved
+ * @param context   Passed through to relocate
+ */
+void pq_compact( explicit_heap *queue, pq_relocate_fn relocate,
+    void *context );
+
 /**
  * Determines whether the queue is empty, or if it holds some items.
  *
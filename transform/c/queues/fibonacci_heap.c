@@ -21,13 +21,17 @@ fibonacci_heap* pq_create( mem_map *map )
 {
     fibonacci_heap *queue = (fibonacci_heap*) calloc( 1,
         sizeof( fibonacci_heap ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
+#ifdef USE_COMPACT_REFS
+    queue->base = (fibonacci_node*) queue->map->data[0];
+#endif
 
     return queue;
 }
 
 void pq_destroy( fibonacci_heap *queue ){
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -35,8 +39,7 @@ void pq_clear( fibonacci_heap *queue )
 {
     mm_clear( queue->map );
     queue->minimum = NULL;
-    memset( queue->roots, 0, MAXRANK * sizeof( fibonacci_node* ) );
-    queue->largest_rank = 0;
+    queue->registry = 0;
     queue->size = 0;
 }
 
@@ -57,11 +60,15 @@ uint32_t pq_get_size( fibonacci_heap *queue )
 
 fibonacci_node* pq_insert( fibonacci_heap *queue, item_type item, key_type key )
 {
-    fibonacci_node* wrapper = pq_alloc_node( queue->map, 0 );
+    fibonacci_node* wrapper = pq_alloc_node_uninit( queue->map, 0 );
     ITEM_ASSIGN( wrapper->item, item );
     wrapper->key = key;
-    wrapper->next_sibling = wrapper;
-    wrapper->prev_sibling = wrapper;
+    wrapper->parent = PQ_NULL_LINK;
+    wrapper->first_child = PQ_NULL_LINK;
+    wrapper->rank = 0;
+    wrapper->marked = FALSE;
+    wrapper->next_sibling = PQ_REF( queue, wrapper );
+    wrapper->prev_sibling = PQ_REF( queue, wrapper );
     queue->size++;
 
     queue->minimum = append_lists( queue, queue->minimum, wrapper );
@@ -80,15 +87,16 @@ key_type pq_delete_min( fibonacci_heap *queue )
 {
     fibonacci_node *node = queue->minimum;
     key_type key = node->key;
-    fibonacci_node *child = node->first_child;
+    fibonacci_node *child = PQ_NODE( queue, node->first_child );
+    fibonacci_node *next = PQ_NODE( queue, node->next_sibling );
 
     // remove from sibling list
-    node->next_sibling->prev_sibling = node->prev_sibling;
-    node->prev_sibling->next_sibling = node->next_sibling;
+    next->prev_sibling = node->prev_sibling;
+    PQ_NODE( queue, node->prev_sibling )->next_sibling = node->next_sibling;
 
     // find new temporary minimum
-    if ( node->next_sibling != node )
-        queue->minimum = node->next_sibling;
+    if ( next != node )
+        queue->minimum = next;
     else
         queue->minimum = child;
 
@@ -106,27 +114,40 @@ key_type pq_delete( fibonacci_heap *queue, fibonacci_node *node )
         return pq_delete_min( queue );
 
     key_type key = node->key;
-    fibonacci_node *child = node->first_child;
+    fibonacci_node *child = PQ_NODE( queue, node->first_child );
+    fibonacci_node *parent = PQ_NODE( queue, node->parent );
+    fibonacci_node *current;
 
     // remove from sibling list
-    node->next_sibling->prev_sibling = node->prev_sibling;
-    node->prev_sibling->next_sibling = node->next_sibling;
+    PQ_NODE( queue, node->next_sibling )->prev_sibling = node->prev_sibling;
+    PQ_NODE( queue, node->prev_sibling )->next_sibling = node->next_sibling;
 
-    if ( node->parent != NULL )
+    // the children become roots, so they must not point back at this node
+    if ( child != NULL )
     {
-        node->parent->rank--;
+        current = child;
+        do
+        {
+            current->parent = PQ_NULL_LINK;
+            current = PQ_NODE( queue, current->next_sibling );
+        } while ( current != child );
+    }
+
+    if ( parent != NULL )
+    {
+        parent->rank--;
         // if not a root, see if we need to update parent's first child
-        if ( node->parent->first_child == node )
+        if ( parent->first_child == PQ_REF( queue, node ) )
         {
-            if ( node->parent->rank == 0 )
-                node->parent->first_child = NULL;
+            if ( parent->rank == 0 )
+                parent->first_child = PQ_NULL_LINK;
             else
-                node->parent->first_child = node->next_sibling;
+                parent->first_child = node->next_sibling;
         }
-        if ( node->parent->marked == FALSE )
-            node->parent->marked = TRUE;
+        if ( parent->marked == FALSE )
+            parent->marked = TRUE;
         else
-            cut_from_parent( queue, node->parent );
+            cut_from_parent( queue, parent );
     }
 
     pq_free_node( queue->map, 0, node );
@@ -156,9 +177,10 @@ bool pq_empty( fibonacci_heap *queue )
 /**
  * Merges two node lists into one to update the root system of the queue.
  * Iteratively links the roots such that no two roots of the same rank
- * remain.  Assumes that the roots array is empty to begin with, and clears out
- * this array before completing execution.  Breaks list of roots to simplify
- * insertion and linking, and rebuilds the circular list at the end.
+ * remain.  Assumes that the registry is empty to begin with, and clears it
+ * before completing execution.  Breaks list of roots to simplify insertion and
+ * linking, and rebuilds the circular list at the end from the occupied ranks
+ * alone.
  *
  * @param queue Queue to which the two lists belong
  * @param a     First node list
@@ -169,62 +191,64 @@ static void merge_and_fix_roots( fibonacci_heap *queue, fibonacci_node *a,
 {
     fibonacci_node *start = append_lists( queue, a, b );
     fibonacci_node *current, *next;
-    int32_t i, rank;
+    uint64_t occupied;
+    uint32_t rank;
 
     if ( start == NULL )
         return;
 
     // break the circular list
-    start->prev_sibling->next_sibling = NULL;
-    start->prev_sibling = NULL;
+    PQ_NODE( queue, start->prev_sibling )->next_sibling = PQ_NULL_LINK;
+    start->prev_sibling = PQ_NULL_LINK;
     // insert an initial node
     queue->roots[start->rank] = start;
-    queue->largest_rank = start->rank;
-    start->parent = NULL;
-    current = start->next_sibling;
+    REGISTRY_SET( queue->registry, start->rank );
+    start->parent = PQ_NULL_LINK;
+    current = PQ_NODE( queue, start->next_sibling );
 
     // insert the rest of the nodes
     while( current != NULL )
     {
         // extract from the list
-        next = current->next_sibling;
+        next = PQ_NODE( queue, current->next_sibling );
         if( next != NULL )
-            next->prev_sibling = NULL;
-        current->next_sibling = NULL;
-        current->parent = NULL;
+            next->prev_sibling = PQ_NULL_LINK;
+        current->next_sibling = PQ_NULL_LINK;
+        current->parent = PQ_NULL_LINK;
 
         // insert into the registry
         while ( !attempt_insert( queue, current ) )
         {
             rank = current->rank;
             current = link( queue, current, queue->roots[rank] );
-            queue->roots[rank] = NULL;
+            REGISTRY_UNSET( queue->registry, rank );
         }
         current = next;
     }
 
-    // pick the largest tree out of the registry to start reforming the list
-    start = queue->roots[queue->largest_rank];
-    queue->roots[queue->largest_rank] = NULL;
+    // pull the trees out of the registry in rank order to reform the list,
+    // ties for the minimum going to the largest tree
+    occupied = queue->registry;
+    rank = REGISTRY_LEADER( occupied );
+    REGISTRY_UNSET( occupied, rank );
+    start = queue->roots[rank];
     queue->minimum = start;
 
     current = start;
-    // pull the rest out and clear the registry for later use
-    for ( i = queue->largest_rank - 1; i >= 0; i-- )
+    while( occupied )
     {
-        if( queue->roots[i] != NULL )
-        {
-            if( queue->roots[i]->key < queue->minimum->key )
-                queue->minimum = queue->roots[i];
-            current->prev_sibling = queue->roots[i];
-            queue->roots[i]->next_sibling = current;
-            current = queue->roots[i];
-            queue->roots[i] = NULL;
-        }
+        rank = REGISTRY_LEADER( occupied );
+        REGISTRY_UNSET( occupied, rank );
+        next = queue->roots[rank];
+        if( PQ_KEY_NOT_AFTER( next->key, queue->minimum->key ) )
+            queue->minimum = next;
+        current->next_sibling = PQ_REF( queue, next );
+        next->prev_sibling = PQ_REF( queue, current );
+        current = next;
     }
-    current->prev_sibling = start;
-    start->next_sibling = current;
-    queue->largest_rank = 0;
+    current->next_sibling = PQ_REF( queue, start );
+    start->prev_sibling = PQ_REF( queue, current );
+    queue->registry = 0;
 }
 
 /**
@@ -239,8 +263,8 @@ static void merge_and_fix_roots( fibonacci_heap *queue, fibonacci_node *a,
 static fibonacci_node* link( fibonacci_heap *queue, fibonacci_node *a,
     fibonacci_node *b )
 {
-    fibonacci_node *parent, *child;
-    if ( b->key < a->key ) {
+    fibonacci_node *parent, *child, *first;
+    if ( PQ_KEY_BEFORE( b->key, a->key ) ) {
         parent = b;
         child = a;
     }
@@ -251,10 +275,11 @@ static fibonacci_node* link( fibonacci_heap *queue, fibonacci_node *a,
 
     // roots are automatically unmarked
     child->marked = FALSE;
-    child->parent = parent;
-    child->next_sibling = child;
-    child->prev_sibling = child;
-    parent->first_child = append_lists( queue, parent->first_child, child );
+    child->parent = PQ_REF( queue, parent );
+    child->next_sibling = PQ_REF( queue, child );
+    child->prev_sibling = PQ_REF( queue, child );
+    first = append_lists( queue, PQ_NODE( queue, parent->first_child ), child );
+    parent->first_child = PQ_REF( queue, first );
     parent->rank++;
 
     return parent;
@@ -269,36 +294,37 @@ static fibonacci_node* link( fibonacci_heap *queue, fibonacci_node *a,
  */
 static void cut_from_parent( fibonacci_heap *queue, fibonacci_node *node )
 {
-    fibonacci_node *next, *prev;
-    if ( node->parent != NULL ) {
-        next = node->next_sibling;
-        prev = node->prev_sibling;
+    fibonacci_node *next, *prev, *parent;
+    if ( node->parent != PQ_NULL_LINK ) {
+        parent = PQ_NODE( queue, node->parent );
+        next = PQ_NODE( queue, node->next_sibling );
+        prev = PQ_NODE( queue, node->prev_sibling );
 
         next->prev_sibling = node->prev_sibling;
         prev->next_sibling = node->next_sibling;
 
-        node->next_sibling = node;
-        node->prev_sibling = node;
+        node->next_sibling = PQ_REF( queue, node );
+        node->prev_sibling = PQ_REF( queue, node );
 
-        node->parent->rank--;
-        if ( node->parent->first_child == node )
+        parent->rank--;
+        if ( parent->first_child == PQ_REF( queue, node ) )
         {
-            if ( node->parent->rank == 0 )
-                node->parent->first_child = NULL;
+            if ( parent->rank == 0 )
+                parent->first_child = PQ_NULL_LINK;
             else
-                node->parent->first_child = next;
+                parent->first_child = PQ_REF( queue, next );
         }
-        if ( node->parent->marked == FALSE )
-            node->parent->marked = TRUE;
+        if ( parent->marked == FALSE )
+            parent->marked = TRUE;
         else
-            cut_from_parent( queue, node->parent );
+            cut_from_parent( queue, parent );
 
         queue->minimum = append_lists( queue, node, queue->minimum );
-        node->parent = NULL;
+        node->parent = PQ_NULL_LINK;
     }
     else
     {
-        if( node->key < queue->minimum->key )
+        if( PQ_KEY_BEFORE( node->key, queue->minimum->key ) )
             queue->minimum = node;
     }
 }
@@ -326,16 +352,16 @@ static fibonacci_node* append_lists( fibonacci_heap *queue, fibonacci_node *a,
         list = a;
     else
     {
-        a_prev = a->prev_sibling;
-        b_prev = b->prev_sibling;
+        a_prev = PQ_NODE( queue, a->prev_sibling );
+        b_prev = PQ_NODE( queue, b->prev_sibling );
 
-        a_prev->next_sibling = b;
-        b_prev->next_sibling = a;
+        a_prev->next_sibling = PQ_REF( queue, b );
+        b_prev->next_sibling = PQ_REF( queue, a );
 
-        a->prev_sibling = b_prev;
-        b->prev_sibling = a_prev;
+        a->prev_sibling = PQ_REF( queue, b_prev );
+        b->prev_sibling = PQ_REF( queue, a_prev );
 
-        list = ( a->key <= b->key ) ? a : b;
+        list = PQ_KEY_NOT_AFTER( a->key, b->key ) ? a : b;
     }
 
     return list;
@@ -343,7 +369,7 @@ static fibonacci_node* append_lists( fibonacci_heap *queue, fibonacci_node *a,
 
 /**
  * Attempt to insert a tree in the rank-indexed array.  Inserts if the
- * correct spot is empty, reports failure if it is occupied.
+ * correct spot is unoccupied, reports failure if it is occupied.
  *
  * @param queue Queue to insert into
  * @param node  Node to insert
@@ -352,13 +378,11 @@ static fibonacci_node* append_lists( fibonacci_heap *queue, fibonacci_node *a,
 static bool attempt_insert( fibonacci_heap *queue, fibonacci_node *node )
 {
     uint32_t rank = node->rank;
-    fibonacci_node *occupant = queue->roots[rank];
-    if ( ( occupant != NULL ) && ( occupant != node ) )
+    if ( OCCUPIED( queue->registry, rank ) && ( queue->roots[rank] != node ) )
         return FALSE;
 
     queue->roots[rank] = node;
-    if ( rank > queue->largest_rank )
-        queue->largest_rank = rank;
+    REGISTRY_SET( queue->registry, rank );
 
     return TRUE;
 }
@@ -7,6 +7,8 @@
 
 #include "queue_common.h"
 
+#define PQ_HAS_COMPACT_REFS
+
 /**
  * Holds an inserted element, as well as pointers to maintain tree
  * structure.  Acts as a handle to clients for the purpose of
@@ -17,13 +19,13 @@
 struct fibonacci_node_t
 {
     //! Parent of this node
-    struct fibonacci_node_t *parent;
+    PQ_LINK( struct fibonacci_node_t ) parent;
     //! "First" child of this node
-    struct fibonacci_node_t *first_child;
+    PQ_LINK( struct fibonacci_node_t ) first_child;
     //! Next node in the list of this node's siblings
-    struct fibonacci_node_t *next_sibling;
+    PQ_LINK( struct fibonacci_node_t ) next_sibling;
     //! Previous node in the list of this node's siblings
-    struct fibonacci_node_t *prev_sibling;
+    PQ_LINK( struct fibonacci_node_t ) prev_sibling;
 
     //! The "height" of a node, i.e. bound on log of subtree size
     uint32_t rank;
@@ -57,8 +59,12 @@ struct fibonacci_heap_t
     fibonacci_node *minimum;
     //! An array of roots of the queue, indexed by rank
     fibonacci_node *roots[MAXRANK];
-    //! Current largest rank in queue
-    uint32_t largest_rank;
+    //! Ranks occupied in the roots array
+    uint64_t registry;
+#ifdef USE_COMPACT_REFS
+    //! Start of the arena's node slab, against which links are resolved
+    fibonacci_node *base;
+#endif
 } __attribute__ ((aligned(4)));
 
 typedef struct fibonacci_heap_t fibonacci_heap;
@@ -69,9 +75,9 @@ typedef fibonacci_heap pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty queue.
+ * Creates a new, empty queue, with its own arena carved from the given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 fibonacci_heap* pq_create( mem_map *map );
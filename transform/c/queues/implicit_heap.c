@@ -24,7 +24,7 @@ implicit_heap* pq_create( mem_map *map )
     queue->capacity = map->capacities[0];
     queue->nodes = calloc( queue->capacity, sizeof( implicit_node* ) );
 #endif
-    queue->map = map;
+    queue->map = mm_create_arena( map );
 
     return queue;
 }
@@ -32,6 +32,7 @@ implicit_heap* pq_create( mem_map *map )
 void pq_destroy( implicit_heap *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue->nodes );
     free( queue );
 }
@@ -59,7 +60,7 @@ uint32_t pq_get_size( implicit_heap *queue )
 
 implicit_node* pq_insert( implicit_heap *queue, item_type item, key_type key )
 {
-    implicit_node *node = pq_alloc_node( queue->map, 0 );
+    implicit_node *node = pq_alloc_node_uninit( queue->map, 0 );
     ITEM_ASSIGN( node->item, item );
     node->key = key;
     node->index = queue->size++;
@@ -86,6 +87,17 @@ key_type pq_delete_min( implicit_heap *queue )
     return pq_delete( queue, queue->nodes[0] );
 }
 
+implicit_node* pq_replace_min( implicit_heap *queue, item_type item,
+    key_type key )
+{
+    implicit_node *node = queue->nodes[0];
+    ITEM_ASSIGN( node->item, item );
+    node->key = key;
+    heapify_down( queue, node );
+
+    return node;
+}
+
 key_type pq_delete( implicit_heap *queue, implicit_node* node )
 {
     key_type key = node->key;
@@ -95,8 +107,14 @@ key_type pq_delete( implicit_heap *queue, implicit_node* node )
     pq_free_node( queue->map, 0, node );
     queue->size--;
 
+    // the last node may belong above the vacated position as well as below
     if ( node != last_node )
-        heapify_down( queue, last_node );
+    {
+        if ( PQ_KEY_BEFORE( last_node->key, key ) )
+            heapify_up( queue, last_node );
+        else
+            heapify_down( queue, last_node );
+    }
 
     return key;
 }
@@ -175,11 +193,11 @@ static uint32_t heapify_down( implicit_heap *queue, implicit_node *node )
         min = i++;
         for( i = i; i < sentinel; i++ )
         {
-            if( queue->nodes[i]->key < queue->nodes[min]->key )
+            if( PQ_KEY_BEFORE( queue->nodes[i]->key, queue->nodes[min]->key ) )
                 min = i;
         }
 
-        if ( queue->nodes[min]->key < node->key )
+        if ( PQ_KEY_BEFORE( queue->nodes[min]->key, node->key ) )
             push( queue, min, base );
         else
             break;
@@ -207,7 +225,8 @@ static uint32_t heapify_up( implicit_heap *queue, implicit_node *node )
     uint32_t i;
     for( i = node->index; i > 0; i = (i-1)/BRANCHING_FACTOR )
     {
-        if ( node->key < queue->nodes[(i-1)/BRANCHING_FACTOR]->key )
+        if ( PQ_KEY_BEFORE( node->key,
+                queue->nodes[(i-1)/BRANCHING_FACTOR]->key ) )
             push( queue, (i-1)/BRANCHING_FACTOR, i );
         else
             break;
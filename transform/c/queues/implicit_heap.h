@@ -17,6 +17,8 @@
 
 #include "queue_common.h"
 
+#define PQ_HAS_REPLACE_MIN
+
 /**
  * Holds an inserted element, as well as the current index in the node array.
  * Acts as a handle to clients for the purpose of mutability.
@@ -59,9 +61,9 @@ typedef implicit_heap pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty queue.
+ * Creates a new, empty queue, with its own arena carved from the given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 implicit_heap* pq_create( mem_map *map );
@@ -136,6 +138,22 @@ implicit_node* pq_find_min( implicit_heap *queue );
  */
 key_type pq_delete_min( implicit_heap *queue ) ;
 
+/**
+ * Replaces the minimum item of the queue with a new item-key pair.  Has the
+ * same effect as @ref <pq_delete_min> followed by @ref <pq_insert>, but writes
+ * the new pair into the root and sifts it down once instead of moving the last
+ * node up to the root and sifting the new node up from the bottom.  The
+ * minimum's node is reused for the new item, so clients must read the old
+ * minimum before the call.
+ *
+ * @param queue Queue to modify, which must not be empty
+ * @param item  Item to insert
+ * @param key   Key to use for node priority
+ * @return      Pointer to the node now holding the new item
+ */
+implicit_node* pq_replace_min( implicit_heap *queue, item_type item,
+    key_type key );
+
 /**
  * Removes an arbitrary item from the queue.  Requires that the location
  * of the item's corresponding node is known.  First swaps target node
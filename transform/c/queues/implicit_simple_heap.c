@@ -24,7 +24,7 @@ implicit_simple_heap* pq_create( mem_map *map )
     queue->capacity = map->capacities[0];
     queue->nodes = calloc( queue->capacity, sizeof( implicit_simple_node ) );
 #endif
-    queue->map = map;
+    queue->map = mm_create_arena( map );
 
     return queue;
 }
@@ -32,6 +32,7 @@ implicit_simple_heap* pq_create( mem_map *map )
 void pq_destroy( implicit_simple_heap *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue->nodes );
     free( queue );
 }
@@ -164,11 +165,11 @@ static uint32_t heapify_down( implicit_simple_heap *queue, implicit_simple_node
         min = i++;
         for( i = i; i < sentinel; i++ )
         {
-            if( queue->nodes[i].key < queue->nodes[min].key )
+            if( PQ_KEY_BEFORE( queue->nodes[i].key, queue->nodes[min].key ) )
                 min = i;
         }
 
-        if ( queue->nodes[min].key < saved.key )
+        if ( PQ_KEY_BEFORE( queue->nodes[min].key, saved.key ) )
             push( queue, min, base );
         else
             break;
@@ -194,7 +195,8 @@ static uint32_t heapify_up( implicit_simple_heap *queue, implicit_simple_node *n
     uint32_t i;
     for( i = node - queue->nodes; i > 0; i = (i-1)/BRANCHING_FACTOR )
     {
-        if ( saved.key < queue->nodes[(i-1)/BRANCHING_FACTOR].key )
+        if ( PQ_KEY_BEFORE( saved.key,
+                queue->nodes[(i-1)/BRANCHING_FACTOR].key ) )
             push( queue, (i-1)/BRANCHING_FACTOR, i );
         else
             break;
@@ -335,8 +335,8 @@ inline  void  KNHeap<Key, Value>::insert(Key k, Value v) {
 //////////////////////////////////////////////////////////////////////
 // Wrapper API for ompatibility with trace driver
 
-key_type PQ_KEY_SUP = std::numeric_limits<uint64_t>::max();
-key_type PQ_KEY_INF = 0;
+const key_type PQ_KEY_SUP = std::numeric_limits<uint64_t>::max();
+const key_type PQ_KEY_INF = 0;
 
 typedef KNHeap<key_type, item_type> pq_type;
 typedef KNElement<key_type, item_type> pq_node_type;
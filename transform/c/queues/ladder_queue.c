@@ -0,0 +1,443 @@
+#include "ladder_queue.h"
+
+//==============================================================================
+// DEFINES AND STATIC DECLARATIONS
+//==============================================================================
+
+#define BUCKET_OF(rung,a)   ( (uint32_t) ( ( (a) - (rung)->start ) >> \
+                                (rung)->shift ) )
+
+static void place( ladder_queue *queue, ladder_node *node );
+static void refill( ladder_queue *queue );
+static void spawn_rung( ladder_queue *queue, ladder_list *list, uint64_t start,
+    uint64_t last );
+static void sort_into_bottom( ladder_queue *queue, ladder_list *list );
+static void list_link( ladder_list *list, ladder_node *node );
+static void list_unlink( ladder_node *node );
+static void list_insert_sorted( ladder_list *list, ladder_node *node );
+static void list_sort( ladder_node **list );
+
+//==============================================================================
+// PUBLIC METHODS
+//==============================================================================
+
+ladder_queue* pq_create( mem_map *map )
+{
+    ladder_queue *queue = calloc( 1, sizeof( ladder_queue ) );
+    queue->map = mm_create_arena( map );
+
+    return queue;
+}
+
+void pq_destroy( ladder_queue *queue )
+{
+    pq_clear( queue );
+    mm_destroy( queue->map );
+    free( queue );
+}
+
+void pq_clear( ladder_queue *queue )
+{
+    uint32_t i;
+
+    mm_clear( queue->map );
+    for ( i = 0; i < queue->rung_count; i++ )
+        free( queue->rungs[i].buckets );
+
+    queue->size = 0;
+    queue->rung_count = 0;
+    queue->top_min = 0;
+    queue->top_max = 0;
+    queue->ladder_last = 0;
+    queue->top.head = NULL;
+    queue->top.count = 0;
+    queue->bottom.head = NULL;
+    queue->bottom.count = 0;
+}
+
+key_type pq_get_key( ladder_queue *queue, ladder_node *node )
+{
+    return PQ_KEY_ORDER( node->key );
+}
+
+item_type* pq_get_item( ladder_queue *queue, ladder_node *node )
+{
+    return (item_type*) &(node->item);
+}
+
+uint32_t pq_get_size( ladder_queue *queue )
+{
+    return queue->size;
+}
+
+ladder_node* pq_insert( ladder_queue *queue, item_type item, key_type key )
+{
+    ladder_node *wrapper = pq_alloc_node( queue->map, 0 );
+    ITEM_ASSIGN( wrapper->item, item );
+    // keys are stored so that the front of the queue is the smallest
+    wrapper->key = PQ_KEY_ORDER( key );
+
+    place( queue, wrapper );
+    queue->size++;
+
+    return wrapper;
+}
+
+ladder_node* pq_find_min( ladder_queue *queue )
+{
+    if ( pq_empty( queue ) )
+        return NULL;
+
+    if ( queue->bottom.count == 0 )
+        refill( queue );
+
+    return queue->bottom.head;
+}
+
+key_type pq_delete_min( ladder_queue *queue )
+{
+    return pq_delete( queue, pq_find_min( queue ) );
+}
+
+key_type pq_delete( ladder_queue *queue, ladder_node *node )
+{
+    key_type key = node->key;
+
+    list_unlink( node );
+    pq_free_node( queue->map, 0, node );
+    queue->size--;
+
+    return PQ_KEY_ORDER( key );
+}
+
+void pq_decrease_key( ladder_queue *queue, ladder_node *node, key_type new_key )
+{
+    list_unlink( node );
+    node->key = PQ_KEY_ORDER( new_key );
+    place( queue, node );
+}
+
+bool pq_empty( ladder_queue *queue )
+{
+    return ( queue->size == 0 );
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Links a node into the tier its key belongs to.  Keys beyond the ladder go
+ * to the top, as does everything while the ladder is empty, since the bottom
+ * is only ever filled from the ladder.  Otherwise the rungs are tried from
+ * the coarsest down, each accepting keys from its first bucket not yet
+ * handed down, and keys below all of them go into the bottom.  A bottom that
+ * grows too long is spread over a new rung.
+ *
+ * @param queue Queue in which to operate
+ * @param node  Node to place
+ */
+static void place( ladder_queue *queue, ladder_node *node )
+{
+    uint64_t key = node->key;
+    uint64_t last;
+    ladder_rung *rung;
+    uint32_t i;
+
+    if ( queue->rung_count == 0 || key > queue->ladder_last )
+    {
+        if ( queue->top.count == 0 )
+        {
+            queue->top_min = key;
+            queue->top_max = key;
+        }
+        else if ( key < queue->top_min )
+            queue->top_min = key;
+        else if ( key > queue->top_max )
+            queue->top_max = key;
+        list_link( &queue->top, node );
+        return;
+    }
+
+    for ( i = 0; i < queue->rung_count; i++ )
+    {
+        rung = &queue->rungs[i];
+        if ( key >= rung->start && key <= rung->last &&
+                BUCKET_OF( rung, key ) >= rung->cur )
+        {
+            list_link( &rung->buckets[BUCKET_OF( rung, key )], node );
+            return;
+        }
+    }
+
+    list_insert_sorted( &queue->bottom, node );
+    if ( queue->bottom.count > LADDER_THRESHOLD &&
+            queue->rung_count < LADDER_MAX_RUNGS )
+    {
+        // the new rung reaches up to where the lowest rung takes over, or
+        // to its end once it is exhausted; cur << shift is only computed
+        // short of that, where it cannot overflow even for a shift of 63
+        rung = &queue->rungs[queue->rung_count - 1];
+        if ( rung->cur == rung->bucket_count )
+            last = rung->last;
+        else
+            last = rung->start + ( (uint64_t) rung->cur << rung->shift ) - 1;
+        spawn_rung( queue, &queue->bottom, queue->bottom.head->key, last );
+    }
+}
+
+/**
+ * Fills the empty bottom.  Works on the lowest rung, dropping it once all of
+ * its buckets have been handed down and restarting the ladder from the top
+ * once no rungs are left.  The rung's first non-empty bucket is sorted into
+ * the bottom if it is short enough, and split into a new rung otherwise.
+ *
+ * @param queue Queue to refill, holding at least one node
+ */
+static void refill( ladder_queue *queue )
+{
+    ladder_rung *rung;
+    ladder_list *list;
+    uint64_t start, span;
+
+    while ( queue->bottom.count == 0 )
+    {
+        if ( queue->rung_count == 0 )
+        {
+            queue->ladder_last = queue->top_max;
+            spawn_rung( queue, &queue->top, queue->top_min, queue->top_max );
+        }
+
+        rung = &queue->rungs[queue->rung_count - 1];
+        while ( rung->cur < rung->bucket_count &&
+                rung->buckets[rung->cur].count == 0 )
+            rung->cur++;
+
+        if ( rung->cur == rung->bucket_count )
+        {
+            free( rung->buckets );
+            queue->rung_count--;
+            continue;
+        }
+
+        list = &rung->buckets[rung->cur];
+        start = rung->start + ( (uint64_t) rung->cur << rung->shift );
+        rung->cur++;
+
+        if ( list->count > LADDER_THRESHOLD && rung->shift > 0 &&
+                queue->rung_count < LADDER_MAX_RUNGS )
+        {
+            span = ( (uint64_t) 1 << rung->shift ) - 1;
+            if ( span > rung->last - start )
+                span = rung->last - start;
+            spawn_rung( queue, list, start, start + span );
+        }
+        else
+            sort_into_bottom( queue, list );
+    }
+}
+
+/**
+ * Adds a new lowest rung covering the given range of keys and spreads the
+ * nodes of a list over it.  The bucket width is the smallest power of two
+ * that gives no more buckets than there are nodes.
+ *
+ * @param queue Queue in which to operate
+ * @param list  List whose nodes to move, all with keys in range
+ * @param start Smallest key covered by the rung
+ * @param last  Largest key covered by the rung
+ */
+static void spawn_rung( ladder_queue *queue, ladder_list *list, uint64_t start,
+    uint64_t last )
+{
+    ladder_rung *rung = &queue->rungs[queue->rung_count++];
+    uint64_t span = last - start;
+    ladder_node *node;
+    uint32_t shift;
+
+    for ( shift = 0; shift < 63 && ( span >> shift ) >= list->count; shift++ );
+
+    rung->start = start;
+    rung->last = last;
+    rung->shift = shift;
+    rung->bucket_count = (uint32_t) ( span >> shift ) + 1;
+    rung->cur = 0;
+    rung->buckets = calloc( rung->bucket_count, sizeof( ladder_list ) );
+
+    while ( list->head != NULL )
+    {
+        node = list->head;
+        list_unlink( node );
+        list_link( &rung->buckets[BUCKET_OF( rung, node->key )], node );
+    }
+}
+
+/**
+ * Sorts a list and makes it the bottom, which must be empty.
+ *
+ * @param queue Queue in which to operate
+ * @param list  List to move
+ */
+static void sort_into_bottom( ladder_queue *queue, ladder_list *list )
+{
+    ladder_node *current;
+
+    list_sort( &list->head );
+    queue->bottom.head = list->head;
+    queue->bottom.count = list->count;
+    list->head = NULL;
+    list->count = 0;
+
+    current = queue->bottom.head;
+    do
+    {
+        current->list = &queue->bottom;
+        current = current->next;
+    } while ( current != queue->bottom.head );
+}
+
+/**
+ * Appends a node to the end of a circular list.
+ *
+ * @param list  List to extend
+ * @param node  Node to append
+ */
+static void list_link( ladder_list *list, ladder_node *node )
+{
+    ladder_node *head = list->head;
+
+    node->list = list;
+    list->count++;
+
+    if ( head == NULL )
+    {
+        node->next = node;
+        node->prev = node;
+        list->head = node;
+        return;
+    }
+
+    node->next = head;
+    node->prev = head->prev;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+/**
+ * Removes a node from the circular list holding it, advancing the head if
+ * necessary.
+ *
+ * @param node  Node to remove
+ */
+static void list_unlink( ladder_node *node )
+{
+    ladder_list *list = node->list;
+
+    list->count--;
+    if ( node->next == node )
+    {
+        list->head = NULL;
+        return;
+    }
+
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    if ( list->head == node )
+        list->head = node->next;
+}
+
+/**
+ * Inserts a node into a circular list kept sorted by key.  Searches from the
+ * tail.
+ *
+ * @param list  Sorted list
+ * @param node  Node to insert
+ */
+static void list_insert_sorted( ladder_list *list, ladder_node *node )
+{
+    ladder_node *current;
+
+    if ( list->head == NULL || node->key < list->head->key )
+    {
+        list_link( list, node );
+        list->head = node;
+        return;
+    }
+
+    current = list->head->prev;
+    while ( node->key < current->key )
+        current = current->prev;
+
+    node->list = list;
+    list->count++;
+    node->next = current->next;
+    node->prev = current;
+    current->next->prev = node;
+    current->next = node;
+}
+
+/**
+ * Sorts a circular list by key with a bottom-up merge sort.
+ *
+ * @param list  Head pointer of the list to sort
+ */
+static void list_sort( ladder_node **list )
+{
+    ladder_node *head = *list;
+    ladder_node *tail, *p, *q, *next;
+    uint32_t width, merges, p_size, q_size;
+
+    if ( head == NULL || head->next == head )
+        return;
+
+    head->prev->next = NULL;
+    for ( width = 1; ; width <<= 1 )
+    {
+        p = head;
+        head = NULL;
+        tail = NULL;
+        merges = 0;
+
+        while ( p != NULL )
+        {
+            merges++;
+            q = p;
+            for ( p_size = 0; p_size < width && q != NULL; p_size++ )
+                q = q->next;
+            q_size = width;
+
+            while ( p_size > 0 || ( q_size > 0 && q != NULL ) )
+            {
+                if ( p_size == 0 || ( q_size > 0 && q != NULL &&
+                        q->key < p->key ) )
+                {
+                    next = q;
+                    q = q->next;
+                    q_size--;
+                }
+                else
+                {
+                    next = p;
+                    p = p->next;
+                    p_size--;
+                }
+
+                if ( tail == NULL )
+                    head = next;
+                else
+                    tail->next = next;
+                next->prev = tail;
+                tail = next;
+            }
+            p = q;
+        }
+        tail->next = NULL;
+
+        if ( merges <= 1 )
+            break;
+    }
+
+    head->prev = tail;
+    tail->next = head;
+    *list = head;
+}
@@ -0,0 +1,235 @@
+#ifndef LADDER_QUEUE
+#define LADDER_QUEUE
+
+//==============================================================================
+// DEFINES, INCLUDES, and STRUCTS
+//==============================================================================
+
+#include "queue_common.h"
+
+// a bucket holding more nodes than this is split into a new rung rather than
+// sorted, and a bottom list growing past it is turned into a rung
+#ifndef LADDER_THRESHOLD
+    #define LADDER_THRESHOLD    50
+#endif
+// the most rungs the ladder may have at once
+#define LADDER_MAX_RUNGS        8
+
+/**
+ * An unsorted circular doubly linked list along with its length.  The top,
+ * the bottom, and every rung bucket are ladder lists.
+ */
+struct ladder_list_t
+{
+    //! First node of the list, or NULL if it is empty
+    struct ladder_node_t *head;
+    //! Number of nodes in the list
+    uint32_t count;
+} __attribute__ ((aligned(4)));
+
+typedef struct ladder_list_t ladder_list;
+
+/**
+ * Holds an inserted element, as well as pointers to maintain its place in a
+ * list.  Acts as a handle to clients for the purpose of mutability.  Lists
+ * are circular, so the prev pointer of the first node points to the last.
+ */
+struct ladder_node_t
+{
+    //! Next node in this node's list
+    struct ladder_node_t *next;
+    //! Previous node in this node's list
+    struct ladder_node_t *prev;
+    //! List currently holding this node
+    ladder_list *list;
+
+    //! Pointer to a piece of client data
+    item_type item;
+    //! Key for the item
+    key_type key;
+} __attribute__ ((aligned(4)));
+
+typedef struct ladder_node_t ladder_node;
+typedef ladder_node pq_node_type;
+
+/**
+ * One rung of the ladder: an array of buckets of width 2^shift covering the
+ * keys from start to last.  Buckets before cur have been handed down to a
+ * lower rung or to the bottom, so new keys in their range go there instead.
+ */
+struct ladder_rung_t
+{
+    //! Smallest key covered by the rung
+    uint64_t start;
+    //! Largest key covered by the rung
+    uint64_t last;
+    //! log2 of the bucket width
+    uint32_t shift;
+    //! Number of buckets
+    uint32_t bucket_count;
+    //! First bucket not yet handed down
+    uint32_t cur;
+    //! The buckets themselves
+    ladder_list *buckets;
+} __attribute__ ((aligned(4)));
+
+typedef struct ladder_rung_t ladder_rung;
+
+/**
+ * A mutable ladder queue, after Tang, Goh and Thng.  Nodes live in one of
+ * three tiers.  The top is an unsorted list of keys beyond everything on the
+ * ladder, appended to in O(1).  The ladder is a stack of rungs, each an array
+ * of buckets finer than the one above it, covering the part of its parent's
+ * bucket that was split off.  The bottom is a short sorted list holding the
+ * smallest keys, from which the minimum is taken.
+ *
+ * When the bottom runs dry, the first non-empty bucket of the lowest rung is
+ * sorted into it, or split into a new rung if it holds more than
+ * LADDER_THRESHOLD nodes; when the ladder runs dry, the top is spread over a
+ * new first rung with about one bucket per node.  Nodes are thus touched a
+ * bounded number of times on their way down, which makes every operation
+ * O(1) amortized for the key distributions of event simulations.  Bucket
+ * widths are rounded to powers of two so that buckets are found with
+ * shifts.  Every node records the list holding it, so it can be unlinked
+ * from wherever it is, and a decrease-key is a removal and reinsertion.
+ */
+struct ladder_queue_t
+{
+    //! Memory map to use for node allocation
+    mem_map *map;
+    //! The number of items held in the queue
+    uint32_t size;
+    //! Number of rungs in use
+    uint32_t rung_count;
+    //! Smallest key in the top, or a lower bound on it
+    uint64_t top_min;
+    //! Largest key in the top, or an upper bound on it
+    uint64_t top_max;
+    //! Largest key covered by the ladder and bottom; larger keys go to the top
+    uint64_t ladder_last;
+    //! Unsorted list of the largest keys
+    ladder_list top;
+    //! Sorted list of the smallest keys
+    ladder_list bottom;
+    //! The rungs, from the coarsest down
+    ladder_rung rungs[LADDER_MAX_RUNGS];
+} __attribute__ ((aligned(4)));
+
+typedef struct ladder_queue_t ladder_queue;
+typedef ladder_queue pq_type;
+
+//==============================================================================
+// PUBLIC DECLARATIONS
+//==============================================================================
+
+/**
+ * Creates a new, empty queue, with its own arena carved from the given map.
+ *
+ * @param map   Memory map from which to carve the arena for its nodes
+ * @return      Pointer to the new queue
+ */
+ladder_queue* pq_create( mem_map *map );
+
+/**
+ * Frees all the memory used by the queue.
+ *
+ * @param queue Queue to destroy
+ */
+void pq_destroy( ladder_queue *queue );
+
+/**
+ * Deletes all nodes, leaving the queue empty.
+ *
+ * @param queue Queue to clear
+ */
+void pq_clear( ladder_queue *queue );
+
+/**
+ * Returns the key associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's key
+ */
+key_type pq_get_key( ladder_queue *queue, ladder_node *node );
+
+/**
+ * Returns the item associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's item
+ */
+item_type* pq_get_item( ladder_queue *queue, ladder_node *node );
+
+/**
+ * Returns the current size of the queue.
+ *
+ * @param queue Queue to query
+ * @return      Size of queue
+ */
+uint32_t pq_get_size( ladder_queue *queue );
+
+/**
+ * Takes an item-key pair to insert it into the queue and creates a new
+ * corresponding node.  Appends the node to the top if its key lies beyond
+ * the ladder, or else to the bucket of the coarsest rung still covering it,
+ * or else into the sorted bottom.
+ *
+ * @param queue Queue to insert into
+ * @param item  Item to insert
+ * @param key   Key to use for node priority
+ * @return      Pointer to corresponding node
+ */
+ladder_node* pq_insert( ladder_queue *queue, item_type item, key_type key );
+
+/**
+ * Returns the minimum item from the queue.  Refills the bottom from the
+ * ladder, and the ladder from the top, if necessary.
+ *
+ * @param queue Queue to query
+ * @return      Node with minimum key
+ */
+ladder_node* pq_find_min( ladder_queue *queue );
+
+/**
+ * Deletes the minimum item from the queue and returns it.  Relies on
+ * @ref <pq_find_min> to locate it and @ref <pq_delete> to unlink it.
+ *
+ * @param queue Queue to query
+ * @return      Minimum key, corresponding to item deleted
+ */
+key_type pq_delete_min( ladder_queue *queue );
+
+/**
+ * Deletes an arbitrary item from the queue.  Requires that the location of
+ * the item's corresponding node is known.  Unlinks the node from its list.
+ *
+ * @param queue Queue in which the node resides
+ * @param node  Pointer to node corresponding to the item to delete
+ * @return      Key of item deleted
+ */
+key_type pq_delete( ladder_queue *queue, ladder_node *node );
+
+/**
+ * If the item in the queue is modified in such a way to decrease the
+ * key, then this function will update the queue to preserve queue
+ * properties given a pointer to the corresponding node.  Unlinks the node
+ * and places it again under its new key.
+ *
+ * @param queue     Queue in which the node resides
+ * @param node      Node to change
+ * @param new_key   New key to use for the given node
+ */
+void pq_decrease_key( ladder_queue *queue, ladder_node *node,
+    key_type new_key );
+
+/**
+ * Determines whether the queue is empty, or if it holds some items.
+ *
+ * @param queue Queue to query
+ * @return      True if queue holds nothing, false otherwise
+ */
+bool pq_empty( ladder_queue *queue );
+
+#endif
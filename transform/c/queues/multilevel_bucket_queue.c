@@ -0,0 +1,554 @@
+#include "multilevel_bucket_queue.h"
+
+//==============================================================================
+// DEFINES AND STATIC DECLARATIONS
+//==============================================================================
+
+#define PRIORITY(a) ( (a) >> MULTILEVEL_KEY_SHIFT )
+#define DIGIT(a,l)  ( (uint32_t) ( ( (a) >> ( (l) * MULTILEVEL_BITS ) ) & \
+    MULTILEVEL_MASK ) )
+
+static uint32_t level_of( uint64_t base, uint64_t priority );
+static multilevel_node** locate( multilevel_bucket_queue *queue,
+    multilevel_node *node );
+static void place( multilevel_bucket_queue *queue, multilevel_node *node );
+static void remove_from( multilevel_bucket_queue *queue,
+    multilevel_node **list, multilevel_node *node );
+static void mark_empty( multilevel_bucket_queue *queue, uint32_t level,
+    uint32_t slot );
+static void lower_base( multilevel_bucket_queue *queue, uint64_t priority );
+static void push_down( multilevel_bucket_queue *queue, uint32_t level );
+static uint32_t first_occupied( multilevel_bucket_queue *queue,
+    uint32_t level );
+static void list_link( multilevel_node **list, multilevel_node *node );
+static void list_unlink( multilevel_node **list, multilevel_node *node );
+static void list_splice( multilevel_node **dst, multilevel_node *src );
+static void list_insert_sorted( multilevel_node **list,
+    multilevel_node *node );
+static void list_sort( multilevel_node **list );
+
+//==============================================================================
+// PUBLIC METHODS
+//==============================================================================
+
+multilevel_bucket_queue* pq_create( mem_map *map )
+{
+    multilevel_bucket_queue *queue = calloc( 1,
+        sizeof( multilevel_bucket_queue ) );
+    queue->map = mm_create_arena( map );
+
+    return queue;
+}
+
+void pq_destroy( multilevel_bucket_queue *queue )
+{
+    pq_clear( queue );
+    mm_destroy( queue->map );
+    free( queue );
+}
+
+void pq_clear( multilevel_bucket_queue *queue )
+{
+    mm_clear( queue->map );
+    queue->size = 0;
+    queue->base = 0;
+    queue->levels = 0;
+    queue->minimum = NULL;
+    queue->sorted = NULL;
+    memset( queue->occupied, 0, sizeof( queue->occupied ) );
+    memset( queue->buckets, 0, sizeof( queue->buckets ) );
+}
+
+key_type pq_get_key( multilevel_bucket_queue *queue, multilevel_node *node )
+{
+    return PQ_KEY_ORDER( node->key );
+}
+
+item_type* pq_get_item( multilevel_bucket_queue *queue, multilevel_node *node )
+{
+    return (item_type*) &(node->item);
+}
+
+uint32_t pq_get_size( multilevel_bucket_queue *queue )
+{
+    return queue->size;
+}
+
+multilevel_node* pq_insert( multilevel_bucket_queue *queue, item_type item,
+    key_type key )
+{
+    // keys are stored so that the front of the queue is the smallest
+    key = PQ_KEY_ORDER( key );
+    uint64_t priority = PRIORITY( key );
+    multilevel_node *wrapper = pq_alloc_node( queue->map, 0 );
+    ITEM_ASSIGN( wrapper->item, item );
+    wrapper->key = key;
+
+    if ( queue->size == 0 )
+        queue->base = priority;
+    else if ( priority < queue->base )
+        lower_base( queue, priority );
+
+    queue->size++;
+    place( queue, wrapper );
+
+    if ( queue->size == 1 ||
+            ( queue->minimum != NULL && key < queue->minimum->key ) )
+        queue->minimum = wrapper;
+
+    return wrapper;
+}
+
+multilevel_node* pq_find_min( multilevel_bucket_queue *queue )
+{
+    uint32_t level, slot;
+
+    if ( pq_empty( queue ) )
+        return NULL;
+    if ( queue->minimum != NULL )
+        return queue->minimum;
+
+    level = REGISTRY_LEADER( queue->levels );
+    if ( level > 0 )
+        push_down( queue, level );
+
+    // every node in a lowest level bucket shares a priority
+    slot = first_occupied( queue, 0 );
+    if ( queue->sorted != &queue->buckets[0][slot] )
+    {
+        list_sort( &queue->buckets[0][slot] );
+        queue->sorted = &queue->buckets[0][slot];
+    }
+    queue->minimum = queue->buckets[0][slot];
+
+    return queue->minimum;
+}
+
+key_type pq_delete_min( multilevel_bucket_queue *queue )
+{
+    return pq_delete( queue, pq_find_min( queue ) );
+}
+
+key_type pq_delete( multilevel_bucket_queue *queue, multilevel_node *node )
+{
+    key_type key = node->key;
+
+    if ( node == queue->minimum )
+        queue->minimum = NULL;
+
+    remove_from( queue, locate( queue, node ), node );
+    pq_free_node( queue->map, 0, node );
+    queue->size--;
+
+    return PQ_KEY_ORDER( key );
+}
+
+void pq_decrease_key( multilevel_bucket_queue *queue, multilevel_node *node,
+    key_type new_key )
+{
+    new_key = PQ_KEY_ORDER( new_key );
+    uint64_t priority = PRIORITY( new_key );
+    multilevel_node **list = locate( queue, node );
+
+    if ( priority < queue->base )
+    {
+        remove_from( queue, list, node );
+        node->key = new_key;
+        lower_base( queue, priority );
+        place( queue, node );
+    }
+    else
+    {
+        node->key = new_key;
+        if ( locate( queue, node ) != list || list == queue->sorted )
+        {
+            // relink from the old location, which the new key may no longer map to
+            remove_from( queue, list, node );
+            place( queue, node );
+        }
+    }
+
+    if ( queue->minimum != NULL && new_key < queue->minimum->key )
+        queue->minimum = node;
+}
+
+bool pq_empty( multilevel_bucket_queue *queue )
+{
+    return ( queue->size == 0 );
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Determines the level of a priority relative to the base, i.e. the index of
+ * the highest digit in which they differ.
+ *
+ * @param base      Base priority
+ * @param priority  Priority to classify, at least the base
+ * @return          Level on which the priority belongs
+ */
+static uint32_t level_of( uint64_t base, uint64_t priority )
+{
+    uint64_t diff = base ^ priority;
+
+    if ( diff == 0 )
+        return 0;
+
+    return ( 63 - __builtin_clzll( diff ) ) / MULTILEVEL_BITS;
+}
+
+/**
+ * Finds the bucket in which a node currently resides.  Relies on the
+ * invariant that every node sits in the bucket its priority maps to under the
+ * current base.
+ *
+ * @param queue Queue in which the node resides
+ * @param node  Node to locate
+ * @return      Address of the head pointer of the node's bucket
+ */
+static multilevel_node** locate( multilevel_bucket_queue *queue,
+    multilevel_node *node )
+{
+    uint64_t priority = PRIORITY( node->key );
+    uint32_t level = level_of( queue->base, priority );
+
+    return &queue->buckets[level][DIGIT( priority, level )];
+}
+
+/**
+ * Links a node into the bucket its priority maps to under the current base.
+ *
+ * @param queue Queue in which to operate
+ * @param node  Node to place
+ */
+static void place( multilevel_bucket_queue *queue, multilevel_node *node )
+{
+    uint64_t priority = PRIORITY( node->key );
+    uint32_t level = level_of( queue->base, priority );
+    uint32_t slot = DIGIT( priority, level );
+
+    if ( queue->buckets[level][slot] == NULL )
+    {
+        REGISTRY_SET( queue->occupied[level][slot >> 6], ( slot & 63 ) );
+        REGISTRY_SET( queue->levels, level );
+    }
+    if ( &queue->buckets[level][slot] == queue->sorted )
+        list_insert_sorted( &queue->buckets[level][slot], node );
+    else
+        list_link( &queue->buckets[level][slot], node );
+}
+
+/**
+ * Unlinks a node from the given bucket, keeping the occupancy bitmaps up to
+ * date.
+ *
+ * @param queue Queue in which to operate
+ * @param list  Head pointer of the bucket holding the node
+ * @param node  Node to remove
+ */
+static void remove_from( multilevel_bucket_queue *queue,
+    multilevel_node **list, multilevel_node *node )
+{
+    uint32_t index;
+
+    list_unlink( list, node );
+    if ( *list != NULL )
+        return;
+
+    if ( list == queue->sorted )
+        queue->sorted = NULL;
+    index = (uint32_t) ( list - &queue->buckets[0][0] );
+    mark_empty( queue, index >> MULTILEVEL_BITS, index & MULTILEVEL_MASK );
+}
+
+/**
+ * Clears the occupancy bit of a bucket that has just been emptied, and that
+ * of its level if no other bucket on it is occupied.
+ *
+ * @param queue Queue in which to operate
+ * @param level Level of the emptied bucket
+ * @param slot  Index of the emptied bucket on its level
+ */
+static void mark_empty( multilevel_bucket_queue *queue, uint32_t level,
+    uint32_t slot )
+{
+    uint32_t word;
+
+    REGISTRY_UNSET( queue->occupied[level][slot >> 6], ( slot & 63 ) );
+    for ( word = 0; word < MULTILEVEL_WORDS; word++ )
+    {
+        if ( queue->occupied[level][word] )
+            return;
+    }
+    REGISTRY_UNSET( queue->levels, level );
+}
+
+/**
+ * Moves the base down to the given priority.  Nodes on levels below the
+ * highest digit in which the old and new bases differ all share that digit
+ * with the old base, so they are spliced whole into the corresponding bucket
+ * on that level.  Nodes on that level or above keep their buckets.
+ *
+ * @param queue     Queue in which to operate
+ * @param priority  New base priority, below the current one
+ */
+static void lower_base( multilevel_bucket_queue *queue, uint64_t priority )
+{
+    uint32_t top = level_of( queue->base, priority );
+    uint32_t target = DIGIT( queue->base, top );
+    uint32_t level, word, slot;
+    uint64_t bits;
+
+    for ( level = 0; level < top; level++ )
+    {
+        if ( !OCCUPIED( queue->levels, level ) )
+            continue;
+
+        // only the lowest level is ever sorted, and it is about to be merged
+        queue->sorted = NULL;
+
+        for ( word = 0; word < MULTILEVEL_WORDS; word++ )
+        {
+            bits = queue->occupied[level][word];
+            while ( bits )
+            {
+                slot = ( word << 6 ) + REGISTRY_LEADER( bits );
+                REGISTRY_UNSET( bits, ( slot & 63 ) );
+                list_splice( &queue->buckets[top][target],
+                    queue->buckets[level][slot] );
+                queue->buckets[level][slot] = NULL;
+            }
+            queue->occupied[level][word] = 0;
+        }
+
+        REGISTRY_UNSET( queue->levels, level );
+        REGISTRY_SET( queue->occupied[top][target >> 6], ( target & 63 ) );
+        REGISTRY_SET( queue->levels, top );
+    }
+
+    queue->base = priority;
+}
+
+/**
+ * Empties the first occupied bucket on the given level, rebasing on the
+ * smallest priority it holds so that all its nodes land on lower levels.
+ *
+ * @param queue Queue in which to operate
+ * @param level Lowest non-empty level, which must be above zero
+ */
+static void push_down( multilevel_bucket_queue *queue, uint32_t level )
+{
+    multilevel_node *current, *next, *bucket;
+    uint32_t slot = first_occupied( queue, level );
+    uint64_t priority;
+
+    bucket = queue->buckets[level][slot];
+    priority = PRIORITY( bucket->key );
+    for ( current = bucket->next; current != bucket; current = current->next )
+    {
+        if ( PRIORITY( current->key ) < priority )
+            priority = PRIORITY( current->key );
+    }
+
+    // detach the bucket and break the cycle so it can be walked while relinking
+    queue->buckets[level][slot] = NULL;
+    mark_empty( queue, level, slot );
+    bucket->prev->next = NULL;
+
+    queue->base = priority;
+    for ( current = bucket; current != NULL; current = next )
+    {
+        next = current->next;
+        place( queue, current );
+    }
+}
+
+/**
+ * Finds the first occupied bucket on a level.  Assumes the level is non-empty.
+ *
+ * @param queue Queue to search
+ * @param level Level to search
+ * @return      Index of the first occupied bucket
+ */
+static uint32_t first_occupied( multilevel_bucket_queue *queue,
+    uint32_t level )
+{
+    uint32_t word;
+
+    for ( word = 0; word < MULTILEVEL_WORDS; word++ )
+    {
+        if ( queue->occupied[level][word] )
+            return ( word << 6 ) +
+                REGISTRY_LEADER( queue->occupied[level][word] );
+    }
+
+    return 0;
+}
+
+/**
+ * Appends a node to the end of a circular list.
+ *
+ * @param list  Head pointer of the list
+ * @param node  Node to append
+ */
+static void list_link( multilevel_node **list, multilevel_node *node )
+{
+    multilevel_node *head = *list;
+
+    if ( head == NULL )
+    {
+        node->next = node;
+        node->prev = node;
+        *list = node;
+        return;
+    }
+
+    node->next = head;
+    node->prev = head->prev;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+/**
+ * Removes a node from a circular list, advancing the head if necessary.
+ *
+ * @param list  Head pointer of the list
+ * @param node  Node to remove
+ */
+static void list_unlink( multilevel_node **list, multilevel_node *node )
+{
+    if ( node->next == node )
+    {
+        *list = NULL;
+        return;
+    }
+
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    if ( *list == node )
+        *list = node->next;
+}
+
+/**
+ * Appends an entire circular list to the end of another.
+ *
+ * @param dst   Head pointer of the list to extend
+ * @param src   Head of the list to append
+ */
+static void list_splice( multilevel_node **dst, multilevel_node *src )
+{
+    multilevel_node *dst_tail, *src_tail;
+
+    if ( src == NULL )
+        return;
+
+    if ( *dst == NULL )
+    {
+        *dst = src;
+        return;
+    }
+
+    dst_tail = (*dst)->prev;
+    src_tail = src->prev;
+    dst_tail->next = src;
+    src->prev = dst_tail;
+    src_tail->next = *dst;
+    (*dst)->prev = src_tail;
+}
+
+/**
+ * Inserts a node into a circular list kept sorted by key.  Searches from the
+ * tail, since new nodes usually carry the largest tie-breaking bits.
+ *
+ * @param list  Head pointer of the sorted list
+ * @param node  Node to insert
+ */
+static void list_insert_sorted( multilevel_node **list,
+    multilevel_node *node )
+{
+    multilevel_node *current;
+
+    if ( *list == NULL || node->key < (*list)->key )
+    {
+        list_link( list, node );
+        *list = node;
+        return;
+    }
+
+    current = (*list)->prev;
+    while ( node->key < current->key )
+        current = current->prev;
+
+    node->next = current->next;
+    node->prev = current;
+    current->next->prev = node;
+    current->next = node;
+}
+
+/**
+ * Sorts a circular list by key with a bottom-up merge sort.
+ *
+ * @param list  Head pointer of the list to sort
+ */
+static void list_sort( multilevel_node **list )
+{
+    multilevel_node *head = *list;
+    multilevel_node *tail, *p, *q, *next;
+    uint32_t width, merges, p_size, q_size;
+
+    if ( head == NULL || head->next == head )
+        return;
+
+    head->prev->next = NULL;
+    for ( width = 1; ; width <<= 1 )
+    {
+        p = head;
+        head = NULL;
+        tail = NULL;
+        merges = 0;
+
+        while ( p != NULL )
+        {
+            merges++;
+            q = p;
+            for ( p_size = 0; p_size < width && q != NULL; p_size++ )
+                q = q->next;
+            q_size = width;
+
+            while ( p_size > 0 || ( q_size > 0 && q != NULL ) )
+            {
+                if ( p_size == 0 || ( q_size > 0 && q != NULL &&
+                        q->key < p->key ) )
+                {
+                    next = q;
+                    q = q->next;
+                    q_size--;
+                }
+                else
+                {
+                    next = p;
+                    p = p->next;
+                    p_size--;
+                }
+
+                if ( tail == NULL )
+                    head = next;
+                else
+                    tail->next = next;
+                next->prev = tail;
+                tail = next;
+            }
+            p = q;
+        }
+        tail->next = NULL;
+
+        if ( merges <= 1 )
+            break;
+    }
+
+    head->prev = tail;
+    tail->next = head;
+    *list = head;
+}
@@ -0,0 +1,201 @@
+#ifndef MULTILEVEL_BUCKET_QUEUE
+#define MULTILEVEL_BUCKET_QUEUE
+
+//==============================================================================
+// DEFINES, INCLUDES, and STRUCTS
+//==============================================================================
+
+#include "queue_common.h"
+
+// keys are bucketed by their high bits; the low bits only break ties
+#ifndef MULTILEVEL_KEY_SHIFT
+    #define MULTILEVEL_KEY_SHIFT    32
+#endif
+// log2 of the number of buckets per level, i.e. of the digit base
+#ifndef MULTILEVEL_BITS
+    #define MULTILEVEL_BITS         8
+#endif
+#define MULTILEVEL_BUCKETS          ( 1 << MULTILEVEL_BITS )
+#define MULTILEVEL_MASK             ( MULTILEVEL_BUCKETS - 1 )
+#define MULTILEVEL_WORDS            ( MULTILEVEL_BUCKETS >> 6 )
+#define MULTILEVEL_LEVELS           ( ( 64 - MULTILEVEL_KEY_SHIFT + \
+    MULTILEVEL_BITS - 1 ) / MULTILEVEL_BITS )
+
+/**
+ * Holds an inserted element, as well as pointers to maintain its place in a
+ * bucket.  Acts as a handle to clients for the purpose of mutability.  Each
+ * bucket is a circular doubly linked list, so the prev pointer of the first
+ * node in a bucket points to the last.
+ */
+struct multilevel_node_t
+{
+    //! Next node in this node's bucket
+    struct multilevel_node_t *next;
+    //! Previous node in this node's bucket
+    struct multilevel_node_t *prev;
+
+    //! Pointer to a piece of client data
+    item_type item;
+    //! Key for the item
+    key_type key;
+} __attribute__ ((aligned(4)));
+
+typedef struct multilevel_node_t multilevel_node;
+typedef multilevel_node pq_node_type;
+
+/**
+ * A mutable multi-level bucket queue in the style of Cherkassky, Goldberg and
+ * Silverstein.  Priorities, the key bits above MULTILEVEL_KEY_SHIFT, are read
+ * as digits in base MULTILEVEL_BUCKETS.  A node lives on the level of the
+ * highest digit in which its priority differs from the base, in the bucket
+ * given by that digit, so the lowest level holds exact priorities and higher
+ * levels hold progressively wider ranges.  Extracting from a higher level
+ * rebases on the smallest priority in the first occupied bucket and pushes
+ * that bucket down, so each node moves at most once per level.  Occupancy
+ * bitmaps per level let scans skip empty buckets a word at a time.  Ties on
+ * priority are broken by sorting the minimum bucket by full key when it is
+ * first reached and keeping it sorted while it remains the minimum, so keys
+ * come out in exact order.
+ *
+ * Inserting a priority below the base is supported by splicing every level
+ * below the highest differing digit into a single bucket on that level.
+ */
+struct multilevel_bucket_queue_t
+{
+    //! Memory map to use for node allocation
+    mem_map *map;
+    //! The number of items held in the queue
+    uint32_t size;
+    //! Priority against which node digits are compared
+    uint64_t base;
+    //! One bit per level, set if the level is non-empty
+    uint64_t levels;
+    //! Cached minimum node, or NULL if it must be recomputed
+    multilevel_node *minimum;
+    //! Head pointer of the bucket kept sorted by key, or NULL if none is
+    multilevel_node **sorted;
+    //! One bit per bucket, set if the bucket is non-empty
+    uint64_t occupied[MULTILEVEL_LEVELS][MULTILEVEL_WORDS];
+    //! Heads of the bucket lists
+    multilevel_node *buckets[MULTILEVEL_LEVELS][MULTILEVEL_BUCKETS];
+} __attribute__ ((aligned(4)));
+
+typedef struct multilevel_bucket_queue_t multilevel_bucket_queue;
+typedef multilevel_bucket_queue pq_type;
+
+//==============================================================================
+// PUBLIC DECLARATIONS
+//==============================================================================
+
+/**
+ * Creates a new, empty queue, with its own arena carved from the given map.
+ *
+ * @param map   Memory map from which to carve the arena for its nodes
+ * @return      Pointer to the new queue
+ */
+multilevel_bucket_queue* pq_create( mem_map *map );
+
+/**
+ * Frees all the memory used by the queue.
+ *
+ * @param queue Queue to destroy
+ */
+void pq_destroy( multilevel_bucket_queue *queue );
+
+/**
+ * Deletes all nodes, leaving the queue empty.
+ *
+ * @param queue Queue to clear
+ */
+void pq_clear( multilevel_bucket_queue *queue );
+
+/**
+ * Returns the key associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's key
+ */
+key_type pq_get_key( multilevel_bucket_queue *queue, multilevel_node *node );
+
+/**
+ * Returns the item associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's item
+ */
+item_type* pq_get_item( multilevel_bucket_queue *queue, multilevel_node *node );
+
+/**
+ * Returns the current size of the queue.
+ *
+ * @param queue Queue to query
+ * @return      Size of queue
+ */
+uint32_t pq_get_size( multilevel_bucket_queue *queue );
+
+/**
+ * Takes an item-key pair to insert it into the queue and creates a new
+ * corresponding node.  Links the node into the bucket given by the highest
+ * digit in which its priority differs from the base.
+ *
+ * @param queue Queue to insert into
+ * @param item  Item to insert
+ * @param key   Key to use for node priority
+ * @return      Pointer to corresponding node
+ */
+multilevel_node* pq_insert( multilevel_bucket_queue *queue, item_type item, key_type key );
+
+/**
+ * Returns the minimum item from the queue.  If the lowest level is empty,
+ * takes the first occupied bucket of the lowest non-empty level, rebases on
+ * its smallest priority, and pushes its nodes down to lower levels.  Caches
+ * the result.
+ *
+ * @param queue Queue to query
+ * @return      Node with minimum key
+ */
+multilevel_node* pq_find_min( multilevel_bucket_queue *queue );
+
+/**
+ * Deletes the minimum item from the queue and returns it.  Relies on
+ * @ref <pq_find_min> to locate it and @ref <pq_delete> to unlink it.
+ *
+ * @param queue Queue to query
+ * @return      Minimum key, corresponding to item deleted
+ */
+key_type pq_delete_min( multilevel_bucket_queue *queue );
+
+/**
+ * Deletes an arbitrary item from the queue.  Requires that the location of
+ * the item's corresponding node is known.  Unlinks the node from its bucket.
+ *
+ * @param queue Queue in which the node resides
+ * @param node  Pointer to node corresponding to the item to delete
+ * @return      Key of item deleted
+ */
+key_type pq_delete( multilevel_bucket_queue *queue, multilevel_node *node );
+
+/**
+ * If the item in the queue is modified in such a way to decrease the
+ * key, then this function will update the queue to preserve queue
+ * properties given a pointer to the corresponding node.  Moves the node to
+ * the bucket for its new priority if that differs from the old one.
+ *
+ * @param queue     Queue in which the node resides
+ * @param node      Node to change
+ * @param new_key   New key to use for the given node
+ */
+void pq_decrease_key( multilevel_bucket_queue *queue, multilevel_node *node,
+    key_type new_key );
+
+/**
+ * Determines whether the queue is empty, or if it holds some items.
+ *
+ * @param queue Queue to query
+ * @return      True if queue holds nothing, false otherwise
+ */
+bool pq_empty( multilevel_bucket_queue *queue );
+
+#endif
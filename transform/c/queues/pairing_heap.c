@@ -7,6 +7,9 @@
 static pairing_node* merge( pairing_heap *queue, pairing_node *a,
     pairing_node *b );
 static pairing_node* collapse( pairing_heap *queue, pairing_node *node );
+static void unlink_node( pairing_heap *queue, pairing_node *node );
+static pairing_node* copy_node( pairing_heap *queue, pairing_node *node,
+    pq_relocate_fn relocate, void *context );
 
 //==============================================================================
 // PUBLIC METHODS
@@ -15,7 +18,10 @@ static pairing_node* collapse( pairing_heap *queue, pairing_node *node );
 pairing_heap* pq_create( mem_map *map )
 {
     pairing_heap *queue = calloc( 1, sizeof( pairing_heap ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
+#ifdef USE_COMPACT_REFS
+    queue->base = (pairing_node*) queue->map->data[0];
+#endif
 
     return queue;
 }
@@ -23,6 +29,7 @@ pairing_heap* pq_create( mem_map *map )
 void pq_destroy( pairing_heap *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -50,9 +57,12 @@ uint32_t pq_get_size( pairing_heap *queue )
 
 pairing_node* pq_insert( pairing_heap *queue, item_type item, key_type key )
 {
-    pairing_node *wrapper = pq_alloc_node( queue->map, 0 );
+    pairing_node *wrapper = pq_alloc_node_uninit( queue->map, 0 );
     ITEM_ASSIGN( wrapper->item, item );
     wrapper->key = key;
+    wrapper->child = PQ_NULL_LINK;
+    wrapper->next = PQ_NULL_LINK;
+    wrapper->prev = PQ_NULL_LINK;
     queue->size++;
 
     queue->root = merge( queue, queue->root, wrapper );
@@ -72,23 +82,36 @@ key_type pq_delete_min( pairing_heap *queue )
     return pq_delete( queue, queue->root );
 }
 
+pairing_node* pq_replace_min( pairing_heap *queue, item_type item,
+    key_type key )
+{
+    pairing_node *node = queue->root;
+    key_type old_key = node->key;
+    ITEM_ASSIGN( node->item, item );
+    node->key = key;
+
+    // the children all come no earlier than the old minimum
+    if ( PQ_KEY_BEFORE( old_key, key ) && node->child != PQ_NULL_LINK )
+    {
+        queue->root = collapse( queue, PQ_NODE( queue, node->child ) );
+        node->child = PQ_NULL_LINK;
+        queue->root = merge( queue, queue->root, node );
+    }
+
+    return node;
+}
+
 key_type pq_delete( pairing_heap *queue, pairing_node *node )
 {
     key_type key = node->key;
 
     if ( node == queue->root )
-        queue->root = collapse( queue, node->child );
+        queue->root = collapse( queue, PQ_NODE( queue, node->child ) );
     else
     {
-        if ( node->prev->child == node )
-            node->prev->child = node->next;
-        else
-            node->prev->next = node->next;
-
-        if ( node->next != NULL )
-            node->next->prev = node->prev;
-
-        queue->root = merge( queue, queue->root, collapse( queue, node->child ) );
+        unlink_node( queue, node );
+        queue->root = merge( queue, queue->root,
+            collapse( queue, PQ_NODE( queue, node->child ) ) );
     }
 
     pq_free_node( queue->map, 0, node );
@@ -103,15 +126,61 @@ void pq_decrease_key( pairing_heap *queue, pairing_node *node, key_type new_key
     if ( node == queue->root )
         return;
 
-    if ( node->prev->child == node )
-        node->prev->child = node->next;
-    else
-        node->prev->next = node->next;
+    unlink_node( queue, node );
+    queue->root = merge( queue, queue->root, node );
+}
 
-    if ( node->next != NULL )
-        node->next->prev = node->prev;
+void pq_compact( pairing_heap *queue, pq_relocate_fn relocate,
+    void *context )
+{
+    // the old links still resolve against the old slab
+    pairing_heap old = *queue;
+    pairing_node **pending;
+    pairing_node *from, *to, *child, *copy, *last;
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    queue->map = mm_create_arena( old.map->parent );
+#ifdef USE_COMPACT_REFS
+    queue->base = (pairing_node*) queue->map->data[0];
+#endif
+
+    if ( old.root != NULL )
+    {
+        // pairs of old and new nodes whose children are yet to be copied
+        pending = malloc( 2 * old.size * sizeof( pairing_node* ) );
+        queue->root = copy_node( queue, old.root, relocate, context );
+        pending[tail++] = old.root;
+        pending[tail++] = queue->root;
 
-    queue->root = merge( queue, queue->root, node );
+        while ( head < tail )
+        {
+            from = pending[head++];
+            to = pending[head++];
+            last = NULL;
+            for ( child = PQ_NODE( &old, from->child ); child != NULL;
+                    child = PQ_NODE( &old, child->next ) )
+            {
+                copy = copy_node( queue, child, relocate, context );
+                if ( last == NULL )
+                {
+                    to->child = PQ_REF( queue, copy );
+                    copy->prev = PQ_REF( queue, to );
+                }
+                else
+                {
+                    last->next = PQ_REF( queue, copy );
+                    copy->prev = PQ_REF( queue, last );
+                }
+                pending[tail++] = child;
+                pending[tail++] = copy;
+                last = copy;
+            }
+        }
+        free( pending );
+    }
+
+    mm_destroy( old.map );
 }
 
 bool pq_empty( pairing_heap *queue )
@@ -144,7 +213,7 @@ static pairing_node* merge( pairing_heap *queue, pairing_node *a,
     else if ( a == b )
         return a;
 
-    if ( b->key < a->key )
+    if ( PQ_KEY_BEFORE( b->key, a->key ) )
     {
         parent = b;
         child = a;
@@ -156,13 +225,13 @@ static pairing_node* merge( pairing_heap *queue, pairing_node *a,
     }
 
     child->next = parent->child;
-    if ( parent->child != NULL )
-        parent->child->prev = child;
-    child->prev = parent;
-    parent->child = child;
+    if ( parent->child != PQ_NULL_LINK )
+        PQ_NODE( queue, parent->child )->prev = PQ_REF( queue, child );
+    child->prev = PQ_REF( queue, parent );
+    parent->child = PQ_REF( queue, child );
 
-    parent->next = NULL;
-    parent->prev = NULL;
+    parent->next = PQ_NULL_LINK;
+    parent->prev = PQ_NULL_LINK;
 
     return parent;
 }
@@ -190,18 +259,18 @@ static pairing_node* collapse( pairing_heap *queue, pairing_node *node )
     while ( next != NULL )
     {
         a = next;
-        b = a->next;
+        b = PQ_NODE( queue, a->next );
         if ( b != NULL )
         {
-            next = b->next;
+            next = PQ_NODE( queue, b->next );
             result = merge( queue, a, b );
             // tack the result onto the end of the temporary list
-            result->prev = tail;
+            result->prev = PQ_REF( queue, tail );
             tail = result;
         }
         else
         {
-            a->prev = tail;
+            a->prev = PQ_REF( queue, tail );
             tail = a;
             break;
         }
@@ -211,10 +280,54 @@ static pairing_node* collapse( pairing_heap *queue, pairing_node *node )
     while ( tail != NULL )
     {
         // trace back through to merge the list
-        next = tail->prev;
+        next = PQ_NODE( queue, tail->prev );
         result = merge( queue, result, tail );
         tail = next;
     }
 
     return result;
 }
+
+/**
+ * Cuts a non-root node, along with its subtree, out of the list of its
+ * siblings.
+ *
+ * @param queue Queue in which to operate
+ * @param node  Node to cut
+ */
+static void unlink_node( pairing_heap *queue, pairing_node *node )
+{
+    pairing_node *prev = PQ_NODE( queue, node->prev );
+
+    if ( prev->child == PQ_REF( queue, node ) )
+        prev->child = node->next;
+    else
+        prev->next = node->next;
+
+    if ( node->next != PQ_NULL_LINK )
+        PQ_NODE( queue, node->next )->prev = node->prev;
+}
+
+/**
+ * Copies a node's item and key into a new node of the queue's arena, with no
+ * links yet, and reports the move.
+ *
+ * @param queue     Queue to allocate from
+ * @param node      Node to copy
+ * @param relocate  Called with the old and new node
+ * @param context   Passed through to relocate
+ * @return          The new node
+ */
+static pairing_node* copy_node( pairing_heap *queue, pairing_node *node,
+    pq_relocate_fn relocate, void *context )
+{
+    pairing_node *copy = pq_alloc_node_uninit( queue->map, 0 );
+    ITEM_ASSIGN( copy->item, node->item );
+    copy->key = node->key;
+    copy->child = PQ_NULL_LINK;
+    copy->next = PQ_NULL_LINK;
+    copy->prev = PQ_NULL_LINK;
+    relocate( context, node, copy );
+
+    return copy;
+}
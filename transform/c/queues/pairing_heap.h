@@ -7,6 +7,10 @@
 
 #include "queue_common.h"
 
+#define PQ_HAS_REPLACE_MIN
+#define PQ_HAS_COMPACT_REFS
+#define PQ_HAS_COMPACT
+
 /**
  * Holds an inserted element, as well as pointers to maintain tree
  * structure.  Acts as a handle to clients for the purpose of
@@ -18,11 +22,11 @@
 struct pairing_node_t
 {
     //! First child of this node
-    struct pairing_node_t *child;
+    PQ_LINK( struct pairing_node_t ) child;
     //! Next node in the list of this node's siblings
-    struct pairing_node_t *next;
+    PQ_LINK( struct pairing_node_t ) next;
     //! Previous node in the list of this node's siblings
-    struct pairing_node_t *prev;
+    PQ_LINK( struct pairing_node_t ) prev;
 
     //! Pointer to a piece of client data
     item_type item;
@@ -48,6 +52,10 @@ struct pairing_heap_t
     uint32_t size;
     //! Pointer to the minimum node in the queue
     pairing_node *root;
+#ifdef USE_COMPACT_REFS
+    //! Start of the arena's node slab, against which links are resolved
+    pairing_node *base;
+#endif
 } __attribute__ ((aligned(4)));
 
 typedef struct pairing_heap_t pairing_heap;
@@ -58,9 +66,9 @@ typedef pairing_heap pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty queue.
+ * Creates a new, empty queue, with its own arena carved from the given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 pairing_heap* pq_create( mem_map *map );
@@ -134,6 +142,22 @@ pairing_node* pq_find_min( pairing_heap *queue );
  */
 key_type pq_delete_min( pairing_heap *queue );
 
+/**
+ * Replaces the minimum item of the queue with a new item-key pair.  Has the
+ * same effect as @ref <pq_delete_min> followed by @ref <pq_insert>, but needs
+ * no pairing pass at all when the new key does not come after the old minimum,
+ * which then stays the root.  Otherwise the root's children are collapsed and
+ * the root merged back in as a single node.  The minimum's node is reused for
+ * the new item, so clients must read the old minimum before the call.
+ *
+ * @param queue Queue to modify, which must not be empty
+ * @param item  Item to insert
+ * @param key   Key to use for node priority
+ * @return      Pointer to the node now holding the new item
+ */
+pairing_node* pq_replace_min( pairing_heap *queue, item_type item,
+    key_type key );
+
 /**
  * Deletes an arbitrary item from the queue and modifies queue structure
  * to preserve the heap invariant.  Requires that the location of the
@@ -160,6 +184,22 @@ key_type pq_delete( pairing_heap *queue, pairing_node *node );
 void pq_decrease_key( pairing_heap *queue, pairing_node *node,
     key_type new_key );
 
+/**
+ * Moves every node of the queue into a fresh arena carved from the same
+ * parent map, root first and then each node's children together in sibling
+ * order, and gives the old arena back.  The nodes of a subtree end up close
+ * to one another, as they seldom are after many deletions.  Handles to the
+ * queue's nodes are invalidated; relocate is called once for each node with
+ * its old and new address, so that the client can update its own.  Briefly
+ * needs room for two copies of the nodes.
+ *
+ * @param queue     Queue to compact
+ * @param relocate  Called for each node moved
+ * @param context   Passed through to relocate
+ */
+void pq_compact( pairing_heap *queue, pq_relocate_fn relocate,
+    void *context );
+
 /**
  * Determines whether the queue is empty, or if it holds some items.
  *
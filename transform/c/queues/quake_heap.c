@@ -6,16 +6,15 @@
 
 static void make_root( quake_heap *queue, quake_node *node );
 static void remove_from_roots( quake_heap *queue, quake_node *node );
+static void detach( quake_heap *queue, quake_node *node );
 static void cut( quake_heap *queue, quake_node *node );
 static quake_node* join( quake_heap *queue, quake_node *a, quake_node *b );
 static void fix_roots( quake_heap *queue );
 static bool attempt_insert( quake_heap *queue, quake_node *node );
-static void fix_min( quake_heap *queue );
 static void fix_decay( quake_heap *queue );
 static void check_decay( quake_heap *queue );
 static bool violation_exists( quake_heap *queue );
 static void prune( quake_heap *queue, quake_node *node );
-static quake_node* clone_node( quake_heap *queue, quake_node *original );
 static bool is_root( quake_heap *queue, quake_node *node );
 
 //==============================================================================
@@ -25,7 +24,7 @@ static bool is_root( quake_heap *queue, quake_node *node );
 quake_heap* pq_create( mem_map *map )
 {
     quake_heap *queue = calloc( 1, sizeof( quake_heap ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
     
     return queue;
 }
@@ -33,6 +32,7 @@ quake_heap* pq_create( mem_map *map )
 void pq_destroy( quake_heap *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -40,7 +40,7 @@ void pq_clear( quake_heap *queue )
 {
     mm_clear( queue->map );
     queue->minimum = NULL;
-    memset( queue->roots, 0, MAXRANK * sizeof( quake_node* ) );
+    queue->registry = 0;
     memset( queue->nodes, 0, MAXRANK * sizeof( uint32_t ) );
     queue->highest_node = 0;
     queue->violation = 0;
@@ -67,8 +67,7 @@ quake_node* pq_insert( quake_heap *queue, item_type item, key_type key )
     quake_node *wrapper = pq_alloc_node( queue->map, 0 );
     ITEM_ASSIGN( wrapper->item, item );
     wrapper->key = key;
-    wrapper->parent = wrapper;
-    
+
     make_root( queue, wrapper );
     queue->size++;
     (queue->nodes[0])++;
@@ -106,16 +105,12 @@ void pq_decrease_key( quake_heap *queue, quake_node *node, key_type new_key )
     node->key = new_key;
     if ( is_root( queue, node ) )
     {
-        if ( node->key < queue->minimum->key )
+        if ( PQ_KEY_BEFORE( node->key, queue->minimum->key ) )
             queue->minimum = node;
     }
     else
     {
-        if ( node->parent->left == node )
-            node->parent->left = NULL;
-        else
-            node->parent->right = NULL;
-
+        detach( queue, node );
         make_root( queue, node );
     }
 }
@@ -138,13 +133,21 @@ quake_heap* pq_meld( quake_heap *a, quake_heap *b )
         
     if( trash->minimum == NULL )
         return result;
-    temp = result->minimum->parent;
-    result->minimum->parent = trash->minimum->parent;
-    trash->minimum->parent = temp;
-    
+    temp = result->minimum->next;
+    result->minimum->next = trash->minimum->next;
+    result->minimum->next->prev = result->minimum;
+    trash->minimum->next = temp;
+    temp->prev = trash->minimum;
+    if( PQ_KEY_BEFORE( trash->minimum->key, result->minimum->key ) )
+        result->minimum = trash->minimum;
+
     int k;
-    for( k = 0; k < result->highest_node; k++ )
+    for( k = 0; k < MAXRANK; k++ )
         result->nodes[k] += trash->nodes[k];
+    if( trash->highest_node > result->highest_node )
+        result->highest_node = trash->highest_node;
+    result->size += trash->size;
+    mm_meld( result->map, trash->map );
 
     return result;
 }
@@ -169,16 +172,20 @@ static void make_root( quake_heap *queue, quake_node* node )
     if ( node == NULL )
         return;
 
+    node->root = TRUE;
     if ( queue->minimum == NULL )
     {
          queue->minimum = node;
-         node->parent = node;
+         node->next = node;
+         node->prev = node;
     }
     else
     {
-        node->parent = queue->minimum->parent;
-        queue->minimum->parent = node;
-        if ( node->key < queue->minimum->key )
+        node->next = queue->minimum->next;
+        node->prev = queue->minimum;
+        queue->minimum->next->prev = node;
+        queue->minimum->next = node;
+        if ( PQ_KEY_BEFORE( node->key, queue->minimum->key ) )
             queue->minimum = node;
     }
 }
@@ -191,53 +198,66 @@ static void make_root( quake_heap *queue, quake_node* node )
  */
 static void remove_from_roots( quake_heap *queue, quake_node *node )
 {
-    quake_node *current = node->parent;
-    while ( current->parent != node )
-        current = current->parent;
-    if ( current == node )
+    if ( node->next == node )
         queue->minimum = NULL;
     else
     {
-        current->parent = node->parent;
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
         if ( queue->minimum == node )
-            queue->minimum = current;
+            queue->minimum = node->prev;
     }
 }
 
 /**
- * Removes the node from the structure.  Recurses down through the left
- * child, which contains the same item, separating the right subtrees, making
- * the right child a new root.
+ * Removes a node from the list of children of the node that beat it.  The
+ * tournament node it lost at stays on the parent's path.
+ *
+ * @param queue Queue the node belongs to
+ * @param node  Non-root node to remove
+ */
+static void detach( quake_heap *queue, quake_node *node )
+{
+    if ( node->prev->child == node )
+        node->prev->child = node->next;
+    else
+        node->prev->next = node->next;
+    if ( node->next != NULL )
+        node->next->prev = node->prev;
+}
+
+/**
+ * Removes the node from the structure, along with every tournament node on
+ * its path, making each tree it beat a new root.
  *
  * @param queue Queue the node belongs to
  * @param node  Node to remove
  */
 static void cut( quake_heap *queue, quake_node *node )
 {
-    if ( node == NULL )
-        return;
+    quake_node *child, *next;
+    uint32_t height;
 
     if ( is_root( queue, node ) )
         remove_from_roots( queue, node );
     else
+        detach( queue, node );
+
+    for ( child = node->child; child != NULL; child = next )
     {
-        if ( node->parent->left == node )
-            node->parent->left = NULL;
-        else if ( node->parent->right == node )
-            node->parent->right = NULL;
+        next = child->next;
+        make_root( queue, child );
     }
-        
-    cut( queue, node->left );
-    make_root( queue, node->right );
 
-    (queue->nodes[node->height])--;
+    for ( height = 0; height <= node->height; height++ )
+        (queue->nodes[height])--;
     pq_free_node( queue->map, 0, node );
 }
 
 /**
  * Links two trees, making the larger-key tree the child of the lesser.
- * Creates a duplicate node to take the larger-key root's place.
- * Promotes the larger-key root as the new root of the joined tree.
+ * The lesser-key root goes up a height, and the other becomes its highest
+ * child.
  *
  * @param queue Queue in which to operate
  * @param a     First node
@@ -246,9 +266,9 @@ static void cut( quake_heap *queue, quake_node *node )
  */
 static quake_node* join( quake_heap *queue, quake_node *a, quake_node *b )
 {
-    quake_node *parent, *child, *duplicate;
+    quake_node *parent, *child;
 
-    if ( b->key < a->key )
+    if ( PQ_KEY_BEFORE( b->key, a->key ) )
     {
         parent = b;
         child = a;
@@ -259,18 +279,12 @@ static quake_node* join( quake_heap *queue, quake_node *a, quake_node *b )
         child = b;
     }
 
-    duplicate = clone_node( queue, parent );
-    if ( duplicate->left != NULL )
-        duplicate->left->parent = duplicate;
-    if ( duplicate->right != NULL )
-        duplicate->right->parent = duplicate;
-
-    duplicate->parent = parent;
-    child->parent = parent;
-
-    parent->parent = NULL;
-    parent->left = duplicate;
-    parent->right = child;
+    child->root = FALSE;
+    child->next = parent->child;
+    if ( child->next != NULL )
+        child->next->prev = child;
+    child->prev = parent;
+    parent->child = child;
 
     parent->height++;
     (queue->nodes[parent->height])++;
@@ -280,76 +294,64 @@ static quake_node* join( quake_heap *queue, quake_node *a, quake_node *b )
 
 /**
  * Performs an iterative linking on the list of roots until no two trees
- * of the same height remain.
+ * of the same height remain.  Finds the new minimum while rebuilding the
+ * list, visiting only the occupied heights of the registry, and leaves the
+ * registry describing the new roots.
  *
  * @param queue Queue whose roots to fix
  */
 static void fix_roots( quake_heap *queue )
 {
-    quake_node *current, *next, *tail, *head, *joined;
-    uint32_t i, height;
+    quake_node *current, *next, *tail, *head;
+    uint64_t occupied;
+    uint32_t height;
 
+    queue->registry = 0;
     if ( queue->minimum == NULL )
         return;
 
-    for ( i = 0; i <= queue->highest_node; i++ )
-        queue->roots[i] = NULL;
     queue->highest_node = 0;
 
-    current = queue->minimum->parent;
-    tail = queue->minimum;
-    queue->minimum->parent = NULL;
+    // break the circular list
+    current = queue->minimum->next;
+    queue->minimum->next = NULL;
 
     while ( current != NULL )
     {
-        next = current->parent;
-        current->parent = NULL;
-        if ( !attempt_insert( queue, current ) )
+        next = current->next;
+        while ( !attempt_insert( queue, current ) )
         {
             height = current->height;
-            joined = join( queue, current, queue->roots[height] );
-            if ( current == tail )
-            {
-                tail = joined; 
-                next = tail;
-            }
-            else
-            {
-                tail->parent = joined;
-                tail = tail->parent;
-            }
-            queue->roots[height] = NULL;
+            current = join( queue, current, queue->roots[height] );
+            REGISTRY_UNSET( queue->registry, height );
         }
         current = next;
     }
 
-    head = NULL;
-    tail = NULL;
-    for ( i = 0; i <= queue->highest_node; i++ )
+    occupied = queue->registry;
+    height = REGISTRY_LEADER( occupied );
+    REGISTRY_UNSET( occupied, height );
+    head = queue->roots[height];
+    tail = head;
+    queue->minimum = head;
+    while ( occupied )
     {
-        if ( queue->roots[i] != NULL )
-        {
-            if ( head == NULL )
-            {
-                head = queue->roots[i];
-                tail = queue->roots[i];
-            }
-            else
-            {
-                tail->parent = queue->roots[i];
-                tail = tail->parent;
-            }
-        }
+        height = REGISTRY_LEADER( occupied );
+        REGISTRY_UNSET( occupied, height );
+        current = queue->roots[height];
+        tail->next = current;
+        current->prev = tail;
+        tail = current;
+        if ( PQ_KEY_BEFORE( tail->key, queue->minimum->key ) )
+            queue->minimum = tail;
     }
-    tail->parent = head;
-
-    queue->minimum = head;
-    fix_min( queue );
+    tail->next = head;
+    head->prev = tail;
 }
 
 /**
  * Attempt to insert a tree in the height-indexed array.  Inserts if the
- * correct spot is empty or already contains the current node, reports
+ * correct spot is unoccupied or already contains the current node, reports
  * failure if it is occupied.
  *
  * @param queue Queue to insert into
@@ -359,35 +361,18 @@ static void fix_roots( quake_heap *queue )
 static bool attempt_insert( quake_heap *queue, quake_node *node )
 {
     uint32_t height = node->height;
-    if ( ( queue->roots[height] != NULL ) && ( queue->roots[height] != node ) )
+    if ( OCCUPIED( queue->registry, height ) &&
+            ( queue->roots[height] != node ) )
         return FALSE;
 
     if ( height > queue->highest_node )
         queue->highest_node = height;
     queue->roots[height] = node;
+    REGISTRY_SET( queue->registry, height );
 
     return TRUE;
 }
 
-/**
- * Scans through the roots list starting from the current, potentially
- * inaccurate, minimum to find the tree with the minimum-value
- * root.
- * 
- * @param queue Queue to fix
- */
-static void fix_min( quake_heap *queue )
-{
-    quake_node *start = queue->minimum;
-    quake_node *current = queue->minimum->parent;
-    while ( current != start )
-    {
-        if ( current->key < queue->minimum->key )
-            queue->minimum = current;
-        current = current->parent;
-    }
-}
-
 /**
  * If a decay violation exists, this will remove all nodes of height
  * greater than or equal to the first violation.
@@ -396,14 +381,19 @@ static void fix_min( quake_heap *queue )
  */
 static void fix_decay( quake_heap *queue )
 {
-    uint32_t i;
+    uint64_t occupied;
+    uint32_t height;
     check_decay( queue );
     if ( violation_exists( queue ) )
     {
-        for ( i = queue->violation; i < MAXRANK; i++ )
+        // roots at or above the violation
+        occupied = queue->registry &
+            ~( ( ( (uint64_t) 1 ) << queue->violation ) - 1 );
+        while ( occupied )
         {
-            if ( queue->roots[i] != NULL )
-                prune( queue, queue->roots[i] );
+            height = REGISTRY_LEADER( occupied );
+            REGISTRY_UNSET( occupied, height );
+            prune( queue, queue->roots[height] );
         }
     }
 }
@@ -438,64 +428,35 @@ static bool violation_exists( quake_heap *queue )
 
 /**
  * If the current node is higher than the violation, this function
- * rotates the current node down into the place of it's duplicate, and
- * deletes the duplicate.  Then it recurses on itself and its old
- * non-duplicate child.
+ * removes the node's tournament nodes down to the violation, making each
+ * tree it beat there a root once it has been pruned in turn.  The node
+ * itself becomes a root if it was not one already.
  *
  * @param queue Queue to fix
  * @param node  Node to check and prune
  */
 static void prune( quake_heap *queue, quake_node *node )
 {
-    quake_node *duplicate, *child;
+    quake_node *child;
 
-    if ( node == NULL )
-        return;
-
-    if ( node->height < queue->violation )
+    while ( node->height >= queue->violation )
     {
-        if ( !is_root( queue, node ) )
-            make_root( queue, node );
-            
-        return;
-    }
-
-    duplicate = node->left;
-    child = node->right;
-
-    prune( queue, child );        
-
-    node->left = duplicate->left;
-    if ( node->left != NULL )
-        node->left->parent = node;
-    node->right = duplicate->right;
-    if ( node->right != NULL )
-        node->right->parent = node;
-    (queue->nodes[node->height])--;
-    node->height--;
-    pq_free_node( queue->map, 0, duplicate );
-
-    prune( queue, node );
-}
+        // the tree beaten at the top of the path, unless it has been cut
+        child = node->child;
+        if ( ( child != NULL ) && ( child->height + 1 == node->height ) )
+        {
+            node->child = child->next;
+            if ( child->next != NULL )
+                child->next->prev = node;
+            prune( queue, child );
+        }
 
-/**
- * Copies internal data of another node for purposes of tournament resolution.
- *
- * @param queue     Queue to which node belongs
- * @param original  Node to copy data from
- * @return          Copy of the new node
- */
-static quake_node* clone_node( quake_heap *queue, quake_node *original )
-{
-    quake_node *clone = pq_alloc_node( queue->map, 0 );
-        
-    ITEM_ASSIGN( clone->item, original->item );
-    clone->key = original->key;
-    clone->height = original->height;
-    clone->left = original->left;
-    clone->right = original->right;
+        (queue->nodes[node->height])--;
+        node->height--;
+    }
 
-    return clone;
+    if ( !is_root( queue, node ) )
+        make_root( queue, node );
 }
 
 /**
@@ -507,6 +468,5 @@ static quake_node* clone_node( quake_heap *queue, quake_node *original )
  */
 static bool is_root( quake_heap *queue, quake_node *node )
 {
-    return ( ( node->parent->left != node ) &&
-        ( node->parent->right != node ) );
+    return node->root;
 }
@@ -10,20 +10,27 @@
 /**
  * Holds an inserted element, as well as pointers to maintain tree
  * structure.  Acts as a handle to clients for the purpose of
- * mutability.  Keeps track of the height of the node as well as pointer
- * to the node's parent, left child (duplicate), and right child.
+ * mutability.  A single node stands for every tournament node on the
+ * element's path, from its leaf up to its height, so elements never
+ * take more than one node.  The trees it beat on the way up hang from it
+ * as a list of children, highest first.  Each lost one level above its
+ * own height, which is all the path needs to record of it.
  */
 struct quake_node_t
 {
-    //! Parent node
-    struct quake_node_t *parent;
-    //! Left child
-    struct quake_node_t *left;
-    //! Right child, or next root if this node is a root
-    struct quake_node_t *right;
+    //! Child that lost highest on this node's path
+    struct quake_node_t *child;
+    //! Next lower child of the same parent, or next root if this node is a
+    //! root
+    struct quake_node_t *next;
+    //! Next higher child, the parent if this is the first child, or previous
+    //! root if this node is a root
+    struct quake_node_t *prev;
 
     //! The height of this node
     uint8_t height;
+    //! Whether this node is a root
+    uint8_t root;
 
     //! Pointer to a piece of client data
     item_type item;
@@ -49,8 +56,11 @@ struct quake_heap_t
     quake_node *minimum;
     //! An array of roots of the queue, indexed by height
     quake_node *roots[MAXRANK];
-    //! An array of counters corresponding to the number of nodes at height
-    //! equal to the index
+    //! Heights occupied in the roots array
+    uint64_t registry;
+    //! An array of counters corresponding to the number of tournament nodes
+    //! at height equal to the index, each element standing for one at every
+    //! height up to its own
     uint32_t nodes[MAXRANK];
     //! Current height of highest node in queue
     uint32_t highest_node;
@@ -66,9 +76,9 @@ typedef quake_heap pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty queue.
+ * Creates a new, empty queue, with its own arena carved from the given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 quake_heap* pq_create( mem_map *map );
@@ -168,9 +178,9 @@ key_type pq_delete( quake_heap *queue, quake_node *node );
 void pq_decrease_key( quake_heap *queue, quake_node *node, key_type new_key );
 
 /**
- * Combines two different item-disjoint queues which share a memory map.
- * Merges node lists and adds the rank lists.  Returns a pointer to the
- * resulting queue.
+ * Combines two different item-disjoint queues created from the same memory
+ * map, the result taking over the node storage of both.  Merges node lists
+ * and adds the rank lists.  Returns a pointer to the resulting queue.
  *
  * @param a First queue
  * @param b Second queue
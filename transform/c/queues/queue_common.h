@@ -39,6 +39,65 @@ typedef uint32_t bool;
 
 #define MAX_KEY 0xFFFFFFFFFFFFFFFF
 
+/**
+ * Key ordering.  Queues are min-queues by default; built with USE_MAX_ORDER
+ * they are max-queues, so pq_find_min and pq_delete_min return the largest
+ * key and pq_decrease_key moves a node towards the front by increasing its
+ * key.  Comparison-based queues compare keys only through PQ_KEY_BEFORE,
+ * and queues that index by key value store PQ_KEY_ORDER( key ), which maps
+ * keys to and from an order in which the front is smallest.  PQ_KEY_FRONT
+ * comes before every other key.
+ */
+#ifdef USE_MAX_ORDER
+    #define PQ_KEY_BEFORE(a,b)  ( (a) > (b) )
+    #define PQ_KEY_ORDER(a)     ( ~(a) )
+    #define PQ_KEY_FRONT        MAX_KEY
+#else
+    #define PQ_KEY_BEFORE(a,b)  ( (a) < (b) )
+    #define PQ_KEY_ORDER(a)     ( a )
+    #define PQ_KEY_FRONT        0
+#endif
+#define PQ_KEY_NOT_AFTER(a,b)   ( !PQ_KEY_BEFORE( b, a ) )
+
+/**
+ * Node links.  Built with USE_COMPACT_REFS, which needs the single slab per
+ * node type of the eager maps, queues that support it link their nodes by
+ * 32-bit references into the slab of their arena instead of by pointers.
+ * Such a queue declares its links with PQ_LINK, keeps the start of its slab
+ * in a base field, and goes between links and nodes only through PQ_NODE and
+ * PQ_REF, which may evaluate their arguments more than once.  Links may be
+ * copied and compared to one another and to PQ_NULL_LINK as they are.  The
+ * queue defines PQ_HAS_COMPACT_REFS.
+ */
+#ifdef USE_COMPACT_REFS
+    #ifndef USE_EAGER
+        #error "USE_COMPACT_REFS needs USE_EAGER"
+    #endif
+    #define PQ_LINK(type)       uint32_t
+    #define PQ_NULL_LINK        0
+    #define PQ_NODE(q,ref)      ( (ref) ? (q)->base + (ref) - 1 : NULL )
+    #define PQ_REF(q,node)      \
+        ( (node) ? (uint32_t) ( (node) - (q)->base ) + 1 : 0 )
+#else
+    #define PQ_LINK(type)       type*
+    #define PQ_NULL_LINK        NULL
+    #define PQ_NODE(q,ref)      ( ref )
+    #define PQ_REF(q,node)      ( node )
+#endif
+
+/**
+ * Optional operations.  A queue that implements pq_replace_min, a fused
+ * pq_delete_min and pq_insert that reuses the minimum's node, defines
+ * PQ_HAS_REPLACE_MIN in its header; clients fall back to the two separate
+ * calls for the others.
+ *
+ * A queue that implements pq_compact, which moves its live nodes into a fresh
+ * arena in breadth-first order of its trees, defines PQ_HAS_COMPACT.  Every
+ * node moves, so handles held by the client go stale; the queue reports each
+ * move through a pq_relocate_fn, while the old node can still be read.
+ */
+typedef void (*pq_relocate_fn)( void *context, void *from, void *to );
+
 #define OCCUPIED(a,b)       ( a & ( ( (uint64_t) 1 ) << b ) )
 #define REGISTRY_SET(a,b)   ( a |= ( ( (uint64_t) 1 ) << b ) )
 #define REGISTRY_UNSET(a,b) ( a &= ~( ( (uint64_t) 1 ) << b ) )
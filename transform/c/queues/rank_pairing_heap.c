@@ -14,7 +14,6 @@ static rank_pairing_node* join( rank_pairing_heap *queue, rank_pairing_node *a,
     rank_pairing_node *b );
 static void fix_roots( rank_pairing_heap *queue );
 static bool attempt_insert( rank_pairing_heap *queue, rank_pairing_node *node );
-static void fix_min( rank_pairing_heap *queue );
 static void propagate_ranks_t1( rank_pairing_heap *queue,
     rank_pairing_node *node );
 static void propagate_ranks_t2( rank_pairing_heap *queue,
@@ -29,7 +28,7 @@ static rank_pairing_node* sever_spine( rank_pairing_heap *queue,
 rank_pairing_heap* pq_create( mem_map *map )
 {
     rank_pairing_heap *queue = calloc( 1, sizeof( rank_pairing_heap ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
 
     return queue;
 }
@@ -37,6 +36,7 @@ rank_pairing_heap* pq_create( mem_map *map )
 void pq_destroy( rank_pairing_heap *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -44,8 +44,7 @@ void pq_clear( rank_pairing_heap *queue )
 {
     mm_clear( queue->map );
     queue->minimum = NULL;
-    memset( queue->roots, 0, MAXRANK * sizeof( rank_pairing_node* ) );
-    queue->largest_rank = 0;
+    queue->registry = 0;
     queue->size = 0;
 }
 
@@ -74,7 +73,8 @@ rank_pairing_node* pq_insert( rank_pairing_heap *queue, item_type item,
     queue->size++;
     merge_roots( queue, queue->minimum, wrapper );
 
-    if ( ( queue->minimum == NULL ) || ( key < queue->minimum->key ) )
+    if ( ( queue->minimum == NULL ) ||
+            PQ_KEY_BEFORE( key, queue->minimum->key ) )
         queue->minimum = wrapper;
 
     return wrapper;
@@ -162,7 +162,7 @@ void pq_decrease_key( rank_pairing_heap *queue, rank_pairing_node *node,
     }
     else
     {
-        if ( node->key < queue->minimum->key )
+        if ( PQ_KEY_BEFORE( node->key, queue->minimum->key ) )
             queue->minimum = node;
     }
 }
@@ -239,7 +239,7 @@ static rank_pairing_node* pick_min( rank_pairing_heap *queue,
         return a;
     else
     {
-        if ( b->key < a->key )
+        if ( PQ_KEY_BEFORE( b->key, a->key ) )
             return b;
         else
             return a;
@@ -259,7 +259,7 @@ static rank_pairing_node* join( rank_pairing_heap *queue, rank_pairing_node *a,
 {
     rank_pairing_node *parent, *child;
 
-    if ( b->key < a->key ) {
+    if ( PQ_KEY_BEFORE( b->key, a->key ) ) {
         parent = b;
         child = a;
     }
@@ -280,7 +280,8 @@ static rank_pairing_node* join( rank_pairing_heap *queue, rank_pairing_node *a,
 
 /**
  * Performs a one-pass linking run through the list of roots.  Links
- * trees of equal ranks.
+ * trees of equal ranks.  Finds the new minimum while rebuilding the list,
+ * visiting only the occupied ranks of the registry.
  *
  * @param queue Queue whose roots to fix
  */
@@ -289,13 +290,12 @@ static void fix_roots( rank_pairing_heap *queue )
     rank_pairing_node *output_head = NULL;
     rank_pairing_node *output_tail = NULL;
     rank_pairing_node *current, *next, *joined;
-    uint32_t i, rank;
+    uint64_t occupied;
+    uint32_t rank;
 
     if ( queue->minimum == NULL )
         return;
 
-    queue->largest_rank = 0;
-
     current = queue->minimum->right;
     queue->minimum->right = NULL;
     while ( current != NULL ) {
@@ -306,38 +306,50 @@ static void fix_roots( rank_pairing_heap *queue )
             // keep a running list of joined trees
             joined = join( queue, current, queue->roots[rank] );
             if ( output_head == NULL )
+            {
                 output_head = joined;
+                queue->minimum = joined;
+            }
             else
+            {
                 output_tail->right = joined;
+                if ( PQ_KEY_BEFORE( joined->key, queue->minimum->key ) )
+                    queue->minimum = joined;
+            }
             output_tail = joined;
-            queue->roots[rank] = NULL;
+            REGISTRY_UNSET( queue->registry, rank );
         }
         current = next;
     }
 
     // move the untouched trees to the list and repair pointers
-    for ( i = 0; i <= queue->largest_rank; i++ )
+    occupied = queue->registry;
+    while ( occupied )
     {
-        if ( queue->roots[i] != NULL )
+        rank = REGISTRY_LEADER( occupied );
+        REGISTRY_UNSET( occupied, rank );
+        current = queue->roots[rank];
+        if ( output_head == NULL )
         {
-            if ( output_head == NULL )
-                output_head = queue->roots[i];
-            else
-                output_tail->right = queue->roots[i];
-            output_tail = queue->roots[i];
-            queue->roots[i] = NULL;
+            output_head = current;
+            queue->minimum = current;
         }
+        else
+        {
+            output_tail->right = current;
+            if ( PQ_KEY_BEFORE( current->key, queue->minimum->key ) )
+                queue->minimum = current;
+        }
+        output_tail = current;
     }
+    queue->registry = 0;
 
     output_tail->right = output_head;
-
-    queue->minimum = output_head;
-    fix_min( queue );
 }
 
 /**
  * Attempt to insert a tree in the rank-indexed array.  Inserts if the
- * correct spot is empty, reports failure if it is occupied.
+ * correct spot is unoccupied, reports failure if it is occupied.
  *
  * @param queue Queue to insert into
  * @param node  Node to insert
@@ -346,37 +358,14 @@ static void fix_roots( rank_pairing_heap *queue )
 static bool attempt_insert( rank_pairing_heap *queue, rank_pairing_node *node )
 {
     uint32_t rank = node->rank;
-    if ( ( queue->roots[rank] != NULL ) && ( queue->roots[rank] != node ) )
+    if ( OCCUPIED( queue->registry, rank ) && ( queue->roots[rank] != node ) )
         return FALSE;
     queue->roots[rank] = node;
-
-    if ( rank > queue->largest_rank )
-        queue->largest_rank = rank;
+    REGISTRY_SET( queue->registry, rank );
 
     return TRUE;
 }
 
-/**
- * Scans through the roots list starting from the current, potentially
- * inaccurate, minimum to find the tree with the minimum-value
- * root.
- *
- * @param queue Queue to fix
- */
-static void fix_min( rank_pairing_heap *queue )
-{
-    if ( queue->minimum == NULL )
-        return;
-    rank_pairing_node *start = queue->minimum;
-    rank_pairing_node *current = queue->minimum->right;
-    while ( current != start )
-    {
-        if ( current->key < queue->minimum->key )
-            queue->minimum = current;
-        current = current->right;
-    }
-}
-
 /**
  * Propagates rank corrections upward from the initial node using the type-1
  * rank rule.
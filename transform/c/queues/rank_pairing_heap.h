@@ -50,8 +50,8 @@ struct rank_pairing_heap_t
     rank_pairing_node *minimum;
     //! An array of roots of the queue, indexed by rank
     rank_pairing_node *roots[MAXRANK];
-    //! Current largest rank in queue
-    uint32_t largest_rank;
+    //! Ranks occupied in the roots array
+    uint64_t registry;
 } __attribute__ ((aligned(4)));
 
 typedef struct rank_pairing_heap_t rank_pairing_heap;
@@ -62,9 +62,9 @@ typedef rank_pairing_heap pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty queue.
+ * Creates a new, empty queue, with its own arena carved from the given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 rank_pairing_heap* pq_create( mem_map *map );
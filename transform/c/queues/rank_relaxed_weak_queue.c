@@ -55,7 +55,7 @@ rank_relaxed_weak_queue* pq_create( mem_map *map )
 {
     rank_relaxed_weak_queue *queue = calloc( 1,
         sizeof( rank_relaxed_weak_queue ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
 
     return queue;
 }
@@ -63,6 +63,7 @@ rank_relaxed_weak_queue* pq_create( mem_map *map )
 void pq_destroy( rank_relaxed_weak_queue *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -103,7 +104,8 @@ rank_relaxed_weak_node* pq_insert( rank_relaxed_weak_queue *queue,
     queue->size++;
     insert_root( queue, wrapper );
 
-    if ( ( queue->minimum == NULL ) || ( key < queue->minimum->key ) )
+    if ( ( queue->minimum == NULL ) ||
+            PQ_KEY_BEFORE( key, queue->minimum->key ) )
         queue->minimum = wrapper;
 
     return wrapper;
@@ -156,7 +158,7 @@ key_type pq_delete_min( rank_relaxed_weak_queue *queue )
 
 key_type pq_delete( rank_relaxed_weak_queue *queue, rank_relaxed_weak_node *node )
 {
-    pq_decrease_key( queue, node, 0 );
+    pq_decrease_key( queue, node, PQ_KEY_FRONT );
     key_type min_key = pq_delete_min( queue );
 
     return min_key;
@@ -173,7 +175,7 @@ void pq_decrease_key( rank_relaxed_weak_queue *queue, rank_relaxed_weak_node *no
         restore_invariants( queue, node );
     }
 
-    if( node->key <= queue->minimum->key )
+    if( PQ_KEY_NOT_AFTER( node->key, queue->minimum->key ) )
         queue->minimum = node;
 }
 
@@ -365,7 +367,7 @@ static rank_relaxed_weak_node* join( rank_relaxed_weak_queue *queue,
     rank_relaxed_weak_node *a, rank_relaxed_weak_node *b )
 {
     rank_relaxed_weak_node *parent, *child;
-    if( a->key <= b->key )
+    if( PQ_KEY_NOT_AFTER( a->key, b->key ) )
     {
         parent = a;
         child = b;
@@ -732,7 +734,7 @@ static void fix_min( rank_relaxed_weak_queue *queue )
         {
             rank = REGISTRY_LEADER( search_registry );
             current = search_list[rank];
-            if( min == NULL || current->key <= min->key )
+            if( min == NULL || PQ_KEY_NOT_AFTER( current->key, min->key ) )
                 min = current;
             REGISTRY_UNSET( search_registry, rank );
         }
@@ -777,7 +779,7 @@ static rank_relaxed_weak_node* transformation_pair(
     rank_relaxed_weak_node *extra = queue->nodes[MARKS][primary->rank];
 
     rank_relaxed_weak_node *tmp = primary;
-    if( extra->parent->key < primary->parent->key )
+    if( PQ_KEY_BEFORE( extra->parent->key, primary->parent->key ) )
     {
         primary = extra;
         extra = tmp;
@@ -791,7 +793,7 @@ static rank_relaxed_weak_node* transformation_pair(
     swap_disconnected( queue, primary, extra_parent );
     swap_subtrees( extra_parent, &(extra_parent->right), extra, &(extra->left) );
 
-    if( extra_parent->key < primary_parent->key )
+    if( PQ_KEY_BEFORE( extra_parent->key, primary_parent->key ) )
     {
         swap_parent_with_right_child( queue, primary_parent, extra_parent );
         flip_subtree( primary_parent );
@@ -799,7 +801,7 @@ static rank_relaxed_weak_node* transformation_pair(
 
     rank_relaxed_weak_node *result = primary;
     rank_relaxed_weak_node *unmarked = extra;
-    if( extra->key < primary->key )
+    if( PQ_KEY_BEFORE( extra->key, primary->key ) )
     {
         swap_parent_with_right_child( queue, primary, extra );
         flip_subtree( primary );
@@ -831,7 +833,7 @@ static rank_relaxed_weak_node* transformation_parent(
         unregister_node( queue, MARKS, parent );
     unregister_node( queue, MARKS, node );
 
-    if( node->key < parent->key )
+    if( PQ_KEY_BEFORE( node->key, parent->key ) )
     {
         swap_parent_with_right_child( queue, parent, node );
         flip_subtree( parent );
@@ -869,7 +871,7 @@ static rank_relaxed_weak_node* transformation_sibling(
     swap_parent_with_left_child( queue, parent, node );
     swap_subtrees( parent, &(parent->right), sibling, &(sibling->left) );
 
-    if( sibling->key < node->key )
+    if( PQ_KEY_BEFORE( sibling->key, node->key ) )
     {
         swap_parent_with_right_child( queue, node, sibling );
         flip_subtree( node );
@@ -898,7 +900,7 @@ static rank_relaxed_weak_node* transformation_zigzag(
     rank_relaxed_weak_node *parent = node->parent;
     rank_relaxed_weak_node *grand = parent->parent;
 
-    if( grand->key < node->key )
+    if( PQ_KEY_BEFORE( grand->key, node->key ) )
         node->marked = 0;
     else
     {
@@ -69,9 +69,9 @@ typedef rank_relaxed_weak_queue pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty queue.
+ * Creates a new, empty queue, with its own arena carved from the given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 rank_relaxed_weak_queue* pq_create( mem_map *map );
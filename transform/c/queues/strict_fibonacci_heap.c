@@ -21,6 +21,8 @@ static inline void remove_from_siblings( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node );
 static void link( strict_fibonacci_heap *queue, strict_fibonacci_node *parent,
     strict_fibonacci_node *child );
+static void link_children( strict_fibonacci_heap *queue,
+    strict_fibonacci_node *parent, strict_fibonacci_node *node );
 static strict_fibonacci_node* select_new_root( strict_fibonacci_heap *queue );
 
 //--------------------------------------
@@ -46,15 +48,13 @@ static void increase_loss( strict_fibonacci_heap *queue,
 static void decrease_loss( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node );
 static void switch_node_rank( strict_fibonacci_heap *queue,
-    strict_fibonacci_node *node, rank_record *new_rank );
-static void insert_fix_node( strict_fibonacci_heap *queue, fix_node *fix,
-    int type );
-static void remove_fix_node( strict_fibonacci_heap *queue, fix_node *fix,
-    int type );
-static void check_rank( strict_fibonacci_heap *queue, rank_record *rank,
-    int type );
-static void move_rank( strict_fibonacci_heap *queue, rank_record *rank,
-    int type, int direction );
+    strict_fibonacci_node *node, uint32_t new_rank );
+static inline strict_fibonacci_node** fix_list_of(
+    strict_fibonacci_heap *queue, strict_fibonacci_node *node, int type );
+static void insert_fix_node( strict_fibonacci_heap *queue,
+    strict_fibonacci_node *node, int type );
+static void remove_fix_node( strict_fibonacci_heap *queue,
+    strict_fibonacci_node *node, int type );
 
 //--------------------------------------
 // NODE TYPE CONVERSIONS
@@ -64,8 +64,6 @@ static void convert_active_to_root( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node );
 static void convert_active_to_loss( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node );
-static void convert_root_to_active( strict_fibonacci_heap *queue,
-    strict_fibonacci_node *node );
 static void convert_loss_to_active( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node );
 static void convert_passive_to_active( strict_fibonacci_heap *queue,
@@ -88,15 +86,8 @@ static void post_decrease_key_reduction( strict_fibonacci_heap *queue );
 // GARBAGE COLLECTION & ALLOCATION
 //--------------------------------------
 
-static rank_record* create_rank_record( strict_fibonacci_heap *queue,
-    uint32_t rank, rank_record *pred );
 static void release_active_record( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node );
-static void release_rank_record( strict_fibonacci_heap *queue,
-    strict_fibonacci_node *node );
-static void release_to_garbage_collector( strict_fibonacci_heap *queue,
-    strict_fibonacci_heap *garbage_queue );
-static void garbage_collection( strict_fibonacci_heap *queue );
 
 //==============================================================================
 // PUBLIC METHODS
@@ -106,13 +97,14 @@ strict_fibonacci_heap* pq_create( mem_map *map )
 {
     strict_fibonacci_heap *queue = (strict_fibonacci_heap*) calloc( 1,
         sizeof( strict_fibonacci_heap ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
 
     return queue;
 }
 
 void pq_destroy( strict_fibonacci_heap *queue ){
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -125,9 +117,11 @@ void pq_clear( strict_fibonacci_heap *queue )
     queue->q_head = NULL;
 
     queue->active = NULL;
-    queue->rank_list = NULL;
-    queue->fix_list[0] = NULL;
-    queue->fix_list[1] = NULL;
+    memset( queue->fix_list, 0,
+        2 * MAXRANK * sizeof( strict_fibonacci_node* ) );
+    queue->fix_pairs[0] = 0;
+    queue->fix_pairs[1] = 0;
+    queue->heavy_loss = NULL;
 }
 
 key_type pq_get_key( strict_fibonacci_heap *queue, strict_fibonacci_node *node )
@@ -149,14 +143,22 @@ uint32_t pq_get_size( strict_fibonacci_heap *queue )
 strict_fibonacci_node* pq_insert( strict_fibonacci_heap *queue, item_type item,
     key_type key )
 {
-    strict_fibonacci_node* wrapper = pq_alloc_node( queue->map,
+    strict_fibonacci_node* wrapper = pq_alloc_node_uninit( queue->map,
         STRICT_NODE_FIB );
     ITEM_ASSIGN( wrapper->item, item );
     wrapper->key = key;
+    wrapper->parent = NULL;
     wrapper->right = wrapper;
     wrapper->left = wrapper;
+    wrapper->left_child = NULL;
     wrapper->q_next = wrapper;
     wrapper->q_prev = wrapper;
+    wrapper->fix_left = NULL;
+    wrapper->fix_right = NULL;
+    wrapper->active = NULL;
+    wrapper->type = STRICT_TYPE_PASSIVE;
+    wrapper->loss = 0;
+    wrapper->rank = 0;
 
     strict_fibonacci_node *parent, *child;
     if( queue->root == NULL )
@@ -172,7 +174,6 @@ strict_fibonacci_node* pq_insert( strict_fibonacci_heap *queue, item_type item,
     }
 
     queue->size++;
-    garbage_collection( queue );
 
     return wrapper;
 }
@@ -214,8 +215,7 @@ key_type pq_delete_min( strict_fibonacci_heap *queue )
         if( is_active( queue, old_root ) )
             convert_to_passive( queue, old_root );
 
-        while( old_root->left_child != NULL )
-            link( queue, new_root, old_root->left_child );
+        link_children( queue, new_root, old_root );
 
         for( i = 0; i < 2; i++ )
         {
@@ -237,7 +237,6 @@ key_type pq_delete_min( strict_fibonacci_heap *queue )
     pq_free_node( queue->map, STRICT_NODE_FIB, old_root );
 
     post_delete_min_reduction( queue );
-    garbage_collection( queue );
 
     queue->size--;
 
@@ -248,7 +247,7 @@ key_type pq_delete( strict_fibonacci_heap *queue, strict_fibonacci_node *node )
 {
     key_type key = node->key;
 
-    pq_decrease_key( queue, node, 0 );
+    pq_decrease_key( queue, node, PQ_KEY_FRONT );
     pq_delete_min( queue );
 
     return key;
@@ -261,7 +260,7 @@ void pq_decrease_key( strict_fibonacci_heap *queue, strict_fibonacci_node *node,
 
     node->key = new_key;
 
-    if( old_parent == NULL || node->key > old_parent->key)
+    if( old_parent == NULL || PQ_KEY_BEFORE( old_parent->key, node->key ))
         return;
 
     strict_fibonacci_node *parent, *child;
@@ -288,13 +287,12 @@ void pq_decrease_key( strict_fibonacci_heap *queue, strict_fibonacci_node *node,
         increase_loss( queue, old_parent );
 
     post_decrease_key_reduction( queue );
-    garbage_collection( queue );
 }
 
 strict_fibonacci_heap* pq_meld( strict_fibonacci_heap *a,
     strict_fibonacci_heap *b )
 {
-    strict_fibonacci_heap *new_heap = pq_create( a->map );
+    strict_fibonacci_heap *new_heap = pq_create( a->map->parent );
     strict_fibonacci_heap *big, *small;
 
     strict_fibonacci_node *big_head, *big_tail, *small_head, *small_tail;
@@ -316,23 +314,30 @@ strict_fibonacci_heap* pq_meld( strict_fibonacci_heap *a,
     new_heap->size = big->size + small->size;
     new_heap->q_head = big->q_head;
     new_heap->active = big->active;
-    new_heap->rank_list = big->rank_list;
-    new_heap->fix_list[0] = big->fix_list[0];
-    new_heap->fix_list[1] = big->fix_list[1];
+    memcpy( new_heap->fix_list, big->fix_list,
+        2 * MAXRANK * sizeof( strict_fibonacci_node* ) );
+    new_heap->fix_pairs[0] = big->fix_pairs[0];
+    new_heap->fix_pairs[1] = big->fix_pairs[1];
+    new_heap->heavy_loss = big->heavy_loss;
 
     if( small->active != NULL )
         small->active->flag = 0;
 
     // merge the queues
-    big_head = big->q_head;
-    big_tail = big_head->q_prev;
-    small_head = small->q_head;
-    small_tail = small_head->q_prev;
-
-    big_head->q_prev = small_tail;
-    small_tail->q_next = big_head;
-    small_head->q_prev = big_tail;
-    big_tail->q_next = small_head;
+    if( new_heap->q_head == NULL )
+        new_heap->q_head = small->q_head;
+    else if( small->q_head != NULL )
+    {
+        big_head = big->q_head;
+        big_tail = big_head->q_prev;
+        small_head = small->q_head;
+        small_tail = small_head->q_prev;
+
+        big_head->q_prev = small_tail;
+        small_tail->q_next = big_head;
+        small_head->q_prev = big_tail;
+        big_tail->q_next = small_head;
+    }
 
     // actually link the two trees
     choose_order_pair( big->root, small->root, &parent, &child );
@@ -340,11 +345,13 @@ strict_fibonacci_heap* pq_meld( strict_fibonacci_heap *a,
     new_heap->root = parent;
     enqueue_node( new_heap, child );
 
-    // take care of some garbage collection
-    release_to_garbage_collector( new_heap, small );
+    // the small heap's fix lists are dropped, as its nodes are now passive
+    mm_meld( new_heap->map, big->map );
+    mm_meld( new_heap->map, small->map );
+    mm_destroy( small->map );
+    mm_destroy( big->map );
     free( small );
     free( big );
-    garbage_collection( new_heap );
 
     return new_heap;
 }
@@ -364,7 +371,9 @@ bool pq_empty( strict_fibonacci_heap *queue )
 
 /**
  * Determines if a given node is active.  If a passive node was previously
- * active, any record references are released.
+ * active, its active record reference is released.  Its fix links may still
+ * point into the fix lists of the heap it was active in, but nothing reads
+ * them again.
  *
  * @param queue Queue in which to operate
  * @param node  Node to check
@@ -379,10 +388,8 @@ static inline int is_active( strict_fibonacci_heap *queue,
     if( !node->active->flag )
     {
         release_active_record( queue, node );
-        release_rank_record( queue, node );
-        if( node->fix != NULL )
-            node->fix = NULL;
         node->type = STRICT_TYPE_PASSIVE;
+        node->loss = 0;
 
         return 0;
     }
@@ -403,7 +410,7 @@ static inline void choose_order_pair( strict_fibonacci_node *a,
     strict_fibonacci_node *b, strict_fibonacci_node **parent,
     strict_fibonacci_node **child )
 {
-    if( a->key <= b->key )
+    if( PQ_KEY_NOT_AFTER( a->key, b->key ) )
     {
         *parent = a;
         *child = b;
@@ -431,15 +438,15 @@ static inline void choose_order_triple( strict_fibonacci_node *a,
     strict_fibonacci_node **grand, strict_fibonacci_node **parent,
     strict_fibonacci_node **child )
 {
-    if( a->key < b->key )
+    if( PQ_KEY_BEFORE( a->key, b->key ) )
     {
-        if( b->key < c->key )
+        if( PQ_KEY_BEFORE( b->key, c->key ) )
         {
             *grand = a;
             *parent = b;
             *child = c;
         }
-        else if( a->key < c->key )
+        else if( PQ_KEY_BEFORE( a->key, c->key ) )
         {
             *grand = a;
             *parent = c;
@@ -454,13 +461,13 @@ static inline void choose_order_triple( strict_fibonacci_node *a,
     }
     else
     {
-        if( a->key < c->key )
+        if( PQ_KEY_BEFORE( a->key, c->key ) )
         {
             *grand = b;
             *parent = a;
             *child = c;
         }
-        else if( b->key < c->key )
+        else if( PQ_KEY_BEFORE( b->key, c->key ) )
         {
             *grand = b;
             *parent = c;
@@ -547,6 +554,61 @@ static void link( strict_fibonacci_heap *queue, strict_fibonacci_node *parent,
     child->parent = parent;
 }
 
+/**
+ * Links all the children of one node to another, in time proportional only
+ * to the number of children.  The leading active children of the node go to
+ * the left end of the parent's children, and the rest to the right end.
+ *
+ * @param queue     Queue in which to operate
+ * @param parent    New parent node
+ * @param node      Node whose children to move
+ */
+static void link_children( strict_fibonacci_heap *queue,
+    strict_fibonacci_node *parent, strict_fibonacci_node *node )
+{
+    strict_fibonacci_node *first = node->left_child;
+    strict_fibonacci_node *last_active = NULL;
+    strict_fibonacci_node *current, *before, *after, *head;
+    int leading = 1;
+
+    if( first == NULL )
+        return;
+
+    current = first;
+    do
+    {
+        if( leading && is_active( queue, current ) )
+            last_active = current;
+        else
+            leading = 0;
+        current->parent = parent;
+        current = current->right;
+    } while( current != first );
+    node->left_child = NULL;
+
+    head = parent->left_child;
+    if( head == NULL )
+    {
+        parent->left_child = first;
+        return;
+    }
+
+    // the parent's children go between the leading active ones and the rest
+    if( last_active == NULL )
+        before = first->left;
+    else
+    {
+        before = last_active;
+        parent->left_child = first;
+    }
+    after = before->right;
+
+    after->left = head->left;
+    head->left->right = after;
+    before->right = head;
+    head->left = before;
+}
+
 /**
  * Searches through the old root's children to find the new minimum.
  *
@@ -561,7 +623,7 @@ static strict_fibonacci_node* select_new_root( strict_fibonacci_heap *queue )
     strict_fibonacci_node *current = new_root->right;
     while( current != old_root->left_child )
     {
-        if( current->key < new_root->key )
+        if( PQ_KEY_BEFORE( current->key, new_root->key ) )
             new_root = current;
         current = current->right;
     }
@@ -647,8 +709,8 @@ static strict_fibonacci_node* consume_node( strict_fibonacci_heap *queue )
 //--------------------------------------
 
 /**
- * Increases the rank of the specified node by 1.  Allocates a new rank record
- * if necessary.  Rearranges fix list appropriately.
+ * Increases the rank of the specified node by 1.  Rearranges fix list
+ * appropriately.  Ranks stop at the last of the fix lists.
  *
  * @param queue Queue in which to operate
  * @param node  Node to alter
@@ -656,17 +718,15 @@ static strict_fibonacci_node* consume_node( strict_fibonacci_heap *queue )
 static void increase_rank( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node )
 {
-    rank_record *new_rank = node->rank->inc;
-    uint32_t target_rank = node->rank->rank + 1;
-    if( new_rank->rank != target_rank )
-        new_rank = create_rank_record( queue, target_rank, new_rank );
-
-    switch_node_rank( queue, node, new_rank );
+    if( node->rank < MAXRANK - 1 )
+        switch_node_rank( queue, node, node->rank + 1 );
 }
 
 /**
- * Decreases the rank of the specified node by 1.  Allocates a new rank record
- * if necessary.  Rearranges fix list appropriately.
+ * Decreases the rank of the specified node by 1.  Rearranges fix list
+ * appropriately.  A rank can fall behind the node's count of active children,
+ * as decrease-key makes a new root by linking rather than by swapping items
+ * and the children an active root gains are not counted, so ranks stop at 0.
  *
  * @param queue Queue in which to operate
  * @param node  Node to alter
@@ -674,12 +734,8 @@ static void increase_rank( strict_fibonacci_heap *queue,
 static void decrease_rank( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node )
 {
-    rank_record *new_rank = node->rank->dec;
-    uint32_t target_rank = node->rank->rank - 1;
-    if( new_rank->rank != target_rank )
-        new_rank = create_rank_record( queue, target_rank, node->rank );
-
-    switch_node_rank( queue, node, new_rank );
+    if( node->rank > 0 )
+        switch_node_rank( queue, node, node->rank - 1 );
 }
 
 /**
@@ -692,9 +748,19 @@ static void decrease_rank( strict_fibonacci_heap *queue,
 static void increase_loss( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node )
 {
-    node->loss++;
-    if( node->loss == 1 )
+    if( node->loss == 0 )
+    {
+        node->loss = 1;
         convert_active_to_loss( queue, node );
+    }
+    else if( node->loss == 1 )
+    {
+        remove_fix_node( queue, node, STRICT_FIX_LOSS );
+        node->loss = 2;
+        insert_fix_node( queue, node, STRICT_FIX_LOSS );
+    }
+    else
+        node->loss++;
 }
 
 /**
@@ -707,200 +773,100 @@ static void increase_loss( strict_fibonacci_heap *queue,
 static void decrease_loss( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node )
 {
-    node->loss = 0;
     convert_loss_to_active( queue, node );
 }
 
 /**
  * Switches the rank of a node, and rearranges the fix lists accordingly.
- * Releases reference to old rank, possibly triggering garbage collection.
  *
  * @param queue     Queue in which to operate
  * @param node      Node to alter
  * @param new_rank  New rank for the node
  */
 static void switch_node_rank( strict_fibonacci_heap *queue,
-    strict_fibonacci_node *node, rank_record *new_rank )
+    strict_fibonacci_node *node, uint32_t new_rank )
 {
     int type = ( node->type == STRICT_TYPE_ROOT ) ? STRICT_FIX_ROOT :
         STRICT_FIX_LOSS;
 
-    fix_node *fix = node->fix;
-    if( fix != NULL )
-        remove_fix_node( queue, fix, type );
-
-    release_rank_record( queue, node );
-    node->rank = new_rank;
-    new_rank->ref_count++;
-
-    if( fix != NULL )
+    if( node->type < STRICT_TYPE_ROOT )
     {
-        fix->rank = new_rank;
-        insert_fix_node( queue, fix, type );
+        node->rank = new_rank;
+        return;
     }
+
+    remove_fix_node( queue, node, type );
+    node->rank = new_rank;
+    insert_fix_node( queue, node, type );
 }
 
 /**
- * Inserts a fix node into the appropriate list.
+ * Finds the fix list a node belongs in, by its rank or, for a node with loss
+ * greater than one, the list of such nodes.
  *
  * @param queue Queue in which to operate
- * @param fix   Fix node to insert
- * @param type  Which list to alter
+ * @param node  Node to place
+ * @param type  Which kind of list
+ * @return      Pointer to the head of the list
  */
-static void insert_fix_node( strict_fibonacci_heap *queue, fix_node *fix,
-    int type )
+static inline strict_fibonacci_node** fix_list_of(
+    strict_fibonacci_heap *queue, strict_fibonacci_node *node, int type )
 {
-    rank_record *rank = fix->rank;
-
-    if( rank->head[type] == NULL )
-    {
-        rank->head[type] = fix;
-        rank->tail[type] = fix;
-
-        if( queue->fix_list[type] == NULL )
-        {
-            fix->right = fix;
-            fix->left = fix;
-            queue->fix_list[type] = fix;
-            return;
-        }
-        else
-        {
-            fix->right = queue->fix_list[type];
-            fix->left = fix->right->left;
-            fix->right->left = fix;
-            fix->left->right = fix;
-        }
-    }
-    else
-    {
-        fix->right = rank->head[type];
-        fix->left = fix->right->left;
-        fix->right->left = fix;
-        fix->left->right = fix;
-
-        if( queue->fix_list[type] == rank->head[type] )
-            queue->fix_list[type] = fix;
-        rank->head[type] = fix;
-    }
-
-    check_rank( queue, rank, type );
+    if( type == STRICT_FIX_LOSS && node->loss > 1 )
+        return &queue->heavy_loss;
+    return &queue->fix_list[type][node->rank];
 }
 
 /**
- * Removes a specified fix node from the appropriate list
+ * Inserts a node at the head of the appropriate fix list, marking its rank
+ * in the registry if it now has a pair to link.
  *
  * @param queue Queue in which to operate
- * @param fix   Fix node to remove
- * @param type  Which list to alter
+ * @param node  Node to insert
+ * @param type  Which kind of list to alter
  */
-static void remove_fix_node( strict_fibonacci_heap *queue, fix_node *fix,
-    int type )
+static void insert_fix_node( strict_fibonacci_heap *queue,
+    strict_fibonacci_node *node, int type )
 {
-    rank_record *rank = fix->rank;
+    strict_fibonacci_node **list = fix_list_of( queue, node, type );
+    strict_fibonacci_node *next = *list;
 
-    if( queue->fix_list[type] == fix )
+    node->fix_left = NULL;
+    node->fix_right = next;
+    if( next != NULL )
     {
-        if( fix->right == fix )
-            queue->fix_list[type] = NULL;
-        else
-            queue->fix_list[type] = fix->right;
+        next->fix_left = node;
+        if( list != &queue->heavy_loss )
+            REGISTRY_SET( queue->fix_pairs[type], node->rank );
     }
-
-    if( rank->head[type] == fix )
-    {
-        if( rank->tail[type] == fix )
-        {
-            rank->head[type] = NULL;
-            rank->tail[type] = NULL;
-        }
-        else
-            rank->head[type] = fix->right;
-    }
-    else if( rank->tail[type] == fix )
-        rank->tail[type] = fix->left;
-
-    fix_node *next = fix->right;
-    fix_node *prev = fix->left;
-
-    next->left = prev;
-    prev->right = next;
-
-    check_rank( queue, rank, type );
+    *list = node;
 }
 
 /**
- * Check a specified rank to see if it needs to be pro- or demoted within the
- * specified fix list.
+ * Removes a specified node from the appropriate fix list, unmarking its rank
+ * in the registry if no pair is left.
  *
  * @param queue Queue in which to operate
- * @param rank  Rank to check
- * @param type  Which list to alter
- */
-static void check_rank( strict_fibonacci_heap *queue, rank_record *rank,
-    int type )
-{
-    if( rank->head[type] == NULL )
-        return;
-
-    int status = ( rank->head[type] != rank->tail[type] ||
-        rank->head[type]->node->loss > 1 );
-
-    if( rank->transformable[type] && !status )
-        move_rank( queue, rank, type, STRICT_DIR_DEMOTE );
-    else if( !rank->transformable[type] && status )
-        move_rank( queue, rank, type, STRICT_DIR_PROMOTE );
-}
-
-/**
- * Move a specified rank within the fix list
- *
- * @param queue     Queue in which to operate
- * @param rank      Rank to move
- * @param type      Which list to alter
- * @param direction STRICT_DIR_PROMOTE or STRICT_DIR_DEMOTE
+ * @param node  Node to remove
+ * @param type  Which kind of list to alter
  */
-static void move_rank( strict_fibonacci_heap *queue, rank_record *rank,
-    int type, int direction )
+static void remove_fix_node( strict_fibonacci_heap *queue,
+    strict_fibonacci_node *node, int type )
 {
-    fix_node *head = rank->head[type];
-    fix_node *tail = rank->tail[type];
-    fix_node *pred = head->left;
-    fix_node *succ = tail->right;
+    strict_fibonacci_node **list = fix_list_of( queue, node, type );
+    strict_fibonacci_node *next = node->fix_right;
+    strict_fibonacci_node *prev = node->fix_left;
 
-    rank->transformable[type] = direction;
-
-    if( pred == tail )
-        return;
-
-    if( queue->fix_list[type] == head && direction == STRICT_DIR_PROMOTE )
-        return;
-
-    if( queue->fix_list[type] == succ && direction == STRICT_DIR_DEMOTE )
-        return;
-
-    if( queue->fix_list[type] == succ && direction == STRICT_DIR_PROMOTE )
-    {
-        queue->fix_list[type] = head;
-        return;
-    }
-
-    if( queue->fix_list[type] == head )
-        queue->fix_list[type] = succ;
-
-    pred->right = succ;
-    succ->left = pred;
-
-    succ = queue->fix_list[type];
-    pred = succ->left;
-
-    succ->left = tail;
-    pred->right = head;
-    head->left = pred;
-    tail->right = succ;
+    if( prev == NULL )
+        *list = next;
+    else
+        prev->fix_right = next;
+    if( next != NULL )
+        next->fix_left = prev;
 
-    if( direction == STRICT_DIR_PROMOTE )
-        queue->fix_list[type] = rank->head[type];
+    if( list != &queue->heavy_loss &&
+            ( *list == NULL || (*list)->fix_right == NULL ) )
+        REGISTRY_UNSET( queue->fix_pairs[type], node->rank );
 }
 
 //--------------------------------------
@@ -908,8 +874,8 @@ static void move_rank( strict_fibonacci_heap *queue, rank_record *rank,
 //--------------------------------------
 
 /**
- * Convert an active node to an active root.  Assign it a fix node and insert it
- * accordingly.
+ * Convert an active node to an active root and insert it into the root fix
+ * list.
  *
  * @param queue Queue in which to operate
  * @param node  Node to convert
@@ -920,18 +886,12 @@ static void convert_active_to_root( strict_fibonacci_heap *queue,
     if( is_active( queue, node ) && node->type == STRICT_TYPE_LOSS )
         convert_loss_to_active( queue, node );
 
-    fix_node *fix = pq_alloc_node( queue->map, STRICT_NODE_FIX );
-    fix->node = node;
-    fix->rank = node->rank;
-    node->fix = fix;
     node->type = STRICT_TYPE_ROOT;
-
-    insert_fix_node( queue, fix, STRICT_FIX_ROOT );
+    insert_fix_node( queue, node, STRICT_FIX_ROOT );
 }
 
 /**
- * Convert an active node to a loss node.  Assign it a fix node and insert it
- * accordingly.
+ * Convert an active node to a loss node and insert it into the loss fix list.
  *
  * @param queue Queue in which to operate
  * @param node  Node to convert
@@ -939,34 +899,13 @@ static void convert_active_to_root( strict_fibonacci_heap *queue,
 static void convert_active_to_loss( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node )
 {
-    fix_node *fix = pq_alloc_node( queue->map, STRICT_NODE_FIX );
-    fix->node = node;
-    fix->rank = node->rank;
-    node->fix = fix;
     node->type = STRICT_TYPE_LOSS;
-
-    insert_fix_node( queue, fix, STRICT_FIX_LOSS );
+    insert_fix_node( queue, node, STRICT_FIX_LOSS );
 }
 
 /**
- * Convert an active root to an active node.  Remove it from the fix list and
- * free the fix node.
- *
- * @param queue Queue in which to operate
- * @param node  Node to convert
- */
-static void convert_root_to_active( strict_fibonacci_heap *queue,
-    strict_fibonacci_node *node )
-{
-    remove_fix_node( queue, node->fix, STRICT_FIX_ROOT );
-    pq_free_node( queue->map, STRICT_NODE_FIX, node->fix );
-    node->fix = NULL;
-    node->type = STRICT_TYPE_ACTIVE;
-}
-
-/**
- * Convert a loss node to an active node.  Remove it from the fix list and
- * free the fix node.
+ * Convert a loss node to an active node with no loss.  Remove it from the fix
+ * list.
  *
  * @param queue Queue in which to operate
  * @param node  Node to convert
@@ -974,15 +913,14 @@ static void convert_root_to_active( strict_fibonacci_heap *queue,
 static void convert_loss_to_active( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node )
 {
-    remove_fix_node( queue, node->fix, STRICT_FIX_LOSS );
-    pq_free_node( queue->map, STRICT_NODE_FIX, node->fix );
-    node->fix = NULL;
+    remove_fix_node( queue, node, STRICT_FIX_LOSS );
+    node->loss = 0;
     node->type = STRICT_TYPE_ACTIVE;
 }
 
 /**
- * Convert a passive node to an active node.  Assign it the proper active record
- * and rank record.  Move it to the left end of its sibling list.
+ * Convert a passive node to an active node of rank 0.  Assign it the proper
+ * active record.  Move it to the left end of its sibling list.
  *
  * @param queue Queue in which to operate
  * @param node  Node to convert
@@ -998,19 +936,16 @@ static void convert_passive_to_active( strict_fibonacci_heap *queue,
     node->active = queue->active;
     queue->active->ref_count++;
 
-    rank_record *rank = queue->rank_list;
-    if( rank == NULL || rank->rank != 0 )
-        rank = create_rank_record( queue, 0, queue->rank_list );
-    node->rank = rank;
-    rank->ref_count++;
+    node->rank = 0;
+    node->loss = 0;
     node->type = STRICT_TYPE_ACTIVE;
 
     node->parent->left_child = node;
 }
 
 /**
- * Convert an active node to a passive one.  Release all fix nodes, active and
- * rank records.
+ * Convert an active node to a passive one.  Remove it from its fix list and
+ * release its active record.
  *
  * @param queue Queue in which to operate
  * @param node  Node to convert
@@ -1018,17 +953,13 @@ static void convert_passive_to_active( strict_fibonacci_heap *queue,
 static void convert_to_passive( strict_fibonacci_heap *queue,
     strict_fibonacci_node *node )
 {
-    if( node->fix != NULL )
-    {
-        remove_fix_node( queue, node->fix, ( node->type == STRICT_TYPE_ROOT ) ?
+    if( node->type >= STRICT_TYPE_ROOT )
+        remove_fix_node( queue, node, ( node->type == STRICT_TYPE_ROOT ) ?
             STRICT_FIX_ROOT : STRICT_FIX_LOSS );
-        pq_free_node( queue->map, STRICT_NODE_FIX, node->fix );
-        node->fix = NULL;
-    }
 
-    release_rank_record( queue, node );
     release_active_record( queue, node );
     node->type = STRICT_TYPE_PASSIVE;
+    node->loss = 0;
 
     if( node->parent != NULL )
         link( queue, node->parent, node );
@@ -1060,21 +991,31 @@ static void convert_to_passive( strict_fibonacci_heap *queue,
  */
 static int reduce_active_roots( strict_fibonacci_heap *queue )
 {
-    fix_node *head = queue->fix_list[STRICT_FIX_ROOT];
-    if( head == NULL )
-        return 0;
-
-    rank_record *rank = head->rank;
-    if( head == rank->tail[STRICT_FIX_ROOT] )
+    if( queue->fix_pairs[STRICT_FIX_ROOT] == 0 )
         return 0;
 
-    fix_node *next = head->right;
+    uint32_t rank = REGISTRY_LEADER( queue->fix_pairs[STRICT_FIX_ROOT] );
+    strict_fibonacci_node *head = queue->fix_list[STRICT_FIX_ROOT][rank];
+    strict_fibonacci_node *next = head->fix_right;
     strict_fibonacci_node *parent, *child;
-    choose_order_pair( head->node, next->node, &parent, &child );
+    choose_order_pair( head, next, &parent, &child );
+
+    // take both off the front of their list before either changes
+    queue->fix_list[STRICT_FIX_ROOT][rank] = next->fix_right;
+    if( next->fix_right == NULL )
+        REGISTRY_UNSET( queue->fix_pairs[STRICT_FIX_ROOT], rank );
+    else
+    {
+        next->fix_right->fix_left = NULL;
+        if( next->fix_right->fix_right == NULL )
+            REGISTRY_UNSET( queue->fix_pairs[STRICT_FIX_ROOT], rank );
+    }
 
     link( queue, parent, child );
-    convert_root_to_active( queue, child );
-    increase_rank( queue, parent );
+    child->type = STRICT_TYPE_ACTIVE;
+    if( rank < MAXRANK - 1 )
+        parent->rank = rank + 1;
+    insert_fix_node( queue, parent, STRICT_FIX_ROOT );
 
     strict_fibonacci_node *extra = parent->left_child->left;
     if( !is_active( queue, extra ) )
@@ -1128,32 +1069,13 @@ static int reduce_root_degree( strict_fibonacci_heap *queue )
  */
 static int reduce_loss( strict_fibonacci_heap *queue )
 {
-    int reduction = 2;
-    fix_node *head = queue->fix_list[STRICT_FIX_LOSS];
-    if( head == NULL )
-        return 0;
-
-    rank_record *rank = head->rank;
-    if( head == rank->tail[STRICT_FIX_LOSS] && head->node->loss < 2 )
-        return 0;
-
-    fix_node *single;
-    fix_node *next = head->right;
+    uint32_t rank;
+    strict_fibonacci_node *head, *next;
     strict_fibonacci_node *child, *parent, *old_parent;
-    if( head->node->loss > 1 )
-    {
-        reduction = 1;
-        single = head;
-    }
-    else if( next->node->loss > 1 )
-    {
-        reduction = 1;
-        single = next;
-    }
 
-    if( reduction == 1 )
+    if( queue->heavy_loss != NULL )
     {
-        child = single->node;
+        child = queue->heavy_loss;
         parent = queue->root;
         old_parent = child->parent;
 
@@ -1165,9 +1087,13 @@ static int reduce_loss( strict_fibonacci_heap *queue )
         if( !is_active( queue, parent ) )
             convert_active_to_root( queue, child );
     }
-    else
+    else if( queue->fix_pairs[STRICT_FIX_LOSS] != 0 )
     {
-        choose_order_pair( head->node, next->node, &parent, &child );
+        rank = REGISTRY_LEADER( queue->fix_pairs[STRICT_FIX_LOSS] );
+        head = queue->fix_list[STRICT_FIX_LOSS][rank];
+        next = head->fix_right;
+
+        choose_order_pair( head, next, &parent, &child );
         old_parent = child->parent;
 
         link( queue, parent, child );
@@ -1176,6 +1102,8 @@ static int reduce_loss( strict_fibonacci_heap *queue )
         decrease_loss( queue, parent );
         increase_rank( queue, parent );
     }
+    else
+        return 0;
 
     if( old_parent != NULL && is_active( queue, old_parent ) )
     {
@@ -1261,39 +1189,6 @@ static void post_decrease_key_reduction( strict_fibonacci_heap *queue )
 // GARBAGE COLLECTION & ALLOCATION
 //--------------------------------------
 
-/**
- * Creates a new rank record with the specified rank.  Inserts it in the rank
- * list before the specified successor.
- *
- * @param queue Queue in which to operate
- * @param rank  Rank for the new record
- * @param succ  Next greatest rank in the list
- */
-static rank_record* create_rank_record( strict_fibonacci_heap *queue,
-    uint32_t rank, rank_record *succ )
-{
-    rank_record *pred;
-    rank_record *new_rank = pq_alloc_node( queue->map, STRICT_NODE_RANK );
-    new_rank->rank = rank;
-    new_rank->inc = new_rank;
-    new_rank->dec = new_rank;
-
-    if( succ == NULL )
-        queue->rank_list = new_rank;
-    else
-    {
-        pred = succ->dec;
-
-        new_rank->inc = succ;
-        new_rank->dec = pred;
-
-        succ->dec = new_rank;
-        pred->inc = new_rank;
-    }
-
-    return new_rank;
-}
-
 /**
  * Releases a reference to an active record, and releases the record for garbage
  * collection if it was the last reference.
@@ -1313,94 +1208,3 @@ static void release_active_record( strict_fibonacci_heap *queue,
     }
     node->active = NULL;
 }
-
-/**
- * Releases a reference to an active record, and releases the record for garbage
- * collection if it was the last reference.
- *
- * @param queue Queue in which to operate
- * @param node  Node containing rank record reference
- */
-static void release_rank_record( strict_fibonacci_heap *queue,
-    strict_fibonacci_node *node )
-{
-    rank_record *rank = node->rank;
-    rank->ref_count--;
-    if( rank->ref_count == 0 )
-    {
-        if( rank->inc == rank )
-        {
-            if( queue->rank_list == rank )
-                queue->rank_list = NULL;
-        }
-        else
-        {
-            if( queue->rank_list == rank )
-                queue->rank_list = rank->inc;
-
-            rank->inc->dec = rank->dec;
-            rank->dec->inc = rank->inc;
-        }
-
-        pq_free_node( queue->map, STRICT_NODE_RANK, rank );
-    }
-    node->rank = NULL;
-}
-
-/**
- * Releases a queue to the garbage collector.  Appends the fix and rank lists to
- * the collecting queue's garbage lists.
- *
- * @param queue         Queue which which will not be deleted
- * @param garbage_queue Queue to release for garbage collection
- */
-static void release_to_garbage_collector( strict_fibonacci_heap *queue,
-    strict_fibonacci_heap *garbage_queue )
-{
-    int i;
-    fix_node *tail, *head, *g_tail, *g_head;
-
-    for( i = 0; i < 2; i++ )
-    {
-        if( garbage_queue->fix_list[i] != NULL )
-        {
-            if( queue->garbage_fix == NULL )
-                queue->garbage_fix = garbage_queue->fix_list[i];
-            else
-            {
-                head = queue->garbage_fix;
-                tail = head->left;
-                g_head = garbage_queue->fix_list[i];
-                g_tail = g_head->left;
-
-                head->left = g_tail;
-                tail->right = g_head;
-                g_tail->right = head;
-                g_head->left = tail;
-            }
-        }
-    }
-}
-
-/**
- * Properly removes a previously released fix and/or rank node.
- *
- * @param queue Queue in which to operate
- */
-static void garbage_collection( strict_fibonacci_heap *queue )
-{
-    fix_node *fix;
-
-    if( queue->garbage_fix != NULL )
-    {
-        fix = queue->garbage_fix;
-        if( fix->right == fix )
-            queue->garbage_fix = NULL;
-        else
-        {
-            queue->garbage_fix = fix->right;
-            fix->right->left = fix->left;
-            fix->left->right = fix->right;
-        }
-    }
-}
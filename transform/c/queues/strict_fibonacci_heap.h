@@ -13,23 +13,16 @@
 
 // node types for memory map allocation
 #define STRICT_NODE_FIB     0
-#define STRICT_NODE_FIX     1
-#define STRICT_NODE_ACTIVE  2
-#define STRICT_NODE_RANK    3
+#define STRICT_NODE_ACTIVE  1
 
 // modes for fix list operations
 #define STRICT_FIX_ROOT     0
 #define STRICT_FIX_LOSS     1
 
-// directions for rank moves
-#define STRICT_DIR_DEMOTE   0
-#define STRICT_DIR_PROMOTE  1
-
 #include "queue_common.h"
 
 // forward declares for pointer resolution
 struct strict_fibonacci_node_t;
-struct fix_node_t;
 
 typedef struct strict_item_t strict_item;
 
@@ -48,51 +41,15 @@ struct active_record_t
 
 typedef struct active_record_t active_record;
 
-/**
- * List of nodes representing rank.  Used to group active nodes for
- * restructuring.
- */
-struct rank_record_t
-{
-    uint32_t rank;
-    //! rank one higher if exists
-    struct rank_record_t *inc;
-    //! rank one lower if exists
-    struct rank_record_t *dec;
-    //! flags of last known transformability status
-    int transformable[2];
-    //! pointers to fix nodes of the current rank
-    struct fix_node_t *head[2];
-    struct fix_node_t *tail[2];
-    //! number of nodes pointing to it, free record if 0
-    uint32_t ref_count;
-} __attribute__ ((aligned(4)));
-
-typedef struct rank_record_t rank_record;
-
-/**
- * A node in a doubly-linked circular list.  Holds a pointer to an active node
- * and a corresponding rank.
- */
-struct fix_node_t
-{
-    struct strict_fibonacci_node_t *node;
-    struct fix_node_t *left;
-    struct fix_node_t *right;
-    rank_record *rank;
-} __attribute__ ((aligned(4)));
-
-typedef struct fix_node_t fix_node;
-
 /**
  * The main structural element of the heap.  Each node stores an item-key pair
  * and  is contained in a doubly-linked circular list of its siblings.
  * Additionally, each node has a pointer to its parent and its leftmost child.
- * The node has pointers to the next and previous nodes in the queue as well as
- * to rank and active records if it is active.  The last known type of the node
- * is stored so that a change in type can easily be detected and unnecessary
- * restructuring can be avoided.  Finally, active nodes may also have positive
- * loss and a reference to a node in the fix list.
+ * The node has pointers to the next and previous nodes in the queue and to
+ * the active record if it is active.  The last known type of the node is
+ * stored so that a change in type can easily be detected and unnecessary
+ * restructuring can be avoided.  Active roots and nodes with positive loss
+ * are linked into the heap's fix lists through the node itself.
  */
 struct strict_fibonacci_node_t
 {
@@ -107,11 +64,15 @@ struct strict_fibonacci_node_t
     struct strict_fibonacci_node_t *q_prev;
     struct strict_fibonacci_node_t *q_next;
 
-    uint32_t type;
+    //! neighbours in a fix list, meaningless unless the node is an active root
+    //! or has positive loss
+    struct strict_fibonacci_node_t *fix_left;
+    struct strict_fibonacci_node_t *fix_right;
+
     active_record *active;
-    rank_record *rank;
-    fix_node *fix;
-    uint32_t loss;
+    uint32_t type : 2;
+    uint32_t rank : 6;
+    uint32_t loss : 24;
 } __attribute__ ((aligned(4)));
 
 typedef struct strict_fibonacci_node_t strict_fibonacci_node;
@@ -119,7 +80,13 @@ typedef strict_fibonacci_node pq_node_type;
 
 /**
  * A mutable, meldable, strict Fibonacci heap.  Maintains a single tree with
- * an auxiliary queue and a fix list.  Entirely pointer-based.
+ * an auxiliary queue and fix lists.  Entirely pointer-based.
+ *
+ * The fix lists are kept per rank, so that a node changes rank by moving
+ * between two lists, and a registry per list type marks the ranks with at
+ * least two nodes, which are those a reduction can link.  Nodes with loss
+ * greater than one are kept apart in a single list of their own, as any of
+ * them can be reduced alone.
  */
 struct strict_fibonacci_heap_t
 {
@@ -130,10 +97,9 @@ struct strict_fibonacci_heap_t
     strict_fibonacci_node *q_head;
 
     active_record *active;
-    rank_record *rank_list;
-    fix_node *fix_list[2];
-
-    fix_node *garbage_fix;
+    strict_fibonacci_node *fix_list[2][MAXRANK];
+    uint64_t fix_pairs[2];
+    strict_fibonacci_node *heavy_loss;
 } __attribute__ ((aligned(4)));
 
 typedef struct strict_fibonacci_heap_t strict_fibonacci_heap;
@@ -144,9 +110,9 @@ typedef strict_fibonacci_heap pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty queue.
+ * Creates a new, empty queue, with its own arena carved from the given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 strict_fibonacci_heap* pq_create( mem_map *map );
@@ -250,8 +216,9 @@ void pq_decrease_key( strict_fibonacci_heap *queue, strict_fibonacci_node *node,
     key_type new_key );
 
 /**
- * Combines two different item-disjoint queues which share a memory map.
- * Returns a pointer to the resulting queue.
+ * Combines two different item-disjoint queues created from the same memory
+ * map, the result taking over the node storage of both.  Returns a pointer to
+ * the resulting queue.
  *
  * @param a First queue
  * @param b Second queue
@@ -0,0 +1,475 @@
+#include "timing_wheel.h"
+
+//==============================================================================
+// DEFINES AND STATIC DECLARATIONS
+//==============================================================================
+
+#define TIME(a)         ( (a) >> WHEEL_KEY_SHIFT )
+// level of a time whose highest digit differing from now is the top one in a
+#define LEVEL_OF(a)     ( (a) ? ( 63 - (uint32_t) __builtin_clzll( a ) ) / \
+                            WHEEL_BITS : 0 )
+
+static wheel_node** locate( timing_wheel *queue, key_type key );
+static void place( timing_wheel *queue, wheel_node *node );
+static void remove_from( timing_wheel *queue, wheel_node **list,
+    wheel_node *node );
+static void cascade( timing_wheel *queue, uint32_t level, uint32_t slot );
+static void rewind_to( timing_wheel *queue, uint64_t time );
+static void list_link( wheel_node **list, wheel_node *node );
+static void list_unlink( wheel_node **list, wheel_node *node );
+static void list_splice( wheel_node **dst, wheel_node *src );
+static void list_insert_sorted( wheel_node **list, wheel_node *node );
+static void list_sort( wheel_node **list );
+
+//==============================================================================
+// PUBLIC METHODS
+//==============================================================================
+
+timing_wheel* pq_create( mem_map *map )
+{
+    timing_wheel *queue = calloc( 1, sizeof( timing_wheel ) );
+    queue->map = mm_create_arena( map );
+
+    return queue;
+}
+
+void pq_destroy( timing_wheel *queue )
+{
+    pq_clear( queue );
+    mm_destroy( queue->map );
+    free( queue );
+}
+
+void pq_clear( timing_wheel *queue )
+{
+    mm_clear( queue->map );
+    queue->size = 0;
+    queue->now = 0;
+    queue->minimum = NULL;
+    queue->sorted = NULL;
+    memset( queue->occupied, 0, WHEEL_LEVELS * sizeof( uint64_t ) );
+    memset( queue->slots, 0, WHEEL_LEVELS * WHEEL_SLOTS *
+        sizeof( wheel_node* ) );
+}
+
+key_type pq_get_key( timing_wheel *queue, wheel_node *node )
+{
+    return PQ_KEY_ORDER( node->key );
+}
+
+item_type* pq_get_item( timing_wheel *queue, wheel_node *node )
+{
+    return (item_type*) &(node->item);
+}
+
+uint32_t pq_get_size( timing_wheel *queue )
+{
+    return queue->size;
+}
+
+wheel_node* pq_insert( timing_wheel *queue, item_type item, key_type key )
+{
+    // keys are stored so that the front of the queue is the smallest
+    key = PQ_KEY_ORDER( key );
+    uint64_t time = TIME( key );
+    wheel_node *wrapper = pq_alloc_node( queue->map, 0 );
+    ITEM_ASSIGN( wrapper->item, item );
+    wrapper->key = key;
+
+    // an empty wheel can be turned to wherever the new key lies
+    if ( queue->size == 0 )
+        queue->now = time;
+    else if ( time < queue->now )
+        rewind_to( queue, time );
+
+    queue->size++;
+    place( queue, wrapper );
+
+    if ( queue->size == 1 ||
+            ( queue->minimum != NULL && key < queue->minimum->key ) )
+        queue->minimum = wrapper;
+
+    return wrapper;
+}
+
+wheel_node* pq_find_min( timing_wheel *queue )
+{
+    uint32_t level, slot;
+
+    if ( pq_empty( queue ) )
+        return NULL;
+    if ( queue->minimum != NULL )
+        return queue->minimum;
+
+    while ( queue->occupied[0] == 0 )
+    {
+        for ( level = 1; queue->occupied[level] == 0; level++ );
+        cascade( queue, level, REGISTRY_LEADER( queue->occupied[level] ) );
+    }
+
+    slot = REGISTRY_LEADER( queue->occupied[0] );
+    queue->now = ( queue->now & ~( (uint64_t) WHEEL_MASK ) ) | slot;
+
+    // every node in the slot shares a time, so only the low bits differ
+    if ( queue->sorted != &queue->slots[0][slot] )
+    {
+        list_sort( &queue->slots[0][slot] );
+        queue->sorted = &queue->slots[0][slot];
+    }
+    queue->minimum = queue->slots[0][slot];
+
+    return queue->minimum;
+}
+
+key_type pq_delete_min( timing_wheel *queue )
+{
+    return pq_delete( queue, pq_find_min( queue ) );
+}
+
+key_type pq_delete( timing_wheel *queue, wheel_node *node )
+{
+    key_type key = node->key;
+
+    if ( node == queue->minimum )
+        queue->minimum = NULL;
+
+    remove_from( queue, locate( queue, key ), node );
+    pq_free_node( queue->map, 0, node );
+    queue->size--;
+
+    return PQ_KEY_ORDER( key );
+}
+
+void pq_decrease_key( timing_wheel *queue, wheel_node *node,
+    key_type new_key )
+{
+    new_key = PQ_KEY_ORDER( new_key );
+    uint64_t time = TIME( new_key );
+    wheel_node **list = locate( queue, node->key );
+
+    if ( time < queue->now )
+    {
+        remove_from( queue, list, node );
+        node->key = new_key;
+        rewind_to( queue, time );
+        place( queue, node );
+    }
+    else
+    {
+        node->key = new_key;
+        if ( locate( queue, new_key ) != list || list == queue->sorted )
+        {
+            // relink from the old slot, which the new key may no longer map to
+            remove_from( queue, list, node );
+            place( queue, node );
+        }
+    }
+
+    if ( queue->minimum != NULL && new_key < queue->minimum->key )
+        queue->minimum = node;
+}
+
+bool pq_empty( timing_wheel *queue )
+{
+    return ( queue->size == 0 );
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Finds the slot to which a key belongs.  Relies on the invariant that every
+ * time in the queue is at least now.
+ *
+ * @param queue Queue in which to operate
+ * @param key   Key to locate
+ * @return      Address of the head pointer of the key's slot
+ */
+static wheel_node** locate( timing_wheel *queue, key_type key )
+{
+    uint64_t time = TIME( key );
+    uint32_t level = LEVEL_OF( time ^ queue->now );
+
+    return &queue->slots[level][( time >> ( level * WHEEL_BITS ) ) &
+        WHEEL_MASK];
+}
+
+/**
+ * Links a node into the slot for its time, in key order if that is the slot
+ * currently kept sorted.  Assumes the time is at least now.
+ *
+ * @param queue Queue in which to operate
+ * @param node  Node to place
+ */
+static void place( timing_wheel *queue, wheel_node *node )
+{
+    wheel_node **list = locate( queue, node->key );
+    uint32_t index = (uint32_t) ( list - &queue->slots[0][0] );
+
+    if ( *list == NULL )
+        REGISTRY_SET( queue->occupied[index >> WHEEL_BITS],
+            ( index & WHEEL_MASK ) );
+    if ( list == queue->sorted )
+        list_insert_sorted( list, node );
+    else
+        list_link( list, node );
+}
+
+/**
+ * Unlinks a node from the given slot, keeping the occupancy bitmaps up to
+ * date.
+ *
+ * @param queue Queue in which to operate
+ * @param list  Head pointer of the slot holding the node
+ * @param node  Node to remove
+ */
+static void remove_from( timing_wheel *queue, wheel_node **list,
+    wheel_node *node )
+{
+    uint32_t index;
+
+    list_unlink( list, node );
+    if ( *list == NULL )
+    {
+        if ( list == queue->sorted )
+            queue->sorted = NULL;
+        index = (uint32_t) ( list - &queue->slots[0][0] );
+        REGISTRY_UNSET( queue->occupied[index >> WHEEL_BITS],
+            ( index & WHEEL_MASK ) );
+    }
+}
+
+/**
+ * Advances now to the start of a slot and redistributes its nodes over the
+ * lower levels.  The slot must be the first occupied one of the lowest
+ * non-empty level, so that no node lies before its start.
+ *
+ * @param queue Queue in which to operate
+ * @param level Level of the slot, at least 1
+ * @param slot  Index of the slot within its level
+ */
+static void cascade( timing_wheel *queue, uint32_t level, uint32_t slot )
+{
+    uint32_t shift = level * WHEEL_BITS;
+    wheel_node *current = queue->slots[level][slot];
+    wheel_node *next;
+
+    queue->now = ( ( queue->now >> ( shift + WHEEL_BITS ) ) <<
+        ( shift + WHEEL_BITS ) ) | ( (uint64_t) slot << shift );
+    queue->slots[level][slot] = NULL;
+    REGISTRY_UNSET( queue->occupied[level], slot );
+
+    current->prev->next = NULL;
+    while ( current != NULL )
+    {
+        next = current->next;
+        place( queue, current );
+        current = next;
+    }
+}
+
+/**
+ * Moves now back to an earlier time.  Nodes on levels above the highest
+ * digit in which the two times differ keep their slots, as do those on that
+ * level itself, whose digit there exceeds both.  Nodes on the levels below
+ * all share the old now's digit there, so those levels are spliced whole
+ * into its slot.
+ *
+ * @param queue Queue in which to operate
+ * @param time  New current time, earlier than now
+ */
+static void rewind_to( timing_wheel *queue, uint64_t time )
+{
+    uint32_t top = LEVEL_OF( time ^ queue->now );
+    uint32_t slot = (uint32_t) ( ( queue->now >> ( top * WHEEL_BITS ) ) &
+        WHEEL_MASK );
+    wheel_node **target = &queue->slots[top][slot];
+    uint32_t level, i;
+    uint64_t bits;
+
+    for ( level = 0; level < top; level++ )
+    {
+        bits = queue->occupied[level];
+        while ( bits )
+        {
+            i = REGISTRY_LEADER( bits );
+            REGISTRY_UNSET( bits, i );
+            list_splice( target, queue->slots[level][i] );
+            queue->slots[level][i] = NULL;
+        }
+        queue->occupied[level] = 0;
+    }
+
+    if ( *target != NULL )
+        REGISTRY_SET( queue->occupied[top], slot );
+    // only level 0 slots are ever sorted, and they have all moved up
+    if ( top > 0 )
+        queue->sorted = NULL;
+    queue->now = time;
+}
+
+/**
+ * Appends a node to the end of a circular list.
+ *
+ * @param list  Head pointer of the list
+ * @param node  Node to append
+ */
+static void list_link( wheel_node **list, wheel_node *node )
+{
+    wheel_node *head = *list;
+
+    if ( head == NULL )
+    {
+        node->next = node;
+        node->prev = node;
+        *list = node;
+        return;
+    }
+
+    node->next = head;
+    node->prev = head->prev;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+/**
+ * Removes a node from a circular list, advancing the head if necessary.
+ *
+ * @param list  Head pointer of the list
+ * @param node  Node to remove
+ */
+static void list_unlink( wheel_node **list, wheel_node *node )
+{
+    if ( node->next == node )
+    {
+        *list = NULL;
+        return;
+    }
+
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    if ( *list == node )
+        *list = node->next;
+}
+
+/**
+ * Appends an entire circular list to the end of another.
+ *
+ * @param dst   Head pointer of the list to extend
+ * @param src   Head of the list to append
+ */
+static void list_splice( wheel_node **dst, wheel_node *src )
+{
+    wheel_node *dst_tail, *src_tail;
+
+    if ( src == NULL )
+        return;
+
+    if ( *dst == NULL )
+    {
+        *dst = src;
+        return;
+    }
+
+    dst_tail = (*dst)->prev;
+    src_tail = src->prev;
+    dst_tail->next = src;
+    src->prev = dst_tail;
+    src_tail->next = *dst;
+    (*dst)->prev = src_tail;
+}
+
+/**
+ * Inserts a node into a circular list kept sorted by key.  Searches from the
+ * tail, since new nodes usually carry the largest tie-breaking bits.
+ *
+ * @param list  Head pointer of the sorted list
+ * @param node  Node to insert
+ */
+static void list_insert_sorted( wheel_node **list, wheel_node *node )
+{
+    wheel_node *current;
+
+    if ( *list == NULL || node->key < (*list)->key )
+    {
+        list_link( list, node );
+        *list = node;
+        return;
+    }
+
+    current = (*list)->prev;
+    while ( node->key < current->key )
+        current = current->prev;
+
+    node->next = current->next;
+    node->prev = current;
+    current->next->prev = node;
+    current->next = node;
+}
+
+/**
+ * Sorts a circular list by key with a bottom-up merge sort.
+ *
+ * @param list  Head pointer of the list to sort
+ */
+static void list_sort( wheel_node **list )
+{
+    wheel_node *head = *list;
+    wheel_node *tail, *p, *q, *next;
+    uint32_t width, merges, p_size, q_size;
+
+    if ( head == NULL || head->next == head )
+        return;
+
+    head->prev->next = NULL;
+    for ( width = 1; ; width <<= 1 )
+    {
+        p = head;
+        head = NULL;
+        tail = NULL;
+        merges = 0;
+
+        while ( p != NULL )
+        {
+            merges++;
+            q = p;
+            for ( p_size = 0; p_size < width && q != NULL; p_size++ )
+                q = q->next;
+            q_size = width;
+
+            while ( p_size > 0 || ( q_size > 0 && q != NULL ) )
+            {
+                if ( p_size == 0 || ( q_size > 0 && q != NULL &&
+                        q->key < p->key ) )
+                {
+                    next = q;
+                    q = q->next;
+                    q_size--;
+                }
+                else
+                {
+                    next = p;
+                    p = p->next;
+                    p_size--;
+                }
+
+                if ( tail == NULL )
+                    head = next;
+                else
+                    tail->next = next;
+                next->prev = tail;
+                tail = next;
+            }
+            p = q;
+        }
+        tail->next = NULL;
+
+        if ( merges <= 1 )
+            break;
+    }
+
+    head->prev = tail;
+    tail->next = head;
+    *list = head;
+}
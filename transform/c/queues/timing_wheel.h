@@ -0,0 +1,202 @@
+#ifndef TIMING_WHEEL
+#define TIMING_WHEEL
+
+//==============================================================================
+// DEFINES, INCLUDES, and STRUCTS
+//==============================================================================
+
+#include "queue_common.h"
+
+// keys are placed by their high bits, the expiry time; the low bits only
+// break ties
+#ifndef WHEEL_KEY_SHIFT
+    #define WHEEL_KEY_SHIFT 32
+#endif
+// log2 of the number of slots per level; one slot bitmap word per level
+#define WHEEL_BITS          6
+#define WHEEL_SLOTS         ( 1 << WHEEL_BITS )
+#define WHEEL_MASK          ( WHEEL_SLOTS - 1 )
+// enough levels to cover every time below 2^(64 - WHEEL_KEY_SHIFT)
+#define WHEEL_LEVELS        ( ( 64 - WHEEL_KEY_SHIFT + WHEEL_BITS - 1 ) / \
+                                WHEEL_BITS )
+
+/**
+ * Holds an inserted element, as well as pointers to maintain its place in a
+ * slot.  Acts as a handle to clients for the purpose of mutability.  Each
+ * slot is a circular doubly linked list, so the prev pointer of the first
+ * node in a slot points to the last.
+ */
+struct wheel_node_t
+{
+    //! Next node in this node's slot
+    struct wheel_node_t *next;
+    //! Previous node in this node's slot
+    struct wheel_node_t *prev;
+
+    //! Pointer to a piece of client data
+    item_type item;
+    //! Key for the item
+    key_type key;
+} __attribute__ ((aligned(4)));
+
+typedef struct wheel_node_t wheel_node;
+typedef wheel_node pq_node_type;
+
+/**
+ * A mutable hierarchical timing wheel, after Varghese and Lauck.  Times, the
+ * key bits above WHEEL_KEY_SHIFT, are read as base-WHEEL_SLOTS numbers, and
+ * level l holds the nodes whose time first differs from the current time now
+ * in digit l, in the slot given by that digit.  Level 0 thus holds one time
+ * per slot, and a node's place follows from its key and now alone, so nodes
+ * need no back pointers.  Scheduling and cancelling are O(1).
+ *
+ * Expiring the minimum takes the first occupied slot of level 0.  If level 0
+ * is empty, now advances to the start of the first occupied slot of the
+ * lowest non-empty level, and that slot cascades down to the levels below
+ * it; a node cascades at most once per level on its way to expiry.  Ties on
+ * time are broken by sorting a level 0 slot by full key when it is first
+ * reached and keeping it sorted while it remains the minimum, as in
+ * bucket_queue.  A bitmap word per level lets the search skip empty slots.
+ *
+ * A time earlier than now, which a timer subsystem never schedules, is still
+ * supported: now moves back to it and the levels below the first digit in
+ * which they differ are spliced whole into one slot, at a cost of
+ * O(WHEEL_LEVELS * WHEEL_SLOTS).
+ */
+struct timing_wheel_t
+{
+    //! Memory map to use for node allocation
+    mem_map *map;
+    //! The number of items held in the queue
+    uint32_t size;
+    //! Current time; no node holds an earlier one
+    uint64_t now;
+    //! Cached minimum node, or NULL if it must be recomputed
+    wheel_node *minimum;
+    //! Head pointer of the level 0 slot kept sorted by key, or NULL if none is
+    wheel_node **sorted;
+    //! One bit per slot of each level, set if the slot is non-empty
+    uint64_t occupied[WHEEL_LEVELS];
+    //! Heads of the slot lists
+    wheel_node *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+} __attribute__ ((aligned(4)));
+
+typedef struct timing_wheel_t timing_wheel;
+typedef timing_wheel pq_type;
+
+//==============================================================================
+// PUBLIC DECLARATIONS
+//==============================================================================
+
+/**
+ * Creates a new, empty queue, with its own arena carved from the given map.
+ *
+ * @param map   Memory map from which to carve the arena for its nodes
+ * @return      Pointer to the new queue
+ */
+timing_wheel* pq_create( mem_map *map );
+
+/**
+ * Frees all the memory used by the queue.
+ *
+ * @param queue Queue to destroy
+ */
+void pq_destroy( timing_wheel *queue );
+
+/**
+ * Deletes all nodes, leaving the queue empty.
+ *
+ * @param queue Queue to clear
+ */
+void pq_clear( timing_wheel *queue );
+
+/**
+ * Returns the key associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's key
+ */
+key_type pq_get_key( timing_wheel *queue, wheel_node *node );
+
+/**
+ * Returns the item associated with the queried node.
+ *
+ * @param queue Queue to which node belongs
+ * @param node  Node to query
+ * @return      Node's item
+ */
+item_type* pq_get_item( timing_wheel *queue, wheel_node *node );
+
+/**
+ * Returns the current size of the queue.
+ *
+ * @param queue Queue to query
+ * @return      Size of queue
+ */
+uint32_t pq_get_size( timing_wheel *queue );
+
+/**
+ * Takes an item-key pair to insert it into the queue and creates a new
+ * corresponding node.  Links the node into the slot for its time, moving now
+ * back first if the time lies before it.
+ *
+ * @param queue Queue to insert into
+ * @param item  Item to insert
+ * @param key   Key to use for node priority
+ * @return      Pointer to corresponding node
+ */
+wheel_node* pq_insert( timing_wheel *queue, item_type item, key_type key );
+
+/**
+ * Returns the minimum item from the queue.  Cascades higher levels down
+ * until level 0 is occupied, then sorts its first occupied slot if needed,
+ * and caches the result.
+ *
+ * @param queue Queue to query
+ * @return      Node with minimum key
+ */
+wheel_node* pq_find_min( timing_wheel *queue );
+
+/**
+ * Deletes the minimum item from the queue and returns it.  Relies on
+ * @ref <pq_find_min> to locate it and @ref <pq_delete> to unlink it.
+ *
+ * @param queue Queue to query
+ * @return      Minimum key, corresponding to item deleted
+ */
+key_type pq_delete_min( timing_wheel *queue );
+
+/**
+ * Deletes an arbitrary item from the queue.  Requires that the location of
+ * the item's corresponding node is known.  Unlinks the node from the slot
+ * its key and now place it in.
+ *
+ * @param queue Queue in which the node resides
+ * @param node  Pointer to node corresponding to the item to delete
+ * @return      Key of item deleted
+ */
+key_type pq_delete( timing_wheel *queue, wheel_node *node );
+
+/**
+ * If the item in the queue is modified in such a way to decrease the
+ * key, then this function will update the queue to preserve queue
+ * properties given a pointer to the corresponding node.  Unlinks the node
+ * and links it back in under its new key.
+ *
+ * @param queue     Queue in which the node resides
+ * @param node      Node to change
+ * @param new_key   New key to use for the given node
+ */
+void pq_decrease_key( timing_wheel *queue, wheel_node *node,
+    key_type new_key );
+
+/**
+ * Determines whether the queue is empty, or if it holds some items.
+ *
+ * @param queue Queue to query
+ * @return      True if queue holds nothing, false otherwise
+ */
+bool pq_empty( timing_wheel *queue );
+
+#endif
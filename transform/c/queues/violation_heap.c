@@ -5,16 +5,19 @@
 //==============================================================================
 
 static void merge_into_roots( violation_heap *queue, violation_node *list );
+static void add_pending( violation_heap *queue, violation_node *list );
+static void remove_root( violation_heap *queue, violation_node *node );
 static violation_node* triple_join( violation_heap *queue, violation_node *a,
     violation_node *b, violation_node *c );
 static violation_node* join( violation_heap *queue, violation_node *parent,
     violation_node *child1, violation_node *child2 );
 static void fix_roots( violation_heap *queue );
 static bool attempt_insert( violation_heap *queue, violation_node *node );
+static void unregister_root( violation_heap *queue, violation_node *node );
 static void set_min( violation_heap *queue );
-static violation_node* find_prev_root( violation_heap *queue, violation_node *node );
 static void propagate_ranks( violation_heap *queue, violation_node *node );
-static void strip_list( violation_heap *queue, violation_node *node );
+static violation_node* strip_list( violation_heap *queue,
+    violation_node *node );
 static bool is_active( violation_heap *queue, violation_node *node );
 static violation_node* get_parent( violation_heap *queue, violation_node *node );
 static int is_root( violation_heap *queue, violation_node *node );
@@ -26,7 +29,7 @@ static int is_root( violation_heap *queue, violation_node *node );
 violation_heap* pq_create( mem_map *map )
 {
     violation_heap *queue = calloc( 1, sizeof( violation_heap ) );
-    queue->map = map;
+    queue->map = mm_create_arena( map );
 
     return queue;
 }
@@ -34,6 +37,7 @@ violation_heap* pq_create( mem_map *map )
 void pq_destroy( violation_heap *queue )
 {
     pq_clear( queue );
+    mm_destroy( queue->map );
     free( queue );
 }
 
@@ -41,8 +45,9 @@ void pq_clear( violation_heap *queue )
 {
     mm_clear( queue->map );
     queue->minimum = NULL;
-    memset( queue->roots, 0, 2 * MAXRANK * sizeof( violation_node* ) );
-    queue->largest_rank = 0;
+    queue->pending = NULL;
+    queue->registry = 0;
+    queue->pairs = 0;
     queue->size = 0;
 }
 
@@ -67,13 +72,12 @@ violation_node* pq_insert( violation_heap *queue, item_type item, key_type key )
     ITEM_ASSIGN( wrapper->item, item );
     wrapper->key = key;
     wrapper->next = wrapper;
+    wrapper->prev = wrapper;
+    wrapper->type = VIOLATION_TYPE_PENDING;
     queue->size++;
 
     merge_into_roots( queue, wrapper );
 
-    if ( ( queue->minimum == NULL ) || ( key < queue->minimum->key ) )
-        queue->minimum = wrapper;
-
     return wrapper;
 }
 
@@ -92,13 +96,9 @@ key_type pq_delete_min( violation_heap *queue )
 key_type pq_delete( violation_heap *queue, violation_node *node )
 {
     key_type key = node->key;
-    violation_node *prev;
 
     if ( is_root( queue, node ) )
-    {
-        prev = find_prev_root( queue, node );
-        prev->next = node->next;
-    }
+        remove_root( queue, node );
     else
     {
         if ( node->next->child == node )
@@ -110,20 +110,13 @@ key_type pq_delete( violation_heap *queue, violation_node *node )
             node->prev->next = node->next;
     }
 
-    if ( queue->minimum == node )
-    {
-        if ( node->next != node )
-            queue->minimum = node->next;
-        else
-            queue->minimum = node->child;
-    }
-
     if ( node->child != NULL )
-    {
-        strip_list( queue, node->child );
-        merge_into_roots( queue, node->child );
-    }
-    fix_roots( queue );
+        add_pending( queue, strip_list( queue, node->child ) );
+
+    // the children cannot precede the minimum, so the roots need only be
+    // consolidated when the minimum itself goes
+    if ( queue->minimum == node )
+        fix_roots( queue );
 
     pq_free_node( queue->map, 0, node );
     queue->size--;
@@ -140,7 +133,7 @@ void pq_decrease_key( violation_heap *queue, violation_node *node,
 
     if( is_root( queue, node ) )
     {
-        if ( node->key < queue->minimum->key )
+        if ( PQ_KEY_BEFORE( node->key, queue->minimum->key ) )
             queue->minimum = node;
         return;
     }
@@ -149,7 +142,7 @@ void pq_decrease_key( violation_heap *queue, violation_node *node,
         if ( is_active( queue, node ) )
         {
             parent = get_parent( queue, node );
-            if ( !( node->key < parent->key ) )
+            if ( !PQ_KEY_BEFORE( node->key, parent->key ) )
                 return;
         }
         first_child = node->child;
@@ -211,7 +204,8 @@ void pq_decrease_key( violation_heap *queue, violation_node *node,
 
         // make node a root
         node->next = node;
-        node->prev = NULL;
+        node->prev = node;
+        node->type = VIOLATION_TYPE_PENDING;
         merge_into_roots( queue, node );
     }
 }
@@ -226,24 +220,68 @@ bool pq_empty( violation_heap *queue )
 //==============================================================================
 
 /**
- * Merges a new node list into the root list.
+ * Merges a new node list into the root list, making its head the minimum if
+ * it comes first.
  *
  * @param queue Queue to merge list into
  * @param list  List to merge
  */
-void merge_into_roots( violation_heap *queue, violation_node *list )
+static void merge_into_roots( violation_heap *queue, violation_node *list )
 {
-    violation_node *temp;
-    if ( queue->minimum == NULL )
+    add_pending( queue, list );
+    if ( ( queue->minimum == NULL ) ||
+            PQ_KEY_BEFORE( list->key, queue->minimum->key ) )
         queue->minimum = list;
-    else if ( ( list != NULL ) && ( queue->minimum != list ) )
+}
+
+/**
+ * Splices a circular list of new roots into the front of the list of roots
+ * awaiting consolidation.  Consolidating the newest roots first joins far
+ * fewer trees on decrease-heavy workloads than taking them in arrival order.
+ *
+ * @param queue Queue to merge list into
+ * @param list  List to merge, or NULL
+ */
+static void add_pending( violation_heap *queue, violation_node *list )
+{
+    violation_node *head, *tail;
+
+    if ( list == NULL )
+        return;
+    if ( queue->pending == NULL )
     {
-        temp = queue->minimum->next;
-        queue->minimum->next = list->next;
-        list->next = temp;
+        queue->pending = list;
+        return;
+    }
+
+    head = queue->pending;
+    tail = head->prev;
+    tail->next = list;
+    head->prev = list->prev;
+    list->prev->next = head;
+    list->prev = tail;
+    queue->pending = list;
+}
 
-        if ( list->key < queue->minimum->key )
-            queue->minimum = list;
+/**
+ * Removes a root from the registry or from the list of pending roots,
+ * whichever holds it.
+ *
+ * @param queue Queue in which the node resides
+ * @param node  Root to remove
+ */
+static void remove_root( violation_heap *queue, violation_node *node )
+{
+    if ( node->type == VIOLATION_TYPE_RANKED )
+        unregister_root( queue, node );
+    else if ( node->next == node )
+        queue->pending = NULL;
+    else
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        if ( queue->pending == node )
+            queue->pending = node->next;
     }
 }
 
@@ -261,9 +299,9 @@ static violation_node* triple_join( violation_heap *queue, violation_node *a,
 {
     violation_node *parent, *child1, *child2;
 
-    if ( a->key < b->key )
+    if ( PQ_KEY_BEFORE( a->key, b->key ) )
     {
-        if ( a->key < c->key )
+        if ( PQ_KEY_BEFORE( a->key, c->key ) )
         {
             parent = a;
             child1 = ( b->rank >= c->rank ) ? b : c;
@@ -278,7 +316,7 @@ static violation_node* triple_join( violation_heap *queue, violation_node *a,
     }
     else
     {
-        if ( b->key < c->key )
+        if ( PQ_KEY_BEFORE( b->key, c->key ) )
         {
             parent = b;
             child1 = ( a->rank >= c->rank ) ? a : c;
@@ -331,6 +369,8 @@ static violation_node* join( violation_heap *queue, violation_node *parent,
         }
     }
 
+    child1->type = VIOLATION_TYPE_CHILD;
+    child2->type = VIOLATION_TYPE_CHILD;
     child1->next = parent;
     child1->prev = child2;
     child2->next = child1;
@@ -346,78 +386,46 @@ static violation_node* join( violation_heap *queue, violation_node *parent,
 }
 
 /**
- * Iterates through roots and three-way joins trees of the same rank
- * until no three trees remain with the same rank.
+ * Iterates through the pending roots, inserting each into the registry and
+ * three-way joining trees of the same rank until no three trees remain with
+ * the same rank.  Then finds the new minimum among the registered roots.
  *
  * @param queue Queue whose roots to fix
  */
 static void fix_roots( violation_heap *queue )
 {
-    violation_node *current, *next, *head, *tail;
-    int i;
-    int32_t rank;
+    violation_node *current, *next;
+    uint32_t rank;
 
-    for ( i = 0; i <= queue->largest_rank; i++ )
+    if ( queue->pending != NULL )
     {
-        queue->roots[i][0] = NULL;
-        queue->roots[i][1] = NULL;
-    }
+        // break the circular list
+        current = queue->pending;
+        current->prev->next = NULL;
+        queue->pending = NULL;
 
-    if ( queue->minimum == NULL )
-        return;
-
-    head = queue->minimum->next;
-    queue->minimum->next = NULL;
-    tail = queue->minimum;
-    current = head;
-    while ( current != NULL )
-    {
-        next = current->next;
-        current->next = NULL;
-        if ( !attempt_insert( queue, current ) )
-        {
-            rank = current->rank;
-            tail->next = triple_join( queue, current, queue->roots[rank][0],
-                queue->roots[rank][1] );
-            if ( tail == current )
-                next = tail->next;
-            tail = tail->next;
-            queue->roots[rank][0] = NULL;
-            queue->roots[rank][1] = NULL;
-        }
-        current = next;
-    }
-
-    head = NULL;
-    tail = NULL;
-    for ( i = 0; i <= queue->largest_rank; i++ )
-    {
-        if ( queue->roots[i][0] != NULL )
-        {
-            if ( head == NULL )
-                head = queue->roots[i][0];
-            else
-                tail->next = queue->roots[i][0];
-            tail = queue->roots[i][0];
-        }
-        if ( queue->roots[i][1] != NULL )
+        while ( current != NULL )
         {
-            if ( head == NULL )
-                head = queue->roots[i][1];
-            else
-                tail->next = queue->roots[i][1];
-            tail = queue->roots[i][1];
+            next = current->next;
+            while ( !attempt_insert( queue, current ) )
+            {
+                rank = current->rank;
+                current = triple_join( queue, current, queue->roots[rank][0],
+                    queue->roots[rank][1] );
+                REGISTRY_UNSET( queue->registry, rank );
+                REGISTRY_UNSET( queue->pairs, rank );
+            }
+            current = next;
         }
     }
 
-    tail->next = head;
-
     set_min( queue );
 }
 
 /**
- * Attempt to insert a tree in the rank-indexed array.  Inserts if the
- * correct spot is empty, reports failure if it is occupied.
+ * Attempt to insert a tree in the rank-indexed registry.  Inserts if
+ * either slot for its rank is empty, reports failure if both are
+ * occupied.
  *
  * @param queue Queue to insert into
  * @param node  Node to insert
@@ -425,69 +433,74 @@ static void fix_roots( violation_heap *queue )
  */
 static bool attempt_insert( violation_heap *queue, violation_node *node )
 {
-    int32_t rank = node->rank;
-    if ( ( queue->roots[rank][0] != NULL ) && ( queue->roots[rank][0] != node ) )
+    uint32_t rank = node->rank;
+    if ( !OCCUPIED( queue->registry, rank ) )
     {
-        if ( ( queue->roots[rank][1] != NULL ) && ( queue->roots[rank][1] !=
-                node ) )
-            return FALSE;
-        else
-            queue->roots[rank][1] = node;
+        queue->roots[rank][0] = node;
+        REGISTRY_SET( queue->registry, rank );
+    }
+    else if ( !OCCUPIED( queue->pairs, rank ) )
+    {
+        queue->roots[rank][1] = node;
+        REGISTRY_SET( queue->pairs, rank );
     }
     else
-        queue->roots[rank][0] = node;
-
-    if ( rank > queue->largest_rank )
-        queue->largest_rank = rank;
+        return FALSE;
 
+    node->type = VIOLATION_TYPE_RANKED;
     return TRUE;
 }
 
 /**
- * Scans through the roots array to find the tree with the minimum-value
- * root.
+ * Removes a root from the registry slot for its current rank, moving the
+ * other root of that rank, if any, into the first slot.
  *
- * @param queue Queue to fix
+ * @param queue Queue in which the node resides
+ * @param node  Registered root to remove
  */
-static void set_min( violation_heap *queue )
+static void unregister_root( violation_heap *queue, violation_node *node )
 {
-    int i;
-    queue->minimum = NULL;
-    for ( i = 0; i <= queue->largest_rank; i++ )
-    {
-        if ( queue->roots[i][0] != NULL )
-        {
-            if ( queue->minimum == NULL )
-                queue->minimum = queue->roots[i][0];
-            else if ( queue->roots[i][0]->key < queue->minimum->key )
-                queue->minimum = queue->roots[i][0];
-        }
-        if ( queue->roots[i][1] != NULL )
-        {
-            if ( queue->minimum == NULL )
-                queue->minimum = queue->roots[i][1];
-            else if ( queue->roots[i][1]->key < queue->minimum->key )
-                queue->minimum = queue->roots[i][1];
-        }
-    }
+    uint32_t rank = node->rank;
+    if ( queue->roots[rank][0] == node )
+        queue->roots[rank][0] = queue->roots[rank][1];
+
+    if ( OCCUPIED( queue->pairs, rank ) )
+        REGISTRY_UNSET( queue->pairs, rank );
+    else
+        REGISTRY_UNSET( queue->registry, rank );
 }
 
 /**
- * Loops around a singly-linked list of roots to find the root prior to
- * the specified node.
+ * Scans the occupied ranks of the registry to find the tree with the
+ * minimum-value root.  Assumes no roots are pending.
  *
- * @param queue The queue in which the node resides
- * @param node  The specified node to start from
- * @return      The node prior to the start
+ * @param queue Queue to fix
  */
-static violation_node* find_prev_root( violation_heap *queue,
-    violation_node *node )
+static void set_min( violation_heap *queue )
 {
-    violation_node *prev = node->next;
-    while ( prev->next != node )
-        prev = prev->next;
+    uint64_t occupied = queue->registry;
+    violation_node *minimum = NULL;
+    violation_node *candidate;
+    uint32_t rank;
 
-    return prev;
+    while ( occupied )
+    {
+        rank = REGISTRY_LEADER( occupied );
+        REGISTRY_UNSET( occupied, rank );
+
+        candidate = queue->roots[rank][0];
+        if ( ( minimum == NULL ) ||
+                PQ_KEY_BEFORE( candidate->key, minimum->key ) )
+            minimum = candidate;
+        if ( OCCUPIED( queue->pairs, rank ) )
+        {
+            candidate = queue->roots[rank][1];
+            if ( PQ_KEY_BEFORE( candidate->key, minimum->key ) )
+                minimum = candidate;
+        }
+    }
+
+    queue->minimum = minimum;
 }
 
 /**
@@ -519,7 +532,21 @@ static void propagate_ranks( violation_heap *queue, violation_node *node )
     else
         new_rank = ( ( total / 2 ) + ( total % 2 ) + 1 );
     updated = new_rank < node->rank;
-    node->rank = new_rank;
+    if ( ( node->type == VIOLATION_TYPE_RANKED ) && ( new_rank != node->rank ) )
+    {
+        // keep the registry indexed by the root's new rank
+        unregister_root( queue, node );
+        node->rank = new_rank;
+        if ( !attempt_insert( queue, node ) )
+        {
+            node->next = node;
+            node->prev = node;
+            node->type = VIOLATION_TYPE_PENDING;
+            add_pending( queue, node );
+        }
+    }
+    else
+        node->rank = new_rank;
 
     if ( updated && is_active( queue, node ) )
     {
@@ -530,22 +557,28 @@ static void propagate_ranks( violation_heap *queue, violation_node *node )
 }
 
 /**
- * Converts a doubly-linked list into a circular singly-linked list.
+ * Converts a list of siblings into a circular list of pending roots.
  *
  * @param queue Queue in which node resides
  * @param node  Last node in the list
+ * @return      The converted list
  */
-static void strip_list( violation_heap *queue, violation_node *node )
+static violation_node* strip_list( violation_heap *queue,
+    violation_node *node )
 {
     violation_node *current = node;
-    violation_node *prev;
-    while ( current->prev != NULL )
+    violation_node *first;
+    do
     {
-        prev = current->prev;
-        current->prev = NULL;
-        current = prev;
-    }
-    node->next = current;
+        current->type = VIOLATION_TYPE_PENDING;
+        first = current;
+        current = current->prev;
+    } while ( current != NULL );
+
+    first->prev = node;
+    node->next = first;
+
+    return node;
 }
 
 /**
@@ -583,10 +616,10 @@ static bool is_active( violation_heap *queue, violation_node *node )
  */
 static violation_node* get_parent( violation_heap *queue, violation_node *node )
 {
-    if ( node->next->child == node )
-        return node->next;
-    else if ( ( node->prev == NULL ) && ( node->next->prev == NULL ) )
+    if ( is_root( queue, node ) )
         return NULL;
+    else if ( node->next->child == node )
+        return node->next;
     else
         return ( get_parent( queue, node->next ) );
 }
@@ -600,6 +633,5 @@ static violation_node* get_parent( violation_heap *queue, violation_node *node )
  */
 static int is_root( violation_heap *queue, violation_node *node )
 {
-    return ( ( node->prev == NULL ) && ( node->next->prev == NULL ) &&
-        ( node->next->child != node ) );
+    return ( node->type != VIOLATION_TYPE_CHILD );
 }
@@ -5,6 +5,11 @@
 // DEFINES, INCLUDES, and STRUCTS
 //==============================================================================
 
+// child, root awaiting consolidation, root held in the rank registry
+#define VIOLATION_TYPE_CHILD    0
+#define VIOLATION_TYPE_PENDING  1
+#define VIOLATION_TYPE_RANKED   2
+
 #include "queue_common.h"
 
 /**
@@ -13,7 +18,9 @@
 * mutability.  Tracks rank of node as well as pointers to this node's
 * first child and the next and previous nodes in the list of siblings.
 * The last node in the list of siblings will have a null prev pointer
-* and the first node's next pointer will point to their parent.
+* and the first node's next pointer will point to their parent.  Roots
+* awaiting consolidation use next and prev for a circular list instead,
+* and roots held in the rank registry leave them unused.
 */
 struct violation_node_t
 {
@@ -25,7 +32,9 @@ struct violation_node_t
     struct violation_node_t *prev;
 
     //! The number of children this node has
-    int32_t rank;
+    uint32_t rank:30;
+    //! Whether this node is a child, a pending root, or a ranked root
+    uint32_t type:2;
 
     //! Pointer to a piece of client data
     item_type item;
@@ -38,8 +47,9 @@ typedef violation_node pq_node_type;
 
 /**
  * A mutable, meldable, violation queue.  Maintains a forest of trees indexed by
- * rank.  At most two trees of each rank remain after a @ref <pq_delete> or @ref
- * <pq_delete_min> operation.
+ * rank.  New roots wait in a circular list until the minimum is deleted, when
+ * they are consolidated into the rank registry.  At most two trees of each rank
+ * remain after a @ref <pq_delete_min> operation.
  */
 struct violation_heap_t
 {
@@ -49,10 +59,14 @@ struct violation_heap_t
     uint32_t size;
     //! Pointer to the minimum node in the queue
     violation_node* minimum;
+    //! Roots added since the last consolidation
+    violation_node* pending;
     //! An array of roots of the queue, indexed by rank
     violation_node* roots[MAXRANK][2];
-    //! Current largest rank in queue
-    uint32_t largest_rank;
+    //! Ranks with at least one root in the registry
+    uint64_t registry;
+    //! Ranks with two roots in the registry
+    uint64_t pairs;
 } __attribute__ ((aligned(4)));
 
 typedef struct violation_heap_t violation_heap;
@@ -63,9 +77,9 @@ typedef violation_heap pq_type;
 //==============================================================================
 
 /**
- * Creates a new, empty queue.
+ * Creates a new, empty queue, with its own arena carved from the given map.
  *
- * @param map   Memory map to use for node allocation
+ * @param map   Memory map from which to carve the arena for its nodes
  * @return      Pointer to the new queue
  */
 violation_heap* pq_create( mem_map *map );
@@ -142,8 +156,8 @@ key_type pq_delete_min( violation_heap *queue );
  * Removes an arbitrary item from the queue and modifies queue structure
  * to preserve queue properties.  Requires that the location of the
  * item's corresponding node is known.  Merges the node's children with
- * the root list.  Merges roots such that no more than two roots have
- * the same rank.
+ * the root list.  If the node was the minimum, merges roots such that no
+ * more than two roots have the same rank.
  *
  * @param queue Queue in which the node resides
  * @param node  Pointer to node corresponding to the item to remove
@@ -13,6 +13,6 @@ long h_current_pos,
 node *node_j,
      *node_k;
 
-double key_k,
-       key_min;
+int64_t key_k,
+        key_min;
 
@@ -43,6 +43,8 @@
 #endif
 
 #include "../../trace_tools.h"
+#include "../../graph_tools.h"
+#include "../../dimacs_tools.h"
 #include "types_ni.h"
 #include "heap.h"
 #include "heap.c"
@@ -133,6 +135,8 @@ node *last_node;
 
 
 #include "parser_ni.c"
+#include "parser_ni_bin.c"
+#include "parser_ni_mt.c"
 
 void printGraph ()
 /* used for debuggeing */
@@ -346,7 +350,7 @@ void *phase ( node *v )
 /***CH5***/
     op_insert.node_id = v - nodes;
     op_insert.item = v - nodes;
-    op_insert.key = MAX_INT64 - v->key;
+    op_insert.key = v->key;
     pq_trace_write_op( trace_file, &op_insert );
     header.op_count++;
     header.node_ids++;
@@ -393,7 +397,7 @@ void *phase ( node *v )
 /***CH5***/
     op_insert.node_id = w - nodes;
     op_insert.item = w - nodes;
-    op_insert.key = MAX_INT64 - w->key;
+    op_insert.key = w->key;
     pq_trace_write_op( trace_file, &op_insert );
     header.op_count++;
     header.node_ids++;
@@ -404,7 +408,7 @@ void *phase ( node *v )
 	  increaseKey ( h, w, w->key );
 /***CH5***/
     op_decrease_key.node_id = w - nodes;
-    op_decrease_key.key = MAX_INT64 - w->key;
+    op_decrease_key.key = w->key;
     pq_trace_write_op( trace_file, &op_decrease_key );
     header.op_count++;
 	}
@@ -801,6 +805,9 @@ char *argv[];
   header.op_count = 0;
   header.pq_ids = 1;
   header.node_ids = 0;
+  /* ni extracts maxima, so the keys are written as they are and the trace
+     is replayed on max-ordered queues */
+  header.flags = PQ_TRACE_MAX_ORDER;
   op_create.pq_id = 0;
   op_destroy.pq_id = 0;
   op_insert.pq_id = 0;
@@ -827,7 +834,11 @@ char *argv[];
     pq_trace_write_op( trace_file, &op_create );
     header.op_count++;
     
-  parse ();
+  /* a second argument names a graph converted by gr_converter */
+  if ( argc > 2 )
+    parse_bin ( argv[2] );
+  else
+    parse_mt ();
 /***CH5**/
 
 
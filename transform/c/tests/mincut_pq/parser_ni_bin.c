@@ -0,0 +1,117 @@
+/* loader for mincut problems converted to binary by gr_converter;
+   the arcs are linked in their original input order, so the adjacency
+   lists, and therefore the traces, match those built by parse () */
+
+int parse_bin ( path )
+
+char *path;
+
+{
+
+pq_graph graph;
+
+long    n,                      /* internal number of nodes */
+        m,                      /* internal number of arcs */
+        node_min,               /* minimal no of node  */
+        node_max,               /* maximal no of nodes */
+        i, u, position, last;
+
+long   *in_tail,                /* arcs in input order */
+       *in_head;
+int64_t *in_cap;
+
+node    *pnodes,                 /* pointers to the node structure */
+        *i_n,
+        *j_n;
+
+arc     *parcs,
+        *arc_current, *r_arc_current;
+
+if ( pq_graph_map ( path, &graph ) ||
+     !( graph.header.flags & PQ_GRAPH_CUT ) )
+  {
+    fprintf ( stderr, "\n%s is not a mincut graph file\n", path );
+    exit (1);
+  }
+
+input_n  = graph.header.declared_nodes;
+input_m  = graph.header.arc_count;
+node_min = graph.header.node_min;
+node_max = node_min + graph.header.node_count - 1;
+
+n = input_n + 1;
+m = 2 * input_m;
+
+/* allocating memory */
+pnodes  = (node *) calloc ( n+1, sizeof(node) );
+parcs   = (arc *)  calloc ( m+3, sizeof(arc) );
+in_tail = (long *) malloc ( input_m * sizeof(long) );
+in_head = (long *) malloc ( input_m * sizeof(long) );
+in_cap  = (int64_t *) malloc ( input_m * sizeof(int64_t) );
+
+if ( pnodes == NULL || parcs == NULL || in_tail == NULL ||
+     in_head == NULL || in_cap == NULL )
+  {
+    fprintf ( stderr, "\ncan't obtain enough memory to solve this problem\n" );
+    exit (1);
+  }
+
+/* restoring input order from the tail-grouped arrays */
+for ( u = 0; u < graph.header.node_count; u++ )
+  {
+    last = pq_graph_offset ( &graph, u + 1 );
+    for ( position = pq_graph_offset ( &graph, u ); position < last;
+          position++ )
+      {
+        i = graph.ids[position];
+        in_tail[i] = node_min + u;
+        in_head[i] = node_min + graph.heads[position];
+        in_cap[i]  = pq_graph_weight ( &graph, position );
+      }
+  }
+
+pq_graph_unmap ( &graph );
+
+for ( i_n = pnodes; i_n < pnodes + n + 1; i_n++ )
+  i_n -> first = NULL;
+
+/* setting pointer to the first arc */
+sentinel_arc = parcs + input_m + 1;
+r_arcs   = sentinel_arc + 1;
+arc_current = sentinel_arc - 1;
+r_arc_current = r_arcs;
+
+for ( i = 0; i < input_m; i++ )
+  {
+    i_n    = pnodes + in_tail[i];
+    j_n    = pnodes + in_head[i];
+
+    /* storing information about the arc */
+    arc_current       -> head    = j_n;
+    arc_current       -> cap     = in_cap[i];
+    arc_current       -> next    = i_n -> first;
+    i_n -> first = arc_current;
+
+    r_arc_current -> head    = i_n;
+    r_arc_current -> cap     = in_cap[i];
+    r_arc_current -> next    = j_n -> first;
+    j_n -> first = r_arc_current;
+
+    arc_current --;
+    r_arc_current ++;
+  }
+
+free ( in_tail ); free ( in_head ); free ( in_cap );
+
+sentinelNode = pnodes + node_max + 1;
+
+arcs = arc_current + 1;
+last_r_arc = r_arc_current - 1;
+nodes = pnodes + node_min;
+
+initInit ();
+
+return (0);
+
+}
+/* --------------------   end of binary loader  -------------------*/
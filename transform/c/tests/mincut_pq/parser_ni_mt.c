@@ -0,0 +1,94 @@
+/* drop-in replacement for parse () that scans the arc lines on all cores
+   with dimacs_tools; the arcs are then linked in input order, so the
+   adjacency lists, and therefore the traces, match those built by parse () */
+
+int parse_mt ( )
+
+{
+
+pq_dimacs graph;
+
+long    n,                      /* internal number of nodes */
+        m,                      /* internal number of arcs */
+        node_min,               /* minimal no of node  */
+        node_max,               /* maximal no of nodes */
+        i;
+
+node    *pnodes,                 /* pointers to the node structure */
+        *i_n,
+        *j_n;
+
+arc     *parcs,
+        *arc_current, *r_arc_current;
+
+if ( pq_dimacs_read ( 0, pq_dimacs_threads (), &graph ) )
+  exit (1);
+
+if ( strcmp ( graph.type, PROBLEM_TYPE ) )
+  {
+    fprintf ( stderr, "\nit is not a Min-cost problem line\n" );
+    exit (1);
+  }
+
+input_n = graph.declared_nodes;
+input_m = graph.arc_count;
+
+n = input_n + 1;
+m = 2 * input_m;
+
+node_min = graph.node_min < n ? graph.node_min : n;
+node_max = graph.node_max;
+
+/* allocating memory */
+pnodes    = (node *) calloc ( n+1, sizeof(node) );
+parcs     = (arc *)  calloc ( m+3, sizeof(arc) );
+
+if ( pnodes == NULL || parcs == NULL )
+  {
+    fprintf ( stderr, "\ncan't obtain enough memory to solve this problem\n" );
+    exit (1);
+  }
+
+for ( i_n = pnodes; i_n < pnodes + n + 1; i_n++ )
+  i_n -> first = NULL;
+
+/* setting pointer to the first arc */
+sentinel_arc = parcs + input_m + 1;
+r_arcs   = sentinel_arc + 1;
+arc_current = sentinel_arc - 1;
+r_arc_current = r_arcs;
+
+for ( i = 0; i < input_m; i++ )
+  {
+    i_n    = pnodes + graph.tails[i];
+    j_n    = pnodes + graph.heads[i];
+
+    /* storing information about the arc */
+    arc_current       -> head    = j_n;
+    arc_current       -> cap     = graph.weights[i];
+    arc_current       -> next    = i_n -> first;
+    i_n -> first = arc_current;
+
+    r_arc_current -> head    = i_n;
+    r_arc_current -> cap     = graph.weights[i];
+    r_arc_current -> next    = j_n -> first;
+    j_n -> first = r_arc_current;
+
+    arc_current --;
+    r_arc_current ++;
+  }
+
+pq_dimacs_free ( &graph );
+
+sentinelNode = pnodes + node_max + 1;
+
+arcs = arc_current + 1;
+last_r_arc = r_arc_current - 1;
+nodes = pnodes + node_min;
+
+initInit ();
+
+return (0);
+
+}
+/* --------------------   end of multi-threaded parser  -------------------*/
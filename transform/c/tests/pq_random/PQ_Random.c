@@ -193,6 +193,7 @@ int main ( int argc, char** argv )
   header.op_count = 0;
   header.pq_ids = 1;
   header.node_ids = 1;
+  header.flags = 0;
   op_create.pq_id = 0;
   op_destroy.pq_id = 0;
   op_insert.pq_id = 0;
@@ -0,0 +1,136 @@
+/**
+ * Replays random inserts, deletions and decrease-keys on a ladder queue whose
+ * keys span more than 2^63, checking every minimum against a brute-force scan
+ * of the live keys.  A wide top makes the first rung take buckets of width
+ * 2^63, and keys inserted below the ladder once that rung is exhausted keep
+ * the bottom growing past LADDER_THRESHOLD, so that new rungs are spawned
+ * from it.
+ *
+ * usage: ladder_wide [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../queues/ladder_queue.h"
+
+#define ELEMENTS    4096
+#define ROUNDS      200000
+
+static pq_node_type *nodes[ELEMENTS];
+static key_type keys[ELEMENTS];
+static uint32_t live[ELEMENTS];
+static uint32_t live_count;
+
+static key_type random_key( uint32_t id )
+{
+    return ( (key_type) ( rand() % 4000000000u ) << 32 ) | id;
+}
+
+static uint32_t reference_min( void )
+{
+    uint32_t i, best = live[0];
+    for ( i = 1; i < live_count; i++ )
+        if ( PQ_KEY_BEFORE( keys[live[i]], keys[best] ) )
+            best = live[i];
+    return best;
+}
+
+static void remove_live( uint32_t slot )
+{
+    live[slot] = live[--live_count];
+}
+
+int main( int argc, char **argv )
+{
+    uint32_t seed = ( argc > 1 ) ? (uint32_t) atoi( argv[1] ) : 1;
+    uint32_t size = sizeof( pq_node_type );
+#ifdef USE_EAGER
+    uint32_t capacity = ELEMENTS;
+    mem_map *map = mm_create( 1, &size, &capacity );
+#else
+    mem_map *map = mm_create( 1, &size );
+#endif
+    pq_type *queue = pq_create( map );
+    uint32_t free_ids[ELEMENTS];
+    uint32_t free_count = ELEMENTS;
+    uint32_t i, id, slot, round;
+    item_type item = 0;
+
+    srand( seed );
+    for ( i = 0; i < ELEMENTS; i++ )
+        free_ids[i] = ELEMENTS - 1 - i;
+
+    // two keys spanning the whole range make a first rung of two buckets of
+    // width 2^63; taking the smaller one and looking at the larger hands both
+    // buckets down, leaving the rung exhausted above a bottom of one node
+    for ( i = 0; i < 2; i++ )
+    {
+        id = free_ids[--free_count];
+        keys[id] = ( (key_type) ( i ? 0xFFFFFFFF : 0x40000000 ) << 32 ) | id;
+        nodes[id] = pq_insert( queue, item, keys[id] );
+        live[live_count++] = id;
+    }
+    pq_delete_min( queue );
+    remove_live( 0 );
+    free_ids[free_count++] = 0;
+    pq_find_min( queue );
+
+    for ( round = 0; round < ROUNDS; round++ )
+    {
+        switch ( rand() % 4 )
+        {
+            case 0:
+            case 1:
+                if ( free_count == 0 )
+                    break;
+                id = free_ids[--free_count];
+                keys[id] = random_key( id );
+                nodes[id] = pq_insert( queue, item, keys[id] );
+                live[live_count++] = id;
+                break;
+            case 2:
+                if ( live_count == 0 )
+                    break;
+                slot = rand() % live_count;
+                id = live[slot];
+                if ( rand() % 2 )
+                {
+                    pq_delete( queue, nodes[id] );
+                    remove_live( slot );
+                    free_ids[free_count++] = id;
+                }
+                else if ( ( keys[id] >> 32 ) > 0 )
+                {
+                    keys[id] = ( (key_type) ( rand() % ( keys[id] >> 32 ) )
+                        << 32 ) | id;
+                    pq_decrease_key( queue, nodes[id], keys[id] );
+                }
+                break;
+            case 3:
+                if ( live_count == 0 )
+                    break;
+                id = reference_min();
+                if ( pq_find_min( queue ) != nodes[id] ||
+                        pq_get_key( queue, nodes[id] ) != keys[id] )
+                {
+                    fprintf( stderr, "seed %u round %u: minimum %016llx, "
+                        "expected %016llx\n", seed, round,
+                        (unsigned long long) pq_get_key( queue,
+                        pq_find_min( queue ) ),
+                        (unsigned long long) keys[id] );
+                    return 1;
+                }
+                pq_delete_min( queue );
+                for ( slot = 0; live[slot] != id; slot++ );
+                remove_live( slot );
+                free_ids[free_count++] = id;
+                break;
+        }
+    }
+
+    pq_destroy( queue );
+    mm_destroy( map );
+    printf( "ladder_wide: seed %u ok\n", seed );
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * Fills several queues from one memory map to the map's capacity, melds them
+ * one after another, and drains the result, checking every minimum against
+ * the sorted keys.  Nodes from the melded queues' storage are then freed by
+ * the result, more of them than a single queue's capacity, and reinserting
+ * half of them midway makes it hand the freed slots out again.
+ *
+ * usage: meld_drain [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef USE_STRICT_FIBONACCI
+    #include "../../queues/strict_fibonacci_heap.h"
+#else
+    #include "../../queues/quake_heap.h"
+#endif
+
+#define CAPACITY    64
+#define QUEUES      4
+#define ELEMENTS    ( CAPACITY * QUEUES )
+
+static int compare_keys( const void *a, const void *b )
+{
+    key_type x = *(const key_type*) a;
+    key_type y = *(const key_type*) b;
+    return ( x > y ) - ( x < y );
+}
+
+int main( int argc, char **argv )
+{
+    uint32_t seed = ( argc > 1 ) ? (uint32_t) atoi( argv[1] ) : 1;
+#ifdef USE_STRICT_FIBONACCI
+    uint32_t types = 2;
+    uint32_t sizes[2] = { sizeof( strict_fibonacci_node ),
+        sizeof( active_record ) };
+#else
+    uint32_t types = 1;
+    uint32_t sizes[1] = { sizeof( pq_node_type ) };
+#endif
+#ifdef USE_EAGER
+    uint32_t capacities[2] = { CAPACITY, CAPACITY };
+    mem_map *map = mm_create( types, sizes, capacities );
+#else
+    mem_map *map = mm_create( types, sizes );
+#endif
+    pq_type *queues[QUEUES];
+    pq_type *result;
+    key_type keys[ELEMENTS];
+    key_type found;
+    uint32_t i, j, round, next;
+    item_type item = 0;
+
+    srand( seed );
+    for ( round = 0; round < 8; round++ )
+    {
+        for ( i = 0; i < QUEUES; i++ )
+        {
+            queues[i] = pq_create( map );
+            for ( j = 0; j < CAPACITY; j++ )
+            {
+                keys[i * CAPACITY + j] = ( (key_type) rand() << 32 ) |
+                    ( i * CAPACITY + j );
+                pq_insert( queues[i], item, keys[i * CAPACITY + j] );
+            }
+        }
+
+        result = queues[0];
+        for ( i = 1; i < QUEUES; i++ )
+            result = pq_meld( result, queues[i] );
+        qsort( keys, ELEMENTS, sizeof( key_type ), compare_keys );
+
+        // take the smaller half, put it back, then drain everything
+        for ( next = 0; next < ELEMENTS / 2; next++ )
+            pq_delete_min( result );
+        for ( next = 0; next < ELEMENTS / 2; next++ )
+            pq_insert( result, item, keys[next] );
+
+        for ( next = 0; next < ELEMENTS; next++ )
+        {
+            found = pq_get_key( result, pq_find_min( result ) );
+            if ( found != keys[next] )
+            {
+                fprintf( stderr, "seed %u round %u: minimum %016llx, "
+                    "expected %016llx\n", seed, round,
+                    (unsigned long long) found,
+                    (unsigned long long) keys[next] );
+                return 1;
+            }
+            pq_delete_min( result );
+        }
+
+        if ( !pq_empty( result ) )
+        {
+            fprintf( stderr, "seed %u round %u: queue not empty\n", seed,
+                round );
+            return 1;
+        }
+        pq_destroy( result );
+    }
+
+    mm_destroy( map );
+    printf( "meld_drain: seed %u ok\n", seed );
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+/***********************************************************/
+/*                                                         */
+/*               Executor of SP codes                      */
+/*               (for A* with a geometric heuristic)       */
+/*                                                         */
+/***********************************************************/
+
+/* Usage: astarh trace_file coordinates [target] < problem.gr
+          astarh trace_file coordinates target problem.bin
+
+   Writes the trace of an A* search from the problem's source to the given
+   target, by default the last node.  The coordinates file gives a position
+   for every node in the DIMACS challenge 9 format, one "v id x y" line per
+   node, as distributed alongside the road networks.
+
+   The heuristic is the straight-line distance to the target scaled by the
+   smallest ratio of arc length to straight-line arc length over the whole
+   graph, and rounded down.  No arc is then shorter than the drop in the
+   heuristic along it, so the heuristic is consistent for any units the
+   coordinates and lengths are given in. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <math.h>
+
+/* statistical variables */
+long n_scans = 0;
+long n_impr = 0;
+
+/* definitions of types: node & arc */
+
+#include "types_dh.h"
+
+/* parser for getting extended DIMACS format input and transforming the
+   data to the internal representation */
+
+#include "parser_dh.c"
+
+/* loader for graphs converted to binary by gr_converter */
+
+#include "parser_bin.c"
+
+/* the same parser, scanning the input on all cores */
+
+#include "parser_dh_mt.c"
+
+/* function for searching a shortest path to the target */
+
+#include "astarh.c"
+
+static uint32_t* heuristic ( const char *path, long n, long nmin, node *ndp,
+    node *target );
+
+int main (int argc, char** argv)
+{
+    arc *arp;
+    node *ndp, *source, *target;
+    long n, m, nmin, t;
+    char name[21];
+    uint32_t *h;
+    uint64_t dist;
+    int trace_file;
+
+    if ( argc < 3 )
+    {
+        fprintf ( stderr, "Usage: %s trace_file coordinates [target "
+            "[problem.bin]]\n", argv[0] );
+        return -1;
+    }
+
+    trace_file = open ( argv[1], O_RDWR | O_CREAT | O_TRUNC, S_IRWXU );
+    if ( trace_file < 0 )
+    {
+        fprintf ( stderr, "Could not open file.\n" );
+        return -1;
+    }
+
+    if ( argc > 4 )
+        parse_bin ( argv[4], &n, &m, &ndp, &arp, &source, &nmin, name );
+    else
+        parse_mt ( &n, &m, &ndp, &arp, &source, &nmin, name );
+
+    t = ( argc > 3 ) ? atol ( argv[3] ) : nmin + n - 1;
+    if ( t < nmin || t >= nmin + n )
+    {
+        fprintf ( stderr, "Target %ld is not a node.\n", t );
+        return -1;
+    }
+    target = ndp + ( t - nmin );
+
+    h = heuristic ( argv[2], n, nmin, ndp, target );
+    dist = astarh ( trace_file, n, ndp, source, target, h );
+
+    printf ( "%s\n", name );
+    printf ( "scans: %ld\n", n_scans );
+    printf ( "improvements: %ld\n", n_impr );
+    if ( dist == VERY_FAR )
+        printf ( "distance: unreachable\n" );
+    else
+        printf ( "distance: %llu\n", (unsigned long long) dist );
+
+    close ( trace_file );
+    free ( h );
+
+    return 0;
+}
+
+/* Reads the node coordinates and returns the scaled, rounded down
+   straight-line distance from every node to the target.  Exits if the file
+   cannot be read or a node has no coordinates. */
+
+static uint32_t* heuristic ( const char *path, long n, long nmin, node *ndp,
+    node *target )
+{
+    FILE *file;
+    char line[256];
+    double *x, *y;
+    double length, estimate, px, py;
+    double scale = HUGE_VAL;
+    char *seen;
+    uint32_t *h;
+    long id, i, count = 0;
+    arc *a;
+
+    x = (double*) malloc ( n * sizeof ( double ) );
+    y = (double*) malloc ( n * sizeof ( double ) );
+    seen = (char*) calloc ( n, sizeof ( char ) );
+    h = (uint32_t*) malloc ( n * sizeof ( uint32_t ) );
+    if ( x == NULL || y == NULL || seen == NULL || h == NULL )
+    {
+        fprintf ( stderr, "Malloc fail.\n" );
+        exit ( -1 );
+    }
+
+    file = fopen ( path, "r" );
+    if ( file == NULL )
+    {
+        fprintf ( stderr, "Could not open %s.\n", path );
+        exit ( -1 );
+    }
+    while ( fgets ( line, sizeof ( line ), file ) != NULL )
+    {
+        if ( line[0] != 'v' )
+            continue;
+        if ( sscanf ( line + 1, "%ld %lf %lf", &id, &px, &py ) != 3 ||
+                id < nmin || id >= nmin + n )
+        {
+            fprintf ( stderr, "Bad coordinate line: %s", line );
+            exit ( -1 );
+        }
+        x[id - nmin] = px;
+        y[id - nmin] = py;
+        if ( ! seen[id - nmin] )
+            count++;
+        seen[id - nmin] = 1;
+    }
+    fclose ( file );
+    if ( count != n )
+    {
+        fprintf ( stderr, "Only %ld of %ld nodes have coordinates.\n", count,
+            n );
+        exit ( -1 );
+    }
+
+    for ( i = 0; i < n; i++ )
+    {
+        for ( a = ndp[i].first; a != ndp[i + 1].first; a++ )
+        {
+            length = hypot ( x[a->head - ndp] - x[i], y[a->head - ndp] - y[i] );
+            if ( length > 0 && a->len / length < scale )
+                scale = a->len / length;
+        }
+    }
+    /* shave off the rounding error of the ratio, which could otherwise
+       make the heuristic drop by more than an arc's length */
+    scale = ( scale == HUGE_VAL ) ? 0 : scale * ( 1.0 - 1e-9 );
+
+    for ( i = 0; i < n; i++ )
+    {
+        estimate = floor ( scale * hypot ( x[target - ndp] - x[i],
+            y[target - ndp] - y[i] ) );
+        h[i] = ( estimate >= 4294967295.0 ) ? 0xFFFFFFFF : (uint32_t) estimate;
+    }
+
+    free ( seen );
+    free ( y );
+    free ( x );
+
+    return h;
+}
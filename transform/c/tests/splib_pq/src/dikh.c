@@ -170,6 +170,7 @@ pq_op_decrease_key op_decrease_key;
 header.op_count = 0;
 header.pq_ids = 1;
 header.node_ids = 0;
+header.flags = 0;
 op_create.pq_id = 0;
 op_destroy.pq_id = 0;
 op_insert.pq_id = 0;
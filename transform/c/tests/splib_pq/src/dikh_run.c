@@ -28,6 +28,14 @@ long n_impr = 0;
 
 #include "parser_dh.c"
 
+/* loader for graphs converted to binary by gr_converter */
+
+#include "parser_bin.c"
+
+/* the same parser, scanning the input on all cores */
+
+#include "parser_dh_mt.c"
+
 /* function 'timer()' for mesuring processor time */
 
 #include "timer.c"
@@ -50,7 +58,10 @@ uint64_t sum_d = 0;
 
 int trace_file = open( argv[1], O_RDWR | O_CREAT | O_TRUNC, S_IRWXU );
 
- parse( &n, &m, &ndp, &arp, &source, &nmin, name );
+ if( argc > 2 )
+   parse_bin( argv[2], &n, &m, &ndp, &arp, &source, &nmin, name );
+ else
+   parse_mt( &n, &m, &ndp, &arp, &source, &nmin, name );
 /*
 printf ( "%s\nn= %ld, m= %ld, nmin= %ld, source = %ld\n",
         name,
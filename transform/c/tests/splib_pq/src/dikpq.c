@@ -0,0 +1,184 @@
+/***********************************************************/
+/*                                                         */
+/*    Dijkstra with a pluggable priority queue             */
+/*                                                         */
+/***********************************************************/
+
+/* Runs Dijkstra directly against one of the queues in queues/, chosen at
+   compile time with -DUSE_<QUEUE> the same way the trace driver chooses, so
+   the queue competes with the graph scan for cache as it would in a real
+   application.  Keys are ( dist << 32 ) | node index, matching the traces. */
+
+#include <sys/time.h>
+#include "types_dh.h"
+
+#ifdef USE_BINOMIAL
+    #include "../../../queues/binomial_queue.h"
+#elif defined USE_EXPLICIT_2
+    #include "../../../queues/explicit_heap.h"
+#elif defined USE_EXPLICIT_4
+    #include "../../../queues/explicit_heap.h"
+#elif defined USE_EXPLICIT_8
+    #include "../../../queues/explicit_heap.h"
+#elif defined USE_EXPLICIT_16
+    #include "../../../queues/explicit_heap.h"
+#elif defined USE_FIBONACCI
+    #include "../../../queues/fibonacci_heap.h"
+#elif defined USE_IMPLICIT_2
+    #include "../../../queues/implicit_heap.h"
+#elif defined USE_IMPLICIT_4
+    #include "../../../queues/implicit_heap.h"
+#elif defined USE_IMPLICIT_8
+    #include "../../../queues/implicit_heap.h"
+#elif defined USE_IMPLICIT_16
+    #include "../../../queues/implicit_heap.h"
+#elif defined USE_PAIRING
+    #include "../../../queues/pairing_heap.h"
+#elif defined USE_QUAKE
+    #include "../../../queues/quake_heap.h"
+#elif defined USE_RANK_PAIRING
+    #include "../../../queues/rank_pairing_heap.h"
+#elif defined USE_RANK_RELAXED_WEAK
+    #include "../../../queues/rank_relaxed_weak_queue.h"
+#elif defined USE_STRICT_FIBONACCI
+    #include "../../../queues/strict_fibonacci_heap.h"
+#elif defined USE_VIOLATION
+    #include "../../../queues/violation_heap.h"
+#elif defined USE_BUCKET
+    #include "../../../queues/bucket_queue.h"
+#elif defined USE_MULTILEVEL_BUCKET
+    #include "../../../queues/multilevel_bucket_queue.h"
+#elif defined USE_CALENDAR
+    #include "../../../queues/calendar_queue.h"
+#elif defined USE_LADDER
+    #include "../../../queues/ladder_queue.h"
+#elif defined USE_TIMING_WHEEL
+    #include "../../../queues/timing_wheel.h"
+#endif
+
+#if defined __x86_64__ || defined __i386__
+    #include <x86intrin.h>
+#endif
+
+#define DIKPQ_VERY_FAR  0xFFFFFFFFFFFFFFF
+#define DIKPQ_MASK_NAME 0x00000000FFFFFFFF
+
+/* queue calls are bracketed with these when a run is instrumented */
+#define QUEUE_ENTER     if ( timed ) t_enter = ticks ()
+#define QUEUE_LEAVE     if ( timed ) queue_ticks += ticks () - t_enter
+
+/**
+ * Cheap timestamp for bracketing individual queue calls.  Uses the cycle
+ * counter where there is one, since a system call per queue operation would
+ * cost more than the operation itself.
+ *
+ * @return  Timestamp in arbitrary but consistent units
+ */
+static inline uint64_t ticks ()
+{
+#if defined __x86_64__ || defined __i386__
+    return __rdtsc ();
+#else
+    struct timeval t;
+    gettimeofday ( &t, NULL );
+    return (uint64_t) t.tv_sec * 1000000 + t.tv_usec;
+#endif
+}
+
+/**
+ * Computes the shortest path tree from source, leaving final distances in
+ * node->dist and the tree in node->parent.  When timed is set every queue
+ * call is bracketed with @ref <ticks>, and the time spent inside the queue
+ * is returned in the same units.
+ *
+ * @param n         Number of nodes
+ * @param nodes     Node array, followed by a sentinel node
+ * @param source    Source node
+ * @param map       Memory map for the queue's nodes
+ * @param handles   Scratch array of n queue handles
+ * @param timed     Whether to measure time spent in the queue
+ * @param scans     Set to the number of nodes scanned
+ * @param imprs     Set to the number of distance improvements
+ * @return          Ticks spent in queue calls, 0 if not timed
+ */
+static uint64_t dikpq ( long n, node *nodes, node *source, mem_map *map,
+    pq_node_type **handles, uint32_t timed, long *scans, long *imprs )
+{
+    uint64_t dist_new, dist_from, key;
+    uint64_t queue_ticks = 0;
+    uint64_t t_enter = 0;
+    uint32_t index;
+    long num_scans = 0;
+    long num_imprs = 0;
+    node *node_from, *node_to, *node_last, *i;
+    arc *arc_ij, *arc_last;
+    pq_type *queue;
+
+    node_last = nodes + n;
+    for ( i = nodes; i != node_last; i++ )
+    {
+        i -> parent = (node*) NULL;
+        i -> dist = DIKPQ_VERY_FAR;
+        handles[i - nodes] = NULL;
+    }
+
+    QUEUE_ENTER;
+    queue = pq_create ( map );
+    QUEUE_LEAVE;
+
+    source -> parent = source;
+    source -> dist = 0;
+    index = (uint32_t) ( source - nodes );
+
+    QUEUE_ENTER;
+    handles[index] = pq_insert ( queue, index, (uint64_t) index );
+    QUEUE_LEAVE;
+
+    while ( 1 )
+    {
+        QUEUE_ENTER;
+        if ( pq_empty ( queue ) )
+        {
+            QUEUE_LEAVE;
+            break;
+        }
+        key = pq_delete_min ( queue );
+        QUEUE_LEAVE;
+
+        node_from = nodes + ( key & DIKPQ_MASK_NAME );
+        dist_from = node_from -> dist;
+        arc_last = ( node_from + 1 ) -> first;
+        num_scans++;
+
+        for ( arc_ij = node_from -> first; arc_ij != arc_last; arc_ij++ )
+        {
+            node_to = arc_ij -> head;
+            dist_new = dist_from + arc_ij -> len;
+
+            if ( dist_new < node_to -> dist )
+            {
+                node_to -> dist = dist_new;
+                node_to -> parent = node_from;
+                index = (uint32_t) ( node_to - nodes );
+                key = ( dist_new << 32 ) | index;
+                num_imprs++;
+
+                QUEUE_ENTER;
+                if ( handles[index] == NULL )
+                    handles[index] = pq_insert ( queue, index, key );
+                else
+                    pq_decrease_key ( queue, handles[index], key );
+                QUEUE_LEAVE;
+            }
+        }
+    }
+
+    QUEUE_ENTER;
+    pq_destroy ( queue );
+    QUEUE_LEAVE;
+
+    *scans = num_scans;
+    *imprs = num_imprs;
+
+    return queue_ticks;
+}
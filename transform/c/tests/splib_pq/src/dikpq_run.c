@@ -0,0 +1,135 @@
+/***********************************************************/
+/*                                                         */
+/*               Executor of SP codes                      */
+/*        (for Dijkstra with a pluggable queue)            */
+/*                                                         */
+/***********************************************************/
+
+/* Usage: dikpq_<queue> [reps] < problem.gr
+          dikpq_<queue> reps problem.bin
+
+   The second form maps a graph converted by gr_converter instead of parsing
+   text from stdin.
+
+   Each repetition runs Dijkstra twice from the problem's source: once plain,
+   to measure total wall time, and once with every queue call bracketed by
+   cycle counter reads, to measure what fraction of the run is spent in the
+   queue.  That fraction is applied to the plain run, so the reported split
+   is not inflated by the instrumentation.  Times are in microseconds and are
+   the minimum over all repetitions. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* definitions of types: node & arc */
+
+#include "types_dh.h"
+
+/* parser for getting extended DIMACS format input and transforming the
+   data to the internal representation */
+
+#include "parser_dh.c"
+
+/* loader for graphs converted to binary by gr_converter */
+
+#include "parser_bin.c"
+
+/* the same parser, scanning the input on all cores */
+
+#include "parser_dh_mt.c"
+
+/* function for constructing shortest path tree */
+
+#include "dikpq.c"
+
+#ifdef USE_STRICT_FIBONACCI
+    static uint32_t mem_types = 2;
+    static uint32_t mem_sizes[2] =
+    {
+        sizeof( strict_fibonacci_node ),
+        sizeof( active_record )
+    };
+#else
+    static uint32_t mem_types = 1;
+    static uint32_t mem_sizes[1] =
+    {
+        sizeof( pq_node_type )
+    };
+#endif
+
+int main (int argc, char** argv)
+{
+    arc *arp;
+    node *ndp, *source, *k;
+    long n, m, nmin, scans, imprs;
+    char name[21];
+    uint64_t sum_d = 0;
+    uint64_t queue_ticks, total_ticks, t0, t1;
+    double total_usec, queue_usec;
+    double best_total = -1.0;
+    double best_queue = 0.0;
+    struct timeval w0, w1;
+    int reps = 1;
+    int r;
+
+    if ( argc > 1 )
+        reps = atoi ( argv[1] );
+    if ( reps < 1 )
+        reps = 1;
+
+    if ( argc > 2 )
+        parse_bin ( argv[2], &n, &m, &ndp, &arp, &source, &nmin, name );
+    else
+        parse_mt ( &n, &m, &ndp, &arp, &source, &nmin, name );
+
+    pq_node_type **handles = calloc ( n, sizeof ( pq_node_type* ) );
+    mem_map *map = mm_create ( mem_types, mem_sizes );
+    if ( handles == NULL || map == NULL )
+    {
+        fprintf ( stderr, "Calloc fail.\n" );
+        return -1;
+    }
+
+    for ( r = 0; r < reps; r++ )
+    {
+        gettimeofday ( &w0, NULL );
+        dikpq ( n, ndp, source, map, handles, 0, &scans, &imprs );
+        gettimeofday ( &w1, NULL );
+        total_usec = ( w1.tv_sec - w0.tv_sec ) * 1000000.0 +
+            ( w1.tv_usec - w0.tv_usec );
+
+        t0 = ticks ();
+        queue_ticks = dikpq ( n, ndp, source, map, handles, 1, &scans,
+            &imprs );
+        t1 = ticks ();
+        total_ticks = t1 - t0;
+        queue_usec = total_ticks == 0 ? 0.0 :
+            total_usec * ( (double) queue_ticks / total_ticks );
+
+        if ( best_total < 0 || total_usec < best_total )
+        {
+            best_total = total_usec;
+            best_queue = queue_usec;
+        }
+    }
+
+    for ( k = ndp; k < ndp + n; k++ )
+        if ( k -> parent != (node*) NULL )
+            sum_d += k -> dist;
+
+    printf ( "%s\n", name );
+    printf ( "nodes: %ld\n", n );
+    printf ( "arcs: %ld\n", m );
+    printf ( "scans: %ld\n", scans );
+    printf ( "improvements: %ld\n", imprs );
+    printf ( "checksum: %llu\n", (unsigned long long) sum_d );
+    printf ( "total_usec: %.0f\n", best_total );
+    printf ( "scan_usec: %.0f\n", best_total - best_queue );
+    printf ( "queue_usec: %.0f\n", best_queue );
+
+    mm_destroy ( map );
+    free ( handles );
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/********************************************************************/
+/*                                                                  */
+/*  parse_mt (...) :                                                */
+/*       1. Reads shortest path problem in extended DIMACS format   */
+/*          on all cores.                                           */
+/*       2. Prepares internal data representation #1.               */
+/*                                                                  */
+/********************************************************************/
+
+/* Drop-in replacement for parse(), with the same outputs.  The arc lines
+   are scanned by dimacs_tools on PQ_PARSE_THREADS threads (all online
+   processors by default), the degrees are counted and summed in parallel,
+   and then the arcs are put in order with the same in-place cycle-leader
+   pass as parse().  That last pass stays sequential because the order it
+   leaves arcs in within a node is what Dijkstra sees, and a different order
+   would change tie-breaking and therefore the traces. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "types_dh.h"
+#include "../../../dimacs_tools.h"
+
+int parse_mt ( long *n_ad, long *m_ad, node **nodes_ad, arc **arcs_ad,
+    node **source_ad, long *node_min_ad, char *problem_name )
+{
+    pq_dimacs graph;
+    node *nodes, *head_p;
+    arc *arcs, *arc_current, *arc_new;
+    int64_t *arc_first;
+    uint32_t *arc_tail;
+    uint32_t length;
+    long n, m, node_min, node_max, source, tail, i;
+    long last, arc_num, arc_new_num;
+
+    if ( pq_dimacs_read ( 0, pq_dimacs_threads (), &graph ) )
+        exit ( 1 );
+
+    if ( strcmp ( graph.type, "sp" ) )
+    {
+        printf ( "\nPrsMt: it is not a Shortest Path problem line.\n" );
+        exit ( 1 );
+    }
+    if ( !graph.has_source )
+    {
+        printf ( "\nPrsMt: source description must be before arc descriptions.\n" );
+        exit ( 1 );
+    }
+    if ( graph.arc_count == 0 )
+    {
+        printf ( "\nPrsMt: bad value of a parameter in the problem line.\n" );
+        exit ( 1 );
+    }
+
+    n = graph.declared_nodes;
+    m = graph.arc_count;
+    source = graph.source;
+    node_min = graph.node_min < n ? graph.node_min : n;
+    node_max = graph.node_max;
+    arc_tail = graph.tails;
+
+    nodes     = (node*) calloc ( n+2, sizeof(node) );
+    arcs      = (arc*)  calloc ( m+1, sizeof(arc) );
+    arc_first = (int64_t*) calloc ( n+2, sizeof(int64_t) );
+    if ( nodes == NULL || arcs == NULL || arc_first == NULL )
+    {
+        printf ( "\nPrsMt: can't obtain enough memory to solve this problem.\n" );
+        exit ( 1 );
+    }
+
+    for ( i = 0; i < m; i++ )
+    {
+        arcs[i].head = nodes + graph.heads[i];
+        arcs[i].len  = (uint32_t) graph.weights[i];
+    }
+
+    /* arc_first[i+1] is the number of arcs outgoing from i; after the sum
+       arc_first[i] is the position of the first arc outgoing from i */
+    pq_dimacs_count_tails ( &graph, arc_first );
+    pq_dimacs_prefix_sum ( arc_first + node_min, node_max - node_min + 2,
+        graph.threads );
+    for ( i = node_min; i <= node_max + 1; i++ )
+        ( nodes + i ) -> first = arcs + arc_first[i];
+
+    /* ordering arcs exactly as parse() does */
+    for ( i = node_min; i < node_max; i++ )
+    {
+        last = ( ( nodes + i + 1 ) -> first ) - arcs;
+
+        for ( arc_num = arc_first[i]; arc_num < last; arc_num++ )
+        {
+            tail = arc_tail[arc_num];
+
+            while ( tail != i )
+            {
+                arc_new_num = arc_first[tail];
+                arc_current = arcs + arc_num;
+                arc_new     = arcs + arc_new_num;
+
+                head_p              = arc_new -> head;
+                arc_new -> head     = arc_current -> head;
+                arc_current -> head = head_p;
+
+                length             = arc_new -> len;
+                arc_new -> len     = arc_current -> len;
+                arc_current -> len = length;
+
+                arc_tail[arc_num] = arc_tail[arc_new_num];
+
+                arc_tail[arc_new_num] = tail;
+                arc_first[tail]++;
+
+                tail = arc_tail[arc_num];
+            }
+        }
+    }
+
+    strcpy ( problem_name, graph.name );
+    *m_ad = m;
+    *n_ad = node_max - node_min + 1;
+    *source_ad = nodes + source;
+    *node_min_ad = node_min;
+    *nodes_ad = nodes + node_min;
+    *arcs_ad = arcs;
+
+    free ( arc_first );
+    pq_dimacs_free ( &graph );
+
+    if ( source < node_min || source > node_max ||
+         (*source_ad) -> first == ( (*source_ad) + 1 ) -> first )
+    {
+        printf ( "\nPrsMt: source doesn't have output arcs.\n" );
+        exit ( 1 );
+    }
+
+    return 0;
+}
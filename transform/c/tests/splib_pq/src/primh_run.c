@@ -0,0 +1,83 @@
+/***********************************************************/
+/*                                                         */
+/*               Executor of SP codes                      */
+/*               (for Prim's MST)                          */
+/*                                                         */
+/***********************************************************/
+/*****THIS CODE HAS BEEN MODIFIED TO PRODUCE PRORITY QUEUE **/
+/*****TRACES FOR DIMACS CHALLENGE 5. LOOK FOR challenge5   **/
+/*****COMMENTS IN THE CODE.  C. McGeoch 7/96                */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/* statistical variables */
+long n_scans = 0;
+long n_impr = 0;
+
+/* definitions of types: node & arc */
+
+#include "types_dh.h"
+
+/* parser for getting extended DIMACS format input and transforming the
+   data to the internal representation */
+
+#include "parser_dh.c"
+
+/* loader for graphs converted to binary by gr_converter */
+
+#include "parser_bin.c"
+
+/* the same parser, scanning the input on all cores */
+
+#include "parser_dh_mt.c"
+
+/* function 'timer()' for mesuring processor time */
+
+#include "timer.c"
+
+/* function for constructing minimum spanning tree */
+
+#include "primh.c"
+
+
+int main (int argc, char** argv)
+
+{
+
+float t;
+arc *arp;
+node *ndp, *source, *k;
+long n, m, nmin; 
+char name[21];
+uint64_t weight = 0;
+
+int trace_file = open( argv[1], O_RDWR | O_CREAT | O_TRUNC, S_IRWXU );
+
+ if( argc > 2 )
+   parse_bin( argv[2], &n, &m, &ndp, &arp, &source, &nmin, name );
+ else
+   parse_mt( &n, &m, &ndp, &arp, &source, &nmin, name );
+
+t = timer();
+
+primh ( trace_file, n, ndp, source );
+
+t = timer() - t;
+
+/* the high half of a tree node's key is the length of its tree arc */
+for ( k= ndp; k< ndp + n; k++ )
+  if ( k -> parent != (node*) NULL && k != source )
+   weight += (k -> dist) >> 32;
+
+printf ( "%s\nweight: %llu\n", name, (unsigned long long) weight );
+
+close( trace_file );
+
+return 0;
+}
+
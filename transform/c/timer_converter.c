@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "trace_tools.h"
+
+//==============================================================================
+// DEFINES
+//==============================================================================
+
+#define DEFAULT_CANCEL  90
+#define DEFAULT_MEAN    1000
+#define MAX_TIME        0xFFFFFFFF
+#define MASK_ID         0x00000000FFFFFFFF
+
+#define HEAP_BRANCH     4
+#define HEAP_PARENT(i)  ( ( (i) - 1 ) / HEAP_BRANCH )
+#define HEAP_CHILD(i)   ( (i) * HEAP_BRANCH + 1 )
+
+//==============================================================================
+// STATIC DECLARATIONS
+//==============================================================================
+
+static uint64_t arm( uint64_t now, uint64_t id, uint32_t cancel, uint64_t mean,
+    uint8_t *cancelled, uint64_t *expiry );
+static void heap_push( uint64_t *heap, uint64_t size, uint64_t key );
+static void heap_replace_top( uint64_t *heap, uint64_t size, uint64_t key );
+
+//==============================================================================
+// MAIN
+//==============================================================================
+
+/**
+ * Writes the trace of a timer subsystem with a steady population of armed
+ * timers, such as a network stack's retransmission timers.  The queue is
+ * filled with size timers armed at time 0.  Each of the events then takes
+ * whichever comes first of the earliest expiry and the earliest
+ * cancellation: an expiry is a delete-min, and a cancellation a delete of
+ * the cancelled timer's node.  Either way a new timer is armed in its place
+ * at the time of the event, so the queue stays at exactly size elements.
+ *
+ * Timeouts are uniform on [mean/2, 3 mean/2] ticks.  The given percentage of
+ * timers, 90 by default, are cancelled before they expire, at a time uniform
+ * over their lifetime, so most keys never reach the front of the queue.  Keys
+ * follow the usual layout, with the expiry time in the high 32 bits and the
+ * timer's node ID in the low 32 bits, and a new timer reuses the node ID of
+ * the one it replaces.  The generator tracks pending expiries and
+ * cancellations in a 4-ary heap of event keys.
+ */
+int main( int argc, char** argv )
+{
+    uint64_t size, events, seed, mean, key, now, id, i;
+    uint32_t cancel = DEFAULT_CANCEL;
+    uint64_t *heap, *expiry;
+    uint8_t *cancelled;
+
+    if( argc < 4 )
+    {
+        fprintf( stderr, "Usage: %s trace_file size events "
+            "[cancel_percent [seed [mean]]]\n", argv[0] );
+        exit( -1 );
+    }
+
+    size = strtoull( argv[2], NULL, 10 );
+    events = strtoull( argv[3], NULL, 10 );
+    if( argc > 4 )
+        cancel = (uint32_t) strtoul( argv[4], NULL, 10 );
+    seed = ( argc > 5 ) ? strtoull( argv[5], NULL, 10 ) : 1;
+    mean = ( argc > 6 ) ? strtoull( argv[6], NULL, 10 ) : DEFAULT_MEAN;
+    if( size == 0 || size > MASK_ID || cancel > 100 || mean == 0 ||
+            mean > MAX_TIME )
+    {
+        fprintf( stderr, "Bad size, cancel percentage, or mean.\n" );
+        exit( -1 );
+    }
+    srand48( seed );
+
+    heap = (uint64_t*) malloc( size * sizeof( uint64_t ) );
+    expiry = (uint64_t*) malloc( size * sizeof( uint64_t ) );
+    cancelled = (uint8_t*) malloc( size * sizeof( uint8_t ) );
+    if( heap == NULL || expiry == NULL || cancelled == NULL )
+    {
+        fprintf( stderr, "Malloc fail.\n" );
+        exit( -1 );
+    }
+
+    int trace_file = open( argv[1], O_RDWR | O_CREAT | O_TRUNC, S_IRWXU );
+    if( trace_file < 0 )
+    {
+        fprintf( stderr, "Could not open file.\n" );
+        exit( -1 );
+    }
+
+    pq_trace_header header;
+    pq_op_create op_create;
+    pq_op_destroy op_destroy;
+    pq_op_insert op_insert;
+    pq_op_delete op_delete;
+    pq_op_delete_min op_delete_min;
+
+    header.op_count = 0;
+    header.pq_ids = 1;
+    header.node_ids = size;
+    header.flags = 0;
+    op_create.code = PQ_OP_CREATE;
+    op_create.pq_id = 0;
+    op_destroy.code = PQ_OP_DESTROY;
+    op_destroy.pq_id = 0;
+    op_insert.code = PQ_OP_INSERT;
+    op_insert.pq_id = 0;
+    op_delete.code = PQ_OP_DELETE;
+    op_delete.pq_id = 0;
+    op_delete_min.code = PQ_OP_DELETE_MIN;
+    op_delete_min.pq_id = 0;
+
+    pq_trace_write_header( trace_file, header );
+    pq_trace_write_op( trace_file, &op_create );
+    header.op_count++;
+
+    for( i = 0; i < size; i++ )
+    {
+        heap_push( heap, i, arm( 0, i, cancel, mean, cancelled, expiry ) );
+
+        op_insert.node_id = i;
+        op_insert.key = expiry[i];
+        op_insert.item = i;
+        pq_trace_write_op( trace_file, &op_insert );
+        header.op_count++;
+    }
+
+    for( i = 0; i < events; i++ )
+    {
+        now = heap[0] >> 32;
+        id = heap[0] & MASK_ID;
+        if( cancelled[id] )
+        {
+            op_delete.node_id = id;
+            pq_trace_write_op( trace_file, &op_delete );
+        }
+        else
+            pq_trace_write_op( trace_file, &op_delete_min );
+        header.op_count++;
+
+        key = arm( now, id, cancel, mean, cancelled, expiry );
+        heap_replace_top( heap, size, key );
+
+        op_insert.node_id = id;
+        op_insert.key = expiry[id];
+        op_insert.item = id;
+        pq_trace_write_op( trace_file, &op_insert );
+        header.op_count++;
+    }
+
+    pq_trace_write_op( trace_file, &op_destroy );
+    header.op_count++;
+    if( pq_trace_write_header( trace_file, header ) )
+    {
+        fprintf( stderr, "Could not write trace.\n" );
+        exit( -1 );
+    }
+    close( trace_file );
+    free( cancelled );
+    free( expiry );
+    free( heap );
+
+    return 0;
+}
+
+//==============================================================================
+// STATIC METHODS
+//==============================================================================
+
+/**
+ * Arms a timer at the given time.  Draws its timeout and decides whether it
+ * will be cancelled, and if so when.  A cancellation always falls strictly
+ * before the expiry, so an expiry that comes first among the pending events
+ * is also the minimum of the queue.  Exits if the expiry no longer fits in
+ * 32 bits, since the trace would then fall out of order.
+ *
+ * @param now       Current time
+ * @param id        Node ID of the timer
+ * @param cancel    Percentage of timers to cancel
+ * @param mean      Mean timeout in ticks
+ * @param cancelled Per-timer flags, set if the timer will be cancelled
+ * @param expiry    Per-timer queue keys
+ * @return          Key of the timer's next event, its cancellation or expiry
+ */
+static uint64_t arm( uint64_t now, uint64_t id, uint32_t cancel, uint64_t mean,
+    uint8_t *cancelled, uint64_t *expiry )
+{
+    uint64_t timeout = mean / 2 + (uint64_t) ( drand48() * (double) mean );
+    uint64_t time = now + timeout;
+    if( time > MAX_TIME )
+    {
+        fprintf( stderr, "Timer expiry overflow; use fewer events.\n" );
+        exit( -1 );
+    }
+
+    expiry[id] = ( time << 32 ) | id;
+    cancelled[id] = ( timeout > 0 && drand48() * 100.0 < (double) cancel );
+    if( !cancelled[id] )
+        return expiry[id];
+
+    time = now + (uint64_t) ( drand48() * (double) timeout );
+    return ( time << 32 ) | id;
+}
+
+/**
+ * Adds a key to a heap of the given size and restores heap order.
+ *
+ * @param heap  Heap array with room for the new key
+ * @param size  Number of keys already in the heap
+ * @param key   Key to add
+ */
+static void heap_push( uint64_t *heap, uint64_t size, uint64_t key )
+{
+    uint64_t i = size;
+    while( i > 0 && key < heap[HEAP_PARENT(i)] )
+    {
+        heap[i] = heap[HEAP_PARENT(i)];
+        i = HEAP_PARENT(i);
+    }
+    heap[i] = key;
+}
+
+/**
+ * Replaces the minimum of a heap with a new key and restores heap order.
+ *
+ * @param heap  Heap array
+ * @param size  Number of keys in the heap
+ * @param key   Key to take the minimum's place
+ */
+static void heap_replace_top( uint64_t *heap, uint64_t size, uint64_t key )
+{
+    uint64_t i = 0;
+    uint64_t child, min_child, last;
+
+    while( ( child = HEAP_CHILD(i) ) < size )
+    {
+        min_child = child;
+        last = child + HEAP_BRANCH;
+        if( last > size )
+            last = size;
+        for( child++; child < last; child++ )
+        {
+            if( heap[child] < heap[min_child] )
+                min_child = child;
+        }
+        if( key <= heap[min_child] )
+            break;
+
+        heap[i] = heap[min_child];
+        i = min_child;
+    }
+    heap[i] = key;
+}
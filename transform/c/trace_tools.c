@@ -1,4 +1,5 @@
 #include "trace_tools.h"
+#include <stdlib.h>
 
 //==============================================================================
 // DEFINES, INCLUDES, and STRUCTS
@@ -36,6 +37,7 @@ static size_t pq_op_buffer_pos = 0;
 static uint8_t pq_op_buffer[PQ_OP_BUFFER_LEN];
 
 static int buffered_write( int file, uint8_t* data, size_t length );
+static FILE* open_profile( const char *trace_path, const char *mode );
 
 //==============================================================================
 // PUBLIC METHODS
@@ -47,6 +49,8 @@ int pq_trace_write_header( int file, pq_trace_header header )
     if( flush == -1 )
         return -1;
     lseek( file, 0, SEEK_SET );
+    header.magic = PQ_TRACE_MAGIC;
+    header.version = PQ_TRACE_VERSION;
     ssize_t bytes = write( file, &header, sizeof( pq_trace_header) );
     if( bytes != sizeof( pq_trace_header ) )
         return -1;
@@ -57,12 +61,77 @@ int pq_trace_write_header( int file, pq_trace_header header )
 int pq_trace_read_header( int file, pq_trace_header *header )
 {
     ssize_t bytes = read( file, header, sizeof( pq_trace_header ) );
-    if( bytes != sizeof( pq_trace_header ) )
+    if( bytes != sizeof( pq_trace_header ) || header->magic != PQ_TRACE_MAGIC ||
+            header->version != PQ_TRACE_VERSION )
+        return -1;
+
+    return 0;
+}
+
+int pq_trace_write_profile( const char *trace_path,
+    pq_trace_profile *profile )
+{
+    FILE *file = open_profile( trace_path, "wb" );
+    if( file == NULL )
+        return -1;
+
+    size_t written = fwrite( profile, sizeof( pq_trace_profile ), 1, file );
+    if( fclose( file ) != 0 || written != 1 )
+        return -1;
+
+    return 0;
+}
+
+int pq_trace_read_profile( const char *trace_path, pq_trace_header *header,
+    pq_trace_profile *profile )
+{
+    FILE *file = open_profile( trace_path, "rb" );
+    if( file == NULL )
+        return -1;
+
+    size_t count = fread( profile, sizeof( pq_trace_profile ), 1, file );
+    fclose( file );
+    if( count != 1 || profile->op_count != header->op_count ||
+            profile->node_ids != header->node_ids )
         return -1;
 
     return 0;
 }
 
+void pq_trace_profile_ops( pq_trace_profile *profile, uint32_t *pq_sizes,
+    uint32_t *live_total, pq_op_blank *ops, uint64_t count )
+{
+    uint64_t i;
+    uint32_t *live;
+
+    for( i = 0; i < count; i++ )
+    {
+        switch( ops[i].code )
+        {
+            case PQ_OP_DESTROY:
+            case PQ_OP_CLEAR:
+                live = &pq_sizes[ops[i].pq_id];
+                *live_total -= *live;
+                *live = 0;
+                break;
+            case PQ_OP_INSERT:
+                live = &pq_sizes[ops[i].pq_id];
+                if( ++(*live) > profile->peak_queue )
+                    profile->peak_queue = *live;
+                if( ++(*live_total) > profile->peak_total )
+                    profile->peak_total = *live_total;
+                break;
+            case PQ_OP_DELETE:
+            case PQ_OP_DELETE_MIN:
+                pq_sizes[ops[i].pq_id]--;
+                (*live_total)--;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
 int pq_trace_write_op( int file, void *op )
 {
     uint32_t code = *((uint32_t*) op);
@@ -89,6 +158,50 @@ int pq_trace_read_op( int file, void *op )
     return 0;
 }
 
+int pq_trace_read_ops( int file, pq_op_blank *ops, uint64_t count )
+{
+    uint8_t block[PQ_OP_BUFFER_LEN];
+    size_t pos = 0;
+    size_t end = 0;
+    uint64_t i = 0;
+    ssize_t bytes;
+    uint32_t code;
+    size_t length;
+
+    while( i < count )
+    {
+        // refill once the next op might straddle the end of the block
+        if( end - pos < sizeof( pq_op_blank ) )
+        {
+            memmove( block, block + pos, end - pos );
+            end -= pos;
+            pos = 0;
+            bytes = read( file, block + end, PQ_OP_BUFFER_LEN - end );
+            if( bytes < 0 )
+                return -1;
+            end += bytes;
+            if( end - pos < sizeof( uint32_t ) )
+                return -1;
+        }
+
+        code = *((uint32_t*) ( block + pos ));
+        if( code > PQ_OP_EMPTY )
+            return -1;
+        length = pq_op_lengths[code];
+        if( end - pos < length )
+            return -1;
+
+        memcpy( ops + i, block + pos, length );
+        pos += length;
+        i++;
+    }
+
+    if( end > pos )
+        lseek( file, -( (off_t) ( end - pos ) ), SEEK_CUR );
+
+    return 0;
+}
+
 int pq_trace_flush_buffer( int file )
 {
     size_t to_write = pq_op_buffer_pos;
@@ -121,3 +234,26 @@ static int buffered_write( int file, uint8_t* data, size_t length )
 
     return length;
 }
+
+/**
+ * Opens the side-car profile of a trace.
+ *
+ * @param trace_path    Path of the trace
+ * @param mode          Mode to pass to fopen
+ * @return              The open file, or NULL on error
+ */
+static FILE* open_profile( const char *trace_path, const char *mode )
+{
+    FILE *file;
+    size_t length = strlen( trace_path );
+    char *path = malloc( length + sizeof( PQ_PROFILE_SUFFIX ) );
+    if( path == NULL )
+        return NULL;
+
+    memcpy( path, trace_path, length );
+    memcpy( path + length, PQ_PROFILE_SUFFIX, sizeof( PQ_PROFILE_SUFFIX ) );
+    file = fopen( path, mode );
+    free( path );
+
+    return file;
+}
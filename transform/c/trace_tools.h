@@ -27,17 +27,49 @@
 #define PQ_OP_EMPTY         12
 
 /**
- * Contains info about the trace file.  pq_ids and node_ids are the number of
+ * Contains info about the trace file.  magic and version identify the format,
+ * and are filled in by @ref <pq_trace_write_header>; traces of any other
+ * format are refused when read.  pq_ids and node_ids are the number of
  * unique IDs for the respective pointer types.  Valid IDs are in the 0-(n-1)
- * range, since IDs are used to index into arrays.
+ * range, since IDs are used to index into arrays.  flags describes how the
+ * keys are to be read; PQ_TRACE_MAX_ORDER marks a trace whose minimum is the
+ * largest key, which only max-ordered queues (USE_MAX_ORDER) can replay.
  */
 struct pq_trace_header
 {
+    uint32_t magic;
+    uint32_t version;
     uint64_t op_count;
     uint32_t pq_ids;
     uint32_t node_ids;
+    uint32_t flags;
 } __attribute__ ((packed, aligned(4)));
 
+#define PQ_TRACE_MAGIC      0x52545150
+#define PQ_TRACE_VERSION    2
+
+#define PQ_TRACE_MAX_ORDER  0x1
+
+/**
+ * Side-car profile of a trace, written by trace_stats to a file named after
+ * the trace with PQ_PROFILE_SUFFIX appended.  Records how many elements are
+ * live at once, which bounds what a queue's node pools must hold far more
+ * tightly than node_ids, the number of elements ever inserted.  op_count and
+ * node_ids repeat the header of the trace profiled, so that a profile left
+ * over from an earlier trace of the same name is not used.
+ */
+struct pq_trace_profile
+{
+    uint64_t op_count;
+    uint32_t node_ids;
+    //! most elements live in any one queue at once
+    uint32_t peak_queue;
+    //! most elements live in all queues together at once
+    uint32_t peak_total;
+} __attribute__ ((packed, aligned(4)));
+
+#define PQ_PROFILE_SUFFIX   ".profile"
+
 struct pq_op_create
 {
     uint32_t code;
@@ -133,6 +165,7 @@ struct pq_op_empty
 } __attribute__ ((packed, aligned(4)));
 
 typedef struct pq_trace_header pq_trace_header;
+typedef struct pq_trace_profile pq_trace_profile;
 typedef struct pq_op_create pq_op_create;
 typedef struct pq_op_destroy pq_op_destroy;
 typedef struct pq_op_clear pq_op_clear;
@@ -158,9 +191,14 @@ typedef struct pq_op_insert pq_op_blank;
 // PUBLIC DECLARATIONS
 //==============================================================================
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
- * Writes a proper trace header with the information specified in the input.
- * Rewinds the file to the beginning before writing.  Recommended use pattern is
+ * Writes a proper trace header with the information specified in the input,
+ * stamped with the current magic and version.  Rewinds the file to the
+ * beginning before writing.  Recommended use pattern is
  * to write a blank struct at the beginning of trace generation, write all the
  * operations, and then write the actual header.
  *
@@ -176,7 +214,8 @@ int pq_trace_write_header( int file, pq_trace_header header );
  *
  * @param file      File to read from.
  * @param header    Address of struct to write header info to
- * @return          0 on success, -1 on error
+ * @return          0 on success, -1 on error or if the file is not a trace
+ *                  of the current format
  */
 int pq_trace_read_header( int file, pq_trace_header *header );
 
@@ -201,6 +240,58 @@ int pq_trace_write_op( int file, void *op );
  */
 int pq_trace_read_op( int file, void *op );
 
+/**
+ * Reads a run of operations from the input file into an array of blank
+ * structs.  Reads the file in large blocks rather than issuing two system
+ * calls per operation, and seeks back over any unconsumed bytes so that the
+ * file position ends up just past the last operation read.
+ *
+ * @param file  File to read from
+ * @param ops   Array of at least count blank operation structs
+ * @param count Number of operations to read
+ * @return      0 on success, -1 on error
+ */
+int pq_trace_read_ops( int file, pq_op_blank *ops, uint64_t count );
+
+/**
+ * Writes the profile of a trace to its side-car file, replacing any earlier
+ * one.
+ *
+ * @param trace_path    Path of the trace profiled
+ * @param profile       Profile to write
+ * @return              0 on success, -1 on error
+ */
+int pq_trace_write_profile( const char *trace_path,
+    pq_trace_profile *profile );
+
+/**
+ * Reads the profile of a trace from its side-car file, if there is one that
+ * matches the trace's header.
+ *
+ * @param trace_path    Path of the trace
+ * @param header        Header read from the trace
+ * @param profile       Address of struct to write the profile to
+ * @return              0 on success, -1 if there is no matching profile
+ */
+int pq_trace_read_profile( const char *trace_path, pq_trace_header *header,
+    pq_trace_profile *profile );
+
+/**
+ * Extends the profile of a trace over a run of its operations.  Counts the
+ * elements live in each queue, dropping all of a queue's elements when it is
+ * cleared or destroyed, and raises the profile's peaks to match.  Call it on
+ * every run of the trace in order, with the same counters throughout.
+ *
+ * @param profile       Profile to extend
+ * @param pq_sizes      Elements live in each queue, one zeroed entry per
+ *                      pq_id to begin with
+ * @param live_total    Elements live in all queues, zero to begin with
+ * @param ops           Operations to profile
+ * @param count         Number of operations
+ */
+void pq_trace_profile_ops( pq_trace_profile *profile, uint32_t *pq_sizes,
+    uint32_t *live_total, pq_op_blank *ops, uint64_t count );
+
 /**
  * Flushes any outstanding writes to the trace file.  Must be called before
  * closing the file.
@@ -209,4 +300,8 @@ int pq_trace_read_op( int file, void *op );
  */
 int pq_trace_flush_buffer( int file );
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif